@@ -25,7 +25,8 @@ public class OpenXRViveTracker : ModuleRules
 			{
 				"Core",
                 "OpenXRHMD",
-                "OpenXRInput"
+                "OpenXRInput",
+                "AnimGraphRuntime"
             }
 			);
 			
@@ -37,6 +38,8 @@ public class OpenXRViveTracker : ModuleRules
 				"Engine",
 				"InputCore",
 				"InputDevice",
+				"PhysicsCore",
+				"RenderCore",
 				"Slate",
 				"SlateCore",
 				"HeadMountedDisplay"	// We need this for FXRMotionControllerBase
@@ -0,0 +1,118 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "AnimNode_ViveTrackerBones.h"
+#include "Animation/AnimInstanceProxy.h"
+
+void FAnimNode_ViveTrackerBones::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	if (m_trackerModule == nullptr)
+	{
+		m_trackerModule = FModuleManager::GetModulePtr<FOpenXRViveTrackerModule>("OpenXRViveTracker");
+	}
+}
+
+void FAnimNode_ViveTrackerBones::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine = DebugData.GetNodeName(this);
+	DebugLine += FString::Printf(TEXT("(Mappings: %d)"), Mappings.Num());
+	DebugData.AddDebugItem(DebugLine);
+
+	ComponentPose.GatherDebugData(DebugData);
+}
+
+void FAnimNode_ViveTrackerBones::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	for (FViveTrackerBoneMapping& Mapping : Mappings)
+	{
+		Mapping.Bone.Initialize(RequiredBones);
+	}
+
+	m_arrRoles.Reset(Mappings.Num());
+	for (const FViveTrackerBoneMapping& Mapping : Mappings)
+	{
+		m_arrRoles.Add(Mapping.TrackerRole);
+	}
+	m_arrSamples.SetNum(Mappings.Num());
+}
+
+bool FAnimNode_ViveTrackerBones::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+{
+	if (m_trackerModule == nullptr)
+		return false;
+
+	for (FViveTrackerBoneMapping& Mapping : Mappings)
+	{
+		if (Mapping.Bone.IsValidToEvaluate(RequiredBones))
+			return true;
+	}
+
+	return false;
+}
+
+void FAnimNode_ViveTrackerBones::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	check(OutBoneTransforms.Num() == 0);
+
+	if (m_arrRoles.Num() != Mappings.Num())
+		return;
+
+	// One locked read of every mapped tracker
+	m_trackerModule->GetTrackerSamples(m_arrRoles, m_arrSamples);
+
+	// Tracking space to component space, the component transform is cached on the proxy for worker threads
+	const FTransform& ComponentTransform = Output.AnimInstanceProxy->GetComponentTransform();
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+
+	for (int32 i = 0; i < Mappings.Num(); i++)
+	{
+		const FViveTrackerBoneMapping& Mapping = Mappings[i];
+		const FViveTrackerSample& Sample = m_arrSamples[i];
+
+		if (!Sample.HasValidPose() || !Mapping.Bone.IsValidToEvaluate(BoneContainer))
+			continue;
+
+		FTransform TrackerWorld = Sample.Transform;
+		TrackerWorld.AddToTranslation(PlayerStartLocation);
+
+		const FCompactPoseBoneIndex BoneIndex = Mapping.Bone.GetCompactPoseIndex(BoneContainer);
+		FTransform BoneTransform = (Mapping.TrackerToBone * TrackerWorld).GetRelativeTransform(ComponentTransform);
+
+		if (!Mapping.bApplyRotation)
+		{
+			BoneTransform.SetRotation(Output.Pose.GetComponentSpaceTransform(BoneIndex).GetRotation());
+		}
+
+		BoneTransform.SetScale3D(Output.Pose.GetComponentSpaceTransform(BoneIndex).GetScale3D());
+		OutBoneTransforms.Add(FBoneTransform(BoneIndex, BoneTransform));
+	}
+
+	// Bone transforms have to be applied parent first
+	OutBoneTransforms.Sort(FCompareBoneTransformIndex());
+}
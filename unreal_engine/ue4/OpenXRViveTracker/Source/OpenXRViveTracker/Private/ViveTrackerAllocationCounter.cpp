@@ -0,0 +1,110 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerAllocationCounter.h"
+#include "HAL/MemoryBase.h"
+
+// Per thread, so allocations of other threads running at the same time aren't counted
+static thread_local int32 GAllocationScopeDepth = 0;
+static thread_local uint64 GNumScopedAllocations = 0;
+
+/** Forwards everything to the allocator it replaced, counting allocations of threads inside a scope */
+class FViveTrackerCountingMalloc final : public FMalloc
+{
+public:
+	explicit FViveTrackerCountingMalloc(FMalloc* InInnerMalloc) : m_pInnerMalloc(InInnerMalloc) {}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		RecordAllocation();
+		return m_pInnerMalloc->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		// Shrinking in place and freeing through Realloc aren't allocations
+		SIZE_T nOriginalSize = 0;
+		if (Count > 0 && (!Original || !m_pInnerMalloc->GetAllocationSize(Original, nOriginalSize) || Count > nOriginalSize))
+		{
+			RecordAllocation();
+		}
+		return m_pInnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override { m_pInnerMalloc->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return m_pInnerMalloc->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return m_pInnerMalloc->GetAllocationSize(Original, SizeOut); }
+	virtual void Trim(bool bTrimThreadCaches) override { m_pInnerMalloc->Trim(bTrimThreadCaches); }
+	virtual void SetupTLSCachesOnCurrentThread() override { m_pInnerMalloc->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { m_pInnerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual void InitializeStatsMetadata() override { m_pInnerMalloc->InitializeStatsMetadata(); }
+	virtual void UpdateStats() override { m_pInnerMalloc->UpdateStats(); }
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { m_pInnerMalloc->GetAllocatorStats(OutStats); }
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override { m_pInnerMalloc->DumpAllocatorStats(Ar); }
+	virtual bool IsInternallyThreadSafe() const override { return m_pInnerMalloc->IsInternallyThreadSafe(); }
+	virtual bool ValidateHeap() override { return m_pInnerMalloc->ValidateHeap(); }
+	virtual const TCHAR* GetDescriptiveName() override { return m_pInnerMalloc->GetDescriptiveName(); }
+
+private:
+	FMalloc* m_pInnerMalloc;
+
+	static void RecordAllocation()
+	{
+		if (GAllocationScopeDepth > 0)
+		{
+			GNumScopedAllocations++;
+		}
+	}
+};
+
+static FViveTrackerCountingMalloc* GCountingMalloc = nullptr;
+
+FViveTrackerAllocationScope::FViveTrackerAllocationScope()
+{
+	// Never removed, other threads may be inside the proxy at any time
+	if (!GCountingMalloc)
+	{
+		check(IsInGameThread());
+		GCountingMalloc = new FViveTrackerCountingMalloc(GMalloc);
+		GMalloc = GCountingMalloc;
+	}
+
+	GAllocationScopeDepth++;
+	m_nStartAllocations = GNumScopedAllocations;
+}
+
+FViveTrackerAllocationScope::~FViveTrackerAllocationScope()
+{
+	GAllocationScopeDepth--;
+}
+
+uint64 FViveTrackerAllocationScope::GetNumAllocations() const
+{
+	return GNumScopedAllocations - m_nStartAllocations;
+}
@@ -0,0 +1,324 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerMockRuntime.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static constexpr double BenchmarkFrameSeconds = 1.0 / 90.0;
+static constexpr int32 BenchmarkNumRoles = (int32)ETrackerRole::Unassigned;
+
+/** One measured stage, as reported in the JSON output */
+struct FViveTrackerBenchmarkResult
+{
+	FString Name;
+	int64 Iterations = 0;
+	double NanosecondsPerOp = 0.0;
+	double ItemsPerSecond = 0.0;
+	FString Label;
+};
+
+/** Measures the stages of the per-frame tracker pipeline against the mock runtime, for one tracker count */
+class FViveTrackerPipelineBenchmark
+{
+public:
+	FViveTrackerPipelineBenchmark(FOpenXRViveTrackerModule& Module, int32 NumTrackers, int32 NumFrames, TArray<FViveTrackerBenchmarkResult>& OutResults)
+		: m_module(Module), m_nTrackers(NumTrackers), m_nFrames(NumFrames), m_arrResults(OutResults)
+	{
+	}
+
+	/**
+	* Run the stages
+	* @param TArray<int32> - Thread counts to update components from
+	* @param bool - Whether to time the per-role stages, which only ever see one tracker per role, or only connect events
+	* @return bool - Whether or not the mock runtime started
+	*/
+	bool Run(const TArray<int32>& ThreadCounts, bool bPerRoleStages)
+	{
+		for (int32 nTracker = 0; nTracker < m_nTrackers; nTracker++)
+		{
+			m_mock.AddTracker(FViveTrackerMockRuntime::MakeOrbitingTracker(nTracker));
+		}
+
+		if (!m_mock.Start(m_module))
+			return false;
+
+		// Connect everything and fill the pose histories before measuring
+		for (int32 nFrame = 0; nFrame < 90; nFrame++)
+		{
+			m_mock.Tick(BenchmarkFrameSeconds);
+		}
+		m_xrTime = m_mock.GetTime();
+
+		if (bPerRoleStages)
+		{
+			MeasureSync();
+			MeasureLocate();
+			MeasureFilter();
+			for (int32 NumThreads : ThreadCounts)
+			{
+				MeasureComponentUpdate(NumThreads);
+			}
+		}
+		MeasureConnectEvent();
+
+		m_mock.Stop();
+		return true;
+	}
+
+private:
+	FOpenXRViveTrackerModule& m_module;
+	FViveTrackerMockRuntime m_mock;
+	int32 m_nTrackers;
+	int32 m_nFrames;
+	TArray<FViveTrackerBenchmarkResult>& m_arrResults;
+	XrTime m_xrTime = 0;
+
+	void AddResult(const TCHAR* Stage, int64 Iterations, double SecondsPerOp, const FString& Label = FString(), int32 NumThreads = 0)
+	{
+		FViveTrackerBenchmarkResult& Result = m_arrResults.AddDefaulted_GetRef();
+		Result.Name = FString::Printf(TEXT("%s/trackers:%d"), Stage, m_nTrackers);
+		if (NumThreads > 0)
+		{
+			Result.Name += FString::Printf(TEXT("/threads:%d"), NumThreads);
+		}
+		Result.Iterations = Iterations;
+		Result.NanosecondsPerOp = SecondsPerOp * 1.0e9;
+		Result.ItemsPerSecond = SecondsPerOp > 0.0 ? FMath::Max(NumThreads, 1) / SecondsPerOp : 0.0;
+		Result.Label = Label;
+
+		UE_LOG(LogOpenXRViveTracker, Display, TEXT("%-40s %12.1f ns %14.0f items/s  %s"), *Result.Name, Result.NanosecondsPerOp, Result.ItemsPerSecond, *Label);
+	}
+
+	XrTime NextFrameTime()
+	{
+		m_xrTime += (XrTime)(BenchmarkFrameSeconds * 1.0e9);
+		return m_xrTime;
+	}
+
+	/** The whole of PostSyncActions, as the OpenXR plugin calls it once per frame, and its publish stage as timed by the module */
+	void MeasureSync()
+	{
+		const double StartPublishSeconds = m_module.GetSyncStats().SumPublishSeconds;
+		uint64 nCycles = 0;
+		for (int32 nFrame = 0; nFrame < m_nFrames; nFrame++)
+		{
+			m_module.UpdateDeviceLocations(m_mock.GetSession(), NextFrameTime(), m_mock.GetBaseSpace());
+
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			m_module.PostSyncActions(m_mock.GetSession());
+			nCycles += FPlatformTime::Cycles64() - StartCycles;
+		}
+
+		AddResult(TEXT("Sync"), m_nFrames, FPlatformTime::ToSeconds64(nCycles) / m_nFrames, TEXT("per frame"));
+		AddResult(TEXT("Publish"), m_nFrames, (m_module.GetSyncStats().SumPublishSeconds - StartPublishSeconds) / m_nFrames, TEXT("per frame, all roles"));
+	}
+
+	/**
+	* Locating every role through a tracker session of its own bound to the mock, the same code PostSyncActions runs.
+	* The mock's own xrLocateSpace cost is reported alongside, so it can be told apart from the plugin's.
+	*/
+	void MeasureLocate()
+	{
+		ViveTrackerCore::FTrackerSession Session;
+		Session.SetEntryPoints(FViveTrackerMockRuntime::GetEntryPoints());
+		if (Session.CreateActionSet(m_mock.GetInstance()) != XR_SUCCESS || Session.CreateActions(m_mock.GetSession()) != XR_SUCCESS)
+		{
+			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Pipeline benchmark: unable to create a tracker session on the mock runtime"));
+			return;
+		}
+
+		uint64 nCycles = 0;
+		for (int32 nFrame = 0; nFrame < m_nFrames; nFrame++)
+		{
+			const XrTime xrTime = NextFrameTime();
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Session.LocateRoles(m_mock.GetBaseSpace(), xrTime);
+			nCycles += FPlatformTime::Cycles64() - StartCycles;
+		}
+		AddResult(TEXT("Locate"), m_nFrames, FPlatformTime::ToSeconds64(nCycles) / m_nFrames, TEXT("per frame, all roles"));
+
+		const PFN_xrLocateSpace LocateSpace = FViveTrackerMockRuntime::GetEntryPoints().LocateSpace;
+		nCycles = 0;
+		for (int32 nFrame = 0; nFrame < m_nFrames; nFrame++)
+		{
+			const XrTime xrTime = NextFrameTime();
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			for (int32 nRole = 0; nRole < BenchmarkNumRoles; nRole++)
+			{
+				XrSpaceVelocity xrSpaceVelocity{ XR_TYPE_SPACE_VELOCITY };
+				XrSpaceLocation xrSpaceLocation{ XR_TYPE_SPACE_LOCATION, &xrSpaceVelocity };
+				LocateSpace(Session.GetRoleAction(nRole).Space, m_mock.GetBaseSpace(), xrTime, &xrSpaceLocation);
+			}
+			nCycles += FPlatformTime::Cycles64() - StartCycles;
+		}
+		AddResult(TEXT("StubLocate"), m_nFrames, FPlatformTime::ToSeconds64(nCycles) / m_nFrames, TEXT("per frame, mock runtime only"));
+
+		Session.Release();
+	}
+
+	/** Evaluating the pose histories, at a past time like late consumers and in substep batches like physics */
+	void MeasureFilter()
+	{
+		const XrTime xrTime = m_module.GetPredictedDisplayTime() - 5 * 1000 * 1000;
+		FTransform Transform;
+
+		uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 nFrame = 0; nFrame < m_nFrames; nFrame++)
+		{
+			for (int32 nRole = 0; nRole < BenchmarkNumRoles; nRole++)
+			{
+				m_module.GetTrackerTransformAtTime((ETrackerRole)nRole, xrTime, Transform);
+			}
+		}
+		const int64 NumCalls = (int64)m_nFrames * BenchmarkNumRoles;
+		AddResult(TEXT("FilterAtTime"), NumCalls, FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) / NumCalls, TEXT("per call"));
+
+		constexpr int32 NumSubsteps = 4;
+		ETrackerRole Roles[BenchmarkNumRoles];
+		FTransform Transforms[BenchmarkNumRoles * NumSubsteps];
+		for (int32 nRole = 0; nRole < BenchmarkNumRoles; nRole++)
+		{
+			Roles[nRole] = (ETrackerRole)nRole;
+		}
+
+		StartCycles = FPlatformTime::Cycles64();
+		for (int32 nFrame = 0; nFrame < m_nFrames; nFrame++)
+		{
+			m_module.GetTrackerSubstepTransforms(MakeArrayView(Roles), (float)BenchmarkFrameSeconds, NumSubsteps, MakeArrayView(Transforms));
+		}
+		AddResult(TEXT("FilterSubsteps"), m_nFrames, FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) / m_nFrames, TEXT("per batch of all roles, 4 substeps"));
+	}
+
+	/** What every UViveTrackerComponent asks the module for in its tick, from several threads at once */
+	void MeasureComponentUpdate(int32 NumThreads)
+	{
+		const int32 NumCallsPerThread = m_nFrames * BenchmarkNumRoles;
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		ParallelFor(NumThreads, [this, NumCallsPerThread](int32 Thread)
+		{
+			for (int32 nCall = 0; nCall < NumCallsPerThread; nCall++)
+			{
+				m_module.GetTrackerTransform((ETrackerRole)((nCall + Thread) % BenchmarkNumRoles));
+			}
+		}, NumThreads == 1);
+
+		// Every thread made the same number of calls concurrently, so the wall time per call is each caller's latency
+		const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+		AddResult(TEXT("ComponentUpdate"), (int64)NumCallsPerThread * NumThreads, Seconds / NumCallsPerThread, TEXT("per GetTrackerTransform call"), NumThreads);
+	}
+
+	/** A connect event, which lists every connected tracker again */
+	void MeasureConnectEvent()
+	{
+		const int32 NumEvents = FMath::Clamp(m_nFrames / 10, 10, 200);
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 nEvent = 0; nEvent < NumEvents; nEvent++)
+		{
+			m_mock.SendConnectEvent(nEvent % m_nTrackers);
+		}
+		AddResult(TEXT("ConnectEvent"), NumEvents, FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) / NumEvents, TEXT("per event"));
+	}
+};
+
+/** Write the results in Google Benchmark's JSON layout, so its comparison tools can diff two runs */
+static bool SaveBenchmarkResults(const FString& Filename, const TArray<FViveTrackerBenchmarkResult>& Results, int32 NumFrames)
+{
+	FString sJson = TEXT("{\n\t\"context\": {\n");
+	sJson += FString::Printf(TEXT("\t\t\"date\": \"%s\",\n"), *FDateTime::UtcNow().ToIso8601());
+	sJson += TEXT("\t\t\"executable\": \"vivetracker.BenchmarkPipeline\",\n");
+	sJson += FString::Printf(TEXT("\t\t\"num_cpus\": %d,\n"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	sJson += FString::Printf(TEXT("\t\t\"frames\": %d\n\t},\n"), NumFrames);
+	sJson += TEXT("\t\"benchmarks\": [\n");
+	for (int32 nResult = 0; nResult < Results.Num(); nResult++)
+	{
+		const FViveTrackerBenchmarkResult& Result = Results[nResult];
+		sJson += FString::Printf(TEXT("\t\t{\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %lld, ")
+			TEXT("\"real_time\": %.3f, \"cpu_time\": %.3f, \"time_unit\": \"ns\", \"items_per_second\": %.1f, \"label\": \"%s\"}%s\n"),
+			*Result.Name, *Result.Name, Result.Iterations, Result.NanosecondsPerOp, Result.NanosecondsPerOp, Result.ItemsPerSecond, *Result.Label,
+			nResult + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+	}
+	sJson += TEXT("\t]\n}\n");
+
+	return FFileHelper::SaveStringToFile(sJson, *Filename, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
+
+/** Time each stage of the per-frame pipeline against the mock runtime at several reader thread counts, and connect events at 12, 64 and 256 trackers */
+static void BenchmarkPipeline(const TArray<FString>& Args)
+{
+	const int32 NumFrames = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 100, 1000000) : 5000;
+	const FString sFilename = Args.Num() > 1 ? Args[1] : FPaths::ProjectSavedDir() / TEXT("ViveTracker") / TEXT("PipelineBenchmark.json");
+
+	FOpenXRViveTrackerModule& Module = FOpenXRViveTrackerModule::Get();
+	if (Module.IsReplaying())
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Pipeline benchmark: stop the tracker replay first"));
+		return;
+	}
+
+	TArray<int32> ThreadCounts;
+	const int32 MaxThreads = FMath::Min(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 8);
+	for (int32 NumThreads = 1; NumThreads <= MaxThreads; NumThreads *= 2)
+	{
+		ThreadCounts.Add(NumThreads);
+	}
+
+	// The runtime binds one tracker per role and the module only locates roles, so every stage but connect events costs
+	// the same at any tracker count and is only timed at 12. The other trackers are listed on every connect event.
+	TArray<FViveTrackerBenchmarkResult> Results;
+	const int32 TrackerCounts[] = { BenchmarkNumRoles, 64, 256 };
+	for (int32 NumTrackers : TrackerCounts)
+	{
+		FViveTrackerPipelineBenchmark Benchmark(Module, NumTrackers, NumFrames, Results);
+		if (!Benchmark.Run(ThreadCounts, NumTrackers == BenchmarkNumRoles))
+		{
+			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Pipeline benchmark: unable to start the mock runtime"));
+			return;
+		}
+	}
+
+	if (SaveBenchmarkResults(sFilename, Results, NumFrames))
+	{
+		UE_LOG(LogOpenXRViveTracker, Display, TEXT("Pipeline benchmark results saved to %s"), *sFilename);
+	}
+	else
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Pipeline benchmark: unable to write %s"), *sFilename);
+	}
+}
+
+static FAutoConsoleCommand BenchmarkPipelineCommand(
+	TEXT("vivetracker.BenchmarkPipeline"),
+	TEXT("Time the sync, locate, publish, filter and component update stages against the mock runtime, and connect events at 12, 64 and 256 trackers. Args: [frames=5000] [json file]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkPipeline));
@@ -0,0 +1,339 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerBodyIK.h"
+#include "ViveTrackerCalibration.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+using namespace ViveTrackerCore;
+
+void FViveTrackerBodyIK::MakeSkeleton(const FViveTrackerBodyIKSettings& Settings, FBodySkeleton& OutSkeleton)
+{
+	OutSkeleton.SpineLength = Settings.SpineLength;
+	OutSkeleton.NeckLength = Settings.NeckLength;
+	OutSkeleton.ShoulderHalfWidth = Settings.ShoulderHalfWidth;
+	OutSkeleton.UpperArmLength = Settings.UpperArmLength;
+	OutSkeleton.LowerArmLength = Settings.LowerArmLength;
+	OutSkeleton.HipHalfWidth = Settings.HipHalfWidth;
+	OutSkeleton.ThighLength = Settings.ThighLength;
+	OutSkeleton.ShinLength = Settings.ShinLength;
+	OutSkeleton.ElbowMinAngle = FMath::DegreesToRadians(Settings.ElbowMinAngle);
+	OutSkeleton.ElbowMaxAngle = PI;
+	OutSkeleton.KneeMinAngle = FMath::DegreesToRadians(Settings.KneeMinAngle);
+	OutSkeleton.KneeMaxAngle = PI;
+	OutSkeleton.SpineMinAngle = FMath::DegreesToRadians(Settings.SpineMinAngle);
+
+	// Unreal's tracking space is Z up, X forward
+	OutSkeleton.Up = { 0.f, 0.f, 1.f };
+	OutSkeleton.Forward = { 1.f, 0.f, 0.f };
+}
+
+void FViveTrackerBodyIK::GatherTargets(const FOpenXRViveTrackerModule& Module, const FTransform& Head, const FTransform* LeftHand, const FTransform* RightHand, FBodyTargets& OutTargets,
+	const FViveTrackerCalibration* Calibration)
+{
+	static const ETrackerRole BodyRoles[] = { ETrackerRole::Waist, ETrackerRole::Chest, ETrackerRole::Foot_L, ETrackerRole::Foot_R,
+		ETrackerRole::Knee_L, ETrackerRole::Knee_R, ETrackerRole::Elbow_L, ETrackerRole::Elbow_R };
+	static const uint32_t BodyTargets[] = { Target_Pelvis, Target_Chest, Target_Foot_L, Target_Foot_R, Target_Knee_L, Target_Knee_R, Target_Elbow_L, Target_Elbow_R };
+	constexpr int32 NumBodyRoles = UE_ARRAY_COUNT(BodyRoles);
+
+	// Every body role in one batch
+	FViveTrackerSample Samples[NumBodyRoles];
+	Module.GetTrackerSamples(MakeArrayView(BodyRoles, NumBodyRoles), MakeArrayView(Samples, NumBodyRoles));
+
+	OutTargets.ValidMask = Target_Head;
+	OutTargets.Head = ToCorePose(Head);
+
+	if (LeftHand)
+	{
+		OutTargets.Hands[0] = ToCorePose(*LeftHand);
+		OutTargets.ValidMask |= Target_Hand_L;
+	}
+
+	if (RightHand)
+	{
+		OutTargets.Hands[1] = ToCorePose(*RightHand);
+		OutTargets.ValidMask |= Target_Hand_R;
+	}
+
+	// The first roles are full targets, the remaining ones only hint at limb bend directions
+	FPose* TargetPoses[] = { &OutTargets.Pelvis, &OutTargets.Chest, &OutTargets.Feet[0], &OutTargets.Feet[1] };
+	FVec3* HintPositions[] = { &OutTargets.Knees[0], &OutTargets.Knees[1], &OutTargets.Elbows[0], &OutTargets.Elbows[1] };
+	constexpr int32 NumTargetPoses = UE_ARRAY_COUNT(TargetPoses);
+
+	for (int32 i = 0; i < NumBodyRoles; i++)
+	{
+		// Trackers that never reported a pose stay invalid
+		if (!Samples[i].HasValidPose() || Samples[i].Time == 0)
+			continue;
+
+		FPose Pose = ToCorePose(Calibration ? Calibration->GetTrackerToBone(BodyRoles[i]) * Samples[i].Transform : Samples[i].Transform);
+		if (!Calibration && BodyRoles[i] == ETrackerRole::Waist)
+		{
+			// The default skeleton's axes are Unreal's tracking space, as MakeSkeleton sets them
+			Pose = MakeUprightPelvis(FBodySkeleton(), Pose);
+		}
+
+		if (i < NumTargetPoses)
+		{
+			*TargetPoses[i] = Pose;
+		}
+		else
+		{
+			*HintPositions[i - NumTargetPoses] = Pose.Position;
+		}
+
+		OutTargets.ValidMask |= BodyTargets[i];
+	}
+}
+
+TArrayView<const ETrackerRole> FViveTrackerBodyIK::GetBodyTrackerRoles()
+{
+	static const ETrackerRole BodyTrackerRoles[] = { ETrackerRole::Waist, ETrackerRole::Chest, ETrackerRole::Foot_L, ETrackerRole::Foot_R,
+		ETrackerRole::Knee_L, ETrackerRole::Knee_R, ETrackerRole::Elbow_L, ETrackerRole::Elbow_R, ETrackerRole::Shoulder_L, ETrackerRole::Shoulder_R };
+	static_assert(UE_ARRAY_COUNT(BodyTrackerRoles) == (int32)EBodyTracker::Count, "A tracker role is needed for every body tracker");
+
+	return MakeArrayView(BodyTrackerRoles, UE_ARRAY_COUNT(BodyTrackerRoles));
+}
+
+void FViveTrackerBodyIK::ToBodyPose(const FBodyPose& Pose, FViveTrackerBodyPose& OutPose)
+{
+	OutPose.Pelvis = ToTransform(Pose.Bones[(int)EBodyBone::Pelvis]);
+	OutPose.Chest = ToTransform(Pose.Bones[(int)EBodyBone::Chest]);
+	OutPose.Head = ToTransform(Pose.Bones[(int)EBodyBone::Head]);
+	OutPose.UpperArm_L = ToTransform(Pose.Bones[(int)EBodyBone::UpperArm_L]);
+	OutPose.LowerArm_L = ToTransform(Pose.Bones[(int)EBodyBone::LowerArm_L]);
+	OutPose.Hand_L = ToTransform(Pose.Bones[(int)EBodyBone::Hand_L]);
+	OutPose.UpperArm_R = ToTransform(Pose.Bones[(int)EBodyBone::UpperArm_R]);
+	OutPose.LowerArm_R = ToTransform(Pose.Bones[(int)EBodyBone::LowerArm_R]);
+	OutPose.Hand_R = ToTransform(Pose.Bones[(int)EBodyBone::Hand_R]);
+	OutPose.Thigh_L = ToTransform(Pose.Bones[(int)EBodyBone::Thigh_L]);
+	OutPose.Calf_L = ToTransform(Pose.Bones[(int)EBodyBone::Calf_L]);
+	OutPose.Foot_L = ToTransform(Pose.Bones[(int)EBodyBone::Foot_L]);
+	OutPose.Thigh_R = ToTransform(Pose.Bones[(int)EBodyBone::Thigh_R]);
+	OutPose.Calf_R = ToTransform(Pose.Bones[(int)EBodyBone::Calf_R]);
+	OutPose.Foot_R = ToTransform(Pose.Bones[(int)EBodyBone::Foot_R]);
+}
+
+void FViveTrackerBodyIKBatch::SetNum(int32 NumAvatars)
+{
+	const int32 OldNum = Num();
+
+	m_arrHeads.SetNum(NumAvatars);
+	m_arrPelvis.SetNum(NumAvatars);
+	m_arrChests.SetNum(NumAvatars);
+	for (int32 Side = 0; Side < 2; Side++)
+	{
+		m_arrHands[Side].SetNum(NumAvatars);
+		m_arrFeet[Side].SetNum(NumAvatars);
+		m_arrElbows[Side].SetNum(NumAvatars);
+		m_arrKnees[Side].SetNum(NumAvatars);
+	}
+	m_arrPoses.SetNum(NumAvatars);
+
+	m_arrValidMasks.SetNum(NumAvatars);
+	for (int32 Avatar = OldNum; Avatar < NumAvatars; Avatar++)
+	{
+		m_arrValidMasks[Avatar] = 0;
+	}
+
+	if (m_arrSkeletons.Num() > 0)
+	{
+		m_arrSkeletons.SetNum(NumAvatars);
+		for (int32 Avatar = OldNum; Avatar < NumAvatars; Avatar++)
+		{
+			m_arrSkeletons[Avatar] = m_sharedSkeleton;
+		}
+	}
+}
+
+void FViveTrackerBodyIKBatch::SetSharedSkeleton(const FViveTrackerBodyIKSettings& Settings)
+{
+	FViveTrackerBodyIK::MakeSkeleton(Settings, m_sharedSkeleton);
+}
+
+void FViveTrackerBodyIKBatch::SetAvatarSkeleton(int32 Avatar, const FViveTrackerBodyIKSettings& Settings)
+{
+	// The first avatar with its own proportions switches the batch to one skeleton per avatar
+	if (m_arrSkeletons.Num() == 0)
+	{
+		m_arrSkeletons.Init(m_sharedSkeleton, Num());
+	}
+
+	FViveTrackerBodyIK::MakeSkeleton(Settings, m_arrSkeletons[Avatar]);
+}
+
+void FViveTrackerBodyIKBatch::SetTargets(int32 Avatar, const FBodyTargets& Targets)
+{
+	m_arrHeads[Avatar] = Targets.Head;
+	m_arrPelvis[Avatar] = Targets.Pelvis;
+	m_arrChests[Avatar] = Targets.Chest;
+	for (int32 Side = 0; Side < 2; Side++)
+	{
+		m_arrHands[Side][Avatar] = Targets.Hands[Side];
+		m_arrFeet[Side][Avatar] = Targets.Feet[Side];
+		m_arrElbows[Side][Avatar] = Targets.Elbows[Side];
+		m_arrKnees[Side][Avatar] = Targets.Knees[Side];
+	}
+	m_arrValidMasks[Avatar] = Targets.ValidMask;
+}
+
+void FViveTrackerBodyIKBatch::ResetTargets(int32 Avatar)
+{
+	m_arrValidMasks[Avatar] = 0;
+}
+
+void FViveTrackerBodyIKBatch::SetHeadAndHands(int32 Avatar, const FTransform& Head, const FTransform* LeftHand, const FTransform* RightHand)
+{
+	uint32& ValidMask = m_arrValidMasks[Avatar];
+	ValidMask &= ~(Target_Head | Target_Hand_L | Target_Hand_R);
+
+	m_arrHeads[Avatar] = FViveTrackerBodyIK::ToCorePose(Head);
+	ValidMask |= Target_Head;
+
+	if (LeftHand)
+	{
+		m_arrHands[0][Avatar] = FViveTrackerBodyIK::ToCorePose(*LeftHand);
+		ValidMask |= Target_Hand_L;
+	}
+
+	if (RightHand)
+	{
+		m_arrHands[1][Avatar] = FViveTrackerBodyIK::ToCorePose(*RightHand);
+		ValidMask |= Target_Hand_R;
+	}
+}
+
+bool FViveTrackerBodyIKBatch::SetTrackerTarget(int32 Avatar, ETrackerRole TrackerRole, const FTransform& Transform)
+{
+	const FPose Pose = FViveTrackerBodyIK::ToCorePose(Transform);
+	uint32& ValidMask = m_arrValidMasks[Avatar];
+
+	switch (TrackerRole)
+	{
+	case ETrackerRole::Waist:
+		m_arrPelvis[Avatar] = MakeUprightPelvis(m_arrSkeletons.Num() > 0 ? m_arrSkeletons[Avatar] : m_sharedSkeleton, Pose);
+		ValidMask |= Target_Pelvis;
+		return true;
+	case ETrackerRole::Chest:
+		m_arrChests[Avatar] = Pose;
+		ValidMask |= Target_Chest;
+		return true;
+	case ETrackerRole::Foot_L:
+	case ETrackerRole::Foot_R:
+		m_arrFeet[TrackerRole == ETrackerRole::Foot_L ? 0 : 1][Avatar] = Pose;
+		ValidMask |= TrackerRole == ETrackerRole::Foot_L ? Target_Foot_L : Target_Foot_R;
+		return true;
+	case ETrackerRole::Elbow_L:
+	case ETrackerRole::Elbow_R:
+		m_arrElbows[TrackerRole == ETrackerRole::Elbow_L ? 0 : 1][Avatar] = Pose.Position;
+		ValidMask |= TrackerRole == ETrackerRole::Elbow_L ? Target_Elbow_L : Target_Elbow_R;
+		return true;
+	case ETrackerRole::Knee_L:
+	case ETrackerRole::Knee_R:
+		m_arrKnees[TrackerRole == ETrackerRole::Knee_L ? 0 : 1][Avatar] = Pose.Position;
+		ValidMask |= TrackerRole == ETrackerRole::Knee_L ? Target_Knee_L : Target_Knee_R;
+		return true;
+	default:
+		return false;
+	}
+}
+
+void FViveTrackerBodyIKBatch::Solve(bool bParallel)
+{
+	FBodyBatch Batch;
+	Batch.Count = Num();
+	Batch.Skeletons = m_arrSkeletons.Num() > 0 ? m_arrSkeletons.GetData() : &m_sharedSkeleton;
+	Batch.bPerBodySkeletons = m_arrSkeletons.Num() > 0;
+	Batch.Heads = m_arrHeads.GetData();
+	Batch.Pelvis = m_arrPelvis.GetData();
+	Batch.Chests = m_arrChests.GetData();
+	for (int32 Side = 0; Side < 2; Side++)
+	{
+		Batch.Hands[Side] = m_arrHands[Side].GetData();
+		Batch.Feet[Side] = m_arrFeet[Side].GetData();
+		Batch.Elbows[Side] = m_arrElbows[Side].GetData();
+		Batch.Knees[Side] = m_arrKnees[Side].GetData();
+	}
+	Batch.ValidMasks = m_arrValidMasks.GetData();
+	Batch.Poses = m_arrPoses.GetData();
+
+	const int32 NumTasks = FMath::DivideAndRoundUp(Batch.Count, AvatarsPerTask);
+	ParallelFor(NumTasks, [&Batch](int32 Task)
+	{
+		SolveBodies(Batch, Task * AvatarsPerTask, (Task + 1) * AvatarsPerTask);
+	}, !bParallel || NumTasks < 2);
+}
+
+/** Time the batched solver on synthetic avatars, from 1 to 256 of them */
+static void BenchmarkBodyIKBatch(const TArray<FString>& Args)
+{
+	const int32 MaxAvatars = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 1, 4096) : 256;
+	constexpr int32 NumIterations = 200;
+
+	FViveTrackerBodyIKBatch Batch;
+	Batch.SetSharedSkeleton(FViveTrackerBodyIKSettings());
+
+	for (int32 NumAvatars = 1; NumAvatars <= MaxAvatars; NumAvatars *= 2)
+	{
+		// Avatars standing in a grid with their arms out and one foot raised
+		Batch.SetNum(NumAvatars);
+		for (int32 Avatar = 0; Avatar < NumAvatars; Avatar++)
+		{
+			const FVector Origin(200.f * (Avatar % 16), 200.f * (Avatar / 16), 0.f);
+			const FTransform LeftHand(Origin + FVector(20.f, -60.f, 130.f));
+			const FTransform RightHand(Origin + FVector(20.f, 60.f, 130.f));
+
+			Batch.ResetTargets(Avatar);
+			Batch.SetHeadAndHands(Avatar, FTransform(Origin + FVector(0.f, 0.f, 165.f)), &LeftHand, &RightHand);
+			Batch.SetTrackerTarget(Avatar, ETrackerRole::Waist, FTransform(Origin + FVector(0.f, 0.f, 95.f)));
+			Batch.SetTrackerTarget(Avatar, ETrackerRole::Foot_L, FTransform(Origin + FVector(0.f, -10.f, 8.f)));
+			Batch.SetTrackerTarget(Avatar, ETrackerRole::Foot_R, FTransform(Origin + FVector(30.f, 10.f, 30.f)));
+		}
+
+		double Seconds[2];
+		for (int32 Parallel = 0; Parallel < 2; Parallel++)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+			{
+				Batch.Solve(Parallel == 1);
+			}
+			Seconds[Parallel] = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) / NumIterations;
+		}
+
+		UE_LOG(LogOpenXRViveTracker, Display, TEXT("Body IK batch of %3i avatars: %8.2f us single threaded, %8.2f us on task graph workers, %6.3f us per avatar"),
+			NumAvatars, Seconds[0] * 1.0e6, Seconds[1] * 1.0e6, Seconds[1] * 1.0e6 / NumAvatars);
+	}
+}
+
+static FAutoConsoleCommand BenchmarkBodyIKBatchCommand(
+	TEXT("vivetracker.BenchmarkIK"),
+	TEXT("Time the batched full-body IK solver for 1 up to N avatars (default 256), single threaded and on task graph workers"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkBodyIKBatch));
@@ -0,0 +1,141 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerCalibration.h"
+#include "Kismet/GameplayStatics.h"
+
+using namespace ViveTrackerCore;
+
+void UViveTrackerCalibrator::BeginCapture()
+{
+	m_calibrator.Reset();
+	m_dCaptureStartTime = FPlatformTime::Seconds();
+}
+
+bool UViveTrackerCalibrator::AddFrame(const FTransform& HeadTransform, const FTransform& LeftHandTransform, bool bLeftHandTracked,
+	const FTransform& RightHandTransform, bool bRightHandTracked)
+{
+	// Without a start time the capture window would be full on the first frame
+	if (!ensureMsgf(m_dCaptureStartTime > 0.0, TEXT("UViveTrackerCalibrator::AddFrame called before BeginCapture")))
+		return false;
+
+	const TArrayView<const ETrackerRole> Roles = FViveTrackerBodyIK::GetBodyTrackerRoles();
+	constexpr int32 NumRoles = (int32)EBodyTracker::Count;
+
+	// Every body role in one batch
+	FViveTrackerSample Samples[NumRoles];
+	FOpenXRViveTrackerModule::Get().GetTrackerSamples(Roles, MakeArrayView(Samples, NumRoles));
+
+	FCalibrationFrame Frame;
+	Frame.Head = FViveTrackerBodyIK::ToCorePose(HeadTransform);
+	Frame.bHeadValid = HeadTransform.IsValid();
+	Frame.Hands[0] = FViveTrackerBodyIK::ToCorePose(LeftHandTransform);
+	Frame.Hands[1] = FViveTrackerBodyIK::ToCorePose(RightHandTransform);
+	Frame.bHandsValid[0] = bLeftHandTracked;
+	Frame.bHandsValid[1] = bRightHandTracked;
+
+	for (int32 i = 0; i < NumRoles; i++)
+	{
+		// Inferred poses would bias the average, only fully tracked samples are used
+		if (!Samples[i].HasValidPose() || Samples[i].Time == 0 || !(Samples[i].LocationFlags & XR_SPACE_LOCATION_POSITION_TRACKED_BIT))
+			continue;
+
+		Frame.Trackers[i] = FViveTrackerBodyIK::ToCorePose(Samples[i].Transform);
+		Frame.ValidMask |= 1u << i;
+	}
+
+	m_calibrator.AddFrame(Frame);
+	return FPlatformTime::Seconds() - m_dCaptureStartTime >= CaptureDuration;
+}
+
+bool UViveTrackerCalibrator::Solve(const FViveTrackerBodyIKSettings& Settings, FViveTrackerCalibration& OutCalibration) const
+{
+	FBodySkeleton Skeleton;
+	FViveTrackerBodyIK::MakeSkeleton(Settings, Skeleton);
+
+	FCalibrationResult Result;
+	const bool bSolved = m_calibrator.Solve(Skeleton, MaxMotion, Result);
+
+	OutCalibration = FViveTrackerCalibration();
+	OutCalibration.Proportions = Settings;
+	OutCalibration.TrackerToBone.Init(FTransform::Identity, ETrackerRole::Unassigned);
+
+	if (!bSolved)
+	{
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Calibration failed after %i frames, largest tracker motion was %f cm"), m_calibrator.GetNumFrames(), Result.MaxMotion);
+		return false;
+	}
+
+	OutCalibration.Proportions.SpineLength = Result.Skeleton.SpineLength;
+	OutCalibration.Proportions.NeckLength = Result.Skeleton.NeckLength;
+	OutCalibration.Proportions.ShoulderHalfWidth = Result.Skeleton.ShoulderHalfWidth;
+	OutCalibration.Proportions.UpperArmLength = Result.Skeleton.UpperArmLength;
+	OutCalibration.Proportions.LowerArmLength = Result.Skeleton.LowerArmLength;
+	OutCalibration.Proportions.HipHalfWidth = Result.Skeleton.HipHalfWidth;
+	OutCalibration.Proportions.ThighLength = Result.Skeleton.ThighLength;
+	OutCalibration.Proportions.ShinLength = Result.Skeleton.ShinLength;
+
+	for (int32 i = 0; i < (int32)EBodyTracker::Count; i++)
+	{
+		if (Result.CalibratedMask & (1u << i))
+		{
+			OutCalibration.TrackerToBone[FViveTrackerBodyIK::GetBodyTrackerRoles()[i]] = FViveTrackerBodyIK::ToTransform(Result.TrackerToBone[i]);
+		}
+	}
+
+	OutCalibration.Height = Result.Height;
+	OutCalibration.ResidualError = Result.ResidualRMS;
+	OutCalibration.bIsValid = true;
+
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Calibrated %i frames, height %f cm, residual %f cm"), m_calibrator.GetNumFrames(), Result.Height, Result.ResidualRMS);
+	return true;
+}
+
+bool UViveTrackerCalibrator::SaveCalibration(const FViveTrackerCalibration& Calibration, const FString& SlotName, int32 UserIndex)
+{
+	UViveTrackerCalibrationSaveGame* SaveGame = Cast<UViveTrackerCalibrationSaveGame>(UGameplayStatics::CreateSaveGameObject(UViveTrackerCalibrationSaveGame::StaticClass()));
+	if (!SaveGame)
+		return false;
+
+	SaveGame->Calibration = Calibration;
+	return UGameplayStatics::SaveGameToSlot(SaveGame, SlotName, UserIndex);
+}
+
+bool UViveTrackerCalibrator::LoadCalibration(const FString& SlotName, int32 UserIndex, FViveTrackerCalibration& OutCalibration)
+{
+	if (!UGameplayStatics::DoesSaveGameExist(SlotName, UserIndex))
+		return false;
+
+	const UViveTrackerCalibrationSaveGame* SaveGame = Cast<UViveTrackerCalibrationSaveGame>(UGameplayStatics::LoadGameFromSlot(SlotName, UserIndex));
+	if (!SaveGame)
+		return false;
+
+	OutCalibration = SaveGame->Calibration;
+	return true;
+}
@@ -0,0 +1,1110 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerCapture.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/StableSort.h"
+
+using namespace ViveTrackerCore;
+
+static_assert(PLATFORM_LITTLE_ENDIAN, "Captures are little-endian");
+
+static constexpr uint64 CaptureAlignment = 8;
+
+static uint64 AlignCaptureSize(uint64 nSize)
+{
+	return (nSize + CaptureAlignment - 1) & ~(CaptureAlignment - 1);
+}
+
+FCaptureSample FViveTrackerCaptureWriter::ToCaptureSample(ETrackerRole Role, uint16 TrackerId, const FViveTrackerSample& Sample)
+{
+	const FVector Location = Sample.Transform.GetLocation();
+	const FQuat Rotation = Sample.Transform.GetRotation();
+
+	FCaptureSample CaptureSample{};
+	CaptureSample.Time = Sample.Time;
+	CaptureSample.PlatformTimeNs = Sample.PlatformTimeNs;
+	CaptureSample.Position[0] = (float)Location.X;
+	CaptureSample.Position[1] = (float)Location.Y;
+	CaptureSample.Position[2] = (float)Location.Z;
+	CaptureSample.Rotation[0] = (float)Rotation.X;
+	CaptureSample.Rotation[1] = (float)Rotation.Y;
+	CaptureSample.Rotation[2] = (float)Rotation.Z;
+	CaptureSample.Rotation[3] = (float)Rotation.W;
+	CaptureSample.LinearVelocity[0] = (float)Sample.LinearVelocity.X;
+	CaptureSample.LinearVelocity[1] = (float)Sample.LinearVelocity.Y;
+	CaptureSample.LinearVelocity[2] = (float)Sample.LinearVelocity.Z;
+	CaptureSample.AngularVelocity[0] = (float)Sample.AngularVelocity.X;
+	CaptureSample.AngularVelocity[1] = (float)Sample.AngularVelocity.Y;
+	CaptureSample.AngularVelocity[2] = (float)Sample.AngularVelocity.Z;
+	CaptureSample.TrackerId = TrackerId;
+	CaptureSample.Role = (uint8)Role;
+	CaptureSample.LocationFlags = (uint8)Sample.LocationFlags;
+	CaptureSample.VelocityFlags = (uint8)Sample.VelocityFlags;
+	return CaptureSample;
+}
+
+FViveTrackerCaptureWriter::FViveTrackerCaptureWriter()
+{
+	m_pWakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+}
+
+FViveTrackerCaptureWriter::~FViveTrackerCaptureWriter()
+{
+	Close();
+	FPlatformProcess::ReturnSynchEventToPool(m_pWakeEvent);
+}
+
+bool FViveTrackerCaptureWriter::Open(const FString& Filename, XrTime StartTime, int64 StartPlatformTimeNs, const FCaptureCodecSettings* pCodecSettings, int32 QueueCapacity)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+	m_pFile = PlatformFile.OpenWrite(*Filename);
+	if (m_pFile == nullptr)
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to create tracker capture file %s"), *Filename);
+		return false;
+	}
+
+	FCaptureHeader Header{};
+	FMemory::Memcpy(Header.Magic, CaptureMagic, sizeof(Header.Magic));
+	Header.Version = CaptureVersion;
+	Header.HeaderSize = sizeof(FCaptureHeader);
+	Header.StartTime = StartTime;
+	Header.StartPlatformTimeNs = StartPlatformTimeNs;
+
+	// Everything either side needs is allocated here, so neither allocates per sample
+	m_mapTrackerIds.Reset();
+	m_arrTrackers.Reset();
+	m_arrRoleTrackers.Init(CaptureNoTracker, (int32)ETrackerRole::Unassigned + 1);
+	m_nSamples = 0;
+	m_nDroppedSamples = 0;
+	m_nUnrecordedDrops = 0;
+	m_nLastSampleTime = StartTime;
+	m_nLastSamplePlatformTime = StartPlatformTimeNs;
+	m_bFallingBehind = false;
+
+	m_nSamplesPerChunk = pCodecSettings ? CompressedSamplesPerChunk : SamplesPerChunk;
+	m_sampleQueue.Reset((uint32)FMath::Max(QueueCapacity, (int32)m_nSamplesPerChunk));
+	m_eventQueue.Reset(EventQueueCapacity);
+	m_arrPendingTrackers.Reset();
+
+	m_sFilename = Filename;
+	m_nOffset = 0;
+	m_bWriteFailed = false;
+	m_nWrittenBytes = 0;
+	m_arrChunks.Reset();
+	m_arrStagedSamples.SetNumUninitialized(m_nSamplesPerChunk);
+	m_nStagedSamples = 0;
+	m_arrStagedEvents.Reset(EventQueueCapacity);
+	m_arrLatestSamples.Reset();
+	m_arrLatestPoses.Reset();
+	m_nLastKeyframeTime = 0;
+	m_bHasKeyframeState = false;
+
+	int64 nMaxChunkSize = m_nSamplesPerChunk * sizeof(FCaptureSample);
+	if (pCodecSettings)
+	{
+		m_pEncoder = MakeUnique<FCaptureEncoder>(*pCodecSettings);
+		m_arrEncodedSamples.SetNumUninitialized((int32)(sizeof(FCaptureCompressedSamples) + FCaptureEncoder::GetMaxEncodedSize(m_nSamplesPerChunk)));
+		nMaxChunkSize = m_arrEncodedSamples.Num();
+	}
+	else
+	{
+		m_pEncoder.Reset();
+		m_arrEncodedSamples.Empty();
+	}
+	m_arrWriteBuffer.Reset(WriteBufferSize + nMaxChunkSize + CaptureAlignment + sizeof(FCaptureChunkHeader));
+
+	m_arrWriteBuffer.Append(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	FlushWriteBuffer();
+
+	if (m_bWriteFailed)
+	{
+		delete m_pFile;
+		m_pFile = nullptr;
+		return false;
+	}
+
+	m_nLastFlushCycles = FPlatformTime::Cycles64();
+	m_bStopping = false;
+	m_pThread = FRunnableThread::Create(this, TEXT("ViveTrackerCaptureWriter"), 0, TPri_BelowNormal);
+	return true;
+}
+
+void FViveTrackerCaptureWriter::Close()
+{
+	if (m_pFile == nullptr)
+		return;
+
+	Update();
+
+	if (m_pThread)
+	{
+		m_bStopping = true;
+		m_pWakeEvent->Trigger();
+		m_pThread->WaitForCompletion();
+		delete m_pThread;
+		m_pThread = nullptr;
+	}
+	else
+	{
+		// Platforms without threads write everything here
+		Drain(true);
+	}
+
+	// The directory lists every chunk before it, the trailer lets readers find it from the end of the file
+	const uint64 nDirectoryOffset = m_nOffset + m_arrWriteBuffer.Num();
+	const int32 nChunks = m_arrChunks.Num();
+	AppendChunk(CaptureChunk_Directory, nChunks, m_arrChunks.GetData(), nChunks * sizeof(FCaptureChunkInfo), 0, 0);
+
+	FCaptureTrailer Trailer{};
+	Trailer.DirectoryOffset = nDirectoryOffset;
+	Trailer.Magic = CaptureTrailerMagic;
+	m_arrWriteBuffer.Append(reinterpret_cast<const uint8*>(&Trailer), sizeof(Trailer));
+	FlushWriteBuffer();
+
+	delete m_pFile;
+	m_pFile = nullptr;
+}
+
+uint16 FViveTrackerCaptureWriter::FindOrAddTracker(const FString& PersistentPath, ETrackerRole Role)
+{
+	int32 nTracker = INDEX_NONE;
+	if (PersistentPath.IsEmpty())
+	{
+		// Trackers located before the runtime reported their path are captured per role
+		nTracker = m_arrTrackers.IndexOfByPredicate([Role](const FViveTrackerCaptureTracker& Tracker)
+			{
+				return Tracker.PersistentPath.IsEmpty() && Tracker.Role == Role;
+			});
+	}
+	else if (const uint16* pTrackerId = m_mapTrackerIds.Find(PersistentPath))
+	{
+		nTracker = *pTrackerId;
+	}
+
+	if (nTracker == INDEX_NONE)
+	{
+		if (m_arrTrackers.Num() >= CaptureNoTracker)
+			return CaptureNoTracker;
+
+		nTracker = m_arrTrackers.Add({ PersistentPath, Role });
+		if (!PersistentPath.IsEmpty())
+		{
+			m_mapTrackerIds.Add(PersistentPath, (uint16)nTracker);
+		}
+	}
+	else if (m_arrTrackers[nTracker].Role != Role)
+	{
+		m_arrTrackers[nTracker].Role = Role;
+	}
+	else
+	{
+		return (uint16)nTracker;
+	}
+
+	FScopeLock trackerLock(&m_trackerLock);
+	m_arrPendingTrackers.Add({ (uint16)nTracker, m_arrTrackers[nTracker] });
+	return (uint16)nTracker;
+}
+
+void FViveTrackerCaptureWriter::SetTrackerPaths(const TMap<FString, ETrackerRole>& PersistentPathRoles)
+{
+	if (m_pFile == nullptr)
+		return;
+
+	for (uint16& nTrackerId : m_arrRoleTrackers)
+	{
+		nTrackerId = CaptureNoTracker;
+	}
+
+	for (const TPair<FString, ETrackerRole>& pathRole : PersistentPathRoles)
+	{
+		const uint16 nTrackerId = FindOrAddTracker(pathRole.Key, pathRole.Value);
+		if (pathRole.Value != ETrackerRole::Unassigned)
+		{
+			m_arrRoleTrackers[(int32)pathRole.Value] = nTrackerId;
+		}
+	}
+}
+
+void FViveTrackerCaptureWriter::AddSample(ETrackerRole Role, const FViveTrackerSample& Sample)
+{
+	if (m_pFile == nullptr || !m_arrRoleTrackers.IsValidIndex((int32)Role))
+		return;
+
+	uint16& nTrackerId = m_arrRoleTrackers[(int32)Role];
+	if (nTrackerId == CaptureNoTracker)
+	{
+		nTrackerId = FindOrAddTracker(FString(), Role);
+	}
+
+	m_nSamples++;
+	m_nLastSampleTime = Sample.Time;
+	m_nLastSamplePlatformTime = Sample.PlatformTimeNs;
+
+	if (!m_sampleQueue.Push(ToCaptureSample(Role, nTrackerId, Sample)))
+	{
+		m_nDroppedSamples++;
+		m_nUnrecordedDrops++;
+	}
+}
+
+void FViveTrackerCaptureWriter::AddEvent(ECaptureEvent Type, const FString& PersistentPath, ETrackerRole Role, XrTime Time, int64 PlatformTimeNs)
+{
+	if (m_pFile == nullptr)
+		return;
+
+	FCaptureEvent Event{};
+	Event.Time = Time;
+	Event.PlatformTimeNs = PlatformTimeNs;
+	Event.TrackerId = PersistentPath.IsEmpty() ? CaptureNoTracker : FindOrAddTracker(PersistentPath, Role);
+	Event.Type = Type;
+	Event.Role = (uint8)Role;
+	PushEvent(Event);
+}
+
+void FViveTrackerCaptureWriter::PushEvent(const FCaptureEvent& Event)
+{
+	// Events are rare, a full ring means the writer thread is stuck
+	if (!m_eventQueue.Push(Event))
+	{
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Tracker capture event queue is full, event dropped"));
+	}
+}
+
+void FViveTrackerCaptureWriter::Update()
+{
+	if (m_pFile == nullptr)
+		return;
+
+	if (m_nUnrecordedDrops > 0)
+	{
+		FCaptureEvent Event{};
+		Event.Time = m_nLastSampleTime;
+		Event.PlatformTimeNs = m_nLastSamplePlatformTime;
+		Event.TrackerId = CaptureNoTracker;
+		Event.Type = ECaptureEvent::SamplesDropped;
+		Event.Role = (uint8)ETrackerRole::Unassigned;
+		Event.Value = (uint32)FMath::Min<int64>(m_nUnrecordedDrops, MAX_uint32);
+
+		if (m_eventQueue.Push(Event))
+		{
+			m_nUnrecordedDrops = 0;
+		}
+	}
+
+	const uint32 nQueued = m_sampleQueue.Num();
+	if (!m_bFallingBehind && nQueued > m_sampleQueue.GetCapacity() / 4 * 3)
+	{
+		m_bFallingBehind = true;
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Tracker capture to %s is falling behind, %u samples queued, %lld dropped so far"),
+			*m_sFilename, nQueued, m_nDroppedSamples);
+	}
+	else if (m_bFallingBehind && nQueued < m_sampleQueue.GetCapacity() / 2)
+	{
+		m_bFallingBehind = false;
+	}
+
+	// Compressed chunks are larger, waking the writer any earlier only has it go back to sleep without a whole chunk
+	if (nQueued >= m_nSamplesPerChunk)
+	{
+		m_pWakeEvent->Trigger();
+	}
+}
+
+uint32 FViveTrackerCaptureWriter::Run()
+{
+	// Wakes up by itself often enough to honor FlushInterval when samples trickle in
+	constexpr uint32 WaitMs = 100;
+
+	while (!m_bStopping)
+	{
+		m_pWakeEvent->Wait(WaitMs);
+		Drain(false);
+	}
+
+	Drain(true);
+	return 0;
+}
+
+void FViveTrackerCaptureWriter::Drain(bool bFinal)
+{
+	TArray<FPendingTracker> arrTrackers;
+	{
+		FScopeLock trackerLock(&m_trackerLock);
+		Swap(arrTrackers, m_arrPendingTrackers);
+	}
+	AppendTrackers(arrTrackers);
+
+	FCaptureEvent arrEvents[64];
+	while (const uint32 nEvents = m_eventQueue.Pop(arrEvents, UE_ARRAY_COUNT(arrEvents)))
+	{
+		m_arrStagedEvents.Append(arrEvents, nEvents);
+	}
+
+	// Whole chunks are written as soon as they are full, partial ones only when flushing
+	for (;;)
+	{
+		m_nStagedSamples += m_sampleQueue.Pop(m_arrStagedSamples.GetData() + m_nStagedSamples, m_nSamplesPerChunk - m_nStagedSamples);
+		if (m_nStagedSamples < m_nSamplesPerChunk)
+			break;
+
+		AppendSamples();
+	}
+
+	const bool bFlush = bFinal || FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - m_nLastFlushCycles) >= FlushInterval;
+	if (!bFlush)
+		return;
+
+	if (m_nStagedSamples > 0)
+	{
+		AppendSamples();
+	}
+
+	if (m_arrStagedEvents.Num() > 0)
+	{
+		AppendChunk(CaptureChunk_Events, m_arrStagedEvents.Num(), m_arrStagedEvents.GetData(), m_arrStagedEvents.Num() * sizeof(FCaptureEvent),
+			m_arrStagedEvents[0].Time, m_arrStagedEvents.Last().Time);
+		m_arrStagedEvents.Reset();
+	}
+
+	FlushWriteBuffer();
+	m_nLastFlushCycles = FPlatformTime::Cycles64();
+}
+
+void FViveTrackerCaptureWriter::AppendSamples()
+{
+	const XrTime nFirstTime = m_arrStagedSamples[0].Time;
+	const XrTime nLastTime = m_arrStagedSamples[m_nStagedSamples - 1].Time;
+
+	if (m_bHasKeyframeState && nFirstTime - m_nLastKeyframeTime >= (XrTime)(KeyframeInterval * 1.0e9))
+	{
+		AppendKeyframe(nFirstTime);
+	}
+
+	if (m_pEncoder)
+	{
+		FCaptureCompressedSamples Range{};
+		Range.FirstTime = nFirstTime;
+		Range.LastTime = nLastTime;
+		FMemory::Memcpy(m_arrEncodedSamples.GetData(), &Range, sizeof(Range));
+
+		const size_t nEncodedSize = m_pEncoder->Encode(m_arrStagedSamples.GetData(), m_nStagedSamples, m_arrEncodedSamples.GetData() + sizeof(Range));
+		AppendChunk(CaptureChunk_CompressedSamples, m_nStagedSamples, m_arrEncodedSamples.GetData(), sizeof(Range) + nEncodedSize, nFirstTime, nLastTime);
+	}
+	else
+	{
+		AppendChunk(CaptureChunk_Samples, m_nStagedSamples, m_arrStagedSamples.GetData(), m_nStagedSamples * sizeof(FCaptureSample), nFirstTime, nLastTime);
+	}
+
+	UpdateKeyframeState();
+	m_nStagedSamples = 0;
+}
+
+void FViveTrackerCaptureWriter::AppendKeyframe(XrTime Time)
+{
+	const int32 nTrackers = m_arrLatestSamples.Num();
+
+	FCaptureKeyframe Keyframe{};
+	Keyframe.Time = Time;
+
+	m_arrKeyframe.Reset();
+	m_arrKeyframe.Append(reinterpret_cast<const uint8*>(&Keyframe), sizeof(Keyframe));
+
+	// A tracker that lost tracking since its last pose needs both, replaying the pose restores it and the newer sample its flags
+	for (int32 nTracker = 0; nTracker < nTrackers; nTracker++)
+	{
+		const FCaptureSample& Pose = m_arrLatestPoses[nTracker];
+		const FCaptureSample& Latest = m_arrLatestSamples[nTracker];
+
+		if (Pose.TrackerId != CaptureNoTracker)
+		{
+			m_arrKeyframe.Append(reinterpret_cast<const uint8*>(&Pose), sizeof(FCaptureSample));
+		}
+		if (Latest.TrackerId != CaptureNoTracker && (Pose.TrackerId == CaptureNoTracker || Latest.Time > Pose.Time))
+		{
+			m_arrKeyframe.Append(reinterpret_cast<const uint8*>(&Latest), sizeof(FCaptureSample));
+		}
+	}
+
+	const int32 nSamples = (m_arrKeyframe.Num() - (int32)sizeof(Keyframe)) / (int32)sizeof(FCaptureSample);
+	TArrayView<FCaptureSample> arrSamples(reinterpret_cast<FCaptureSample*>(m_arrKeyframe.GetData() + sizeof(Keyframe)), nSamples);
+	Algo::StableSortBy(arrSamples, [](const FCaptureSample& Sample) { return Sample.Time; });
+
+	AppendChunk(CaptureChunk_Keyframe, nSamples, m_arrKeyframe.GetData(), m_arrKeyframe.Num(), Time, Time);
+	m_nLastKeyframeTime = Time;
+}
+
+void FViveTrackerCaptureWriter::UpdateKeyframeState()
+{
+	constexpr uint8 PoseValidFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+
+	for (uint32 nSample = 0; nSample < m_nStagedSamples; nSample++)
+	{
+		const FCaptureSample& Sample = m_arrStagedSamples[nSample];
+		while (Sample.TrackerId >= m_arrLatestSamples.Num())
+		{
+			FCaptureSample Empty{};
+			Empty.TrackerId = CaptureNoTracker;
+			m_arrLatestSamples.Add(Empty);
+			m_arrLatestPoses.Add(Empty);
+		}
+
+		m_arrLatestSamples[Sample.TrackerId] = Sample;
+		if ((Sample.LocationFlags & PoseValidFlags) == PoseValidFlags)
+		{
+			m_arrLatestPoses[Sample.TrackerId] = Sample;
+		}
+	}
+
+	m_bHasKeyframeState = true;
+}
+
+void FViveTrackerCaptureWriter::AppendTrackers(const TArray<FPendingTracker>& arrTrackers)
+{
+	if (arrTrackers.Num() == 0)
+		return;
+
+	TArray<uint8> arrRecords;
+	for (const FPendingTracker& PendingTracker : arrTrackers)
+	{
+		FTCHARToUTF8 PathUTF8(*PendingTracker.Tracker.PersistentPath);
+
+		FCaptureTrackerRecord Record{};
+		Record.TrackerId = PendingTracker.TrackerId;
+		Record.Role = (uint8)PendingTracker.Tracker.Role;
+		Record.PathLength = (uint32)PathUTF8.Length();
+
+		const int32 nRecordOffset = arrRecords.Num();
+		arrRecords.AddZeroed((int32)AlignCaptureSize(sizeof(Record) + Record.PathLength));
+		FMemory::Memcpy(arrRecords.GetData() + nRecordOffset, &Record, sizeof(Record));
+		FMemory::Memcpy(arrRecords.GetData() + nRecordOffset + sizeof(Record), PathUTF8.Get(), Record.PathLength);
+	}
+
+	AppendChunk(CaptureChunk_Trackers, arrTrackers.Num(), arrRecords.GetData(), arrRecords.Num(), 0, 0);
+}
+
+void FViveTrackerCaptureWriter::AppendChunk(uint32 Type, uint32 Count, const void* pData, int64 nSize, int64 nFirstTime, int64 nLastTime)
+{
+	static const uint8 Padding[CaptureAlignment] = {};
+
+	FCaptureChunkHeader ChunkHeader{};
+	ChunkHeader.Type = Type;
+	ChunkHeader.Count = Count;
+	ChunkHeader.Size = AlignCaptureSize(nSize);
+
+	FCaptureChunkInfo ChunkInfo{};
+	ChunkInfo.Offset = m_nOffset + m_arrWriteBuffer.Num();
+	ChunkInfo.Type = Type;
+	ChunkInfo.Count = Count;
+	ChunkInfo.FirstTime = nFirstTime;
+	ChunkInfo.LastTime = nLastTime;
+
+	m_arrWriteBuffer.Append(reinterpret_cast<const uint8*>(&ChunkHeader), sizeof(ChunkHeader));
+	m_arrWriteBuffer.Append(static_cast<const uint8*>(pData), (int32)nSize);
+	m_arrWriteBuffer.Append(Padding, (int32)(ChunkHeader.Size - nSize));
+
+	// Added after the copy, pData may point into m_arrChunks
+	m_arrChunks.Add(ChunkInfo);
+
+	if (m_arrWriteBuffer.Num() >= WriteBufferSize)
+	{
+		FlushWriteBuffer();
+	}
+}
+
+void FViveTrackerCaptureWriter::FlushWriteBuffer()
+{
+	if (m_arrWriteBuffer.Num() == 0)
+		return;
+
+	if (!m_bWriteFailed)
+	{
+		if (m_pFile->Write(m_arrWriteBuffer.GetData(), m_arrWriteBuffer.Num()))
+		{
+			m_nWrittenBytes += m_arrWriteBuffer.Num();
+		}
+		else
+		{
+			// Keep what was written so far readable, a capture without trailer is recovered by walking its chunks
+			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to write to tracker capture file %s, the rest of the capture is lost"), *m_sFilename);
+			m_bWriteFailed = true;
+		}
+	}
+
+	m_nOffset += m_arrWriteBuffer.Num();
+	m_arrWriteBuffer.Reset();
+}
+
+/** Queue synthetic samples of 30 trackers as fast as possible for a few seconds and report the rate the writer sustains */
+static void BenchmarkCaptureWriter(const TArray<FString>& Args)
+{
+	const double Duration = Args.Num() > 0 ? FMath::Clamp(FCString::Atod(*Args[0]), 0.1, 60.0) : 5.0;
+	constexpr int32 NumTrackers = 30;
+	constexpr int32 FramesPerUpdate = 16;
+	const FString sFilename = FPaths::ProjectSavedDir() / TEXT("ViveTracker") / TEXT("CaptureBenchmark.vtcap");
+
+	FViveTrackerCaptureWriter Writer;
+	if (!Writer.Open(sFilename, 0, 0))
+		return;
+
+	FViveTrackerSample Sample;
+	Sample.LocationFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+	Sample.VelocityFlags = XR_SPACE_VELOCITY_LINEAR_VALID_BIT | XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
+
+	// Samples 1ms apart, time advances as fast as they can be queued
+	int64 nFrame = 0;
+	uint64 nAddCycles = 0;
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	while (FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) < Duration)
+	{
+		const uint64 AddStartCycles = FPlatformTime::Cycles64();
+		for (int32 Frame = 0; Frame < FramesPerUpdate; Frame++, nFrame++)
+		{
+			Sample.Time = nFrame * 1000 * 1000;
+			Sample.PlatformTimeNs = Sample.Time;
+			for (int32 Tracker = 0; Tracker < NumTrackers; Tracker++)
+			{
+				Sample.Transform.SetLocation(FVector(10.f * Tracker, 50.f * FMath::Sin(0.01f * nFrame), 100.f));
+				Writer.AddSample((ETrackerRole)(Tracker % (int32)ETrackerRole::Unassigned), Sample);
+			}
+		}
+		nAddCycles += FPlatformTime::Cycles64() - AddStartCycles;
+
+		Writer.Update();
+	}
+
+	const double QueueSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	Writer.Close();
+	const double TotalSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	const int64 nWritten = Writer.GetNumSamples() - Writer.GetNumDroppedSamples();
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Capture writer: queued %lld samples in %.2fs at %.1f ns per sample, %lld dropped (%.2f%%)"),
+		Writer.GetNumSamples(), QueueSeconds, FPlatformTime::ToSeconds64(nAddCycles) * 1.0e9 / FMath::Max<int64>(Writer.GetNumSamples(), 1),
+		Writer.GetNumDroppedSamples(), 100.0 * Writer.GetNumDroppedSamples() / FMath::Max<int64>(Writer.GetNumSamples(), 1));
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Capture writer: sustained %.2f M samples/s, %.1f MB/s to %s"),
+		nWritten / TotalSeconds / 1.0e6, Writer.GetNumWrittenBytes() / TotalSeconds / (1024.0 * 1024.0), *sFilename);
+
+	FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*sFilename);
+}
+
+static FAutoConsoleCommand BenchmarkCaptureWriterCommand(
+	TEXT("vivetracker.BenchmarkCapture"),
+	TEXT("Queue samples of 30 trackers into a capture writer as fast as possible for N seconds (default 5) and report the sustained write rate and drops"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkCaptureWriter));
+
+/** Synthetic trajectories of 30 trackers sampled at 1kHz, smooth motion plus sensor noise around the size of the default error bounds */
+static void MakeSyntheticCaptureSamples(int32 NumFrames, TArray<FCaptureSample>& OutSamples)
+{
+	constexpr int32 NumTrackers = 30;
+	FRandomStream Random(0x5EED);
+	auto Noise = [&Random](float Scale) { return (Random.FRand() + Random.FRand() + Random.FRand() - 1.5f) * 2.f * Scale; };
+
+	OutSamples.Reset(NumFrames * NumTrackers);
+	for (int32 nFrame = 0; nFrame < NumFrames; nFrame++)
+	{
+		const float Time = nFrame * 0.001f;
+		for (int32 nTracker = 0; nTracker < NumTrackers; nTracker++)
+		{
+			FCaptureSample& Sample = OutSamples.AddZeroed_GetRef();
+			Sample.Time = (int64)nFrame * 1000 * 1000;
+			Sample.PlatformTimeNs = Sample.Time + 1000 * 1000 * 1000;
+			Sample.TrackerId = (uint16)nTracker;
+			Sample.Role = (uint8)(nTracker % (int32)ETrackerRole::Unassigned);
+			Sample.LocationFlags = 0xF;
+			Sample.VelocityFlags = 0x3;
+
+			const float Phase = nTracker * 0.7f;
+			for (int32 nAxis = 0; nAxis < 3; nAxis++)
+			{
+				const float Frequency = 2.f * PI * (0.3f + 0.2f * nAxis + 0.05f * nTracker);
+				Sample.Position[nAxis] = 30.f * FMath::Sin(Frequency * Time + Phase + nAxis) + 50.f * nAxis + Noise(0.003f);
+				Sample.LinearVelocity[nAxis] = 30.f * Frequency * FMath::Cos(Frequency * Time + Phase + nAxis) + Noise(0.05f);
+				Sample.AngularVelocity[nAxis] = 0.5f * FMath::Cos(Frequency * Time) + Noise(0.001f);
+			}
+
+			const FQuat Rotation = FQuat(FRotator(20.f * FMath::Sin(1.3f * Time + Phase), 90.f * FMath::Sin(0.4f * Time + Phase), 10.f * FMath::Cos(0.7f * Time)));
+			Sample.Rotation[0] = (float)Rotation.X + Noise(0.00002f);
+			Sample.Rotation[1] = (float)Rotation.Y + Noise(0.00002f);
+			Sample.Rotation[2] = (float)Rotation.Z + Noise(0.00002f);
+			Sample.Rotation[3] = (float)Rotation.W + Noise(0.00002f);
+		}
+	}
+}
+
+/** Encode samples in capture sized chunks, decode them a few times and log the ratio, throughput and largest errors */
+static void BenchmarkCodecOn(const TCHAR* Name, const TArray<FCaptureSample>& arrSamples)
+{
+	constexpr int32 DecodePasses = 10;
+	const int32 nChunkSamples = FViveTrackerCaptureWriter::CompressedSamplesPerChunk;
+	if (arrSamples.Num() == 0)
+		return;
+
+	FCaptureEncoder Encoder;
+	FCaptureDecoder Decoder;
+	TArray<uint8> arrChunk;
+	TArray<uint8> arrEncoded;
+	TArray<int32> arrChunkOffsets;
+	arrChunk.SetNumUninitialized((int32)FCaptureEncoder::GetMaxEncodedSize(nChunkSamples));
+	arrEncoded.Reserve(arrSamples.Num() * sizeof(FCaptureSample));
+
+	const uint64 EncodeStartCycles = FPlatformTime::Cycles64();
+	for (int32 nStart = 0; nStart < arrSamples.Num(); nStart += nChunkSamples)
+	{
+		const uint32 nCount = (uint32)FMath::Min(nChunkSamples, arrSamples.Num() - nStart);
+		arrChunkOffsets.Add(arrEncoded.Num());
+		arrEncoded.Append(arrChunk.GetData(), (int32)Encoder.Encode(arrSamples.GetData() + nStart, nCount, arrChunk.GetData()));
+	}
+	const double EncodeSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - EncodeStartCycles);
+	arrChunkOffsets.Add(arrEncoded.Num());
+
+	TArray<FCaptureSample> arrDecoded;
+	arrDecoded.SetNumUninitialized(arrSamples.Num());
+
+	const uint64 DecodeStartCycles = FPlatformTime::Cycles64();
+	bool bValid = true;
+	for (int32 nPass = 0; nPass < DecodePasses; nPass++)
+	{
+		for (int32 nChunk = 0; nChunk + 1 < arrChunkOffsets.Num(); nChunk++)
+		{
+			bValid &= Decoder.Decode(arrEncoded.GetData() + arrChunkOffsets[nChunk], arrChunkOffsets[nChunk + 1] - arrChunkOffsets[nChunk],
+				arrDecoded.GetData() + nChunk * nChunkSamples);
+		}
+	}
+	const double DecodeSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - DecodeStartCycles) / DecodePasses;
+
+	float MaxPositionError = 0.f, MaxRotationError = 0.f, MaxLinearVelocityError = 0.f, MaxAngularVelocityError = 0.f;
+	for (int32 nSample = 0; nSample < arrSamples.Num() && bValid; nSample++)
+	{
+		const FCaptureSample& Sample = arrSamples[nSample];
+		const FCaptureSample& Decoded = arrDecoded[nSample];
+		bValid = Sample.Time == Decoded.Time && Sample.PlatformTimeNs == Decoded.PlatformTimeNs && Sample.TrackerId == Decoded.TrackerId &&
+			Sample.Role == Decoded.Role && Sample.LocationFlags == Decoded.LocationFlags && Sample.VelocityFlags == Decoded.VelocityFlags;
+
+		for (int32 nAxis = 0; nAxis < 3; nAxis++)
+		{
+			MaxPositionError = FMath::Max(MaxPositionError, FMath::Abs(Sample.Position[nAxis] - Decoded.Position[nAxis]));
+			MaxLinearVelocityError = FMath::Max(MaxLinearVelocityError, FMath::Abs(Sample.LinearVelocity[nAxis] - Decoded.LinearVelocity[nAxis]));
+			MaxAngularVelocityError = FMath::Max(MaxAngularVelocityError, FMath::Abs(Sample.AngularVelocity[nAxis] - Decoded.AngularVelocity[nAxis]));
+		}
+		for (int32 nAxis = 0; nAxis < 4; nAxis++)
+		{
+			MaxRotationError = FMath::Max(MaxRotationError, FMath::Abs(Sample.Rotation[nAxis] - Decoded.Rotation[nAxis]));
+		}
+	}
+
+	const double RawBytes = (double)arrSamples.Num() * sizeof(FCaptureSample);
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Capture codec, %s: %d samples, %.2fx smaller (%.2f bytes per sample), encode %.2f GB/s, decode %.2f GB/s (%.1f M samples/s)"),
+		Name, arrSamples.Num(), RawBytes / FMath::Max(arrEncoded.Num(), 1), (double)arrEncoded.Num() / arrSamples.Num(),
+		RawBytes / EncodeSeconds / 1.0e9, RawBytes / DecodeSeconds / 1.0e9, arrSamples.Num() / DecodeSeconds / 1.0e6);
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Capture codec, %s: largest errors %g cm, %g, %g cm/s, %g rad/s%s"),
+		Name, MaxPositionError, MaxRotationError, MaxLinearVelocityError, MaxAngularVelocityError, bValid ? TEXT("") : TEXT(", DECODED SAMPLES DON'T MATCH"));
+}
+
+/** Benchmark the capture codec on synthetic trajectories and optionally on the samples of a recorded capture */
+static void BenchmarkCaptureCodec(const TArray<FString>& Args)
+{
+	TArray<FCaptureSample> arrSamples;
+	MakeSyntheticCaptureSamples(10 * 1000, arrSamples);
+	BenchmarkCodecOn(TEXT("synthetic"), arrSamples);
+
+	if (Args.Num() == 0)
+		return;
+
+	FViveTrackerCaptureReader Reader;
+	if (!Reader.Open(Args[0]))
+		return;
+
+	FViveTrackerCaptureDecodeBuffer Buffer;
+	arrSamples.Reset(Reader.GetNumSamples());
+	for (int32 nChunk = 0; nChunk < Reader.GetNumSampleChunks(); nChunk++)
+	{
+		const TArrayView<const FCaptureSample> arrChunk = Reader.GetSampleChunk(nChunk, Buffer);
+		arrSamples.Append(arrChunk.GetData(), arrChunk.Num());
+	}
+	BenchmarkCodecOn(*FPaths::GetCleanFilename(Args[0]), arrSamples);
+}
+
+static FAutoConsoleCommand BenchmarkCaptureCodecCommand(
+	TEXT("vivetracker.BenchmarkCodec"),
+	TEXT("Report the capture codec's compression ratio, encode and decode throughput and errors on synthetic trajectories of 30 trackers at 1kHz, and on the samples of a capture file if given"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkCaptureCodec));
+
+bool FViveTrackerCaptureReader::Open(const FString& Filename)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	m_pMappedFile = PlatformFile.OpenMapped(*Filename);
+	if (m_pMappedFile && m_pMappedFile->GetFileSize() > 0)
+	{
+		m_pMappedRegion = m_pMappedFile->MapRegion(0, m_pMappedFile->GetFileSize());
+	}
+
+	if (m_pMappedRegion)
+	{
+		m_pData = m_pMappedRegion->GetMappedPtr();
+		m_nSize = (uint64)m_pMappedRegion->GetMappedSize();
+	}
+	else
+	{
+		delete m_pMappedFile;
+		m_pMappedFile = nullptr;
+
+		if (!FFileHelper::LoadFileToArray(m_arrFileData, *Filename, FILEREAD_Silent))
+		{
+			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to open tracker capture file %s"), *Filename);
+			return false;
+		}
+
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Unable to map tracker capture file %s, reading it into memory instead"), *Filename);
+		m_pData = m_arrFileData.GetData();
+		m_nSize = (uint64)m_arrFileData.Num();
+	}
+
+	const FCaptureHeader* pHeader = reinterpret_cast<const FCaptureHeader*>(m_pData);
+	if (m_pData == nullptr || m_nSize < sizeof(FCaptureHeader) || FMemory::Memcmp(pHeader->Magic, CaptureMagic, sizeof(CaptureMagic)) != 0)
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("%s is not a tracker capture file"), *Filename);
+		Close();
+		return false;
+	}
+
+	if (pHeader->Version > CaptureVersion || pHeader->HeaderSize < sizeof(FCaptureHeader) || pHeader->HeaderSize > m_nSize || pHeader->HeaderSize % CaptureAlignment != 0)
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Tracker capture file %s has unsupported version %u"), *Filename, pHeader->Version);
+		Close();
+		return false;
+	}
+
+	if (!ReadDirectory())
+	{
+		WalkChunks();
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Tracker capture file %s wasn't closed, recovered %i chunks"), *Filename, m_arrChunks.Num());
+	}
+
+	if (!ReadChunks())
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Tracker capture file %s is corrupt"), *Filename);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void FViveTrackerCaptureReader::Close()
+{
+	delete m_pMappedRegion;
+	m_pMappedRegion = nullptr;
+	delete m_pMappedFile;
+	m_pMappedFile = nullptr;
+	m_arrFileData.Empty();
+
+	m_pData = nullptr;
+	m_nSize = 0;
+	m_bComplete = false;
+
+	m_arrChunks.Empty();
+	m_arrSampleChunks.Empty();
+	m_arrEvents.Empty();
+	m_arrKeyframes.Empty();
+	m_arrTrackers.Empty();
+	m_nSamples = 0;
+	m_nStartTime = 0;
+	m_nEndTime = 0;
+}
+
+const FCaptureChunkHeader* FViveTrackerCaptureReader::GetChunkHeader(uint64 nOffset) const
+{
+	if (nOffset % CaptureAlignment != 0 || nOffset < GetHeader().HeaderSize || nOffset > m_nSize || m_nSize - nOffset < sizeof(FCaptureChunkHeader))
+		return nullptr;
+
+	const FCaptureChunkHeader* pChunkHeader = reinterpret_cast<const FCaptureChunkHeader*>(m_pData + nOffset);
+	if (pChunkHeader->Size % CaptureAlignment != 0 || pChunkHeader->Size > m_nSize - nOffset - sizeof(FCaptureChunkHeader))
+		return nullptr;
+
+	return pChunkHeader;
+}
+
+bool FViveTrackerCaptureReader::ReadDirectory()
+{
+	if (m_nSize < GetHeader().HeaderSize + sizeof(FCaptureTrailer))
+		return false;
+
+	const FCaptureTrailer* pTrailer = reinterpret_cast<const FCaptureTrailer*>(m_pData + m_nSize - sizeof(FCaptureTrailer));
+	if (pTrailer->Magic != CaptureTrailerMagic)
+		return false;
+
+	const FCaptureChunkHeader* pDirectory = GetChunkHeader(pTrailer->DirectoryOffset);
+	if (pDirectory == nullptr || pDirectory->Type != CaptureChunk_Directory || pDirectory->Size < (uint64)pDirectory->Count * sizeof(FCaptureChunkInfo))
+		return false;
+
+	const FCaptureChunkInfo* pChunks = reinterpret_cast<const FCaptureChunkInfo*>(pDirectory + 1);
+	m_arrChunks.Append(pChunks, (int32)pDirectory->Count);
+	m_bComplete = true;
+	return true;
+}
+
+bool FViveTrackerCaptureReader::WalkChunks()
+{
+	m_arrChunks.Reset();
+
+	uint64 nOffset = GetHeader().HeaderSize;
+	while (const FCaptureChunkHeader* pChunkHeader = GetChunkHeader(nOffset))
+	{
+		FCaptureChunkInfo ChunkInfo{};
+		ChunkInfo.Offset = nOffset;
+		ChunkInfo.Type = pChunkHeader->Type;
+		ChunkInfo.Count = pChunkHeader->Count;
+
+		if (pChunkHeader->Type == CaptureChunk_Samples && pChunkHeader->Count > 0 && pChunkHeader->Size >= (uint64)pChunkHeader->Count * sizeof(FCaptureSample))
+		{
+			const FCaptureSample* pSamples = reinterpret_cast<const FCaptureSample*>(pChunkHeader + 1);
+			ChunkInfo.FirstTime = pSamples[0].Time;
+			ChunkInfo.LastTime = pSamples[pChunkHeader->Count - 1].Time;
+		}
+		else if (pChunkHeader->Type == CaptureChunk_CompressedSamples && pChunkHeader->Count > 0 && pChunkHeader->Size >= sizeof(FCaptureCompressedSamples))
+		{
+			const FCaptureCompressedSamples* pRange = reinterpret_cast<const FCaptureCompressedSamples*>(pChunkHeader + 1);
+			ChunkInfo.FirstTime = pRange->FirstTime;
+			ChunkInfo.LastTime = pRange->LastTime;
+		}
+		else if (pChunkHeader->Type == CaptureChunk_Keyframe && pChunkHeader->Size >= sizeof(FCaptureKeyframe))
+		{
+			const FCaptureKeyframe* pKeyframe = reinterpret_cast<const FCaptureKeyframe*>(pChunkHeader + 1);
+			ChunkInfo.FirstTime = pKeyframe->Time;
+			ChunkInfo.LastTime = pKeyframe->Time;
+		}
+		else if (pChunkHeader->Type == CaptureChunk_Events && pChunkHeader->Count > 0 && pChunkHeader->Size >= (uint64)pChunkHeader->Count * sizeof(FCaptureEvent))
+		{
+			const FCaptureEvent* pEvents = reinterpret_cast<const FCaptureEvent*>(pChunkHeader + 1);
+			ChunkInfo.FirstTime = pEvents[0].Time;
+			ChunkInfo.LastTime = pEvents[pChunkHeader->Count - 1].Time;
+		}
+
+		if (pChunkHeader->Type != CaptureChunk_Directory)
+		{
+			m_arrChunks.Add(ChunkInfo);
+		}
+
+		nOffset += sizeof(FCaptureChunkHeader) + pChunkHeader->Size;
+	}
+
+	return m_arrChunks.Num() > 0;
+}
+
+bool FViveTrackerCaptureReader::ReadChunks()
+{
+	for (const FCaptureChunkInfo& ChunkInfo : m_arrChunks)
+	{
+		const FCaptureChunkHeader* pChunkHeader = GetChunkHeader(ChunkInfo.Offset);
+		if (pChunkHeader == nullptr || pChunkHeader->Type != ChunkInfo.Type || pChunkHeader->Count != ChunkInfo.Count)
+			return false;
+
+		const uint8* pPayload = reinterpret_cast<const uint8*>(pChunkHeader + 1);
+
+		switch (ChunkInfo.Type)
+		{
+		case CaptureChunk_Samples:
+		case CaptureChunk_CompressedSamples:
+			if (ChunkInfo.Type == CaptureChunk_Samples ? pChunkHeader->Size < (uint64)ChunkInfo.Count * sizeof(FCaptureSample) :
+				pChunkHeader->Size < sizeof(FCaptureCompressedSamples) ||
+				FCaptureDecoder::GetNumSamples(pPayload + sizeof(FCaptureCompressedSamples), pChunkHeader->Size - sizeof(FCaptureCompressedSamples)) != ChunkInfo.Count)
+				return false;
+
+			if (ChunkInfo.Count > 0)
+			{
+				m_nStartTime = m_arrSampleChunks.Num() == 0 ? ChunkInfo.FirstTime : m_nStartTime;
+				m_nEndTime = ChunkInfo.LastTime;
+				m_nSamples += ChunkInfo.Count;
+				m_arrSampleChunks.Add(ChunkInfo);
+			}
+			break;
+
+		case CaptureChunk_Keyframe:
+		{
+			if (pChunkHeader->Size < sizeof(FCaptureKeyframe) + (uint64)ChunkInfo.Count * sizeof(FCaptureSample))
+				return false;
+
+			// Applies to the sample chunk after it
+			FViveTrackerCaptureKeyframe& Keyframe = m_arrKeyframes.AddDefaulted_GetRef();
+			Keyframe.Time = reinterpret_cast<const FCaptureKeyframe*>(pPayload)->Time;
+			Keyframe.SampleChunk = m_arrSampleChunks.Num();
+			Keyframe.Samples = TArrayView<const FCaptureSample>(reinterpret_cast<const FCaptureSample*>(pPayload + sizeof(FCaptureKeyframe)), (int32)ChunkInfo.Count);
+			break;
+		}
+
+		case CaptureChunk_Events:
+			if (pChunkHeader->Size < (uint64)ChunkInfo.Count * sizeof(FCaptureEvent))
+				return false;
+
+			m_arrEvents.Append(reinterpret_cast<const FCaptureEvent*>(pPayload), (int32)ChunkInfo.Count);
+			break;
+
+		case CaptureChunk_Trackers:
+		{
+			uint64 nRecordOffset = 0;
+			for (uint32 nRecord = 0; nRecord < ChunkInfo.Count; nRecord++)
+			{
+				if (pChunkHeader->Size - nRecordOffset < sizeof(FCaptureTrackerRecord))
+					return false;
+
+				const FCaptureTrackerRecord* pRecord = reinterpret_cast<const FCaptureTrackerRecord*>(pPayload + nRecordOffset);
+				if (pChunkHeader->Size - nRecordOffset - sizeof(FCaptureTrackerRecord) < pRecord->PathLength || pRecord->TrackerId == CaptureNoTracker)
+					return false;
+
+				// Later records of the same tracker carry its new role
+				if (pRecord->TrackerId >= m_arrTrackers.Num())
+				{
+					m_arrTrackers.SetNum(pRecord->TrackerId + 1);
+				}
+
+				FViveTrackerCaptureTracker& Tracker = m_arrTrackers[pRecord->TrackerId];
+				FUTF8ToTCHAR PathTCHAR(reinterpret_cast<const ANSICHAR*>(pRecord + 1), pRecord->PathLength);
+				Tracker.PersistentPath = FString(PathTCHAR.Length(), PathTCHAR.Get());
+				Tracker.Role = pRecord->Role <= (uint8)ETrackerRole::Unassigned ? (ETrackerRole)pRecord->Role : ETrackerRole::Unassigned;
+
+				nRecordOffset += AlignCaptureSize(sizeof(FCaptureTrackerRecord) + pRecord->PathLength);
+			}
+			break;
+		}
+
+		default:
+			// Chunk types added by later versions
+			break;
+		}
+	}
+
+	// A capture cut short right after a keyframe has no sample chunk for it
+	while (m_arrKeyframes.Num() > 0 && m_arrKeyframes.Last().SampleChunk >= m_arrSampleChunks.Num())
+	{
+		m_arrKeyframes.Pop();
+	}
+
+	return true;
+}
+
+TArrayView<const FCaptureSample> FViveTrackerCaptureReader::GetSampleChunk(int32 ChunkIndex, FViveTrackerCaptureDecodeBuffer& Buffer) const
+{
+	const FCaptureChunkInfo& ChunkInfo = m_arrSampleChunks[ChunkIndex];
+	const FCaptureChunkHeader* pChunkHeader = reinterpret_cast<const FCaptureChunkHeader*>(m_pData + ChunkInfo.Offset);
+	const uint8* pPayload = reinterpret_cast<const uint8*>(pChunkHeader + 1);
+
+	if (ChunkInfo.Type == CaptureChunk_Samples)
+		return TArrayView<const FCaptureSample>(reinterpret_cast<const FCaptureSample*>(pPayload), (int32)ChunkInfo.Count);
+
+	Buffer.Samples.SetNumUninitialized((int32)ChunkInfo.Count);
+	if (!Buffer.Decoder.Decode(pPayload + sizeof(FCaptureCompressedSamples), pChunkHeader->Size - sizeof(FCaptureCompressedSamples), Buffer.Samples.GetData()))
+	{
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Sample chunk %d of the tracker capture is corrupt"), ChunkIndex);
+		return TArrayView<const FCaptureSample>();
+	}
+
+	return Buffer.Samples;
+}
+
+int32 FViveTrackerCaptureReader::FindSampleChunk(XrTime Time) const
+{
+	if (m_arrSampleChunks.Num() == 0)
+		return INDEX_NONE;
+
+	const int32 nChunk = Algo::UpperBoundBy(m_arrSampleChunks, Time, [](const FCaptureChunkInfo& ChunkInfo) { return ChunkInfo.FirstTime; }) - 1;
+	return FMath::Max(nChunk, 0);
+}
+
+int32 FViveTrackerCaptureReader::FindKeyframe(XrTime Time) const
+{
+	return Algo::UpperBoundBy(m_arrKeyframes, Time, [](const FViveTrackerCaptureKeyframe& Keyframe) { return Keyframe.Time; }) - 1;
+}
+
+bool FViveTrackerCaptureReader::FindTrackerSample(uint16 TrackerId, XrTime Time, FViveTrackerSample& OutSample, FViveTrackerCaptureDecodeBuffer& Buffer, int32 MaxChunks) const
+{
+	const int32 nLastChunk = FindSampleChunk(Time);
+	const int32 nKeyframe = FindKeyframe(Time);
+	const int32 nFirstChunk = nKeyframe != INDEX_NONE ? m_arrKeyframes[nKeyframe].SampleChunk : nLastChunk - MaxChunks + 1;
+
+	for (int32 nChunk = nLastChunk; nChunk >= 0 && nChunk >= nFirstChunk; nChunk--)
+	{
+		const TArrayView<const FCaptureSample> arrSamples = GetSampleChunk(nChunk, Buffer);
+		const int32 nEnd = Algo::UpperBoundBy(arrSamples, Time, [](const FCaptureSample& Sample) { return Sample.Time; });
+
+		for (int32 nSample = nEnd - 1; nSample >= 0; nSample--)
+		{
+			if (arrSamples[nSample].TrackerId == TrackerId)
+			{
+				OutSample = ToTrackerSample(arrSamples[nSample]);
+				return true;
+			}
+		}
+	}
+
+	if (nKeyframe != INDEX_NONE)
+	{
+		const TArrayView<const FCaptureSample> arrSamples = m_arrKeyframes[nKeyframe].Samples;
+		for (int32 nSample = arrSamples.Num() - 1; nSample >= 0; nSample--)
+		{
+			if (arrSamples[nSample].TrackerId == TrackerId)
+			{
+				OutSample = ToTrackerSample(arrSamples[nSample]);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+FViveTrackerSample FViveTrackerCaptureReader::ToTrackerSample(const FCaptureSample& CaptureSample)
+{
+	FViveTrackerSample Sample;
+	Sample.Transform = FTransform(
+		FQuat(CaptureSample.Rotation[0], CaptureSample.Rotation[1], CaptureSample.Rotation[2], CaptureSample.Rotation[3]),
+		FVector(CaptureSample.Position[0], CaptureSample.Position[1], CaptureSample.Position[2]));
+	Sample.LinearVelocity = FVector(CaptureSample.LinearVelocity[0], CaptureSample.LinearVelocity[1], CaptureSample.LinearVelocity[2]);
+	Sample.AngularVelocity = FVector(CaptureSample.AngularVelocity[0], CaptureSample.AngularVelocity[1], CaptureSample.AngularVelocity[2]);
+	Sample.Time = CaptureSample.Time;
+	Sample.PlatformTimeNs = CaptureSample.PlatformTimeNs;
+	Sample.LocationFlags = CaptureSample.LocationFlags;
+	Sample.VelocityFlags = CaptureSample.VelocityFlags;
+	return Sample;
+}
@@ -0,0 +1,128 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// Scalar vector and quaternion helpers shared by the engine independent solvers
+
+#include "ViveTrackerCore/ViveTrackerIK.h"
+
+#include <cmath>
+
+namespace ViveTrackerCore
+{
+	inline FVec3 operator+(const FVec3& A, const FVec3& B) { return { A.X + B.X, A.Y + B.Y, A.Z + B.Z }; }
+	inline FVec3 operator-(const FVec3& A, const FVec3& B) { return { A.X - B.X, A.Y - B.Y, A.Z - B.Z }; }
+	inline FVec3 operator*(const FVec3& A, float S) { return { A.X * S, A.Y * S, A.Z * S }; }
+	inline float Dot(const FVec3& A, const FVec3& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+	inline FVec3 Cross(const FVec3& A, const FVec3& B) { return { A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X }; }
+
+	inline FVec3 SafeNormal(const FVec3& A, const FVec3& Fallback)
+	{
+		const float LengthSq = Dot(A, A);
+		return LengthSq > 1.0e-8f ? A * (1.f / std::sqrt(LengthSq)) : Fallback;
+	}
+
+	inline FVec3 Rotate(const FQuat4& Q, const FVec3& V)
+	{
+		// v' = v + 2w(q x v) + 2q x (q x v)
+		const FVec3 QV{ Q.X, Q.Y, Q.Z };
+		const FVec3 T = Cross(QV, V) * 2.f;
+		return V + T * Q.W + Cross(QV, T);
+	}
+
+	/** Rotation whose X axis points along Axis and whose Z axis is as close as possible to Bend */
+	inline FQuat4 MakeFromXZ(const FVec3& Axis, const FVec3& Bend)
+	{
+		const FVec3 X = SafeNormal(Axis, FVec3{ 1.f, 0.f, 0.f });
+		const FVec3 Y = SafeNormal(Cross(Bend, X), SafeNormal(Cross(FVec3{ 0.f, 0.f, 1.f }, X), FVec3{ 0.f, 1.f, 0.f }));
+		const FVec3 Z = Cross(X, Y);
+
+		// Rotation matrix with X, Y, Z as columns to quaternion
+		FQuat4 Q;
+		const float Trace = X.X + Y.Y + Z.Z;
+		if (Trace > 0.f)
+		{
+			const float S = std::sqrt(Trace + 1.f) * 2.f;
+			Q.W = 0.25f * S;
+			Q.X = (Y.Z - Z.Y) / S;
+			Q.Y = (Z.X - X.Z) / S;
+			Q.Z = (X.Y - Y.X) / S;
+		}
+		else if (X.X > Y.Y && X.X > Z.Z)
+		{
+			const float S = std::sqrt(1.f + X.X - Y.Y - Z.Z) * 2.f;
+			Q.W = (Y.Z - Z.Y) / S;
+			Q.X = 0.25f * S;
+			Q.Y = (Y.X + X.Y) / S;
+			Q.Z = (Z.X + X.Z) / S;
+		}
+		else if (Y.Y > Z.Z)
+		{
+			const float S = std::sqrt(1.f + Y.Y - X.X - Z.Z) * 2.f;
+			Q.W = (Z.X - X.Z) / S;
+			Q.X = (Y.X + X.Y) / S;
+			Q.Y = 0.25f * S;
+			Q.Z = (Z.Y + Y.Z) / S;
+		}
+		else
+		{
+			const float S = std::sqrt(1.f + Z.Z - X.X - Y.Y) * 2.f;
+			Q.W = (X.Y - Y.X) / S;
+			Q.X = (Z.X + X.Z) / S;
+			Q.Y = (Z.Y + Y.Z) / S;
+			Q.Z = 0.25f * S;
+		}
+		return Q;
+	}
+
+	inline FQuat4 Conjugate(const FQuat4& Q) { return { -Q.X, -Q.Y, -Q.Z, Q.W }; }
+
+	/** Hamilton product, rotating by B first then by A */
+	inline FQuat4 operator*(const FQuat4& A, const FQuat4& B)
+	{
+		return {
+			A.W * B.X + A.X * B.W + A.Y * B.Z - A.Z * B.Y,
+			A.W * B.Y - A.X * B.Z + A.Y * B.W + A.Z * B.X,
+			A.W * B.Z + A.X * B.Y - A.Y * B.X + A.Z * B.W,
+			A.W * B.W - A.X * B.X - A.Y * B.Y - A.Z * B.Z };
+	}
+
+	inline FQuat4 Normalize(const FQuat4& Q)
+	{
+		const float LengthSq = Q.X * Q.X + Q.Y * Q.Y + Q.Z * Q.Z + Q.W * Q.W;
+		if (LengthSq < 1.0e-12f)
+			return FQuat4();
+
+		const float Inv = 1.f / std::sqrt(LengthSq);
+		return { Q.X * Inv, Q.Y * Inv, Q.Z * Inv, Q.W * Inv };
+	}
+
+	inline float Length(const FVec3& A) { return std::sqrt(Dot(A, A)); }
+}
@@ -0,0 +1,374 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerCore/ViveTrackerSession.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace ViveTrackerCore
+{
+	/** Role paths and action names in ETrackerRole order */
+	static const char* const RolePaths[NumTrackerRoles] = {
+		"/user/vive_tracker_htcx/role/left_foot",
+		"/user/vive_tracker_htcx/role/right_foot",
+		"/user/vive_tracker_htcx/role/left_shoulder",
+		"/user/vive_tracker_htcx/role/right_shoulder",
+		"/user/vive_tracker_htcx/role/left_elbow",
+		"/user/vive_tracker_htcx/role/right_elbow",
+		"/user/vive_tracker_htcx/role/left_knee",
+		"/user/vive_tracker_htcx/role/right_knee",
+		"/user/vive_tracker_htcx/role/waist",
+		"/user/vive_tracker_htcx/role/chest",
+		"/user/vive_tracker_htcx/role/camera",
+		"/user/vive_tracker_htcx/role/keyboard",
+	};
+
+	static const char* const RoleActionNames[NumTrackerRoles] = {
+		"tracker_foot_l",
+		"tracker_foot_r",
+		"tracker_shoulder_l",
+		"tracker_shoulder_r",
+		"tracker_elbow_l",
+		"tracker_elbow_r",
+		"tracker_knee_l",
+		"tracker_knee_r",
+		"tracker_waist",
+		"tracker_chest",
+		"tracker_camera",
+		"tracker_keyboard",
+	};
+
+	static const char* const InteractionProfilePath = "/interaction_profiles/htc/vive_tracker_htcx";
+	static const char* const PoseInputPath = "/input/grip/pose";
+
+	const char* GetTrackerRolePath(int Role)
+	{
+		return Role >= 0 && Role < NumTrackerRoles ? RolePaths[Role] : nullptr;
+	}
+
+	int FindTrackerRole(const char* pRolePath)
+	{
+		if (pRolePath == nullptr)
+			return NumTrackerRoles;
+
+		for (int Role = 0; Role < NumTrackerRoles; Role++)
+		{
+			if (std::strcmp(RolePaths[Role], pRolePath) == 0)
+				return Role;
+		}
+		return NumTrackerRoles;
+	}
+
+	const char* FTrackerSession::GetRoleActionName(int Role)
+	{
+		return Role >= 0 && Role < NumTrackerRoles ? RoleActionNames[Role] : nullptr;
+	}
+
+	XrResult FTrackerSession::CreateActionSet(XrInstance Instance)
+	{
+		m_xrInstance = Instance;
+
+		// Resolved once, connect events come in bursts when trackers power on
+		m_pfnEnumerateViveTrackerPaths = nullptr;
+		if (m_entryPoints.GetInstanceProcAddr)
+		{
+			m_entryPoints.GetInstanceProcAddr(m_xrInstance, "xrEnumerateViveTrackerPathsHTCX", (PFN_xrVoidFunction*)&m_pfnEnumerateViveTrackerPaths);
+		}
+
+		if (!m_entryPoints.CreateActionSet)
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+
+		XrActionSetCreateInfo xrActionSetCreateInfo{ XR_TYPE_ACTION_SET_CREATE_INFO };
+		std::snprintf(xrActionSetCreateInfo.actionSetName, XR_MAX_ACTION_SET_NAME_SIZE, "%s", GetActionSetName());
+		std::snprintf(xrActionSetCreateInfo.localizedActionSetName, XR_MAX_LOCALIZED_ACTION_SET_NAME_SIZE, "Actionset for vive tracker actions");
+		xrActionSetCreateInfo.priority = 0;
+
+		return m_entryPoints.CreateActionSet(m_xrInstance, &xrActionSetCreateInfo, &m_xrActionSet);
+	}
+
+	XrResult FTrackerSession::CreateRoleAction(int Role)
+	{
+		FTrackerRoleAction& RoleAction = m_roleActions[Role];
+
+		XrActionCreateInfo xrActionCreateInfo{ XR_TYPE_ACTION_CREATE_INFO };
+		std::snprintf(xrActionCreateInfo.actionName, XR_MAX_ACTION_NAME_SIZE, "%s", RoleActionNames[Role]);
+		std::snprintf(xrActionCreateInfo.localizedActionName, XR_MAX_LOCALIZED_ACTION_NAME_SIZE, "%s", RoleActionNames[Role]);
+		xrActionCreateInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
+		xrActionCreateInfo.countSubactionPaths = 0;
+		xrActionCreateInfo.subactionPaths = nullptr;
+
+		XrAction xrAction = XR_NULL_HANDLE;
+		XrResult result = m_entryPoints.CreateAction(m_xrActionSet, &xrActionCreateInfo, &xrAction);
+		if (result != XR_SUCCESS)
+			return result;
+
+		// Every role is located through its own action space
+		XrActionSpaceCreateInfo xrActionSpaceCreateInfo{ XR_TYPE_ACTION_SPACE_CREATE_INFO };
+		xrActionSpaceCreateInfo.action = xrAction;
+		xrActionSpaceCreateInfo.poseInActionSpace.orientation.w = 1.f;
+		xrActionSpaceCreateInfo.subactionPath = XR_NULL_PATH;
+
+		XrSpace xrSpace = XR_NULL_HANDLE;
+		result = m_entryPoints.CreateActionSpace(m_xrSession, &xrActionSpaceCreateInfo, &xrSpace);
+		if (result != XR_SUCCESS)
+		{
+			m_entryPoints.DestroyAction(xrAction);
+			return result;
+		}
+
+		RoleAction.Action = xrAction;
+		RoleAction.Space = xrSpace;
+		return XR_SUCCESS;
+	}
+
+	XrResult FTrackerSession::CreateActions(XrSession Session)
+	{
+		m_xrSession = Session;
+		if (m_xrSession == XR_NULL_HANDLE || m_xrActionSet == XR_NULL_HANDLE || m_bActionsGenerated)
+			return XR_ERROR_HANDLE_INVALID;
+
+		if (!m_entryPoints.CreateAction || !m_entryPoints.CreateActionSpace || !m_entryPoints.StringToPath || !m_entryPoints.SuggestInteractionProfileBindings)
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+
+		XrActionSuggestedBinding xrBindings[NumTrackerRoles];
+		uint32_t nBindings = 0;
+		char sInputPath[XR_MAX_PATH_LENGTH];
+
+		for (int Role = 0; Role < NumTrackerRoles; Role++)
+		{
+			FTrackerRoleAction& RoleAction = m_roleActions[Role];
+			RoleAction.Result = CreateRoleAction(Role);
+			if (RoleAction.Result != XR_SUCCESS)
+				continue;
+
+			// Bound to the role's grip pose, <role path>/input/grip/pose
+			std::snprintf(sInputPath, sizeof(sInputPath), "%s%s", RolePaths[Role], PoseInputPath);
+			XrPath xrPath = XR_NULL_PATH;
+			RoleAction.Result = m_entryPoints.StringToPath(m_xrInstance, sInputPath, &xrPath);
+			if (RoleAction.Result == XR_SUCCESS)
+			{
+				xrBindings[nBindings].action = RoleAction.Action;
+				xrBindings[nBindings].binding = xrPath;
+				nBindings++;
+			}
+		}
+
+		m_bActionsGenerated = true;
+		if (nBindings == 0)
+			return XR_ERROR_PATH_UNSUPPORTED;
+
+		XrPath xrProfilePath = XR_NULL_PATH;
+		XrResult result = m_entryPoints.StringToPath(m_xrInstance, InteractionProfilePath, &xrProfilePath);
+		if (result != XR_SUCCESS)
+			return result;
+
+		XrInteractionProfileSuggestedBinding xrSuggestedBinding{ XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING };
+		xrSuggestedBinding.interactionProfile = xrProfilePath;
+		xrSuggestedBinding.suggestedBindings = xrBindings;
+		xrSuggestedBinding.countSuggestedBindings = nBindings;
+		return m_entryPoints.SuggestInteractionProfileBindings(m_xrInstance, &xrSuggestedBinding);
+	}
+
+	void FTrackerSession::Release()
+	{
+		for (FTrackerRoleAction& RoleAction : m_roleActions)
+		{
+			if (RoleAction.Action != XR_NULL_HANDLE && m_entryPoints.DestroyAction)
+			{
+				m_entryPoints.DestroyAction(RoleAction.Action);
+			}
+			RoleAction = FTrackerRoleAction();
+		}
+
+		if (m_xrActionSet != XR_NULL_HANDLE && m_entryPoints.DestroyActionSet)
+		{
+			m_entryPoints.DestroyActionSet(m_xrActionSet);
+		}
+
+		for (FTrackerLocation& Location : m_locations)
+		{
+			Location = FTrackerLocation();
+		}
+
+		m_pfnEnumerateViveTrackerPaths = nullptr;
+		m_xrInstance = XR_NULL_HANDLE;
+		m_xrSession = XR_NULL_HANDLE;
+		m_xrActionSet = XR_NULL_HANDLE;
+		m_xrSessionState = XR_SESSION_STATE_UNKNOWN;
+		m_bActionsGenerated = false;
+		m_connectedTracker = FTrackerPathRole();
+		m_bTrackersDirty = false;
+		m_nTrackers = 0;
+		m_xrTrackersResult = XR_ERROR_HANDLE_INVALID;
+	}
+
+	bool FTrackerSession::GetPathString(XrPath Path, std::string& OutString) const
+	{
+		char sPath[XR_MAX_PATH_LENGTH];
+		uint32_t nCount = 0;
+		if (Path == XR_NULL_PATH || !m_entryPoints.PathToString ||
+			m_entryPoints.PathToString(m_xrInstance, Path, sizeof(sPath), &nCount, sPath) != XR_SUCCESS || nCount == 0)
+		{
+			OutString.clear();
+			return false;
+		}
+
+		// The count includes the terminator
+		OutString.assign(sPath, nCount - 1);
+		return true;
+	}
+
+	int FTrackerSession::GetPathRole(XrPath RolePath) const
+	{
+		// Trackers without an assigned role have a null role path
+		char sRolePath[XR_MAX_PATH_LENGTH];
+		uint32_t nCount = 0;
+		if (RolePath == XR_NULL_PATH || !m_entryPoints.PathToString ||
+			m_entryPoints.PathToString(m_xrInstance, RolePath, sizeof(sRolePath), &nCount, sRolePath) != XR_SUCCESS)
+			return NumTrackerRoles;
+
+		return FindTrackerRole(sRolePath);
+	}
+
+	ETrackerSessionEvent FTrackerSession::HandleEvent(const XrEventDataBaseHeader* pHeader)
+	{
+		if (m_xrInstance == XR_NULL_HANDLE || pHeader == nullptr)
+			return ETrackerSessionEvent::None;
+
+		if (pHeader->type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED)
+		{
+			m_xrSessionState = reinterpret_cast<const XrEventDataSessionStateChanged*>(pHeader)->state;
+			return ETrackerSessionEvent::SessionStateChanged;
+		}
+
+		if (pHeader->type != XR_TYPE_EVENT_DATA_VIVE_TRACKER_CONNECTED_HTCX)
+			return ETrackerSessionEvent::None;
+
+		const XrViveTrackerPathsHTCX* pPaths = reinterpret_cast<const XrEventDataViveTrackerConnectedHTCX*>(pHeader)->paths;
+		if (pPaths)
+		{
+			GetPathString(pPaths->persistentPath, m_connectedTracker.PersistentPath);
+			m_connectedTracker.Role = GetPathRole(pPaths->rolePath);
+		}
+		else
+		{
+			m_connectedTracker = FTrackerPathRole();
+		}
+
+		// The event only names one tracker, the others may have changed roles too
+		m_bTrackersDirty = true;
+		return ETrackerSessionEvent::TrackerConnected;
+	}
+
+	bool FTrackerSession::RefreshTrackers()
+	{
+		if (!m_bTrackersDirty)
+			return false;
+
+		m_bTrackersDirty = false;
+		m_xrTrackersResult = EnumerateTrackers();
+		return true;
+	}
+
+	XrResult FTrackerSession::EnumerateTrackers()
+	{
+		if (!m_pfnEnumerateViveTrackerPaths)
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+
+		// Two call idiom, again if trackers connected in between
+		XrResult result = XR_ERROR_SIZE_INSUFFICIENT;
+		uint32_t nPaths = 0;
+		for (int nAttempt = 0; nAttempt < 3 && result == XR_ERROR_SIZE_INSUFFICIENT; nAttempt++)
+		{
+			result = m_pfnEnumerateViveTrackerPaths(m_xrInstance, 0, &nPaths, nullptr);
+			if (result != XR_SUCCESS)
+				return result;
+
+			if (m_xrTrackerPaths.size() < nPaths)
+			{
+				m_xrTrackerPaths.resize(nPaths);
+			}
+			for (uint32_t nPath = 0; nPath < nPaths; nPath++)
+			{
+				m_xrTrackerPaths[nPath] = XrViveTrackerPathsHTCX{ XR_TYPE_VIVE_TRACKER_PATHS_HTCX };
+			}
+			result = nPaths > 0 ? m_pfnEnumerateViveTrackerPaths(m_xrInstance, nPaths, &nPaths, m_xrTrackerPaths.data()) : XR_SUCCESS;
+		}
+
+		if (result != XR_SUCCESS)
+			return result;
+
+		// Trackers whose persistent path can't be read are left out
+		if (m_trackers.size() < nPaths)
+		{
+			m_trackers.resize(nPaths);
+		}
+		m_nTrackers = 0;
+		for (uint32_t nPath = 0; nPath < nPaths; nPath++)
+		{
+			FTrackerPathRole& Tracker = m_trackers[m_nTrackers];
+			if (GetPathString(m_xrTrackerPaths[nPath].persistentPath, Tracker.PersistentPath))
+			{
+				Tracker.Role = GetPathRole(m_xrTrackerPaths[nPath].rolePath);
+				m_nTrackers++;
+			}
+		}
+		return XR_SUCCESS;
+	}
+
+	void FTrackerSession::LocateRoles(XrSpace BaseSpace, XrTime Time)
+	{
+		if (!m_entryPoints.LocateSpace)
+			return;
+
+		for (int Role = 0; Role < NumTrackerRoles; Role++)
+		{
+			const FTrackerRoleAction& RoleAction = m_roleActions[Role];
+			FTrackerLocation& Location = m_locations[Role];
+			if (RoleAction.Space == XR_NULL_HANDLE)
+			{
+				Location = FTrackerLocation();
+				continue;
+			}
+
+			XrSpaceVelocity xrSpaceVelocity{ XR_TYPE_SPACE_VELOCITY };
+			XrSpaceLocation xrSpaceLocation{ XR_TYPE_SPACE_LOCATION, &xrSpaceVelocity };
+			Location.Result = m_entryPoints.LocateSpace(RoleAction.Space, BaseSpace, Time, &xrSpaceLocation);
+			if (Location.Result != XR_SUCCESS)
+				continue;
+
+			Location.LocationFlags = xrSpaceLocation.locationFlags;
+			Location.VelocityFlags = xrSpaceVelocity.velocityFlags;
+			Location.Pose = xrSpaceLocation.pose;
+			Location.LinearVelocity = xrSpaceVelocity.linearVelocity;
+			Location.AngularVelocity = xrSpaceVelocity.angularVelocity;
+		}
+	}
+}
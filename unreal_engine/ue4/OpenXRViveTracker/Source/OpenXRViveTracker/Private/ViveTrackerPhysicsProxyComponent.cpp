@@ -0,0 +1,271 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerPhysicsProxyComponent.h"
+#include "ViveTrackerStats.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Physics/PhysicsInterfaceCore.h"
+#include "PhysicsEngine/BodyInstance.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+
+// Number of simulation steps the physics scene runs for a frame, the same way the scene splits it
+static int32 GetNumPhysicsSubsteps(float DeltaTime)
+{
+	const UPhysicsSettings* Settings = UPhysicsSettings::Get();
+	if (!Settings->bSubstepping || Settings->MaxSubstepDeltaTime <= 0.f)
+		return 1;
+
+	const float StepDeltaTime = FMath::Min(DeltaTime, Settings->MaxPhysicsDeltaTime);
+	return FMath::Clamp(FMath::CeilToInt(StepDeltaTime / Settings->MaxSubstepDeltaTime), 1, FMath::Max(Settings->MaxSubsteps, 1));
+}
+
+// Sets default values for this component's properties
+UViveTrackerPhysicsProxyComponent::UViveTrackerPhysicsProxyComponent()
+{
+	// Targets have to be in place before the physics scene steps
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+}
+
+UStaticMeshComponent* UViveTrackerPhysicsProxyComponent::GetProxyBody(int32 ProxyIndex) const
+{
+	return m_arrBodies.IsValidIndex(ProxyIndex) ? m_arrBodies[ProxyIndex] : nullptr;
+}
+
+// Called when the game starts
+void UViveTrackerPhysicsProxyComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Obtain a reference of the main plugin module
+	m_trackerModule = &FOpenXRViveTrackerModule::Get();
+
+	const int32 nProxies = Proxies.Num();
+	m_arrBodies.Reset(nProxies);
+	m_arrRoles.Init(ETrackerRole::Unassigned, nProxies);
+	m_arrSamples.SetNum(nProxies);
+	m_arrTargets.Init(FTransform::Identity, nProxies);
+	m_arrCCDEnabled.Init(false, nProxies);
+
+	// Create a kinematic body per proxy, placed in world space independently of this component
+	for (const FViveTrackerPhysicsProxy& Proxy : Proxies)
+	{
+		UStaticMeshComponent* Body = NewObject<UStaticMeshComponent>(GetOwner());
+		Body->SetMobility(EComponentMobility::Movable);
+		Body->SetUsingAbsoluteLocation(true);
+		Body->SetUsingAbsoluteRotation(true);
+		Body->SetUsingAbsoluteScale(true);
+		Body->SetStaticMesh(Proxy.CollisionMesh);
+		Body->SetCollisionProfileName(CollisionProfileName);
+		Body->SetSimulatePhysics(false);
+		Body->RegisterComponent();
+
+		m_arrBodies.Add(Body);
+	}
+
+	m_nTrackerPathsGeneration = MAX_uint32;
+
+	if (FPhysScene* PhysScene = GetWorld() ? GetWorld()->GetPhysicsScene() : nullptr)
+	{
+		m_hPhysSceneStep = PhysScene->OnPhysSceneStep.AddUObject(this, &UViveTrackerPhysicsProxyComponent::OnPhysSceneStep);
+	}
+}
+
+// Called when the game ends or the component is destroyed
+void UViveTrackerPhysicsProxyComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for (UStaticMeshComponent* Body : m_arrBodies)
+	{
+		if (Body)
+		{
+			Body->DestroyComponent();
+		}
+	}
+	m_arrBodies.Reset();
+
+	if (m_hPhysSceneStep.IsValid())
+	{
+		if (FPhysScene* PhysScene = GetWorld() ? GetWorld()->GetPhysicsScene() : nullptr)
+		{
+			PhysScene->OnPhysSceneStep.Remove(m_hPhysSceneStep);
+		}
+		m_hPhysSceneStep.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UViveTrackerPhysicsProxyComponent::ResolveRoles()
+{
+	// Persistent paths only need resolving again when the runtime reports a change in trackers
+	const uint32 nGeneration = m_trackerModule->GetTrackerPathsGeneration();
+	if (nGeneration == m_nTrackerPathsGeneration)
+		return;
+
+	m_nTrackerPathsGeneration = nGeneration;
+
+	for (int32 i = 0; i < m_arrRoles.Num(); i++)
+	{
+		const FViveTrackerPhysicsProxy& Proxy = Proxies[i];
+		ETrackerRole Role = Proxy.TrackerRole;
+
+		if (!Proxy.PersistentPath.IsEmpty() && !m_trackerModule->GetTrackerRoleFromPersistentPath(Proxy.PersistentPath, Role))
+		{
+			Role = ETrackerRole::Unassigned;
+		}
+
+		m_arrRoles[i] = Role;
+	}
+}
+
+void UViveTrackerPhysicsProxyComponent::PushKinematicTargets()
+{
+	UWorld* World = GetWorld();
+	FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr;
+	if (PhysScene == nullptr)
+		return;
+
+	// Every body is written under a single scene lock
+	FPhysicsCommand::ExecuteWrite(PhysScene, [this]()
+	{
+		for (int32 i = 0; i < m_arrBodies.Num(); i++)
+		{
+			FBodyInstance* BodyInstance = m_arrBodies[i] ? m_arrBodies[i]->GetBodyInstance() : nullptr;
+			if (BodyInstance && BodyInstance->IsValidBodyInstance() && m_arrSamples[i].HasValidPose())
+			{
+				FPhysicsInterface::SetKinematicTarget_AssumesLocked(BodyInstance->GetPhysicsActorHandle(), m_arrTargets[i]);
+			}
+		}
+	});
+}
+
+void UViveTrackerPhysicsProxyComponent::PushSubstepTargets(float DeltaTime, int32 NumSubsteps)
+{
+	// Every substep of every tracker in one batch, relative to the end of this frame's step
+	const int32 nBodies = m_arrBodies.Num();
+	m_arrSubstepTransforms.SetNum(nBodies * NumSubsteps, false);
+	m_trackerModule->GetTrackerSubstepTransforms(m_arrRoles, DeltaTime, NumSubsteps, m_arrSubstepTransforms);
+
+	// Turn the transforms into targets in place, OnPhysSceneStep picks a substep's row
+	for (int32 nSubstep = 0; nSubstep < NumSubsteps; nSubstep++)
+	{
+		for (int32 i = 0; i < nBodies; i++)
+		{
+			FTransform& Transform = m_arrSubstepTransforms[nSubstep * nBodies + i];
+			Transform.AddToTranslation(PlayerStartLocation);
+			Transform = Proxies[i].MeshOffset * Transform;
+		}
+	}
+
+	// The scene steps after the pre-physics tick group, nothing writes these until the next frame
+	m_nSubsteps = NumSubsteps;
+	m_nNextSubstep = 0;
+}
+
+void UViveTrackerPhysicsProxyComponent::OnPhysSceneStep(FPhysScene* PhysScene, float DeltaTime)
+{
+	// Called on the physics thread at the start of each substep, or once per frame without substepping
+	if (m_nSubsteps <= 1)
+		return;
+
+	const int32 nSubstep = FMath::Min(m_nNextSubstep++, m_nSubsteps - 1);
+	const int32 nBodies = m_arrBodies.Num();
+
+	FPhysicsCommand::ExecuteWrite(PhysScene, [this, nSubstep, nBodies]()
+	{
+		for (int32 i = 0; i < nBodies; i++)
+		{
+			FBodyInstance* BodyInstance = m_arrBodies[i] ? m_arrBodies[i]->GetBodyInstance() : nullptr;
+			if (BodyInstance && BodyInstance->IsValidBodyInstance() && m_arrSamples[i].HasValidPose())
+			{
+				FPhysicsInterface::SetKinematicTarget_AssumesLocked(BodyInstance->GetPhysicsActorHandle(), m_arrSubstepTransforms[nSubstep * nBodies + i]);
+			}
+		}
+	});
+}
+
+// Called every frame
+void UViveTrackerPhysicsProxyComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (m_trackerModule == nullptr || m_arrBodies.Num() == 0)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ViveTracker_PhysicsProxy);
+
+	ResolveRoles();
+
+	// Fetch every tracker in one go
+	m_trackerModule->GetTrackerSamples(m_arrRoles, m_arrSamples);
+
+	for (int32 i = 0; i < m_arrBodies.Num(); i++)
+	{
+		const FViveTrackerSample& Sample = m_arrSamples[i];
+		if (!Sample.HasValidPose())
+			continue;
+
+		FTransform TrackerTransform = Sample.Transform;
+		TrackerTransform.AddToTranslation(PlayerStartLocation);
+		m_arrTargets[i] = Proxies[i].MeshOffset * TrackerTransform;
+
+		// Toggle CCD only when crossing the speed threshold, it's rare and takes its own scene lock
+		const bool bWantCCD = bEnableCCD && Sample.HasValidVelocity() && Sample.LinearVelocity.SizeSquared() > FMath::Square(CCDSpeedThreshold);
+		if (bWantCCD != m_arrCCDEnabled[i] && m_arrBodies[i])
+		{
+			m_arrBodies[i]->GetBodyInstance()->SetUseCCD(bWantCCD);
+			m_arrCCDEnabled[i] = bWantCCD;
+		}
+	}
+
+	// Substepped physics would otherwise move every body to its end-of-frame pose on the first substep
+	const int32 NumSubsteps = m_hPhysSceneStep.IsValid() ? GetNumPhysicsSubsteps(DeltaTime) : 1;
+	if (NumSubsteps > 1)
+	{
+		PushSubstepTargets(DeltaTime, NumSubsteps);
+	}
+	else
+	{
+		m_nSubsteps = 1;
+		PushKinematicTargets();
+	}
+
+	// Keep component transforms in sync for rendering and gameplay, without another physics update per body
+	for (int32 i = 0; i < m_arrBodies.Num(); i++)
+	{
+		UStaticMeshComponent* Body = m_arrBodies[i];
+		if (Body && m_arrSamples[i].HasValidPose())
+		{
+			const FTransform& Target = m_arrTargets[i];
+			Body->MoveComponent(Target.GetLocation() - Body->GetComponentLocation(), Target.GetRotation(), false, nullptr, MOVECOMP_SkipPhysicsMove, ETeleportType::None);
+		}
+	}
+}
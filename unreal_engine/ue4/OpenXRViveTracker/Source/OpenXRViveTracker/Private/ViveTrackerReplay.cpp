@@ -0,0 +1,591 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerReplay.h"
+#include "Algo/BinarySearch.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+using namespace ViveTrackerCore;
+
+/**
+* Worker thread keeping the chunks around a replay's playhead ready: compressed chunks are decoded into slots the
+* replay takes their samples from, uncompressed ones have their pages of the mapping touched so reaching them doesn't fault.
+* The slots' sample arrays are swapped back and forth with the replay's decode buffer, so nothing allocates once they have grown.
+*/
+class FViveTrackerReplayPrefetcher : public FRunnable
+{
+public:
+	FViveTrackerReplayPrefetcher(const FViveTrackerCaptureReader& Reader, int32 ChunksAhead)
+		: m_reader(Reader)
+		, m_nChunksAhead(ChunksAhead)
+	{
+		// One slot per chunk of the window, the ones ahead and the one behind the playhead
+		m_arrSlots.SetNum(ChunksAhead + 1);
+		m_pWakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		m_pThread = FRunnableThread::Create(this, TEXT("ViveTrackerReplayPrefetcher"), 0, TPri_BelowNormal);
+	}
+
+	virtual ~FViveTrackerReplayPrefetcher()
+	{
+		if (m_pThread)
+		{
+			Stop();
+			m_pThread->WaitForCompletion();
+			delete m_pThread;
+		}
+		FPlatformProcess::ReturnSynchEventToPool(m_pWakeEvent);
+	}
+
+	/**
+	* Move the window of prefetched chunks
+	* @param int32 - Index of the sample chunk the replay is in
+	*/
+	void SetPlayhead(int32 ChunkIndex)
+	{
+		if (m_nPlayhead.Exchange(ChunkIndex) != ChunkIndex)
+		{
+			m_pWakeEvent->Trigger();
+		}
+	}
+
+	/**
+	* Take a decoded compressed chunk if it is ready
+	* @param int32 - Index of the sample chunk
+	* @param int32 - Index of the chunk the array currently holds, kept in its place for scrubbing back, INDEX_NONE if none
+	* @param TArray<ViveTrackerCore::FCaptureSample> - Swapped with the decoded samples
+	* @return bool - Whether or not the chunk was ready
+	*/
+	bool TakeChunk(int32 ChunkIndex, int32 HeldChunkIndex, TArray<FCaptureSample>& InOutSamples)
+	{
+		FScopeLock slotLock(&m_slotLock);
+		for (FSlot& Slot : m_arrSlots)
+		{
+			if (Slot.ChunkIndex == ChunkIndex && Slot.Samples.Num() > 0)
+			{
+				Swap(Slot.Samples, InOutSamples);
+				Slot.ChunkIndex = HeldChunkIndex;
+				if (HeldChunkIndex == INDEX_NONE)
+				{
+					Slot.Samples.Reset();
+				}
+				m_pWakeEvent->Trigger();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** FRunnable */
+	virtual uint32 Run() override
+	{
+		TArray<FCaptureSample> arrSamples;
+		FViveTrackerCaptureDecodeBuffer Buffer;
+
+		while (!m_bStopping)
+		{
+			const int32 nPlayhead = m_nPlayhead.Load();
+			const int32 nChunk = FindMissingChunk(nPlayhead);
+			if (nChunk == INDEX_NONE)
+			{
+				m_pWakeEvent->Wait();
+				continue;
+			}
+
+			const TArrayView<const FCaptureSample> arrChunk = m_reader.GetSampleChunk(nChunk, Buffer);
+			if (!m_reader.IsSampleChunkCompressed(nChunk))
+			{
+				// Reading a byte per page is enough to have the mapping paged in
+				const uint8* pBytes = reinterpret_cast<const uint8*>(arrChunk.GetData());
+				const int64 nBytes = arrChunk.Num() * (int64)sizeof(FCaptureSample);
+				uint32 nTouched = 0;
+				for (int64 nByte = 0; nByte < nBytes; nByte += 4096)
+				{
+					nTouched += pBytes[nByte];
+				}
+				m_nTouched.Store(nTouched, EMemoryOrder::Relaxed);
+			}
+			else
+			{
+				Swap(arrSamples, Buffer.Samples);
+				if (arrChunk.Num() == 0)
+				{
+					// Corrupt, the replay skips it when it gets there
+					arrSamples.Reset();
+				}
+			}
+
+			FScopeLock slotLock(&m_slotLock);
+			const int32 nSlot = FindFreeSlot(m_nPlayhead.Load());
+			if (nSlot != INDEX_NONE)
+			{
+				m_arrSlots[nSlot].ChunkIndex = nChunk;
+				Swap(m_arrSlots[nSlot].Samples, arrSamples);
+			}
+		}
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		m_bStopping = true;
+		m_pWakeEvent->Trigger();
+	}
+
+private:
+	struct FSlot
+	{
+		int32 ChunkIndex = INDEX_NONE;
+		TArray<FCaptureSample> Samples;
+	};
+
+	bool IsInWindow(int32 ChunkIndex, int32 Playhead) const
+	{
+		return ChunkIndex != INDEX_NONE && ChunkIndex >= Playhead - 1 && ChunkIndex <= Playhead + m_nChunksAhead && ChunkIndex != Playhead;
+	}
+
+	int32 FindMissingChunk(int32 Playhead)
+	{
+		FScopeLock slotLock(&m_slotLock);
+
+		// Nearest first ahead of the playhead, then the chunk behind it
+		for (int32 nOffset = 1; nOffset <= m_nChunksAhead + 1; nOffset++)
+		{
+			const int32 nChunk = nOffset <= m_nChunksAhead ? Playhead + nOffset : Playhead - 1;
+			if (nChunk < 0 || nChunk >= m_reader.GetNumSampleChunks())
+				continue;
+
+			if (!m_arrSlots.ContainsByPredicate([nChunk](const FSlot& Slot) { return Slot.ChunkIndex == nChunk; }))
+				return nChunk;
+		}
+		return INDEX_NONE;
+	}
+
+	int32 FindFreeSlot(int32 Playhead) const
+	{
+		return m_arrSlots.IndexOfByPredicate([this, Playhead](const FSlot& Slot) { return !IsInWindow(Slot.ChunkIndex, Playhead); });
+	}
+
+	const FViveTrackerCaptureReader& m_reader;
+	const int32 m_nChunksAhead;
+
+	FCriticalSection m_slotLock;
+	TArray<FSlot> m_arrSlots;
+
+	TAtomic<int32> m_nPlayhead{ 0 };
+	TAtomic<bool> m_bStopping{ false };
+	FEvent* m_pWakeEvent = nullptr;
+	FRunnableThread* m_pThread = nullptr;
+	// Keeps the page touching from being optimized out
+	TAtomic<uint32> m_nTouched{ 0 };
+};
+
+FViveTrackerReplay::FViveTrackerReplay()
+{
+}
+
+FViveTrackerReplay::~FViveTrackerReplay()
+{
+	Close();
+}
+
+bool FViveTrackerReplay::Open(const FString& Filename, const FViveTrackerReplaySettings& Settings)
+{
+	Close();
+	m_settings = Settings;
+
+	if (!m_reader.Open(Filename))
+		return false;
+
+	if (m_reader.GetNumSampleChunks() == 0)
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Tracker capture %s has no samples to replay"), *Filename);
+		m_reader.Close();
+		return false;
+	}
+
+	if (Settings.DecodeAheadChunks > 0 && m_reader.GetNumSampleChunks() > 1)
+	{
+		m_pPrefetcher = MakeUnique<FViveTrackerReplayPrefetcher>(m_reader, FMath::Min(Settings.DecodeAheadChunks, 64));
+	}
+
+	Seek(m_reader.GetStartTime());
+	return true;
+}
+
+void FViveTrackerReplay::Close()
+{
+	// The prefetcher reads from the mapping, it goes first
+	m_pPrefetcher.Reset();
+	m_nDecodedChunk = INDEX_NONE;
+	m_arrChunkSamples = TArrayView<const FCaptureSample>();
+	m_arrKeyframeSamples = TArrayView<const FCaptureSample>();
+	m_reader.Close();
+	m_nTime = 0;
+	m_nChunk = 0;
+	m_nSample = 0;
+	m_nEvent = 0;
+	m_nKeyframeSample = 0;
+}
+
+bool FViveTrackerReplay::LoadChunk(int32 ChunkIndex)
+{
+	m_nChunk = ChunkIndex;
+	m_nSample = 0;
+
+	if (ChunkIndex >= m_reader.GetNumSampleChunks())
+	{
+		m_arrChunkSamples = TArrayView<const FCaptureSample>();
+		return false;
+	}
+
+	if (m_pPrefetcher)
+	{
+		m_pPrefetcher->SetPlayhead(ChunkIndex);
+	}
+
+	if (!m_reader.IsSampleChunkCompressed(ChunkIndex))
+	{
+		m_arrChunkSamples = m_reader.GetSampleChunk(ChunkIndex, m_decodeBuffer);
+	}
+	else if (ChunkIndex == m_nDecodedChunk)
+	{
+		// Seeking within the chunk already decoded, e.g. scrubbing in small steps
+		m_arrChunkSamples = m_decodeBuffer.Samples;
+	}
+	else if (m_pPrefetcher && m_pPrefetcher->TakeChunk(ChunkIndex, m_nDecodedChunk, m_decodeBuffer.Samples))
+	{
+		m_arrChunkSamples = m_decodeBuffer.Samples;
+		m_nDecodedChunk = ChunkIndex;
+	}
+	else
+	{
+		m_arrChunkSamples = m_reader.GetSampleChunk(ChunkIndex, m_decodeBuffer);
+		m_nDecodedChunk = m_arrChunkSamples.Num() > 0 ? ChunkIndex : INDEX_NONE;
+	}
+	return m_arrChunkSamples.Num() > 0;
+}
+
+void FViveTrackerReplay::Seek(XrTime Time)
+{
+	if (!IsOpen())
+		return;
+
+	const int32 nKeyframe = m_reader.FindKeyframe(Time);
+	if (nKeyframe != INDEX_NONE)
+	{
+		const FViveTrackerCaptureKeyframe& Keyframe = m_reader.GetKeyframe(nKeyframe);
+		m_arrKeyframeSamples = Keyframe.Samples;
+		LoadChunk(Keyframe.SampleChunk);
+	}
+	else
+	{
+		m_arrKeyframeSamples = TArrayView<const FCaptureSample>();
+		LoadChunk(FMath::Max(m_reader.FindSampleChunk(Time), 0));
+	}
+	m_nKeyframeSample = 0;
+
+	// Events from the start of the chunk are handed out again along with its samples
+	const XrTime nChunkStart = m_arrChunkSamples.Num() > 0 ? m_arrChunkSamples[0].Time : Time;
+	m_nEvent = Algo::LowerBoundBy(m_reader.GetEvents(), FMath::Min(nChunkStart, Time), [](const FCaptureEvent& Event) { return Event.Time; });
+	m_nTime = FMath::Min(nChunkStart, Time) - 1;
+}
+
+void FViveTrackerReplay::Advance(XrTime Time, TFunctionRef<void(const FCaptureSample&)> OnSample, TFunctionRef<void(const FCaptureEvent&)> OnEvent)
+{
+	if (!IsOpen() || Time <= m_nTime)
+		return;
+
+	// The state a seek starts from, older than everything after it
+	while (m_nKeyframeSample < m_arrKeyframeSamples.Num())
+	{
+		OnSample(m_arrKeyframeSamples[m_nKeyframeSample++]);
+	}
+
+	const TArrayView<const FCaptureEvent> arrEvents = m_reader.GetEvents();
+
+	for (;;)
+	{
+		// Corrupt chunks are skipped, the replay carries on with the next one
+		while (m_nSample >= m_arrChunkSamples.Num() && m_nChunk < m_reader.GetNumSampleChunks())
+		{
+			LoadChunk(m_nChunk + 1);
+		}
+
+		const FCaptureSample* pSample = m_nSample < m_arrChunkSamples.Num() ? &m_arrChunkSamples[m_nSample] : nullptr;
+		const FCaptureEvent* pEvent = m_nEvent < arrEvents.Num() ? &arrEvents[m_nEvent] : nullptr;
+
+		if (pEvent && pEvent->Time <= Time && (!pSample || pEvent->Time <= pSample->Time))
+		{
+			m_nEvent++;
+			OnEvent(*pEvent);
+		}
+		else if (pSample && pSample->Time <= Time)
+		{
+			m_nSample++;
+			OnSample(*pSample);
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	m_nTime = Time;
+}
+
+/** Every tracker's replayed state, folded the way the module applies replayed samples */
+struct FSeekTestTracker
+{
+	FCaptureSample Pose{};
+	FCaptureSample Latest{};
+	bool bHasPose = false;
+	bool bHasSample = false;
+
+	void Apply(const FCaptureSample& Sample)
+	{
+		constexpr uint8 PoseValidFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+		if ((Sample.LocationFlags & PoseValidFlags) == PoseValidFlags)
+		{
+			Pose = Sample;
+			bHasPose = true;
+		}
+		Latest = Sample;
+		bHasSample = true;
+	}
+};
+
+/**
+* Write a long synthetic capture of 12 trackers at 1kHz with dropouts and lost tracking, then seek to random times
+* and check that the replay restores the same state as playing the capture from the start
+* @param int32 - Length of the capture in seconds
+* @param int32 - Number of seeks
+* @return bool - Whether every seek restored the expected state
+*/
+static bool RunCaptureSeekTest(int32 NumSeconds, int32 NumSeeks)
+{
+	constexpr int32 NumTrackers = 12;
+	constexpr XrTime StartTime = 1000 * 1000 * 1000;
+	const FString sFilename = FPaths::ProjectSavedDir() / TEXT("ViveTracker") / TEXT("SeekTest.vtcap");
+
+	const ViveTrackerCore::FCaptureCodecSettings CodecSettings;
+	{
+		FViveTrackerCaptureWriter Writer;
+		if (!Writer.Open(sFilename, StartTime, 0, &CodecSettings))
+		{
+			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Capture seek: FAILED, can't write %s"), *sFilename);
+			return false;
+		}
+
+		TMap<FString, ETrackerRole> mapPathRoles;
+		for (int32 nTracker = 0; nTracker < NumTrackers; nTracker++)
+		{
+			mapPathRoles.Add(FString::Printf(TEXT("/devices/htc/vive_trackerSEEKTEST%02d"), nTracker), (ETrackerRole)nTracker);
+		}
+		Writer.SetTrackerPaths(mapPathRoles);
+
+		FViveTrackerSample Sample;
+		Sample.VelocityFlags = XR_SPACE_VELOCITY_LINEAR_VALID_BIT | XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
+		for (int32 nFrame = 0; nFrame < NumSeconds * 1000; nFrame++)
+		{
+			Sample.Time = StartTime + (XrTime)nFrame * 1000 * 1000;
+			Sample.PlatformTimeNs = Sample.Time;
+			for (int32 nTracker = 0; nTracker < NumTrackers; nTracker++)
+			{
+				// Every tracker disappears for seconds at a time and regularly loses tracking, so seeks depend on keyframes
+				if ((nFrame / 1500 + nTracker * 3) % 9 == 0)
+					continue;
+
+				const bool bTracking = (nFrame / 200 + nTracker) % 13 != 0;
+				Sample.LocationFlags = bTracking ? XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT : 0;
+
+				const float Time = nFrame * 0.001f;
+				Sample.Transform.SetLocation(FVector(30.f * FMath::Sin(Time + nTracker), 30.f * FMath::Cos(0.7f * Time), 10.f * nTracker));
+				Sample.Transform.SetRotation(FQuat(FRotator(0.f, 90.f * FMath::Sin(0.3f * Time + nTracker), 0.f)));
+				Writer.AddSample((ETrackerRole)nTracker, Sample);
+			}
+
+			if (nFrame % 16 == 0)
+			{
+				Writer.Update();
+			}
+		}
+		Writer.Close();
+	}
+
+	FViveTrackerReplay Replay;
+	if (!Replay.Open(sFilename))
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Capture seek: FAILED, can't open %s"), *sFilename);
+		return false;
+	}
+
+	const FViveTrackerCaptureReader& Reader = Replay.GetReader();
+	const int32 nCaptureTrackers = Reader.GetTrackers().Num();
+
+	// Expected state at every seek time, from one pass over the whole capture
+	FRandomStream Random(0x5EEC);
+	TArray<XrTime> arrSeekTimes;
+	for (int32 nSeek = 0; nSeek < NumSeeks; nSeek++)
+	{
+		arrSeekTimes.Add(Reader.GetStartTime() + (XrTime)(Random.FRand() * (Reader.GetEndTime() - Reader.GetStartTime())));
+	}
+	arrSeekTimes.Sort();
+
+	TArray<FSeekTestTracker> arrState;
+	TArray<FSeekTestTracker> arrExpected;
+	arrState.SetNum(nCaptureTrackers);
+	arrExpected.Reserve(NumSeeks * nCaptureTrackers);
+	{
+		FViveTrackerCaptureDecodeBuffer Buffer;
+		int32 nSeek = 0;
+		for (int32 nChunk = 0; nChunk < Reader.GetNumSampleChunks() && nSeek < NumSeeks; nChunk++)
+		{
+			for (const FCaptureSample& Sample : Reader.GetSampleChunk(nChunk, Buffer))
+			{
+				for (; nSeek < NumSeeks && arrSeekTimes[nSeek] < Sample.Time; nSeek++)
+				{
+					arrExpected.Append(arrState);
+				}
+				arrState[Sample.TrackerId].Apply(Sample);
+			}
+		}
+		for (; nSeek < NumSeeks; nSeek++)
+		{
+			arrExpected.Append(arrState);
+		}
+	}
+
+	// Keyframes hold the samples as recorded, chunks decode within the codec's error bounds
+	auto IsSame = [&CodecSettings](const FCaptureSample& A, const FCaptureSample& B)
+	{
+		bool bSame = A.Time == B.Time && A.TrackerId == B.TrackerId && A.LocationFlags == B.LocationFlags && A.VelocityFlags == B.VelocityFlags;
+		for (int32 nAxis = 0; nAxis < 3; nAxis++)
+		{
+			bSame &= FMath::Abs(A.Position[nAxis] - B.Position[nAxis]) <= CodecSettings.PositionError * 1.01f + 1.0e-5f;
+		}
+		for (int32 nAxis = 0; nAxis < 4; nAxis++)
+		{
+			bSame &= FMath::Abs(A.Rotation[nAxis] - B.Rotation[nAxis]) <= CodecSettings.RotationError * 1.01f + 1.0e-5f;
+		}
+		return bSame;
+	};
+
+	TArray<int32> arrOrder;
+	for (int32 nSeek = 0; nSeek < NumSeeks; nSeek++)
+	{
+		arrOrder.Add(nSeek);
+	}
+	for (int32 nSeek = NumSeeks - 1; nSeek > 0; nSeek--)
+	{
+		arrOrder.Swap(nSeek, Random.RandRange(0, nSeek));
+	}
+
+	TArray<double> arrSeekSeconds;
+	FViveTrackerCaptureDecodeBuffer FindBuffer;
+	int32 nMismatches = 0;
+	int32 nFindMismatches = 0;
+	for (const int32 nSeek : arrOrder)
+	{
+		const XrTime SeekTime = arrSeekTimes[nSeek];
+		for (FSeekTestTracker& Tracker : arrState)
+		{
+			Tracker = FSeekTestTracker();
+		}
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		Replay.Seek(SeekTime);
+		Replay.Advance(SeekTime, [&arrState](const FCaptureSample& Sample) { arrState[Sample.TrackerId].Apply(Sample); }, [](const FCaptureEvent&) {});
+		arrSeekSeconds.Add(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles));
+
+		for (int32 nTracker = 0; nTracker < nCaptureTrackers; nTracker++)
+		{
+			const FSeekTestTracker& Expected = arrExpected[nSeek * nCaptureTrackers + nTracker];
+			const FSeekTestTracker& Actual = arrState[nTracker];
+			if (Expected.bHasPose != Actual.bHasPose || Expected.bHasSample != Actual.bHasSample ||
+				(Expected.bHasPose && !IsSame(Expected.Pose, Actual.Pose)) || (Expected.bHasSample && !IsSame(Expected.Latest, Actual.Latest)))
+			{
+				nMismatches++;
+			}
+		}
+
+		const uint16 nTracker = (uint16)Random.RandRange(0, nCaptureTrackers - 1);
+		const FSeekTestTracker& Expected = arrExpected[nSeek * nCaptureTrackers + nTracker];
+		FViveTrackerSample Found;
+		const bool bFound = Reader.FindTrackerSample(nTracker, SeekTime, Found, FindBuffer);
+		if (bFound != Expected.bHasSample || (bFound && (Found.Time != Expected.Latest.Time || Found.LocationFlags != Expected.Latest.LocationFlags)))
+		{
+			nFindMismatches++;
+		}
+	}
+
+	arrSeekSeconds.Sort();
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Capture seek: %d s capture, %lld samples, %d keyframes, %.1f MB"), NumSeconds, Reader.GetNumSamples(),
+		Reader.GetNumKeyframes(), IFileManager::Get().FileSize(*sFilename) / (1024.0 * 1024.0));
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Capture seek: %d random seeks, median %.1f us, 99th percentile %.1f us, max %.1f us"), NumSeeks,
+		arrSeekSeconds[NumSeeks / 2] * 1.0e6, arrSeekSeconds[NumSeeks * 99 / 100] * 1.0e6, arrSeekSeconds.Last() * 1.0e6);
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Capture seek: %s, %d tracker states and %d sample lookups differ from playing from the start"),
+		nMismatches == 0 && nFindMismatches == 0 ? TEXT("PASSED") : TEXT("FAILED"), nMismatches, nFindMismatches);
+
+	Replay.Close();
+	FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*sFilename);
+	return nMismatches == 0 && nFindMismatches == 0;
+}
+
+static void TestCaptureSeek(const TArray<FString>& Args)
+{
+	const int32 NumSeconds = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 1, 4 * 3600) : 600;
+	const int32 NumSeeks = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 1, 100000) : 1000;
+	RunCaptureSeekTest(NumSeconds, NumSeeks);
+}
+
+static FAutoConsoleCommand TestCaptureSeekCommand(
+	TEXT("vivetracker.TestCaptureSeek"),
+	TEXT("Write a synthetic capture of N seconds (default 600), seek a replay to M random times (default 1000) and check every tracker's state against playing from the start"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&TestCaptureSeek));
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// A minute of capture keeps the test quick while still spanning many chunks and keyframes
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FViveTrackerCaptureSeekTest, "OpenXRViveTracker.Capture.Seek",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FViveTrackerCaptureSeekTest::RunTest(const FString& Parameters)
+{
+	return RunCaptureSeekTest(60, 200);
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
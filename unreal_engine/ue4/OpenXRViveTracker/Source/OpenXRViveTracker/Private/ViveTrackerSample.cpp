@@ -0,0 +1,118 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerSample.h"
+
+static constexpr double NanosecondsToSeconds = 1.0e-9;
+
+void FViveTrackerPoseHistory::Push(const FViveTrackerSample& Sample)
+{
+	// Ignore duplicate or out of order samples, e.g. when the display time didn't advance
+	if (m_nCount > 0 && Sample.Time <= Get(0).Time)
+		return;
+
+	m_nHead = (m_nHead + 1) % Capacity;
+	m_arrSamples[m_nHead] = Sample;
+	m_nCount = FMath::Min(m_nCount + 1, Capacity);
+}
+
+bool FViveTrackerPoseHistory::Evaluate(XrTime Time, FTransform& OutTransform) const
+{
+	if (m_nCount == 0)
+		return false;
+
+	// Past the newest sample, extrapolate
+	const FViveTrackerSample& Newest = Get(0);
+	if (Time >= Newest.Time)
+	{
+		const XrTime DeltaNs = FMath::Min(Time - Newest.Time, MaxExtrapolationNs);
+		OutTransform = Extrapolate(Newest, DeltaNs * NanosecondsToSeconds);
+		return true;
+	}
+
+	// Find the two samples surrounding the requested time
+	for (int32 Age = 1; Age < m_nCount; Age++)
+	{
+		const FViveTrackerSample& Older = Get(Age);
+		if (Older.Time <= Time)
+		{
+			OutTransform = Interpolate(Older, Get(Age - 1), Time);
+			return true;
+		}
+	}
+
+	// Older than anything we have, hold the oldest pose
+	OutTransform = Get(m_nCount - 1).Transform;
+	return true;
+}
+
+FTransform FViveTrackerPoseHistory::Extrapolate(const FViveTrackerSample& Sample, double DeltaSeconds)
+{
+	if (!Sample.HasValidVelocity() || DeltaSeconds == 0.0)
+		return Sample.Transform;
+
+	FTransform Result = Sample.Transform;
+	Result.SetLocation(Sample.Transform.GetLocation() + Sample.LinearVelocity * DeltaSeconds);
+
+	// Angular velocity is expressed in base space, so the delta rotation is applied after the sample's rotation
+	const float AngularSpeed = (float)Sample.AngularVelocity.Size();
+	if (AngularSpeed > KINDA_SMALL_NUMBER)
+	{
+		const FQuat DeltaRotation(Sample.AngularVelocity / AngularSpeed, (float)(AngularSpeed * DeltaSeconds));
+		Result.SetRotation((DeltaRotation * Sample.Transform.GetRotation()).GetNormalized());
+	}
+
+	return Result;
+}
+
+FTransform FViveTrackerPoseHistory::Interpolate(const FViveTrackerSample& From, const FViveTrackerSample& To, XrTime Time)
+{
+	const XrTime IntervalNs = To.Time - From.Time;
+	if (IntervalNs <= 0)
+		return To.Transform;
+
+	const float Alpha = FMath::Clamp((float)((double)(Time - From.Time) / (double)IntervalNs), 0.f, 1.f);
+	const FVector FromLocation = From.Transform.GetLocation();
+	const FVector ToLocation = To.Transform.GetLocation();
+
+	FVector Location;
+	if (From.HasValidVelocity() && To.HasValidVelocity())
+	{
+		// Hermite tangents are velocities scaled to the interval
+		const float IntervalSeconds = (float)(IntervalNs * NanosecondsToSeconds);
+		Location = FMath::CubicInterp(FromLocation, From.LinearVelocity * IntervalSeconds, ToLocation, To.LinearVelocity * IntervalSeconds, Alpha);
+	}
+	else
+	{
+		Location = FMath::Lerp(FromLocation, ToLocation, Alpha);
+	}
+
+	const FQuat Rotation = FQuat::Slerp(From.Transform.GetRotation(), To.Transform.GetRotation(), Alpha);
+	return FTransform(Rotation.GetNormalized(), Location);
+}
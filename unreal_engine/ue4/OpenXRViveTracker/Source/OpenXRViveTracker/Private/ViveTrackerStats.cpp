@@ -0,0 +1,112 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerStats.h"
+
+DEFINE_STAT(STAT_ViveTracker_Sync);
+DEFINE_STAT(STAT_ViveTracker_Locate);
+DEFINE_STAT(STAT_ViveTracker_Publish);
+DEFINE_STAT(STAT_ViveTracker_TrackerPaths);
+DEFINE_STAT(STAT_ViveTracker_Events);
+DEFINE_STAT(STAT_ViveTracker_Replay);
+DEFINE_STAT(STAT_ViveTracker_Component);
+DEFINE_STAT(STAT_ViveTracker_PhysicsProxy);
+DEFINE_STAT(STAT_ViveTracker_DebugDraw);
+DEFINE_STAT(STAT_ViveTracker_LocatedTrackers);
+DEFINE_STAT(STAT_ViveTracker_ConnectEvents);
+DEFINE_STAT(STAT_ViveTracker_ConnectedTrackers);
+DEFINE_STAT(STAT_ViveTrackerXr_GetInstanceProcAddr);
+DEFINE_STAT(STAT_ViveTrackerXr_CreateActionSet);
+DEFINE_STAT(STAT_ViveTrackerXr_DestroyActionSet);
+DEFINE_STAT(STAT_ViveTrackerXr_CreateAction);
+DEFINE_STAT(STAT_ViveTrackerXr_DestroyAction);
+DEFINE_STAT(STAT_ViveTrackerXr_CreateActionSpace);
+DEFINE_STAT(STAT_ViveTrackerXr_SuggestInteractionProfileBindings);
+DEFINE_STAT(STAT_ViveTrackerXr_LocateSpace);
+DEFINE_STAT(STAT_ViveTrackerXr_StringToPath);
+DEFINE_STAT(STAT_ViveTrackerXr_PathToString);
+DEFINE_STAT(STAT_ViveTrackerXr_EnumerateViveTrackerPaths);
+DEFINE_STAT(STAT_ViveTrackerXr_ConvertTime);
+
+#if VIVETRACKER_TRACE_ENABLED
+
+#include "Trace/Trace.inl"
+
+UE_TRACE_CHANNEL_DEFINE(ViveTrackerChannel);
+
+UE_TRACE_EVENT_BEGIN(ViveTracker, Pose)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(int64, Time)
+	UE_TRACE_EVENT_FIELD(uint8, Role)
+	UE_TRACE_EVENT_FIELD(uint8, LocationFlags)
+	UE_TRACE_EVENT_FIELD(uint8, VelocityFlags)
+	UE_TRACE_EVENT_FIELD(float, X)
+	UE_TRACE_EVENT_FIELD(float, Y)
+	UE_TRACE_EVENT_FIELD(float, Z)
+	UE_TRACE_EVENT_FIELD(float, QX)
+	UE_TRACE_EVENT_FIELD(float, QY)
+	UE_TRACE_EVENT_FIELD(float, QZ)
+	UE_TRACE_EVENT_FIELD(float, QW)
+	UE_TRACE_EVENT_FIELD(float, Speed)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(ViveTracker, Connected)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint8, Role)
+UE_TRACE_EVENT_END()
+
+void FViveTrackerTrace::OutputPose(uint8 Role, const FViveTrackerSample& Sample)
+{
+	const FVector location = Sample.Transform.GetLocation();
+	const FQuat rotation = Sample.Transform.GetRotation();
+
+	UE_TRACE_LOG(ViveTracker, Pose, ViveTrackerChannel)
+		<< Pose.Cycle(FPlatformTime::Cycles64())
+		<< Pose.Time(Sample.Time)
+		<< Pose.Role(Role)
+		<< Pose.LocationFlags((uint8)Sample.LocationFlags)
+		<< Pose.VelocityFlags((uint8)Sample.VelocityFlags)
+		<< Pose.X((float)location.X)
+		<< Pose.Y((float)location.Y)
+		<< Pose.Z((float)location.Z)
+		<< Pose.QX((float)rotation.X)
+		<< Pose.QY((float)rotation.Y)
+		<< Pose.QZ((float)rotation.Z)
+		<< Pose.QW((float)rotation.W)
+		<< Pose.Speed((float)Sample.LinearVelocity.Size());
+}
+
+void FViveTrackerTrace::OutputConnected(uint8 Role)
+{
+	UE_TRACE_LOG(ViveTracker, Connected, ViveTrackerChannel)
+		<< Connected.Cycle(FPlatformTime::Cycles64())
+		<< Connected.Role(Role);
+}
+
+#endif
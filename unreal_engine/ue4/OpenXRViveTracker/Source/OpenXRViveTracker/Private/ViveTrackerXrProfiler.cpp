@@ -0,0 +1,285 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerXrProfiler.h"
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerClock.h"
+#include "Misc/FileHelper.h"
+
+static bool GXrProfilerEnabled = false;
+static FViveTrackerXrCallHistogram GXrCallHistograms[(int32)EViveTrackerXrCall::Num];
+
+// What the profiled entry points forward to
+static ViveTrackerCore::FXrEntryPoints GProfiledEntryPoints;
+static PFN_xrEnumerateViveTrackerPathsHTCX GProfiledEnumerateViveTrackerPaths = nullptr;
+
+void FViveTrackerXrCallHistogram::Add(uint64 Nanoseconds)
+{
+	m_arrBuckets[GetBucket(Nanoseconds)]++;
+	m_nCount++;
+	m_nTotalNs += Nanoseconds;
+	m_nMaxNs = FMath::Max(m_nMaxNs, Nanoseconds);
+}
+
+void FViveTrackerXrCallHistogram::Reset()
+{
+	for (uint32& nBucket : m_arrBuckets)
+	{
+		nBucket = 0;
+	}
+	m_nCount = 0;
+	m_nTotalNs = 0;
+	m_nMaxNs = 0;
+}
+
+double FViveTrackerXrCallHistogram::GetPercentile(double Percentile) const
+{
+	if (m_nCount == 0)
+		return 0.0;
+
+	const int64 nRank = FMath::Max((int64)FMath::CeilToDouble(FMath::Clamp(Percentile, 0.0, 1.0) * m_nCount), (int64)1);
+	int64 nBelow = 0;
+	for (int32 nBucket = 0; nBucket < NumBuckets; nBucket++)
+	{
+		nBelow += m_arrBuckets[nBucket];
+		if (nBelow >= nRank)
+			return FMath::Min(GetBucketUpperBound(nBucket), m_nMaxNs) * 1.0e-9;
+	}
+	return GetMax();
+}
+
+int32 FViveTrackerXrCallHistogram::GetBucket(uint64 Nanoseconds)
+{
+	if (Nanoseconds < (1ull << MinExponent))
+		return 0;
+
+	// The exponent picks a power of two, the bits below the leading one its sub-bucket
+	const int32 nExponent = (int32)FMath::FloorLog2_64(Nanoseconds);
+	if (nExponent > MaxExponent)
+		return NumBuckets - 1;
+
+	const int32 nSubBucket = (int32)(Nanoseconds >> (nExponent - SubBucketBits)) & ((1 << SubBucketBits) - 1);
+	return 1 + ((nExponent - MinExponent) << SubBucketBits) + nSubBucket;
+}
+
+uint64 FViveTrackerXrCallHistogram::GetBucketUpperBound(int32 Bucket)
+{
+	if (Bucket == 0)
+		return 1ull << MinExponent;
+
+	const int32 nExponent = MinExponent + ((Bucket - 1) >> SubBucketBits);
+	const uint64 nSubBucket = (uint64)((Bucket - 1) & ((1 << SubBucketBits) - 1));
+	return ((1ull << SubBucketBits) + nSubBucket + 1) << (nExponent - SubBucketBits);
+}
+
+static XrResult XRAPI_CALL ProfiledEnumerateViveTrackerPaths(XrInstance Instance, uint32_t PathCapacityInput, uint32_t* pPathCountOutput, XrViveTrackerPathsHTCX* pPaths)
+{
+	VIVETRACKER_XR_CALL_SCOPE(EnumerateViveTrackerPaths);
+	return GProfiledEnumerateViveTrackerPaths(Instance, PathCapacityInput, pPathCountOutput, pPaths);
+}
+
+static XrResult XRAPI_CALL ProfiledGetInstanceProcAddr(XrInstance Instance, const char* pName, PFN_xrVoidFunction* pFunction)
+{
+	XrResult result;
+	{
+		VIVETRACKER_XR_CALL_SCOPE(GetInstanceProcAddr);
+		result = GProfiledEntryPoints.GetInstanceProcAddr(Instance, pName, pFunction);
+	}
+
+	// Extension functions are profiled too, the session resolves them itself
+	if (result == XR_SUCCESS && *pFunction != nullptr && FCStringAnsi::Strcmp(pName, "xrEnumerateViveTrackerPathsHTCX") == 0)
+	{
+		GProfiledEnumerateViveTrackerPaths = (PFN_xrEnumerateViveTrackerPathsHTCX)*pFunction;
+		*pFunction = (PFN_xrVoidFunction)&ProfiledEnumerateViveTrackerPaths;
+	}
+	return result;
+}
+
+static XrResult XRAPI_CALL ProfiledCreateActionSet(XrInstance Instance, const XrActionSetCreateInfo* pCreateInfo, XrActionSet* pActionSet)
+{
+	VIVETRACKER_XR_CALL_SCOPE(CreateActionSet);
+	return GProfiledEntryPoints.CreateActionSet(Instance, pCreateInfo, pActionSet);
+}
+
+static XrResult XRAPI_CALL ProfiledDestroyActionSet(XrActionSet ActionSet)
+{
+	VIVETRACKER_XR_CALL_SCOPE(DestroyActionSet);
+	return GProfiledEntryPoints.DestroyActionSet(ActionSet);
+}
+
+static XrResult XRAPI_CALL ProfiledCreateAction(XrActionSet ActionSet, const XrActionCreateInfo* pCreateInfo, XrAction* pAction)
+{
+	VIVETRACKER_XR_CALL_SCOPE(CreateAction);
+	return GProfiledEntryPoints.CreateAction(ActionSet, pCreateInfo, pAction);
+}
+
+static XrResult XRAPI_CALL ProfiledDestroyAction(XrAction Action)
+{
+	VIVETRACKER_XR_CALL_SCOPE(DestroyAction);
+	return GProfiledEntryPoints.DestroyAction(Action);
+}
+
+static XrResult XRAPI_CALL ProfiledCreateActionSpace(XrSession Session, const XrActionSpaceCreateInfo* pCreateInfo, XrSpace* pSpace)
+{
+	VIVETRACKER_XR_CALL_SCOPE(CreateActionSpace);
+	return GProfiledEntryPoints.CreateActionSpace(Session, pCreateInfo, pSpace);
+}
+
+static XrResult XRAPI_CALL ProfiledSuggestInteractionProfileBindings(XrInstance Instance, const XrInteractionProfileSuggestedBinding* pSuggestedBindings)
+{
+	VIVETRACKER_XR_CALL_SCOPE(SuggestInteractionProfileBindings);
+	return GProfiledEntryPoints.SuggestInteractionProfileBindings(Instance, pSuggestedBindings);
+}
+
+static XrResult XRAPI_CALL ProfiledLocateSpace(XrSpace Space, XrSpace BaseSpace, XrTime Time, XrSpaceLocation* pLocation)
+{
+	VIVETRACKER_XR_CALL_SCOPE(LocateSpace);
+	return GProfiledEntryPoints.LocateSpace(Space, BaseSpace, Time, pLocation);
+}
+
+static XrResult XRAPI_CALL ProfiledStringToPath(XrInstance Instance, const char* pPathString, XrPath* pPath)
+{
+	VIVETRACKER_XR_CALL_SCOPE(StringToPath);
+	return GProfiledEntryPoints.StringToPath(Instance, pPathString, pPath);
+}
+
+static XrResult XRAPI_CALL ProfiledPathToString(XrInstance Instance, XrPath Path, uint32_t BufferCapacityInput, uint32_t* pBufferCountOutput, char* pBuffer)
+{
+	VIVETRACKER_XR_CALL_SCOPE(PathToString);
+	return GProfiledEntryPoints.PathToString(Instance, Path, BufferCapacityInput, pBufferCountOutput, pBuffer);
+}
+
+ViveTrackerCore::FXrEntryPoints FViveTrackerXrProfiler::Wrap(const ViveTrackerCore::FXrEntryPoints& EntryPoints)
+{
+	GProfiledEntryPoints = EntryPoints;
+	GProfiledEnumerateViveTrackerPaths = nullptr;
+
+	// Missing entry points stay missing
+	ViveTrackerCore::FXrEntryPoints profiledEntryPoints;
+	profiledEntryPoints.GetInstanceProcAddr = EntryPoints.GetInstanceProcAddr ? &ProfiledGetInstanceProcAddr : nullptr;
+	profiledEntryPoints.CreateActionSet = EntryPoints.CreateActionSet ? &ProfiledCreateActionSet : nullptr;
+	profiledEntryPoints.DestroyActionSet = EntryPoints.DestroyActionSet ? &ProfiledDestroyActionSet : nullptr;
+	profiledEntryPoints.CreateAction = EntryPoints.CreateAction ? &ProfiledCreateAction : nullptr;
+	profiledEntryPoints.DestroyAction = EntryPoints.DestroyAction ? &ProfiledDestroyAction : nullptr;
+	profiledEntryPoints.CreateActionSpace = EntryPoints.CreateActionSpace ? &ProfiledCreateActionSpace : nullptr;
+	profiledEntryPoints.SuggestInteractionProfileBindings = EntryPoints.SuggestInteractionProfileBindings ? &ProfiledSuggestInteractionProfileBindings : nullptr;
+	profiledEntryPoints.LocateSpace = EntryPoints.LocateSpace ? &ProfiledLocateSpace : nullptr;
+	profiledEntryPoints.StringToPath = EntryPoints.StringToPath ? &ProfiledStringToPath : nullptr;
+	profiledEntryPoints.PathToString = EntryPoints.PathToString ? &ProfiledPathToString : nullptr;
+	return profiledEntryPoints;
+}
+
+void FViveTrackerXrProfiler::SetEnabled(bool bEnabled)
+{
+	GXrProfilerEnabled = bEnabled;
+}
+
+bool FViveTrackerXrProfiler::IsEnabled()
+{
+	return GXrProfilerEnabled;
+}
+
+void FViveTrackerXrProfiler::Reset()
+{
+	for (FViveTrackerXrCallHistogram& Histogram : GXrCallHistograms)
+	{
+		Histogram.Reset();
+	}
+}
+
+void FViveTrackerXrProfiler::Record(EViveTrackerXrCall Call, uint64 StartCycles)
+{
+	const uint64 nCycles = FPlatformTime::Cycles64() - StartCycles;
+	GXrCallHistograms[(int32)Call].Add((uint64)(nCycles * FPlatformTime::GetSecondsPerCycle64() * 1.0e9));
+}
+
+const FViveTrackerXrCallHistogram& FViveTrackerXrProfiler::GetHistogram(EViveTrackerXrCall Call)
+{
+	return GXrCallHistograms[(int32)Call];
+}
+
+const TCHAR* FViveTrackerXrProfiler::GetCallName(EViveTrackerXrCall Call)
+{
+	switch (Call)
+	{
+	case EViveTrackerXrCall::GetInstanceProcAddr: return TEXT("xrGetInstanceProcAddr");
+	case EViveTrackerXrCall::CreateActionSet: return TEXT("xrCreateActionSet");
+	case EViveTrackerXrCall::DestroyActionSet: return TEXT("xrDestroyActionSet");
+	case EViveTrackerXrCall::CreateAction: return TEXT("xrCreateAction");
+	case EViveTrackerXrCall::DestroyAction: return TEXT("xrDestroyAction");
+	case EViveTrackerXrCall::CreateActionSpace: return TEXT("xrCreateActionSpace");
+	case EViveTrackerXrCall::SuggestInteractionProfileBindings: return TEXT("xrSuggestInteractionProfileBindings");
+	case EViveTrackerXrCall::LocateSpace: return TEXT("xrLocateSpace");
+	case EViveTrackerXrCall::StringToPath: return TEXT("xrStringToPath");
+	case EViveTrackerXrCall::PathToString: return TEXT("xrPathToString");
+	case EViveTrackerXrCall::EnumerateViveTrackerPaths: return TEXT("xrEnumerateViveTrackerPathsHTCX");
+	case EViveTrackerXrCall::ConvertTime: return FViveTrackerClock::GetConvertFunctionName();
+	default: return TEXT("Unknown");
+	}
+}
+
+void FViveTrackerXrProfiler::LogReport(FOutputDevice& Ar)
+{
+	Ar.Logf(TEXT("OpenXR calls, profiling %s, durations in us:"), IsEnabled() ? TEXT("on") : TEXT("off"));
+
+	for (int32 nCall = 0; nCall < (int32)EViveTrackerXrCall::Num; nCall++)
+	{
+		const FViveTrackerXrCallHistogram& Histogram = GXrCallHistograms[nCall];
+		if (Histogram.Num() == 0)
+			continue;
+
+		Ar.Logf(TEXT("  %s: %lld calls, total %.3f ms, mean %.2f, p50 %.2f, p90 %.2f, p99 %.2f, p99.9 %.2f, max %.2f"),
+			GetCallName((EViveTrackerXrCall)nCall), Histogram.Num(), Histogram.GetTotal() * 1.0e3, Histogram.GetMean() * 1.0e6,
+			Histogram.GetPercentile(0.5) * 1.0e6, Histogram.GetPercentile(0.9) * 1.0e6, Histogram.GetPercentile(0.99) * 1.0e6,
+			Histogram.GetPercentile(0.999) * 1.0e6, Histogram.GetMax() * 1.0e6);
+	}
+}
+
+bool FViveTrackerXrProfiler::WriteCsv(const FString& Filename)
+{
+	FString sCsv = TEXT("Function,Calls,TotalMs,MeanUs,P50Us,P90Us,P99Us,P999Us,MaxUs\n");
+	for (int32 nCall = 0; nCall < (int32)EViveTrackerXrCall::Num; nCall++)
+	{
+		const FViveTrackerXrCallHistogram& Histogram = GXrCallHistograms[nCall];
+		if (Histogram.Num() == 0)
+			continue;
+
+		sCsv += FString::Printf(TEXT("%s,%lld,%.4f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n"),
+			GetCallName((EViveTrackerXrCall)nCall), Histogram.Num(), Histogram.GetTotal() * 1.0e3, Histogram.GetMean() * 1.0e6,
+			Histogram.GetPercentile(0.5) * 1.0e6, Histogram.GetPercentile(0.9) * 1.0e6, Histogram.GetPercentile(0.99) * 1.0e6,
+			Histogram.GetPercentile(0.999) * 1.0e6, Histogram.GetMax() * 1.0e6);
+	}
+
+	if (!FFileHelper::SaveStringToFile(sCsv, *Filename))
+	{
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Unable to write OpenXR call profile to %s"), *Filename);
+		return false;
+	}
+	return true;
+}
@@ -46,6 +46,12 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "IOpenXRHMDPlugin.h"
 
+#include "ViveTrackerClock.h"
+#include "ViveTrackerCore/ViveTrackerSession.h"
+#include "ViveTrackerSample.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Atomic.h"
+
 
 UENUM()
 enum ETrackerRole
@@ -65,7 +71,65 @@ enum ETrackerRole
 	Unassigned	UMETA(DisplayName = "Unassigned"),
 };
 
-class FOpenXRViveTrackerModule : 
+class FViveTrackerCaptureWriter;
+class FViveTrackerDebugDraw;
+class FViveTrackerLatencyRecorder;
+class FViveTrackerReplay;
+struct FViveTrackerReplaySettings;
+struct FViveTrackerDebugDrawSettings;
+
+namespace ViveTrackerCore
+{
+	struct FCaptureSample;
+	struct FCaptureEvent;
+}
+
+/** Fired on the game thread when a tracker connects, with its persistent path and runtime role */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnViveTrackerConnected, const FString&, ETrackerRole);
+
+/** How a role's tracker has been located since the stats were last reset, gathered by PostSyncActions */
+struct FViveTrackerRoleStats
+{
+	/** Frames the tracker was located with a valid pose */
+	int64 NumLocated = 0;
+
+	/** Frames the tracker was located without a valid pose, i.e. it lost tracking */
+	int64 NumLost = 0;
+
+	/** Frames xrLocateSpace failed for the role */
+	int64 NumErrors = 0;
+
+	/** Seconds between consecutive valid poses, summed over NumIntervals and at most */
+	double SumIntervalSeconds = 0.0;
+	double MaxIntervalSeconds = 0.0;
+	int64 NumIntervals = 0;
+
+	/** Seconds valid poses were predicted ahead of when they were sampled, summed over NumPredictions. Needs time conversion. */
+	double SumPredictionSeconds = 0.0;
+	int64 NumPredictions = 0;
+
+	/** FPlatformTime::Seconds() of the latest valid pose, 0 if none */
+	double LastLocatedSeconds = 0.0;
+};
+
+/** Time spent in PostSyncActions since the stats were last reset */
+struct FViveTrackerSyncStats
+{
+	/** Frames PostSyncActions ran */
+	int64 NumFrames = 0;
+
+	/** Seconds spent in the whole of PostSyncActions, summed and at most */
+	double SumSeconds = 0.0;
+	double MaxSeconds = 0.0;
+
+	/** Seconds spent locating every role, summed */
+	double SumLocateSeconds = 0.0;
+
+	/** Seconds spent publishing the located poses to the samples, histories and capture, summed */
+	double SumPublishSeconds = 0.0;
+};
+
+class OPENXRVIVETRACKER_API FOpenXRViveTrackerModule : 
 	public IModuleInterface,
 	public IOpenXRExtensionPlugin,
 	public IInputDevice,
@@ -73,6 +137,8 @@ class FOpenXRViveTrackerModule :
 {
 public:
 
+	virtual ~FOpenXRViveTrackerModule();
+
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
@@ -84,6 +150,7 @@ public:
 	}
 
 	virtual bool GetRequiredExtensions(TArray<const ANSICHAR*>& OutExtensions) override;
+	virtual bool GetOptionalExtensions(TArray<const ANSICHAR*>& OutExtensions) override;
 	virtual void PostCreateInstance(XrInstance InInstance) override;
 	virtual void PostCreateSession(XrSession InSession) override;
 	virtual const void* OnBeginSession(XrSession InSession, const void* InNext) override;
@@ -96,6 +163,7 @@ public:
 	virtual bool GetControllerOrientationAndPosition(const int32 ControllerIndex, const FName MotionSource, FRotator& OutOrientation, FVector& OutPosition, float WorldToMetersScale) const override;
 	virtual bool GetControllerOrientationAndPosition(const int32 ControllerIndex, const EControllerHand DeviceHand, FRotator& OutOrientation, FVector& OutPosition, float WorldToMetersScale) const override;
 	virtual ETrackingStatus GetControllerTrackingStatus(const int32 ControllerIndex, const EControllerHand DeviceHand) const override;
+	virtual ETrackingStatus GetControllerTrackingStatus(const int32 ControllerIndex, const FName MotionSource) const override;
 	virtual FName GetMotionControllerDeviceTypeName() const override;
 	virtual void EnumerateSources(TArray<FMotionControllerSource>& SourcesOut) const override;
 
@@ -112,7 +180,13 @@ public:
 	* Check whether or not the tracker pose actions have all been generated
 	* @return bool - Whether or not tracker pose actions have been generated
 	*/
-	bool IsActionsGenerated() { return m_bActionsGenerated;  }
+	bool IsActionsGenerated() { return m_session.IsActionsGenerated();  }
+
+	/**
+	* Destroy the tracker actions and action set and forget the runtime's instance, session and trackers,
+	* so the module can be driven by another runtime, e.g. FViveTrackerMockRuntime
+	*/
+	void ReleaseRuntimeResources();
 
 	/**
 	* Retrieve all the pose actions generated by this plugin
@@ -145,28 +219,366 @@ public:
 	*/
 	FTransform GetTrackerTransform(ETrackerRole trackerRole);
 
+	/**
+	* Obtain the latest timestamped sample of a tracker from a given role
+	* @param ETrackerRole - The assigned role of the tracker you want the sample of
+	* @param FViveTrackerSample - Receives the tracker's latest sample
+	* @return bool - Whether or not the role is known to this plugin
+	*/
+	bool GetTrackerSample(ETrackerRole trackerRole, FViveTrackerSample& OutSample) const;
+
+	/**
+	* Obtain the tracker transform from a given role at an arbitrary runtime time, interpolated from
+	* the tracker's recent history or extrapolated from its latest velocity. Safe to call from any thread.
+	* @param ETrackerRole - The assigned role of the tracker you want the transform of
+	* @param XrTime - The runtime time to evaluate the transform at
+	* @param FTransform - Receives the transform of the tracker
+	* @return bool - Whether or not the tracker has been located at least once
+	*/
+	bool GetTrackerTransformAtTime(ETrackerRole trackerRole, XrTime Time, FTransform& OutTransform) const;
+
+	/**
+	* Obtain the transforms of several trackers at every substep of a physics step, in a single batch.
+	* The step is assumed to end at the current predicted display time. Safe to call from any thread.
+	* @param TArrayView<const ETrackerRole> - The roles of the trackers to evaluate
+	* @param float - Duration of the whole physics step in seconds
+	* @param int32 - Number of substeps the step is divided into
+	* @param TArrayView<FTransform> - Receives Roles.Num() * NumSubsteps transforms, substep-major.
+	*								  Trackers that were never located get an identity transform.
+	*/
+	void GetTrackerSubstepTransforms(TArrayView<const ETrackerRole> Roles, float StepDeltaTime, int32 NumSubsteps, TArrayView<FTransform> OutTransforms) const;
+
+	/**
+	* Runtime time at the end of a physics substep, assuming the whole step ends at the current predicted display time.
+	* Safe to call from any thread.
+	* @param float - Duration of the whole physics step in seconds
+	* @param int32 - Index of the substep
+	* @param int32 - Number of substeps the step is divided into
+	* @return XrTime - Runtime time at the end of the substep
+	*/
+	XrTime GetSubstepTime(float StepDeltaTime, int32 SubstepIndex, int32 NumSubsteps) const;
+
+	/**
+	* Obtain the latest samples of several trackers in a single batch. Safe to call from any thread.
+	* @param TArrayView<const ETrackerRole> - The roles of the trackers you want the samples of
+	* @param TArrayView<FViveTrackerSample> - Receives one sample per role, default samples for unknown roles
+	*/
+	void GetTrackerSamples(TArrayView<const ETrackerRole> Roles, TArrayView<FViveTrackerSample> OutSamples) const;
+
+	/**
+	* Look up the role currently assigned to a tracker by its persistent path (e.g. /devices/htc/vive_trackerLHR-XXXXXXXX).
+	* A role inferred through SetInferredTrackerRoles takes precedence over the one assigned in the runtime.
+	* @param FString - The persistent path of the tracker
+	* @param ETrackerRole - Receives the tracker's role, Unassigned if the runtime reports no role for it
+	* @return bool - Whether or not the tracker is currently reported by the runtime
+	*/
+	bool GetTrackerRoleFromPersistentPath(const FString& PersistentPath, ETrackerRole& OutRole) const;
+
+	/**
+	* List every tracker currently reported by the runtime, with the role it answers to as in GetTrackerRoleFromPersistentPath
+	* @param TArray<FString> - Receives the persistent paths of the trackers
+	* @param TArray<ETrackerRole> - Receives one role per persistent path
+	*/
+	void GetTrackerPersistentPaths(TArray<FString>& OutPersistentPaths, TArray<ETrackerRole>& OutRoles) const;
+
+	/**
+	* Make trackers answer to roles other than the ones assigned in the runtime, e.g. roles inferred by a
+	* UViveTrackerRoleClassifierComponent. Every role based getter follows the new roles. Trackers need some
+	* role assigned in the runtime to be located at all, only that role can be changed here.
+	* @param TMap<FString, ETrackerRole> - Role per persistent path, an empty map restores the runtime's roles
+	*/
+	void SetInferredTrackerRoles(const TMap<FString, ETrackerRole>& InferredRoles);
+
+	/**
+	* Counter incremented every time the runtime's tracker paths are re-enumerated or inferred roles change,
+	* so callers can cache persistent path lookups until it changes
+	* @return uint32 - The current tracker paths generation
+	*/
+	uint32 GetTrackerPathsGeneration() const { return m_nTrackerPathsGeneration; }
+
+	/**
+	* Top level user path the runtime binds a tracker role to
+	* @param ETrackerRole - The tracker role
+	* @return const char* - The role's user path, nullptr for Unassigned
+	*/
+	static const char* GetTrackerRolePath(ETrackerRole role);
+
+	/**
+	* Reverse lookup of GetTrackerRolePath
+	* @param const char* - A tracker role user path
+	* @return ETrackerRole - The matching role, Unassigned if the path isn't a known role path
+	*/
+	static ETrackerRole GetTrackerRoleFromPath(const char* pRolePath);
+
+	/**
+	* Convert a runtime time to the platform's monotonic clock without calling into the runtime
+	* @param XrTime - The runtime time to convert
+	* @return int64 - Platform monotonic time in nanoseconds, 0 if the runtime doesn't support time conversion
+	*/
+	int64 ConvertXrTimeToPlatformTime(XrTime Time) const { return m_clock.XrTimeToPlatformTime(Time); }
+
+	/**
+	* Convert a platform monotonic time to runtime time without calling into the runtime
+	* @param int64 - Platform monotonic time in nanoseconds
+	* @return XrTime - The runtime time, 0 if the runtime doesn't support time conversion
+	*/
+	XrTime ConvertPlatformTimeToXrTime(int64 PlatformTimeNs) const { return m_clock.PlatformTimeToXrTime(PlatformTimeNs); }
+
+	/**
+	* Getter for the runtime to platform clock estimator
+	* @return FViveTrackerClock - The clock estimator
+	*/
+	const FViveTrackerClock& GetClock() const { return m_clock; }
+
+	/**
+	* Start recording every tracker sample and connect event to a capture file, read it back with a FViveTrackerCaptureReader.
+	* Replaces the capture in progress, if any.
+	* @param FString - Path of the capture file, a timestamped file under Saved/ViveTracker if empty
+	* @param bool - Compress samples with the default error bounds of the capture codec
+	* @return bool - Whether or not the capture file could be created
+	*/
+	bool StartCapture(const FString& Filename = FString(), bool bCompress = true);
+
+	/** Finish the capture in progress, if any */
+	void StopCapture();
+
+	/**
+	* Check whether or not tracker samples are being captured
+	* @return bool - Whether or not a capture is in progress
+	*/
+	bool IsCapturing() const { return m_pCaptureWriter.IsValid(); }
+
+	/**
+	* Serve every getter, the motion controller sources and connect events from a capture file instead of the runtime.
+	* Replaces the replay in progress, if any. Also started by the -ViveTrackerReplay=<file> command line switch, with
+	* -ViveTrackerReplayStep=<seconds> for a fixed step, -ViveTrackerReplayRate=<rate> and -ViveTrackerReplayLoop, so game code runs
+	* unchanged without a headset.
+	* @param FString - Path of the capture file
+	* @param FViveTrackerReplaySettings - How the replay advances
+	* @return bool - Whether or not the capture could be opened
+	*/
+	bool StartReplay(const FString& Filename, const FViveTrackerReplaySettings& Settings);
+
+	/** Stop replaying and go back to the runtime's trackers */
+	void StopReplay();
+
+	/**
+	* Check whether or not tracker samples are served from a capture
+	* @return bool - Whether or not a replay is in progress
+	*/
+	bool IsReplaying() const { return m_pReplay.IsValid(); }
+
+	/**
+	* Check whether or not the replay reached the end of its capture, the last poses are held until it stops
+	* @return bool - Whether or not the replay in progress is finished
+	*/
+	bool IsReplayFinished() const;
+
+	/**
+	* Pause or resume the replay in progress, a paused replay holds its poses until it resumes or seeks
+	* @param bool - Whether or not the replay should be paused
+	*/
+	void SetReplayPaused(bool bPaused) { m_bReplayPaused = bPaused; }
+
+	/**
+	* Check whether or not the replay in progress is paused
+	* @return bool - Whether or not the replay is paused
+	*/
+	bool IsReplayPaused() const { return m_bReplayPaused; }
+
+	/**
+	* Move the replay to a time of its capture, paused or not. The seek happens at the start of the next frame,
+	* so only the last of several seeks in a frame costs anything, e.g. while scrubbing. Connect events between the
+	* keyframe the seek starts from and the new time aren't fired again.
+	* @param double - Seconds from the start of the capture
+	*/
+	void SeekReplay(double Seconds);
+
+	/**
+	* Playhead of the replay in progress, including a seek that hasn't happened yet
+	* @return double - Seconds from the start of the capture, 0 without a replay
+	*/
+	double GetReplayPosition() const;
+
+	/**
+	* Length of the capture being replayed
+	* @return double - Seconds from the first to the last sample of the capture, 0 without a replay
+	*/
+	double GetReplayDuration() const;
+
+	/**
+	* Settings of the replay in progress
+	* @return FViveTrackerReplaySettings - The settings, null without a replay
+	*/
+	const FViveTrackerReplaySettings* GetReplaySettings() const;
+
+	/**
+	* Change the speed, fixed step or looping of the replay in progress, the playhead stays where it is
+	* @param FViveTrackerReplaySettings - The new settings, DecodeAheadChunks is ignored
+	*/
+	void SetReplaySettings(const FViveTrackerReplaySettings& Settings);
+
+	/**
+	* Start measuring how long poses take from being sampled to being published, applied by tracker components
+	* and submitted for rendering. Replaces the results of the previous measurement. Game thread only.
+	*/
+	void StartLatencyRecording();
+
+	/** Stop measuring latency, the results stay available from GetLatencyRecorder until the next start */
+	void StopLatencyRecording();
+
+	/**
+	* Latency distributions of the current or last measurement
+	* @return FViveTrackerLatencyRecorder - The recorder, null if latency was never measured
+	*/
+	const FViveTrackerLatencyRecorder* GetLatencyRecorder() const { return m_pLatencyRecorder.Get(); }
+
+	/**
+	* Report a sample a consumer such as UViveTrackerComponent applied, for latency measurements. Game thread only.
+	* @param FViveTrackerSample - The applied sample
+	*/
+	void NotifySampleConsumed(const FViveTrackerSample& Sample);
+
+	/**
+	* Delegate fired on the game thread when a tracker connects, live or replayed
+	* @return FOnViveTrackerConnected - The delegate
+	*/
+	FOnViveTrackerConnected& OnTrackerConnected() { return m_onTrackerConnected; }
+
+	/**
+	* Locate statistics of a role since the last ResetStats. Game thread only.
+	* @param ETrackerRole - The tracker role, not Unassigned
+	* @return FViveTrackerRoleStats - The role's statistics
+	*/
+	const FViveTrackerRoleStats& GetRoleStats(ETrackerRole role) const { check(role < ETrackerRole::Unassigned); return m_arrRoleStats[role]; }
+
+	/**
+	* PostSyncActions timings since the last ResetStats. Game thread only.
+	* @return FViveTrackerSyncStats - The timings
+	*/
+	const FViveTrackerSyncStats& GetSyncStats() const { return m_syncStats; }
+
+	/** Reset the per-role, PostSyncActions and OpenXR call statistics. Game thread only. */
+	void ResetStats();
+
+	/**
+	* Locate poses at the runtime's predicted display time, the default, or at the time they are sampled. Without
+	* prediction poses lag a frame or more behind, which helps telling prediction overshoot from tracking issues.
+	* Poses stay predicted if the runtime can't convert time.
+	* @param bool - Whether or not poses should be predicted
+	*/
+	void SetPosePredictionEnabled(bool bEnabled) { m_bPosePrediction = bEnabled; }
+
+	/**
+	* Check whether or not poses are located at the predicted display time
+	* @return bool - Whether or not poses are predicted
+	*/
+	bool IsPosePredictionEnabled() const { return m_bPosePrediction; }
+
+	/**
+	* Interpolate and extrapolate the tracker history in GetTrackerTransformAtTime and GetTrackerSubstepTransforms,
+	* the default. When disabled both return the latest valid pose, whatever the time.
+	* @param bool - Whether or not the history should be filtered
+	*/
+	void SetPoseFilterEnabled(bool bEnabled);
+
+	/**
+	* Check whether or not poses at arbitrary times are filtered from the tracker history
+	* @return bool - Whether or not the history is filtered
+	*/
+	bool IsPoseFilterEnabled() const { return m_bPoseFilter; }
+
+	/**
+	* Draw every tracker's axes, velocity, trail and status into game worlds, or change what is drawn. Also started by the
+	* -ViveTrackerDebugDraw command line switch. Game thread only.
+	* @param FViveTrackerDebugDrawSettings - What to draw
+	*/
+	void StartDebugDraw(const FViveTrackerDebugDrawSettings& Settings);
+
+	/** Stop drawing trackers, which frees everything the overlay used */
+	void StopDebugDraw();
+
+	/**
+	* The tracker debug overlay
+	* @return FViveTrackerDebugDraw - The overlay, null when trackers aren't drawn
+	*/
+	const FViveTrackerDebugDraw* GetDebugDraw() const { return m_pDebugDraw.Get(); }
+
 	// Singleton-like getter
 	static inline FOpenXRViveTrackerModule& Get() { return FModuleManager::LoadModuleChecked<FOpenXRViveTrackerModule>("OpenXRViveTracker"); }
 
 private:
-	XrInstance m_xrInstance = XR_NULL_HANDLE;
-	XrSession m_xrSession = XR_NULL_HANDLE;
-	XrActionSet m_xrActionSet = XR_NULL_HANDLE;
-	XrSessionState m_xrCurrentSessionState = XR_SESSION_STATE_UNKNOWN;
+	// Role actions, connect events and locating, independent of the engine
+	ViveTrackerCore::FTrackerSession m_session;
 
-	bool m_bActionsGenerated = false;
 	TArray<XrAction> m_arrPoseActions;
 	TMap<XrAction, XrSpace> m_mapActionSpace;
-	TArray<XrActionSuggestedBinding> m_arrActionBindings;
 
-	XrTime m_predictedDisplayTime;
+	XrTime m_predictedDisplayTime = 0;
 	XrSpace m_baseSpace = XR_NULL_HANDLE;
 
-	TMap<XrAction, ETrackerRole> m_mapTrackerRoles;
-	TMap<ETrackerRole, FTransform> m_mapTrackerTransforms;
-
-	XrAction CreatePoseAction(const char* pName);
-	void CreateTrackerBinding(ETrackerRole role, XrAction xrAction);
+	// Last xrLocateSpace result per role, so errors are only logged when they change
+	XrResult m_arrLocateResults[(int32)ETrackerRole::Unassigned] = {};
+
+	// Diagnostics, only used from the game thread apart from the filter switch which is guarded by m_poseLock
+	FViveTrackerRoleStats m_arrRoleStats[(int32)ETrackerRole::Unassigned];
+	FViveTrackerSyncStats m_syncStats;
+	bool m_bPosePrediction = true;
+	bool m_bPoseFilter = true;
+
+	TMap<ETrackerRole, FViveTrackerSample> m_mapTrackerSamples;
+	TMap<ETrackerRole, FViveTrackerPoseHistory> m_mapTrackerHistory;
+
+	TMap<FString, ETrackerRole> m_mapPersistentPathRoles;
+	TMap<FString, ETrackerRole> m_mapInferredPathRoles;
+
+	// Inferred role to the runtime role the tracker is bound to, rebuilt whenever paths or inferred roles change
+	TMap<ETrackerRole, ETrackerRole> m_mapRoleOverrides;
+	TAtomic<uint32> m_nTrackerPathsGeneration{ 0 };
+
+	// Guards tracker samples, history and paths, which are read from the physics and animation threads
+	mutable FCriticalSection m_poseLock;
+
+	FViveTrackerClock m_clock;
+
+	// Only used from the game thread, like PostSyncActions and OnEvent
+	TUniquePtr<FViveTrackerCaptureWriter> m_pCaptureWriter;
+	TUniquePtr<FViveTrackerLatencyRecorder> m_pLatencyRecorder;
+	TUniquePtr<FViveTrackerDebugDraw> m_pDebugDraw;
+	FOnViveTrackerConnected m_onTrackerConnected;
+
+	// Reused for the connected tracker and path lookups, so connect handling keeps its storage
+	FString m_sConnectedPath;
+	FString m_sPathKey;
+
+	// Replay state, only used from the game thread
+	TUniquePtr<FViveTrackerReplay> m_pReplay;
+	double m_fReplayElapsed = 0.0;
+	// Pending seek in seconds from the start of the capture, negative if none
+	double m_fReplaySeekSeconds = -1.0;
+	bool m_bReplayPaused = false;
+	FDelegateHandle m_hReplayTick;
+	// The runtime's trackers while a replay shows the captured ones
+	TMap<FString, ETrackerRole> m_mapLivePersistentPathRoles;
+
+	void TickReplay();
+	void ApplyReplaySample(const ViveTrackerCore::FCaptureSample& captureSample);
+	void ApplyReplayEvent(const ViveTrackerCore::FCaptureEvent& captureEvent);
+	void ResetTrackerSamples();
+	ETrackerRole GetMotionSourceRole(const FName MotionSource) const;
+
+	void UpdateTrackerPaths();
+	static void AssignPathString(FString& OutString, const std::string& Path);
+	void RebuildRoleOverrides();
+	ETrackerRole GetBoundRole(ETrackerRole role) const;
+	ETrackerRole GetPathRole(const FString& persistentPath, ETrackerRole boundRole) const;
+
+	bool EvaluateHistory(const FViveTrackerPoseHistory* trackerHistory, XrTime Time, FTransform& OutTransform) const;
+	static XrTime GetSubstepTime(XrTime StepEndTime, float StepDeltaTime, int32 SubstepIndex, int32 NumSubsteps);
+	XrTime GetLocateTime() const;
+	void UpdateRoleStats(int32 nRole, const ViveTrackerCore::FTrackerLocation& location, double fSampledSeconds, int64 nSampledPlatformTime, int64 nPlatformTime);
+	void DumpStatus(FOutputDevice& Ar) const;
+	void DumpStats(FOutputDevice& Ar) const;
 };
 
 DEFINE_LOG_CATEGORY_STATIC(LogOpenXRViveTracker, Display, All);
@@ -0,0 +1,376 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerCore/ViveTrackerCaptureFormat.h"
+#include "ViveTrackerCore/ViveTrackerCaptureCodec.h"
+#include "ViveTrackerCore/ViveTrackerSpscRing.h"
+#include "HAL/Runnable.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Atomic.h"
+
+class FEvent;
+class FRunnableThread;
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/** A tracker known to a capture */
+struct FViveTrackerCaptureTracker
+{
+	/** Persistent path of the tracker, empty if the runtime never reported one while capturing */
+	FString PersistentPath;
+
+	/** Role the tracker was bound to in the runtime when it was last listed */
+	ETrackerRole Role = ETrackerRole::Unassigned;
+};
+
+/**
+* Writes every sample and connect event the module sees to a capture file (see ViveTrackerCaptureFormat.h).
+*
+* AddSample and AddEvent only push into lock-free single producer, single consumer rings sized once in
+* Open, so the pose path never blocks on the disk or allocates. A writer thread drains the rings into
+* chunks and writes them out in large sequential writes. If the disk falls behind and the sample ring
+* fills up, further samples are dropped, counted, and recorded in the capture as a SamplesDropped event.
+* Sample chunks can be compressed with the capture codec, which runs on the writer thread. A keyframe with
+* every tracker's latest state is written before a sample chunk whenever KeyframeInterval has passed since
+* the previous one, so readers can seek without decoding from the start.
+*
+* Everything but GetNumWrittenBytes is for the producer thread, the module's game thread.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerCaptureWriter : public FRunnable
+{
+public:
+	/** Number of samples per sample chunk, about a second of 12 trackers at 90Hz */
+	static constexpr int32 SamplesPerChunk = 1024;
+
+	/** Number of samples per compressed sample chunk, larger chunks spread the cost of each tracker's first sample */
+	static constexpr int32 CompressedSamplesPerChunk = 8192;
+
+	/** Default number of samples the ring holds before dropping, about two seconds of 30 trackers at 1kHz */
+	static constexpr int32 DefaultQueueCapacity = 64 * 1024;
+
+	/** Number of events the event ring holds */
+	static constexpr int32 EventQueueCapacity = 1024;
+
+	/** Chunks are gathered into writes of about this many bytes */
+	static constexpr int32 WriteBufferSize = 1024 * 1024;
+
+	/** Longest time samples wait in the writer before reaching the file, in seconds */
+	static constexpr double FlushInterval = 1.0;
+
+	/** Shortest time between keyframes in seconds, seeks decode at most this much capture past the keyframe they start from */
+	static constexpr double KeyframeInterval = 0.25;
+
+	FViveTrackerCaptureWriter();
+	virtual ~FViveTrackerCaptureWriter();
+
+	/**
+	* Create the capture file, replacing any existing file, write its header and start the writer thread
+	* @param FString - Path of the capture file
+	* @param XrTime - Runtime time the capture starts at
+	* @param int64 - Same instant on the platform's monotonic clock in nanoseconds
+	* @param ViveTrackerCore::FCaptureCodecSettings* - Error bounds to compress samples with, null to store them as is
+	* @param int32 - Number of samples that can be queued before samples are dropped
+	* @return bool - Whether or not the file could be created
+	*/
+	bool Open(const FString& Filename, XrTime StartTime, int64 StartPlatformTimeNs, const ViveTrackerCore::FCaptureCodecSettings* pCodecSettings = nullptr,
+		int32 QueueCapacity = DefaultQueueCapacity);
+
+	/** Stop the writer thread once everything queued is written, then write the directory and trailer and close the file */
+	void Close();
+
+	/** Whether or not a capture file is open */
+	bool IsOpen() const { return m_pFile != nullptr; }
+
+	/** Path of the open capture file */
+	const FString& GetFilename() const { return m_sFilename; }
+
+	/** Number of samples queued since the file was opened */
+	int64 GetNumSamples() const { return m_nSamples; }
+
+	/** Number of samples dropped because the writer thread fell behind */
+	int64 GetNumDroppedSamples() const { return m_nDroppedSamples; }
+
+	/** Number of bytes written to the file so far, safe to call from any thread */
+	int64 GetNumWrittenBytes() const { return m_nWrittenBytes.Load(EMemoryOrder::Relaxed); }
+
+	/**
+	* Record the trackers currently reported by the runtime. Trackers keep their id across calls,
+	* only new trackers and role changes are written.
+	* @param TMap<FString, ETrackerRole> - Runtime role per persistent path
+	*/
+	void SetTrackerPaths(const TMap<FString, ETrackerRole>& PersistentPathRoles);
+
+	/**
+	* Queue a located sample, never blocks or allocates once the tracker is known to the capture
+	* @param ETrackerRole - Runtime role the sample was located through
+	* @param FViveTrackerSample - The sample
+	*/
+	void AddSample(ETrackerRole Role, const FViveTrackerSample& Sample);
+
+	/**
+	* Queue an event
+	* @param ViveTrackerCore::ECaptureEvent - Type of the event
+	* @param FString - Persistent path of the tracker the event is about, may be empty
+	* @param ETrackerRole - Runtime role of that tracker
+	* @param XrTime - Runtime time of the event
+	* @param int64 - Same instant on the platform's monotonic clock in nanoseconds
+	*/
+	void AddEvent(ViveTrackerCore::ECaptureEvent Type, const FString& PersistentPath, ETrackerRole Role, XrTime Time, int64 PlatformTimeNs);
+
+	/** Record dropped samples, warn when the writer thread falls behind and wake it once a chunk's worth of samples is queued */
+	void Update();
+
+	/**
+	* Convert a sample to its capture record
+	* @param ETrackerRole - Runtime role the sample was located through
+	* @param uint16 - Id of the tracker in the capture
+	* @param FViveTrackerSample - The sample
+	* @return ViveTrackerCore::FCaptureSample - The capture record
+	*/
+	static ViveTrackerCore::FCaptureSample ToCaptureSample(ETrackerRole Role, uint16 TrackerId, const FViveTrackerSample& Sample);
+
+	/** FRunnable, the writer thread */
+	virtual uint32 Run() override;
+
+private:
+	struct FPendingTracker
+	{
+		uint16 TrackerId;
+		FViveTrackerCaptureTracker Tracker;
+	};
+
+	// Producer side
+	uint16 FindOrAddTracker(const FString& PersistentPath, ETrackerRole Role);
+	void PushEvent(const ViveTrackerCore::FCaptureEvent& Event);
+
+	TMap<FString, uint16> m_mapTrackerIds;
+	TArray<FViveTrackerCaptureTracker> m_arrTrackers;
+	TArray<uint16> m_arrRoleTrackers;
+	int64 m_nSamples = 0;
+	int64 m_nDroppedSamples = 0;
+	int64 m_nUnrecordedDrops = 0;
+	XrTime m_nLastSampleTime = 0;
+	int64 m_nLastSamplePlatformTime = 0;
+	bool m_bFallingBehind = false;
+
+	// Shared between both sides
+	ViveTrackerCore::TSpscRing<ViveTrackerCore::FCaptureSample> m_sampleQueue;
+	ViveTrackerCore::TSpscRing<ViveTrackerCore::FCaptureEvent> m_eventQueue;
+
+	// New trackers and role changes are rare, they go through a lock instead of a ring
+	FCriticalSection m_trackerLock;
+	TArray<FPendingTracker> m_arrPendingTrackers;
+
+	FRunnableThread* m_pThread = nullptr;
+	FEvent* m_pWakeEvent = nullptr;
+	TAtomic<bool> m_bStopping{ false };
+	TAtomic<int64> m_nWrittenBytes{ 0 };
+
+	// Writer thread side, also used by Open and Close while the thread isn't running
+	void Drain(bool bFinal);
+	void AppendSamples();
+	void AppendKeyframe(XrTime Time);
+	void UpdateKeyframeState();
+	void AppendTrackers(const TArray<FPendingTracker>& arrTrackers);
+	void AppendChunk(uint32 Type, uint32 Count, const void* pData, int64 nSize, int64 nFirstTime, int64 nLastTime);
+	void FlushWriteBuffer();
+
+	IFileHandle* m_pFile = nullptr;
+	FString m_sFilename;
+	uint64 m_nOffset = 0;
+	bool m_bWriteFailed = false;
+	uint64 m_nLastFlushCycles = 0;
+
+	TArray<ViveTrackerCore::FCaptureChunkInfo> m_arrChunks;
+	TArray<ViveTrackerCore::FCaptureSample> m_arrStagedSamples;
+	uint32 m_nStagedSamples = 0;
+	uint32 m_nSamplesPerChunk = SamplesPerChunk;
+	TUniquePtr<ViveTrackerCore::FCaptureEncoder> m_pEncoder;
+	TArray<uint8> m_arrEncodedSamples;
+	TArray<ViveTrackerCore::FCaptureEvent> m_arrStagedEvents;
+	TArray<uint8> m_arrWriteBuffer;
+
+	// Latest sample and latest sample with a valid pose of every tracker by id, TrackerId is CaptureNoTracker until there is one
+	TArray<ViveTrackerCore::FCaptureSample> m_arrLatestSamples;
+	TArray<ViveTrackerCore::FCaptureSample> m_arrLatestPoses;
+	TArray<uint8> m_arrKeyframe;
+	XrTime m_nLastKeyframeTime = 0;
+	bool m_bHasKeyframeState = false;
+};
+
+/** Scratch memory for reading compressed sample chunks, keep one per reading thread */
+struct FViveTrackerCaptureDecodeBuffer
+{
+	ViveTrackerCore::FCaptureDecoder Decoder;
+	TArray<ViveTrackerCore::FCaptureSample> Samples;
+};
+
+/** Tracker state at a point of a capture, see ViveTrackerCore::FCaptureKeyframe */
+struct FViveTrackerCaptureKeyframe
+{
+	/** Time of the first sample of the sample chunk the keyframe comes before */
+	XrTime Time = 0;
+
+	/** Index of that sample chunk */
+	int32 SampleChunk = 0;
+
+	/** Latest samples of every tracker before the sample chunk in time order, pointing into the mapping */
+	TArrayView<const ViveTrackerCore::FCaptureSample> Samples;
+};
+
+/**
+* Reads a capture file through a memory mapping. Uncompressed samples are served straight from the mapping
+* without copies, compressed chunks are decoded one at a time into a caller's buffer, and opening only reads the directory at the end of the file and the few tracker and event
+* chunks, so even hour long captures open instantly. Keyframes are indexed from the directory as well, so reaching any time
+* takes a binary search and decoding from the keyframe before it. Captures that weren't closed are recovered by walking their chunks.
+* Can be read from any number of threads once opened.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerCaptureReader
+{
+public:
+	~FViveTrackerCaptureReader() { Close(); }
+
+	/**
+	* Map a capture file and read its directory
+	* @param FString - Path of the capture file
+	* @return bool - Whether or not the file is a capture this version can read
+	*/
+	bool Open(const FString& Filename);
+
+	/** Unmap the capture file */
+	void Close();
+
+	/** Whether or not a capture file is open */
+	bool IsOpen() const { return m_pData != nullptr; }
+
+	/** Header of the open capture */
+	const ViveTrackerCore::FCaptureHeader& GetHeader() const { return *reinterpret_cast<const ViveTrackerCore::FCaptureHeader*>(m_pData); }
+
+	/** Whether or not the capture was closed properly, captures that weren't may miss their last samples */
+	bool IsComplete() const { return m_bComplete; }
+
+	/** Every tracker in the capture, indexed by the TrackerId of samples and events */
+	const TArray<FViveTrackerCaptureTracker>& GetTrackers() const { return m_arrTrackers; }
+
+	/** Every event in the capture, in time order */
+	TArrayView<const ViveTrackerCore::FCaptureEvent> GetEvents() const { return m_arrEvents; }
+
+	/** Number of sample chunks */
+	int32 GetNumSampleChunks() const { return m_arrSampleChunks.Num(); }
+
+	/** Directory entry of a sample chunk */
+	const ViveTrackerCore::FCaptureChunkInfo& GetSampleChunkInfo(int32 ChunkIndex) const { return m_arrSampleChunks[ChunkIndex]; }
+
+	/** Whether or not a sample chunk is compressed */
+	bool IsSampleChunkCompressed(int32 ChunkIndex) const { return m_arrSampleChunks[ChunkIndex].Type == ViveTrackerCore::CaptureChunk_CompressedSamples; }
+
+	/**
+	* Samples of a chunk, pointing into the mapping for uncompressed chunks and decoded into the buffer for compressed ones
+	* @param int32 - Index of the sample chunk
+	* @param FViveTrackerCaptureDecodeBuffer - Receives the decoded samples, the returned view is valid until the buffer is reused
+	* @return TArrayView<const ViveTrackerCore::FCaptureSample> - The chunk's samples in time order, empty if the chunk is corrupt
+	*/
+	TArrayView<const ViveTrackerCore::FCaptureSample> GetSampleChunk(int32 ChunkIndex, FViveTrackerCaptureDecodeBuffer& Buffer) const;
+
+	/** Total number of samples */
+	int64 GetNumSamples() const { return m_nSamples; }
+
+	/** Runtime time of the first and last sample */
+	XrTime GetStartTime() const { return m_nStartTime; }
+	XrTime GetEndTime() const { return m_nEndTime; }
+
+	/**
+	* Binary search for the sample chunk holding a time
+	* @param XrTime - Runtime time to look for
+	* @return int32 - Last chunk starting at or before the time, 0 if the time is before the first chunk, INDEX_NONE without samples
+	*/
+	int32 FindSampleChunk(XrTime Time) const;
+
+	/** Number of keyframes, captures written before keyframes existed have none */
+	int32 GetNumKeyframes() const { return m_arrKeyframes.Num(); }
+
+	/** A keyframe, in time order */
+	const FViveTrackerCaptureKeyframe& GetKeyframe(int32 KeyframeIndex) const { return m_arrKeyframes[KeyframeIndex]; }
+
+	/**
+	* Binary search for the keyframe to start decoding from to reach a time
+	* @param XrTime - Runtime time to look for
+	* @return int32 - Last keyframe at or before the time, INDEX_NONE if there is none
+	*/
+	int32 FindKeyframe(XrTime Time) const;
+
+	/**
+	* Find the latest sample of a tracker at or before a time. Searches back to the keyframe before the time and
+	* takes the tracker's state from it, without keyframes gives up after MaxChunks chunks.
+	* @param uint16 - Id of the tracker
+	* @param XrTime - Runtime time to look for
+	* @param FViveTrackerSample - Receives the sample
+	* @param FViveTrackerCaptureDecodeBuffer - Scratch memory for compressed chunks
+	* @param int32 - How many chunks to search back before giving up when the capture has no keyframe before the time
+	* @return bool - Whether or not a sample was found
+	*/
+	bool FindTrackerSample(uint16 TrackerId, XrTime Time, FViveTrackerSample& OutSample, FViveTrackerCaptureDecodeBuffer& Buffer, int32 MaxChunks = 4) const;
+
+	/**
+	* Convert a capture record back to a sample
+	* @param ViveTrackerCore::FCaptureSample - The capture record
+	* @return FViveTrackerSample - The sample
+	*/
+	static FViveTrackerSample ToTrackerSample(const ViveTrackerCore::FCaptureSample& CaptureSample);
+
+private:
+	bool ReadDirectory();
+	bool WalkChunks();
+	bool ReadChunks();
+
+	const ViveTrackerCore::FCaptureChunkHeader* GetChunkHeader(uint64 nOffset) const;
+
+	IMappedFileHandle* m_pMappedFile = nullptr;
+	IMappedFileRegion* m_pMappedRegion = nullptr;
+	// Used when the platform can't map files
+	TArray<uint8> m_arrFileData;
+
+	const uint8* m_pData = nullptr;
+	uint64 m_nSize = 0;
+	bool m_bComplete = false;
+
+	TArray<ViveTrackerCore::FCaptureChunkInfo> m_arrChunks;
+	TArray<ViveTrackerCore::FCaptureChunkInfo> m_arrSampleChunks;
+	TArray<ViveTrackerCore::FCaptureEvent> m_arrEvents;
+	TArray<FViveTrackerCaptureKeyframe> m_arrKeyframes;
+	TArray<FViveTrackerCaptureTracker> m_arrTrackers;
+	int64 m_nSamples = 0;
+	XrTime m_nStartTime = 0;
+	XrTime m_nEndTime = 0;
+};
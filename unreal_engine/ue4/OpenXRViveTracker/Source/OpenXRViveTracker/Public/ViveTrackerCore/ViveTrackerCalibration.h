@@ -0,0 +1,123 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// Engine independent T-pose calibration. This header must not include any Unreal headers
+// so the solver can be built and exercised outside of the engine.
+
+#include "ViveTrackerCore/ViveTrackerIK.h"
+
+namespace ViveTrackerCore
+{
+	/** One frame of samples captured while the user holds a T-pose, all in the same space */
+	struct FCalibrationFrame
+	{
+		FPose Head;
+		FPose Hands[2];
+		FPose Trackers[(int)EBodyTracker::Count];
+
+		/** A bit per EBodyTracker */
+		uint32_t ValidMask = 0;
+		bool bHandsValid[2] = { false, false };
+
+		/** Whether Head holds a pose */
+		bool bHeadValid = true;
+	};
+
+	/** Result of a calibration */
+	struct FCalibrationResult
+	{
+		/** Solved proportions, joint limits and axes are copied from the skeleton passed to Solve */
+		FBodySkeleton Skeleton;
+
+		/** Bone pose relative to its tracker, bone = TrackerToBone applied first, then the tracker pose */
+		FPose TrackerToBone[(int)EBodyTracker::Count];
+
+		/** A bit per EBodyTracker that received an offset */
+		uint32_t CalibratedMask = 0;
+
+		/** Estimated standing height of the user */
+		float Height = 0.f;
+
+		/** Root mean square of the measurement residuals of the proportion fit */
+		float ResidualRMS = 0.f;
+
+		/** Largest positional standard deviation of a tracker during capture */
+		float MaxMotion = 0.f;
+	};
+
+	/**
+	* Accumulates T-pose frames and fits tracker to bone offsets and body proportions. Frames are
+	* reduced to running sums as they arrive, so memory and solve time do not depend on the capture length.
+	*/
+	class FBodyCalibrator
+	{
+	public:
+		void Reset();
+
+		/**
+		* Add a frame of samples. Frames without a head pose are ignored and don't count towards GetNumFrames.
+		* @param FCalibrationFrame - Samples captured during the T-pose
+		*/
+		void AddFrame(const FCalibrationFrame& Frame);
+
+		int GetNumFrames() const { return m_nFrames; }
+
+		/**
+		* Fit body proportions to the averaged T-pose with a regularized least-squares solve, anthropometric
+		* ratios of the user's height acting as priors, then derive each tracker's offset to its bone.
+		* @param FBodySkeleton - Joint limits and axes for the result, its lengths are ignored
+		* @param float - Largest positional standard deviation a tracker may have during capture
+		* @param FCalibrationResult - Receives the calibration
+		* @return bool - Whether the calibration succeeded, false if no frames were captured or someone moved
+		*/
+		bool Solve(const FBodySkeleton& Skeleton, float MaxMotion, FCalibrationResult& OutResult) const;
+
+	private:
+		/** Running sums of one pose over the capture window */
+		struct FPoseSum
+		{
+			double Position[3] = { 0.0, 0.0, 0.0 };
+			double PositionSq = 0.0;
+			double Rotation[4] = { 0.0, 0.0, 0.0, 0.0 };
+			FQuat4 Reference;
+			int Count = 0;
+
+			void Add(const FPose& Pose);
+			FPose Mean() const;
+			float Deviation() const;
+		};
+
+		enum { Sum_Head = (int)EBodyTracker::Count, Sum_Hand_L, Sum_Hand_R, Sum_Count };
+
+		FPoseSum m_sums[Sum_Count];
+		int m_nFrames = 0;
+	};
+}
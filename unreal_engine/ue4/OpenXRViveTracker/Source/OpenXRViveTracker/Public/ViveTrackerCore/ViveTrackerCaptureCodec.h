@@ -0,0 +1,120 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// Engine independent codec for blocks of capture samples. This header must not include any Unreal
+// headers so the codec can be built, tested and benchmarked outside of the engine.
+//
+// Samples are split into one stream per tracker. The first sample of a stream is kept as is, the
+// following ones are quantized to twice the configured error bound and predicted from the two samples
+// before them. Residuals of the sixteen pose and velocity components are bit-packed in groups of four
+// lanes and 32 samples, so they are unpacked and reconstructed four components at a time with SIMD.
+// Times and flags rarely differ from their prediction and are zero run-length coded instead.
+
+#include "ViveTrackerCore/ViveTrackerCaptureFormat.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace ViveTrackerCore
+{
+	/** Largest error the codec may introduce per component, besides float rounding. Larger bounds compress better. */
+	struct FCaptureCodecSettings
+	{
+		/** In cm */
+		float PositionError = 0.005f;
+		/** Per quaternion component */
+		float RotationError = 0.00005f;
+		/** In cm/s */
+		float LinearVelocityError = 0.05f;
+		/** In rad/s */
+		float AngularVelocityError = 0.0005f;
+	};
+
+	/** Compresses blocks of capture samples. Keeps its scratch memory between blocks. */
+	class FCaptureEncoder
+	{
+	public:
+		explicit FCaptureEncoder(const FCaptureCodecSettings& Settings = FCaptureCodecSettings()) : m_settings(Settings) {}
+
+		const FCaptureCodecSettings& GetSettings() const { return m_settings; }
+
+		/**
+		* Largest size a block of samples can encode to
+		* @param uint32_t - Number of samples in the block
+		* @return size_t - Size in bytes
+		*/
+		static size_t GetMaxEncodedSize(uint32_t NumSamples);
+
+		/**
+		* Compress a block of samples
+		* @param FCaptureSample* - The samples, at most 65535 different trackers
+		* @param uint32_t - Number of samples
+		* @param uint8_t* - Receives the block, at least GetMaxEncodedSize(NumSamples) bytes
+		* @return size_t - Size of the block in bytes
+		*/
+		size_t Encode(const FCaptureSample* pSamples, uint32_t NumSamples, uint8_t* pOut);
+
+	private:
+		FCaptureCodecSettings m_settings;
+		std::vector<uint16_t> m_arrOrder;
+		std::vector<uint32_t> m_arrStreamSamples;
+		std::vector<uint32_t> m_arrStreamOffsets;
+		std::vector<uint16_t> m_arrStreamTrackers;
+		std::vector<int32_t> m_arrQuantized;
+	};
+
+	/** Decompresses blocks of capture samples. Keeps its scratch memory between blocks. */
+	class FCaptureDecoder
+	{
+	public:
+		/**
+		* Number of samples in an encoded block
+		* @param uint8_t* - The block
+		* @param size_t - Size of the block in bytes
+		* @return uint32_t - Number of samples, 0 if the block is too small to be valid
+		*/
+		static uint32_t GetNumSamples(const uint8_t* pData, size_t Size);
+
+		/**
+		* Decompress a block of samples, in the order they were encoded in
+		* @param uint8_t* - The block
+		* @param size_t - Size of the block in bytes
+		* @param FCaptureSample* - Receives GetNumSamples() samples
+		* @return bool - Whether or not the block was valid, the output is undefined if not
+		*/
+		bool Decode(const uint8_t* pData, size_t Size, FCaptureSample* pOut);
+
+	private:
+		std::vector<uint32_t> m_arrPositions;
+		std::vector<uint32_t> m_arrStreamOffsets;
+		std::vector<uint32_t> m_arrStreamCounts;
+	};
+}
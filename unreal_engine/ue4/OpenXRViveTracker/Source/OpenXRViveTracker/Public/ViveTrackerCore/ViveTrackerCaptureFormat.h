@@ -0,0 +1,196 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// On-disk layout of tracker captures. Plain little-endian structs so captures can be written and read
+// without the engine, this header must not include any Unreal headers.
+//
+// A capture is a header followed by chunks, each a chunk header plus a payload padded to 8 bytes. Closed
+// captures end with a directory chunk listing every other chunk and a trailer pointing at it, so readers
+// open them without scanning. Captures cut short by a crash have no trailer and are recovered by walking
+// the chunk headers. Readers skip chunk types they don't know, new types don't need a new version.
+//
+// Sample chunks decode on their own. Keyframe chunks placed before some of them hold the state every
+// tracker is in at that point, so a reader can seek anywhere by finding the last keyframe before the time
+// in the directory and decoding only from the sample chunk after it.
+
+#include <cstdint>
+
+namespace ViveTrackerCore
+{
+	constexpr char CaptureMagic[8] = { 'V', 'T', 'R', 'K', 'C', 'A', 'P', '\0' };
+	constexpr uint32_t CaptureVersion = 1;
+	constexpr uint32_t CaptureTrailerMagic = 0x45435456; // "VTCE"
+
+	/** TrackerId of events that aren't about a single tracker */
+	constexpr uint16_t CaptureNoTracker = 0xFFFF;
+
+	constexpr uint32_t MakeCaptureFourCC(char A, char B, char C, char D)
+	{
+		return (uint32_t)(uint8_t)A | ((uint32_t)(uint8_t)B << 8) | ((uint32_t)(uint8_t)C << 16) | ((uint32_t)(uint8_t)D << 24);
+	}
+
+	/** Chunk types */
+	enum ECaptureChunk : uint32_t
+	{
+		/** FCaptureTrackerRecord entries, trackers first seen or whose role changed */
+		CaptureChunk_Trackers = MakeCaptureFourCC('T', 'R', 'K', 'R'),
+		/** FCaptureSample entries in time order */
+		CaptureChunk_Samples = MakeCaptureFourCC('S', 'M', 'P', 'L'),
+		/** FCaptureCompressedSamples followed by a block of samples in time order encoded by FCaptureEncoder, Count is the number of samples */
+		CaptureChunk_CompressedSamples = MakeCaptureFourCC('S', 'M', 'P', 'Z'),
+		/** FCaptureKeyframe followed by FCaptureSample entries in time order, the state of every tracker before the next sample chunk */
+		CaptureChunk_Keyframe = MakeCaptureFourCC('K', 'E', 'Y', 'F'),
+		/** FCaptureEvent entries in time order */
+		CaptureChunk_Events = MakeCaptureFourCC('E', 'V', 'N', 'T'),
+		/** FCaptureChunkInfo entries, one per chunk before it */
+		CaptureChunk_Directory = MakeCaptureFourCC('D', 'I', 'R', ' '),
+	};
+
+	struct FCaptureHeader
+	{
+		char Magic[8];
+		uint32_t Version;
+		uint32_t HeaderSize;
+		/** Runtime time (XrTime) and platform monotonic time in nanoseconds when the capture started */
+		int64_t StartTime;
+		int64_t StartPlatformTimeNs;
+		uint64_t Reserved[2];
+	};
+	static_assert(sizeof(FCaptureHeader) == 48, "Capture header layout changed");
+
+	struct FCaptureChunkHeader
+	{
+		uint32_t Type;
+		/** Number of entries in the payload */
+		uint32_t Count;
+		/** Payload size in bytes, a multiple of 8 */
+		uint64_t Size;
+	};
+	static_assert(sizeof(FCaptureChunkHeader) == 16, "Capture chunk header layout changed");
+
+	/** Directory entry */
+	struct FCaptureChunkInfo
+	{
+		/** Offset of the chunk header from the start of the file */
+		uint64_t Offset;
+		uint32_t Type;
+		uint32_t Count;
+		/** Time range of the entries, 0 for chunks without times */
+		int64_t FirstTime;
+		int64_t LastTime;
+	};
+	static_assert(sizeof(FCaptureChunkInfo) == 32, "Capture chunk info layout changed");
+
+	/** Last bytes of a closed capture */
+	struct FCaptureTrailer
+	{
+		uint64_t DirectoryOffset;
+		uint32_t Reserved;
+		uint32_t Magic;
+	};
+	static_assert(sizeof(FCaptureTrailer) == 16, "Capture trailer layout changed");
+
+	/**
+	* A tracker known to the capture. Followed by PathLength bytes of UTF-8 persistent path,
+	* the record plus path padded to 8 bytes. Trackers the runtime didn't report a path for have none.
+	*/
+	struct FCaptureTrackerRecord
+	{
+		uint16_t TrackerId;
+		/** ETrackerRole of the tracker from here on */
+		uint8_t Role;
+		uint8_t Reserved;
+		uint32_t PathLength;
+	};
+	static_assert(sizeof(FCaptureTrackerRecord) == 8, "Capture tracker record layout changed");
+
+	/** One located tracker, positions in cm and velocities in cm/s and rad/s in the engine's tracking space */
+	struct FCaptureSample
+	{
+		/** Runtime time (XrTime) and platform monotonic time in nanoseconds */
+		int64_t Time;
+		int64_t PlatformTimeNs;
+		float Position[3];
+		/** Quaternion X, Y, Z, W */
+		float Rotation[4];
+		float LinearVelocity[3];
+		float AngularVelocity[3];
+		uint16_t TrackerId;
+		uint8_t Role;
+		/** Lowest bits of XrSpaceLocationFlags and XrSpaceVelocityFlags */
+		uint8_t LocationFlags;
+		uint8_t VelocityFlags;
+		uint8_t Reserved[7];
+	};
+	static_assert(sizeof(FCaptureSample) == 80, "Capture sample layout changed");
+
+	/** Start of a compressed sample chunk's payload, so the chunk's time range is known without decoding it */
+	struct FCaptureCompressedSamples
+	{
+		int64_t FirstTime;
+		int64_t LastTime;
+	};
+	static_assert(sizeof(FCaptureCompressedSamples) == 16, "Compressed sample chunk layout changed");
+
+	/**
+	* Start of a keyframe chunk's payload. The samples after it are each tracker's latest sample with a valid pose,
+	* plus its latest sample if that one came later and lost tracking, so replaying them restores every pose and flag.
+	*/
+	struct FCaptureKeyframe
+	{
+		/** Time of the first sample of the sample chunk following the keyframe */
+		int64_t Time;
+		uint64_t Reserved;
+	};
+	static_assert(sizeof(FCaptureKeyframe) == 16, "Capture keyframe layout changed");
+
+	enum class ECaptureEvent : uint8_t
+	{
+		/** The runtime reported a tracker as connected */
+		Connected,
+		/** The runtime's tracker paths were re-enumerated */
+		PathsChanged,
+		/** Samples were dropped because the disk fell behind, Value holds how many since the previous such event */
+		SamplesDropped,
+	};
+
+	struct FCaptureEvent
+	{
+		int64_t Time;
+		int64_t PlatformTimeNs;
+		uint16_t TrackerId;
+		ECaptureEvent Type;
+		uint8_t Role;
+		/** Depends on the type of the event */
+		uint32_t Value;
+	};
+	static_assert(sizeof(FCaptureEvent) == 24, "Capture event layout changed");
+}
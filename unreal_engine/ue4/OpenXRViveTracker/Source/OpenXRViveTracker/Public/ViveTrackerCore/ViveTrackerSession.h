@@ -0,0 +1,230 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// Engine independent tracker session: the role actions and their bindings, tracker connect events and
+// locating every role's tracker through XR_HTCX_vive_tracker_interaction. This header must not include any
+// Unreal headers so the session can be built and driven outside of the engine. OpenXR is only reached through
+// a table of entry points, filled in from the engine's loader by the module or pointed at a stand-in runtime.
+
+#include "tracker_openxr/openxr.h"
+
+#include <string>
+#include <vector>
+
+namespace ViveTrackerCore
+{
+	/** Roles of the extension, in ETrackerRole order */
+	constexpr int NumTrackerRoles = 12;
+
+	/**
+	* Path of a role, e.g. /user/vive_tracker_htcx/role/waist
+	* @param int - The role
+	* @return const char* - The role path, nullptr for roles out of range
+	*/
+	const char* GetTrackerRolePath(int Role);
+
+	/**
+	* Reverse lookup of GetTrackerRolePath
+	* @param const char* - A role path
+	* @return int - The role, NumTrackerRoles if the path isn't a role path
+	*/
+	int FindTrackerRole(const char* pRolePath);
+
+	/** OpenXR entry points a session calls */
+	struct FXrEntryPoints
+	{
+		PFN_xrGetInstanceProcAddr GetInstanceProcAddr = nullptr;
+		PFN_xrCreateActionSet CreateActionSet = nullptr;
+		PFN_xrDestroyActionSet DestroyActionSet = nullptr;
+		PFN_xrCreateAction CreateAction = nullptr;
+		PFN_xrDestroyAction DestroyAction = nullptr;
+		PFN_xrCreateActionSpace CreateActionSpace = nullptr;
+		PFN_xrSuggestInteractionProfileBindings SuggestInteractionProfileBindings = nullptr;
+		PFN_xrLocateSpace LocateSpace = nullptr;
+		PFN_xrStringToPath StringToPath = nullptr;
+		PFN_xrPathToString PathToString = nullptr;
+	};
+
+	/** The pose action of a role */
+	struct FTrackerRoleAction
+	{
+		XrAction Action = XR_NULL_HANDLE;
+		XrSpace Space = XR_NULL_HANDLE;
+		/** Result of creating the action and its space, then of converting its binding path */
+		XrResult Result = XR_ERROR_HANDLE_INVALID;
+	};
+
+	/** A tracker reported by the runtime */
+	struct FTrackerPathRole
+	{
+		/** e.g. /devices/htc/vive_trackerLHR-XXXXXXXX */
+		std::string PersistentPath;
+		/** NumTrackerRoles for trackers without an assigned role */
+		int Role = NumTrackerRoles;
+	};
+
+	/** Where a role's tracker was located, in OpenXR units and axes */
+	struct FTrackerLocation
+	{
+		XrResult Result = XR_ERROR_HANDLE_INVALID;
+		XrSpaceLocationFlags LocationFlags = 0;
+		XrSpaceVelocityFlags VelocityFlags = 0;
+		XrPosef Pose{ { 0.f, 0.f, 0.f, 1.f }, { 0.f, 0.f, 0.f } };
+		XrVector3f LinearVelocity{ 0.f, 0.f, 0.f };
+		XrVector3f AngularVelocity{ 0.f, 0.f, 0.f };
+	};
+
+	/** What HandleEvent made of an event */
+	enum class ETrackerSessionEvent
+	{
+		/** Not an event of the session */
+		None,
+		/** The session state changed, see GetSessionState */
+		SessionStateChanged,
+		/** A tracker connected or its role changed, see GetConnectedTracker and RefreshTrackers */
+		TrackerConnected
+	};
+
+	/**
+	* Owns the action set and one pose action and action space per role, tracks the trackers the runtime
+	* reports and locates every role each frame. Only used from one thread, like the OpenXR frame loop.
+	*/
+	class FTrackerSession
+	{
+	public:
+		FTrackerSession() = default;
+		~FTrackerSession() { Release(); }
+
+		FTrackerSession(const FTrackerSession&) = delete;
+		FTrackerSession& operator=(const FTrackerSession&) = delete;
+
+		/** Set the entry points used from here on, keep them until Release */
+		void SetEntryPoints(const FXrEntryPoints& EntryPoints) { m_entryPoints = EntryPoints; }
+
+		/**
+		* Create the action set hosting the role actions and resolve the extension's entry points
+		* @param XrInstance - The instance
+		* @return XrResult - Result of creating the action set
+		*/
+		XrResult CreateActionSet(XrInstance Instance);
+
+		/**
+		* Create every role's pose action and action space and suggest their vive tracker interaction profile bindings
+		* @param XrSession - The session
+		* @return XrResult - Result of suggesting the bindings, see GetRoleAction for each role's own result
+		*/
+		XrResult CreateActions(XrSession Session);
+
+		/** Destroy the actions and action set and forget the instance, session and trackers */
+		void Release();
+
+		XrInstance GetInstance() const { return m_xrInstance; }
+		XrSession GetSession() const { return m_xrSession; }
+		XrActionSet GetActionSet() const { return m_xrActionSet; }
+		XrSessionState GetSessionState() const { return m_xrSessionState; }
+		bool IsActionsGenerated() const { return m_bActionsGenerated; }
+
+		/** Name of the action set */
+		static const char* GetActionSetName() { return "tracker_actionset"; }
+
+		/** Name of a role's action, e.g. tracker_waist */
+		static const char* GetRoleActionName(int Role);
+
+		/** The pose action of a role, Role must be below NumTrackerRoles */
+		const FTrackerRoleAction& GetRoleAction(int Role) const { return m_roleActions[Role]; }
+
+		/**
+		* Handle an event from the runtime. A connect event only reads the paths of the tracker it names and flags the
+		* trackers for RefreshTrackers, so its cost doesn't depend on how many trackers there are and, once the strings
+		* have grown to the runtime's path length, it doesn't allocate.
+		* @param XrEventDataBaseHeader - The event
+		* @return ETrackerSessionEvent - What the event was
+		*/
+		ETrackerSessionEvent HandleEvent(const XrEventDataBaseHeader* pHeader);
+
+		/** The tracker of the last connect event */
+		const FTrackerPathRole& GetConnectedTracker() const { return m_connectedTracker; }
+
+		/**
+		* Enumerate the trackers again if a connect event came in since the last refresh, meant to be called once per
+		* frame so a burst of events costs a single enumeration. Storage is reused, so it only allocates when more
+		* trackers than ever before are connected.
+		* @return bool - Whether or not the trackers were enumerated
+		*/
+		bool RefreshTrackers();
+
+		/** Result of the last tracker enumeration, the trackers are only current if it succeeded */
+		XrResult GetTrackersResult() const { return m_xrTrackersResult; }
+
+		/** Number of trackers the runtime reported in the last successful enumeration */
+		size_t GetNumTrackers() const { return m_nTrackers; }
+
+		/** A tracker of the last successful enumeration, Index must be below GetNumTrackers */
+		const FTrackerPathRole& GetTracker(size_t Index) const { return m_trackers[Index]; }
+
+		/**
+		* Locate every role's tracker, with velocities
+		* @param XrSpace - Space to locate in
+		* @param XrTime - Time to locate at
+		*/
+		void LocateRoles(XrSpace BaseSpace, XrTime Time);
+
+		/** Where a role's tracker was last located, Role must be below NumTrackerRoles */
+		const FTrackerLocation& GetLocation(int Role) const { return m_locations[Role]; }
+
+	private:
+		FXrEntryPoints m_entryPoints;
+		PFN_xrEnumerateViveTrackerPathsHTCX m_pfnEnumerateViveTrackerPaths = nullptr;
+
+		XrInstance m_xrInstance = XR_NULL_HANDLE;
+		XrSession m_xrSession = XR_NULL_HANDLE;
+		XrActionSet m_xrActionSet = XR_NULL_HANDLE;
+		XrSessionState m_xrSessionState = XR_SESSION_STATE_UNKNOWN;
+		bool m_bActionsGenerated = false;
+
+		FTrackerRoleAction m_roleActions[NumTrackerRoles];
+		FTrackerLocation m_locations[NumTrackerRoles];
+
+		FTrackerPathRole m_connectedTracker;
+		bool m_bTrackersDirty = false;
+
+		// Only ever grown, trackers past m_nTrackers keep their strings' storage for the next enumeration
+		std::vector<XrViveTrackerPathsHTCX> m_xrTrackerPaths;
+		std::vector<FTrackerPathRole> m_trackers;
+		size_t m_nTrackers = 0;
+		XrResult m_xrTrackersResult = XR_ERROR_HANDLE_INVALID;
+
+		XrResult CreateRoleAction(int Role);
+		XrResult EnumerateTrackers();
+		bool GetPathString(XrPath Path, std::string& OutString) const;
+		int GetPathRole(XrPath RolePath) const;
+	};
+}
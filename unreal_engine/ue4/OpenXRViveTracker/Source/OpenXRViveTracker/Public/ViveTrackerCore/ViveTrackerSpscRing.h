@@ -0,0 +1,146 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// Bounded lock-free ring between exactly one producer thread and one consumer thread.
+// Storage is allocated once up front, pushing and popping never allocate or take a lock.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ViveTrackerCore
+{
+	template <typename T>
+	class TSpscRing
+	{
+	public:
+		explicit TSpscRing(uint32_t Capacity = 0) { Reset(Capacity); }
+
+		TSpscRing(const TSpscRing&) = delete;
+		TSpscRing& operator=(const TSpscRing&) = delete;
+
+		/**
+		* Discard every element and reallocate. Not thread safe, only call while neither end is in use.
+		* @param uint32_t - Minimum number of elements, rounded up to a power of two
+		*/
+		void Reset(uint32_t Capacity)
+		{
+			uint32_t nCapacity = 2;
+			while (nCapacity < Capacity && nCapacity < (1u << 31))
+			{
+				nCapacity <<= 1;
+			}
+
+			m_pItems.reset(new T[nCapacity]);
+			m_nMask = nCapacity - 1;
+			m_nHead.store(0, std::memory_order_relaxed);
+			m_nTail.store(0, std::memory_order_relaxed);
+			m_nCachedHead = 0;
+			m_nCachedTail = 0;
+		}
+
+		uint32_t GetCapacity() const { return m_nMask + 1; }
+
+		/**
+		* Number of queued elements. Exact from either end for its own side, a snapshot otherwise.
+		* @return uint32_t - Number of elements pushed and not yet popped
+		*/
+		uint32_t Num() const
+		{
+			return m_nHead.load(std::memory_order_acquire) - m_nTail.load(std::memory_order_acquire);
+		}
+
+		/**
+		* Producer only. Add an element if there is room.
+		* @param T - The element
+		* @return bool - Whether or not the element was added, false if the ring is full
+		*/
+		bool Push(const T& Item)
+		{
+			const uint32_t nHead = m_nHead.load(std::memory_order_relaxed);
+			if (nHead - m_nCachedTail > m_nMask)
+			{
+				// Only look at the consumer's index when the cached one says full, keeps the cache line mostly unshared
+				m_nCachedTail = m_nTail.load(std::memory_order_acquire);
+				if (nHead - m_nCachedTail > m_nMask)
+					return false;
+			}
+
+			m_pItems[nHead & m_nMask] = Item;
+			m_nHead.store(nHead + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		* Consumer only. Take up to MaxCount of the oldest elements.
+		* @param T* - Receives the elements in push order
+		* @param uint32_t - Room in pOut
+		* @return uint32_t - Number of elements taken
+		*/
+		uint32_t Pop(T* pOut, uint32_t MaxCount)
+		{
+			const uint32_t nTail = m_nTail.load(std::memory_order_relaxed);
+			if (m_nCachedHead - nTail < MaxCount)
+			{
+				m_nCachedHead = m_nHead.load(std::memory_order_acquire);
+			}
+
+			const uint32_t nAvailable = m_nCachedHead - nTail;
+			const uint32_t nCount = nAvailable < MaxCount ? nAvailable : MaxCount;
+
+			// Copy in up to two runs, before and after the end of the storage
+			const uint32_t nStart = nTail & m_nMask;
+			const uint32_t nFirst = nCount < GetCapacity() - nStart ? nCount : GetCapacity() - nStart;
+			for (uint32_t n = 0; n < nFirst; n++)
+			{
+				pOut[n] = m_pItems[nStart + n];
+			}
+			for (uint32_t n = nFirst; n < nCount; n++)
+			{
+				pOut[n] = m_pItems[n - nFirst];
+			}
+
+			m_nTail.store(nTail + nCount, std::memory_order_release);
+			return nCount;
+		}
+
+	private:
+		std::unique_ptr<T[]> m_pItems;
+		uint32_t m_nMask = 0;
+
+		// Each end's index and its cached copy of the other end's index share a cache line
+		alignas(64) std::atomic<uint32_t> m_nHead{ 0 };
+		uint32_t m_nCachedTail = 0;
+
+		alignas(64) std::atomic<uint32_t> m_nTail{ 0 };
+		uint32_t m_nCachedHead = 0;
+	};
+}
@@ -0,0 +1,110 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/LineBatchComponent.h"
+#include "Engine/EngineBaseTypes.h"
+#include "ViveTrackerSample.h"
+
+class FOpenXRViveTrackerModule;
+class UWorld;
+
+/** What FViveTrackerDebugDraw shows */
+struct FViveTrackerDebugDrawSettings
+{
+	/** Longest trail, a trail point per role is kept for every past position */
+	static constexpr int32 MaxTrailLength = 10000;
+
+	/** Added to every tracker location, like UViveTrackerComponent::PlayerStartLocation */
+	FVector PlayerStartLocation = FVector::ZeroVector;
+
+	/** Length of each tracker's axes in cm, 0 hides them */
+	float AxisLength = 10.f;
+
+	/** Velocity vectors point where a tracker will be this many seconds later, 0 hides them */
+	float VelocitySeconds = 0.1f;
+
+	/** Number of past positions in each tracker's trail up to MaxTrailLength, 0 hides trails */
+	int32 TrailLength = 90;
+
+	/** Size of the point showing a tracker's status */
+	float PointSize = 8.f;
+
+	/** Draw over the scene instead of being hidden by it */
+	bool bForeground = true;
+};
+
+/**
+* Draws every tracker role's axes, velocity, trail and status into each game world, so mounting and calibration issues
+* can be seen without debug draw code in actors. Status colours are green for a tracked pose, yellow for a valid but
+* inferred one and red for a lost tracker at its last pose. A frame's lines and points are built in arrays kept across
+* frames and handed to the world's line batcher at once, instead of a DrawDebug call per primitive.
+*
+* Only exists while drawing, see FOpenXRViveTrackerModule::StartDebugDraw, so the module costs nothing extra otherwise.
+* Game thread only.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerDebugDraw
+{
+public:
+	FViveTrackerDebugDraw(const FOpenXRViveTrackerModule& Module, const FViveTrackerDebugDrawSettings& Settings);
+	~FViveTrackerDebugDraw();
+
+	/** What is drawn, changing the trail length restarts the trails */
+	const FViveTrackerDebugDrawSettings& GetSettings() const { return m_settings; }
+	void SetSettings(const FViveTrackerDebugDrawSettings& Settings);
+
+private:
+	// A ring of positions in m_arrTrailPoints
+	struct FTrail
+	{
+		int32 Head = 0;
+		int32 Num = 0;
+		XrTime LastTime = 0;
+	};
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void UpdateTrails();
+	void BuildPrimitives(uint8 DepthPriority);
+
+	const FOpenXRViveTrackerModule& m_module;
+	FViveTrackerDebugDrawSettings m_settings;
+
+	TArray<ETrackerRole> m_arrRoles;
+	TArray<FViveTrackerSample> m_arrSamples;
+	TArray<FTrail> m_arrTrails;
+	TArray<FVector> m_arrTrailPoints;
+	uint64 m_nLastUpdateFrame = MAX_uint64;
+
+	TArray<FBatchedLine> m_arrLines;
+	TArray<FBatchedPoint> m_arrPoints;
+
+	FDelegateHandle m_hPostActorTick;
+};
@@ -0,0 +1,261 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Range.h"
+#include "OpenXRViveTracker.h"
+
+/** A tracker played by FViveTrackerMockRuntime */
+struct FViveTrackerMockTracker
+{
+	/** Persistent path the runtime reports for the tracker, e.g. /devices/htc/vive_trackerLHR-XXXXXXXX */
+	FString PersistentPath;
+
+	/** Role assigned to the tracker when it connects, trackers without a role are listed but can't be located */
+	ETrackerRole Role = ETrackerRole::Unassigned;
+
+	/** Pose in tracking space, in engine units and axes, at a time in seconds since the mock runtime started */
+	TFunction<FTransform(double)> Trajectory;
+
+	/** Times in seconds during which the tracker stays connected but has lost tracking */
+	TArray<TRange<double>> Dropouts;
+};
+
+/**
+* An in-process stand-in for an OpenXR runtime implementing XR_HTCX_vive_tracker_interaction, so the module's whole
+* pose path runs deterministically without SteamVR, a headset or a GPU, e.g. in automated tests and benchmarks.
+*
+* Start swaps the engine's OpenXR entry points the module calls (xrCreateActionSet, xrCreateAction, xrCreateActionSpace,
+* xrSuggestInteractionProfileBindings, xrLocateSpace, xrStringToPath, xrPathToString and xrGetInstanceProcAddr for
+* xrEnumerateViveTrackerPathsHTCX) for its own, then creates an instance and session through the module's
+* IOpenXRExtensionPlugin callbacks. Every Tick then drives the module like the OpenXR plugin does in a frame: scripted
+* connect events through OnEvent, UpdateDeviceLocations with the next display time and PostSyncActions, which locates
+* the scripted trackers. Time only moves with Tick, so runs are reproducible.
+*
+* Only start the mock in processes without an OpenXR session, the real runtime's entry points are restored by Stop.
+* Runtime time conversion isn't implemented, so samples carry no platform timestamps.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerMockRuntime
+{
+public:
+	/** Runtime time of the mock's first frame */
+	static constexpr XrTime StartTime = 1000 * 1000 * 1000;
+
+	~FViveTrackerMockRuntime();
+
+	/**
+	* Install the mock's entry points and create an instance and session in the module
+	* @param FOpenXRViveTrackerModule - The module to drive
+	* @return bool - Whether or not the mock started, it doesn't when a real runtime session or another mock is active
+	*/
+	bool Start(FOpenXRViveTrackerModule& Module);
+
+	/** Release the module's runtime resources and restore the engine's entry points */
+	void Stop();
+
+	/** Whether or not the mock is driving the module */
+	bool IsRunning() const { return m_pModule != nullptr; }
+
+	/**
+	* Add a tracker to the script
+	* @param FViveTrackerMockTracker - The tracker, its trajectory and dropouts
+	* @param double - Time in seconds since the start the tracker connects at
+	* @return int32 - Index of the tracker, for the other script calls
+	*/
+	int32 AddTracker(const FViveTrackerMockTracker& Tracker, double ConnectSeconds = 0.0);
+
+	/**
+	* Script a tracker to disconnect, it is no longer listed or located until it connects again
+	* @param int32 - Index of the tracker
+	* @param double - Time in seconds since the start
+	*/
+	void Disconnect(int32 TrackerIndex, double Seconds);
+
+	/**
+	* Script a tracker to connect again, with a connect event
+	* @param int32 - Index of the tracker
+	* @param double - Time in seconds since the start
+	*/
+	void Connect(int32 TrackerIndex, double Seconds);
+
+	/**
+	* Script a role change, sent with a connect event like SteamVR does when roles are reassigned
+	* @param int32 - Index of the tracker
+	* @param ETrackerRole - The new role
+	* @param double - Time in seconds since the start
+	*/
+	void ChangeRole(int32 TrackerIndex, ETrackerRole Role, double Seconds);
+
+	/**
+	* Run a frame: send the events scripted up to the new time, then update device locations and sync actions
+	* @param double - Length of the frame in seconds
+	*/
+	void Tick(double DeltaSeconds);
+
+	/**
+	* Send a connected tracker's connect event right away, outside the script, e.g. to measure event handling
+	* @param int32 - Index of the tracker
+	*/
+	void SendConnectEvent(int32 TrackerIndex);
+
+	/** Seconds since the start, the time of the last frame */
+	double GetSeconds() const { return m_fSeconds; }
+
+	/** Runtime time of the last frame */
+	XrTime GetTime() const { return StartTime + (XrTime)FMath::RoundToDouble(m_fSeconds * 1.0e9); }
+
+	/** Number of scripted trackers */
+	int32 GetNumTrackers() const { return m_arrTrackers.Num(); }
+
+	/** A scripted tracker, with its role as of the last frame */
+	const FViveTrackerMockTracker& GetTracker(int32 TrackerIndex) const { return m_arrTrackers[TrackerIndex].Script; }
+
+	/** Whether or not a scripted tracker is connected as of the last frame */
+	bool IsConnected(int32 TrackerIndex) const { return m_arrTrackers[TrackerIndex].bConnected; }
+
+	/**
+	* What a tracker reports at a time, for checking results
+	* @param int32 - Index of the tracker
+	* @param double - Seconds since the start
+	* @param FTransform - Receives the scripted pose
+	* @return bool - Whether or not the tracker is connected, has a role and is tracking at that time
+	*/
+	bool GetExpectedPose(int32 TrackerIndex, double Seconds, FTransform& OutPose) const;
+
+	/** Number of xrLocateSpace calls, connect events and tracker path enumerations so far */
+	int64 GetNumLocateCalls() const { return m_nLocateCalls; }
+	int64 GetNumEventsSent() const { return m_nEventsSent; }
+	int64 GetNumEnumerateCalls() const { return m_nEnumerateCalls; }
+
+	/** Number of calls the module made into the mock, and seconds it spent, while handling connect events */
+	int64 GetNumEventRuntimeCalls() const { return m_nEventRuntimeCalls; }
+	double GetEventSeconds() const { return m_fEventSeconds; }
+
+	/**
+	* Count the heap allocations the module makes while handling connect events, through a FViveTrackerAllocationScope
+	* @param bool - Whether or not to count
+	*/
+	void SetCountEventAllocations(bool bCount) { m_bCountEventAllocations = bCount; }
+
+	/** Number of heap allocations counted while handling connect events */
+	int64 GetNumEventAllocations() const { return m_nEventAllocations; }
+
+	/** Handles of the mock's instance, session and tracking space, for calling into the mock without the module */
+	XrInstance GetInstance() const;
+	XrSession GetSession() const;
+	XrSpace GetBaseSpace() const;
+
+	/** The mock's entry points, only valid while a mock is running */
+	static ViveTrackerCore::FXrEntryPoints GetEntryPoints();
+
+	/**
+	* A tracker orbiting a point of a body sized volume, with its own phase and speed
+	* @param int32 - Index of the tracker, picks the persistent path, the role (cycling through the 12 roles) and the orbit
+	* @return FViveTrackerMockTracker - The tracker
+	*/
+	static FViveTrackerMockTracker MakeOrbitingTracker(int32 Index);
+
+private:
+	enum class EScriptEvent : uint8
+	{
+		Connect,
+		Disconnect,
+		ChangeRole
+	};
+
+	struct FScriptEvent
+	{
+		double Seconds;
+		int32 TrackerIndex;
+		EScriptEvent Type;
+		ETrackerRole Role;
+	};
+
+	struct FTrackerState
+	{
+		FViveTrackerMockTracker Script;
+		XrViveTrackerPathsHTCX Paths;
+		bool bConnected = false;
+	};
+
+	struct FAction
+	{
+		ETrackerRole Role = ETrackerRole::Unassigned;
+	};
+
+	void AddScriptEvent(const FScriptEvent& Event);
+	void ApplyScriptEvent(const FScriptEvent& Event);
+	void RebuildRoleTrackers();
+	XrPath StringToPath(const char* pString);
+	int32 FindRoleTracker(ETrackerRole Role) const;
+	static void RecordRuntimeCall();
+	bool GetScriptedPose(const FTrackerState& Tracker, double Seconds, FTransform& OutPose) const;
+
+	// Entry points, dispatched to the active mock
+	static XrResult XRAPI_CALL GetInstanceProcAddr(XrInstance Instance, const char* pName, PFN_xrVoidFunction* pFunction);
+	static XrResult XRAPI_CALL CreateActionSet(XrInstance Instance, const XrActionSetCreateInfo* pCreateInfo, XrActionSet* pActionSet);
+	static XrResult XRAPI_CALL DestroyActionSet(XrActionSet ActionSet);
+	static XrResult XRAPI_CALL CreateAction(XrActionSet ActionSet, const XrActionCreateInfo* pCreateInfo, XrAction* pAction);
+	static XrResult XRAPI_CALL DestroyAction(XrAction Action);
+	static XrResult XRAPI_CALL CreateActionSpace(XrSession Session, const XrActionSpaceCreateInfo* pCreateInfo, XrSpace* pSpace);
+	static XrResult XRAPI_CALL SuggestInteractionProfileBindings(XrInstance Instance, const XrInteractionProfileSuggestedBinding* pSuggestedBindings);
+	static XrResult XRAPI_CALL LocateSpace(XrSpace Space, XrSpace BaseSpace, XrTime Time, XrSpaceLocation* pLocation);
+	static XrResult XRAPI_CALL StringToPathEntry(XrInstance Instance, const char* pPathString, XrPath* pPath);
+	static XrResult XRAPI_CALL PathToString(XrInstance Instance, XrPath Path, uint32_t BufferCapacityInput, uint32_t* pBufferCountOutput, char* pBuffer);
+	static XrResult XRAPI_CALL EnumerateViveTrackerPaths(XrInstance Instance, uint32_t PathCapacityInput, uint32_t* pPathCountOutput, XrViveTrackerPathsHTCX* pPaths);
+
+	FOpenXRViveTrackerModule* m_pModule = nullptr;
+
+	TArray<FTrackerState> m_arrTrackers;
+	TArray<FScriptEvent> m_arrScript;
+	int32 m_nNextScriptEvent = 0;
+
+	// Index of the connected tracker bound to each role, INDEX_NONE if none, so locating never searches
+	int32 m_arrRoleTrackers[ETrackerRole::Unassigned + 1];
+
+	TArray<FString> m_arrPathStrings;
+	TMap<FString, XrPath> m_mapPaths;
+
+	TArray<FAction> m_arrActions;
+	// Action of every action space
+	TArray<int32> m_arrSpaceActions;
+
+	double m_fSeconds = 0.0;
+	int64 m_nLocateCalls = 0;
+	int64 m_nEventsSent = 0;
+	int64 m_nEnumerateCalls = 0;
+
+	bool m_bInEvent = false;
+	bool m_bCountEventAllocations = false;
+	int64 m_nEventRuntimeCalls = 0;
+	int64 m_nEventAllocations = 0;
+	double m_fEventSeconds = 0.0;
+};
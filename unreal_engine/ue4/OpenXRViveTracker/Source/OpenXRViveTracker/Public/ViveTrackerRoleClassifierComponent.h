@@ -0,0 +1,103 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Async/Future.h"
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerCore/ViveTrackerRoleClassifier.h"
+#include "ViveTrackerRoleClassifierComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnViveTrackerRolesInferred);
+
+/**
+* Infers body roles for the connected trackers from their poses relative to the HMD, for setups where
+* roles were assigned carelessly in the runtime. Samples are gathered every tick and classified on a
+* worker thread once per window, and roles only change after two consecutive windows agree. The
+* tracking space must be floor level. Trackers need some role in the runtime to be located at all,
+* trackers the runtime reports without a role are logged and skipped.
+*/
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class OPENXRVIVETRACKER_API UViveTrackerRoleClassifierComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UViveTrackerRoleClassifierComponent();
+
+	/** Seconds of samples per classification */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker", meta = (ClampMin = "0.5"))
+	float WindowDuration = 2.f;
+
+	/** Make the module's role based getters follow the inferred roles, restored when play ends */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker")
+	bool bApplyInferredRoles = true;
+
+	/** Inferred role per persistent path, for trackers that look body worn */
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker")
+	TMap<FString, TEnumAsByte<ETrackerRole>> InferredRoles;
+
+	/** Broadcast on the game thread whenever InferredRoles changes */
+	UPROPERTY(BlueprintAssignable, Category = "ViveTracker")
+	FOnViveTrackerRolesInferred OnTrackerRolesInferred;
+
+private:
+	FOpenXRViveTrackerModule* m_trackerModule = nullptr;
+
+	ViveTrackerCore::FRoleClassifier m_classifier;
+	TFuture<ViveTrackerCore::FRoleClassification> m_classification;
+	float m_fWindowTime = 0.f;
+
+	// Tracker slots of the classifier, sorted by persistent path so they survive re-enumeration
+	TArray<FString> m_arrSlotPaths;
+	TArray<ETrackerRole> m_arrSlotRoles;
+	TArray<FViveTrackerSample> m_arrSamples;
+	TArray<FString> m_arrClassifiedPaths;
+	uint32 m_nTrackerPathsGeneration = MAX_uint32;
+
+	ViveTrackerCore::FRoleAgreement m_roleAgreement;
+	bool m_bRolesApplied = false;
+
+	void RefreshTrackers();
+	void ApplyClassification(const ViveTrackerCore::FRoleClassification& Classification);
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the game ends or the component is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+};
@@ -0,0 +1,142 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "tracker_openxr/openxr.h"
+
+/** Latest pose reported by the runtime for a tracker, stamped with both the runtime and the platform clock */
+struct FViveTrackerSample
+{
+	/** Tracker transform in the application's base space */
+	FTransform Transform = FTransform::Identity;
+
+	/** Linear velocity in the application's base space, in cm/s */
+	FVector LinearVelocity = FVector::ZeroVector;
+
+	/** Angular velocity in the application's base space, as a rotation axis scaled by rad/s */
+	FVector AngularVelocity = FVector::ZeroVector;
+
+	/** Runtime time the pose was located for */
+	XrTime Time = 0;
+
+	/** Same instant on the platform's monotonic clock in nanoseconds, 0 if the runtime can't convert time */
+	int64 PlatformTimeNs = 0;
+
+	/** FPlatformTime::Seconds() when the module asked the runtime for the pose, 0 for replayed samples */
+	double SampledSeconds = 0.0;
+
+	/** Location flags returned by the runtime for this pose */
+	XrSpaceLocationFlags LocationFlags = 0;
+
+	/** Velocity flags returned by the runtime for this pose */
+	XrSpaceVelocityFlags VelocityFlags = 0;
+
+	/** Whether or not both the position and orientation of this sample are valid */
+	bool HasValidPose() const
+	{
+		return (LocationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) && (LocationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT);
+	}
+
+	/** Whether or not both the linear and angular velocities of this sample are valid */
+	bool HasValidVelocity() const
+	{
+		return (VelocityFlags & XR_SPACE_VELOCITY_LINEAR_VALID_BIT) && (VelocityFlags & XR_SPACE_VELOCITY_ANGULAR_VALID_BIT);
+	}
+};
+
+/**
+* Fixed size ring of the most recent valid samples of a tracker. Used to evaluate a tracker's
+* pose at times other than the frame's predicted display time, e.g. for physics substeps.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerPoseHistory
+{
+public:
+	/** Number of samples kept per tracker, roughly 170ms at 90Hz */
+	static constexpr int32 Capacity = 16;
+
+	/** Furthest a pose will be extrapolated past the newest sample, in nanoseconds */
+	static constexpr XrTime MaxExtrapolationNs = 50 * 1000 * 1000;
+
+	/**
+	* Add a new sample, replacing the oldest one if the history is full. Samples must be pushed in time order.
+	* @param FViveTrackerSample - The sample to add
+	*/
+	void Push(const FViveTrackerSample& Sample);
+
+	/** Discard all samples */
+	void Reset() { m_nHead = 0; m_nCount = 0; }
+
+	/** Number of samples currently held */
+	int32 Num() const { return m_nCount; }
+
+	/**
+	* Access a sample by age
+	* @param int32 - Age of the sample, 0 being the newest
+	* @return FViveTrackerSample - The sample
+	*/
+	const FViveTrackerSample& Get(int32 Age) const
+	{
+		check(Age >= 0 && Age < m_nCount);
+		return m_arrSamples[(m_nHead - Age + Capacity) % Capacity];
+	}
+
+	/**
+	* Evaluate the tracker's pose at an arbitrary runtime time. Interpolates between the two samples
+	* surrounding the time, or extrapolates from the newest sample's velocity if the time is past it.
+	* @param XrTime - The runtime time to evaluate the pose at
+	* @param FTransform - Receives the evaluated transform
+	* @return bool - Whether or not there was any sample to evaluate from
+	*/
+	bool Evaluate(XrTime Time, FTransform& OutTransform) const;
+
+	/**
+	* Extrapolate a sample forward (or backward) in time from its velocities
+	* @param FViveTrackerSample - The sample to extrapolate from
+	* @param double - Time offset from the sample's time, in seconds
+	* @return FTransform - The extrapolated transform
+	*/
+	static FTransform Extrapolate(const FViveTrackerSample& Sample, double DeltaSeconds);
+
+	/**
+	* Interpolate between two samples, using their velocities for a cubic position curve when available
+	* @param FViveTrackerSample - The older sample
+	* @param FViveTrackerSample - The newer sample
+	* @param XrTime - The runtime time to interpolate at, between both samples' times
+	* @return FTransform - The interpolated transform
+	*/
+	static FTransform Interpolate(const FViveTrackerSample& From, const FViveTrackerSample& To, XrTime Time);
+
+private:
+	TStaticArray<FViveTrackerSample, Capacity> m_arrSamples;
+	int32 m_nHead = 0;
+	int32 m_nCount = 0;
+};
@@ -0,0 +1,29 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class OpenXRViveTrackerEditor : ModuleRules
+{
+	public OpenXRViveTrackerEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Engine",
+				"AnimGraph",
+				"AnimGraphRuntime",
+				"BlueprintGraph",
+				"UnrealEd",
+				"Slate",
+				"SlateCore",
+				"DesktopPlatform",
+				"WorkspaceMenuStructure",
+				"OpenXRViveTracker"
+			}
+			);
+	}
+}
@@ -0,0 +1,324 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "SViveTrackerPlayback.h"
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerReplay.h"
+#include "DesktopPlatformModule.h"
+#include "IDesktopPlatform.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Misc/Paths.h"
+#include "Widgets/SBoxPanel.h"
+#include "Widgets/Input/SButton.h"
+#include "Widgets/Input/SCheckBox.h"
+#include "Widgets/Input/SEditableTextBox.h"
+#include "Widgets/Input/SSlider.h"
+#include "Widgets/Input/SSpinBox.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/Text/STextBlock.h"
+
+#define LOCTEXT_NAMESPACE "ViveTrackerPlayback"
+
+// Slowest and fastest playback speed offered
+static constexpr float MinPlaybackRate = 0.1f;
+static constexpr float MaxPlaybackRate = 10.f;
+
+// Compressed chunks decoded ahead of the playhead, enough to keep up at the fastest speed
+static constexpr int32 DecodeAheadChunks = 8;
+
+void SViveTrackerPlayback::Construct(const FArguments& InArgs)
+{
+	ChildSlot
+	[
+		SNew(SVerticalBox)
+
+		+ SVerticalBox::Slot()
+		.AutoHeight()
+		.Padding(4.f)
+		[
+			SNew(SHorizontalBox)
+
+			+ SHorizontalBox::Slot()
+			.FillWidth(1.f)
+			.VAlign(VAlign_Center)
+			[
+				SAssignNew(m_pFilenameBox, SEditableTextBox)
+				.HintText(LOCTEXT("CaptureHint", "Tracker capture file (.vtcap)"))
+			]
+
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.Padding(4.f, 0.f, 0.f, 0.f)
+			[
+				SNew(SButton)
+				.Text(LOCTEXT("Browse", "..."))
+				.ToolTipText(LOCTEXT("BrowseTooltip", "Pick a tracker capture"))
+				.OnClicked(this, &SViveTrackerPlayback::OnBrowseClicked)
+			]
+
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.Padding(4.f, 0.f, 0.f, 0.f)
+			[
+				SNew(SButton)
+				.Text(LOCTEXT("Open", "Open"))
+				.ToolTipText(LOCTEXT("OpenTooltip", "Replay the capture through the tracker module, paused at its start"))
+				.OnClicked(this, &SViveTrackerPlayback::OnOpenClicked)
+			]
+
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.Padding(4.f, 0.f, 0.f, 0.f)
+			[
+				SNew(SButton)
+				.Text(LOCTEXT("Close", "Close"))
+				.ToolTipText(LOCTEXT("CloseTooltip", "Stop the replay and go back to the runtime's trackers"))
+				.IsEnabled(this, &SViveTrackerPlayback::IsReplaying)
+				.OnClicked(this, &SViveTrackerPlayback::OnCloseClicked)
+			]
+		]
+
+		+ SVerticalBox::Slot()
+		.AutoHeight()
+		.Padding(4.f)
+		[
+			SNew(SHorizontalBox)
+			.IsEnabled(this, &SViveTrackerPlayback::IsReplaying)
+
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			[
+				SNew(SButton)
+				.Text(this, &SViveTrackerPlayback::GetPlayPauseText)
+				.OnClicked(this, &SViveTrackerPlayback::OnPlayPauseClicked)
+			]
+
+			+ SHorizontalBox::Slot()
+			.FillWidth(1.f)
+			.VAlign(VAlign_Center)
+			.Padding(8.f, 0.f)
+			[
+				SNew(SSlider)
+				.Value(this, &SViveTrackerPlayback::GetScrubValue)
+				.OnMouseCaptureBegin(this, &SViveTrackerPlayback::OnScrubBegin)
+				.OnMouseCaptureEnd(this, &SViveTrackerPlayback::OnScrubEnd)
+				.OnValueChanged(this, &SViveTrackerPlayback::OnScrubChanged)
+			]
+
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.VAlign(VAlign_Center)
+			[
+				SNew(STextBlock)
+				.Text(this, &SViveTrackerPlayback::GetTimeText)
+			]
+		]
+
+		+ SVerticalBox::Slot()
+		.AutoHeight()
+		.Padding(4.f)
+		[
+			SNew(SHorizontalBox)
+			.IsEnabled(this, &SViveTrackerPlayback::IsReplaying)
+
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.VAlign(VAlign_Center)
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("Speed", "Speed"))
+			]
+
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.Padding(8.f, 0.f)
+			[
+				SNew(SBox)
+				.WidthOverride(80.f)
+				[
+					SNew(SSpinBox<float>)
+					.MinValue(MinPlaybackRate)
+					.MaxValue(MaxPlaybackRate)
+					.Delta(0.1f)
+					.Value(this, &SViveTrackerPlayback::GetRate)
+					.OnValueChanged(this, &SViveTrackerPlayback::OnRateChanged)
+				]
+			]
+
+			+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.VAlign(VAlign_Center)
+			[
+				SNew(SCheckBox)
+				.IsChecked(this, &SViveTrackerPlayback::GetLoopState)
+				.OnCheckStateChanged(this, &SViveTrackerPlayback::OnLoopChanged)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("Loop", "Loop"))
+				]
+			]
+		]
+	];
+}
+
+FReply SViveTrackerPlayback::OnBrowseClicked()
+{
+	IDesktopPlatform* pDesktopPlatform = FDesktopPlatformModule::Get();
+	if (!pDesktopPlatform)
+		return FReply::Handled();
+
+	TArray<FString> arrFilenames;
+	const FString sDefaultPath = FPaths::ProjectSavedDir() / TEXT("ViveTracker");
+	if (pDesktopPlatform->OpenFileDialog(FSlateApplication::Get().FindBestParentWindowHandleForDialogs(AsShared()), LOCTEXT("BrowseTitle", "Open Tracker Capture").ToString(),
+		sDefaultPath, FString(), TEXT("Tracker captures (*.vtcap)|*.vtcap|All files (*.*)|*.*"), EFileDialogFlags::None, arrFilenames) && arrFilenames.Num() > 0)
+	{
+		m_pFilenameBox->SetText(FText::FromString(FPaths::ConvertRelativePathToFull(arrFilenames[0])));
+		OnOpenClicked();
+	}
+	return FReply::Handled();
+}
+
+FReply SViveTrackerPlayback::OnOpenClicked()
+{
+	const FString sFilename = m_pFilenameBox->GetText().ToString().TrimStartAndEnd();
+	if (sFilename.IsEmpty())
+		return FReply::Handled();
+
+	FViveTrackerReplaySettings Settings;
+	Settings.DecodeAheadChunks = DecodeAheadChunks;
+
+	FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	if (TrackerModule.StartReplay(sFilename, Settings))
+	{
+		TrackerModule.SetReplayPaused(true);
+	}
+	return FReply::Handled();
+}
+
+FReply SViveTrackerPlayback::OnCloseClicked()
+{
+	FOpenXRViveTrackerModule::Get().StopReplay();
+	return FReply::Handled();
+}
+
+FReply SViveTrackerPlayback::OnPlayPauseClicked()
+{
+	FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	if (TrackerModule.IsReplayPaused() && TrackerModule.GetReplayPosition() >= TrackerModule.GetReplayDuration())
+	{
+		// Playing again from the end starts over
+		TrackerModule.SeekReplay(0.0);
+	}
+	TrackerModule.SetReplayPaused(!TrackerModule.IsReplayPaused());
+	return FReply::Handled();
+}
+
+void SViveTrackerPlayback::OnScrubBegin()
+{
+	FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	m_bScrubbing = true;
+	m_bPausedBeforeScrub = TrackerModule.IsReplayPaused();
+	TrackerModule.SetReplayPaused(true);
+}
+
+void SViveTrackerPlayback::OnScrubEnd()
+{
+	if (m_bScrubbing)
+	{
+		m_bScrubbing = false;
+		FOpenXRViveTrackerModule::Get().SetReplayPaused(m_bPausedBeforeScrub);
+	}
+}
+
+void SViveTrackerPlayback::OnScrubChanged(float Value)
+{
+	// The module applies the last seek of the frame, dragging never queues up work
+	FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	TrackerModule.SeekReplay(Value * TrackerModule.GetReplayDuration());
+}
+
+void SViveTrackerPlayback::OnRateChanged(float Rate)
+{
+	FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	if (const FViveTrackerReplaySettings* pSettings = TrackerModule.GetReplaySettings())
+	{
+		FViveTrackerReplaySettings Settings = *pSettings;
+		Settings.PlaybackRate = FMath::Clamp(Rate, MinPlaybackRate, MaxPlaybackRate);
+		TrackerModule.SetReplaySettings(Settings);
+	}
+}
+
+void SViveTrackerPlayback::OnLoopChanged(ECheckBoxState State)
+{
+	FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	if (const FViveTrackerReplaySettings* pSettings = TrackerModule.GetReplaySettings())
+	{
+		FViveTrackerReplaySettings Settings = *pSettings;
+		Settings.bLoop = State == ECheckBoxState::Checked;
+		TrackerModule.SetReplaySettings(Settings);
+	}
+}
+
+bool SViveTrackerPlayback::IsReplaying() const
+{
+	return FOpenXRViveTrackerModule::Get().IsReplaying();
+}
+
+FText SViveTrackerPlayback::GetPlayPauseText() const
+{
+	const FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	return TrackerModule.IsReplaying() && !TrackerModule.IsReplayPaused() && !m_bScrubbing ? LOCTEXT("Pause", "Pause") : LOCTEXT("Play", "Play");
+}
+
+FText SViveTrackerPlayback::GetTimeText() const
+{
+	const FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	return FText::FromString(FString::Printf(TEXT("%.2f / %.2f s"), TrackerModule.GetReplayPosition(), TrackerModule.GetReplayDuration()));
+}
+
+float SViveTrackerPlayback::GetScrubValue() const
+{
+	const FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	const double fDuration = TrackerModule.GetReplayDuration();
+	return fDuration > 0.0 ? (float)(TrackerModule.GetReplayPosition() / fDuration) : 0.f;
+}
+
+float SViveTrackerPlayback::GetRate() const
+{
+	const FViveTrackerReplaySettings* pSettings = FOpenXRViveTrackerModule::Get().GetReplaySettings();
+	return pSettings ? pSettings->PlaybackRate : 1.f;
+}
+
+ECheckBoxState SViveTrackerPlayback::GetLoopState() const
+{
+	const FViveTrackerReplaySettings* pSettings = FOpenXRViveTrackerModule::Get().GetReplaySettings();
+	return pSettings && pSettings->bLoop ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+}
+
+#undef LOCTEXT_NAMESPACE
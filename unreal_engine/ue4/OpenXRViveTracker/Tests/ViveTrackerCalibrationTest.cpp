@@ -0,0 +1,126 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Calibrates a synthetic T-pose and checks the solved height and offsets, and that frames without a head pose are ignored.
+
+#include "ViveTrackerTestSupport.h"
+#include "ViveTrackerCore/ViveTrackerCalibration.h"
+#include "ViveTrackerCore/ViveTrackerMath.h"
+
+#include <cmath>
+
+using namespace ViveTrackerCore;
+
+/** A user standing in a T-pose in a Z up space, facing +X so their left is -Y, with a pelvis and two foot trackers */
+static FCalibrationFrame MakeTPoseFrame()
+{
+	FCalibrationFrame Frame;
+	Frame.Head.Position = FVec3{ 0.f, 0.f, 165.f };
+	Frame.Hands[0].Position = FVec3{ 0.f, -80.f, 145.f };
+	Frame.Hands[1].Position = FVec3{ 0.f, 80.f, 145.f };
+	Frame.bHandsValid[0] = Frame.bHandsValid[1] = true;
+
+	Frame.Trackers[(int)EBodyTracker::Pelvis].Position = FVec3{ 5.f, 0.f, 95.f };
+	Frame.Trackers[(int)EBodyTracker::Foot_L].Position = FVec3{ 5.f, -12.f, 8.f };
+	Frame.Trackers[(int)EBodyTracker::Foot_R].Position = FVec3{ 5.f, 12.f, 8.f };
+	Frame.ValidMask = (1u << (int)EBodyTracker::Pelvis) | (1u << (int)EBodyTracker::Foot_L) | (1u << (int)EBodyTracker::Foot_R);
+	return Frame;
+}
+
+static void TestTPose()
+{
+	const FBodySkeleton Skeleton;
+	FBodyCalibrator Calibrator;
+	FCalibrationResult Result;
+
+	// Nothing captured yet
+	VIVETRACKER_CHECK(!Calibrator.Solve(Skeleton, 2.f, Result));
+
+	const FCalibrationFrame Frame = MakeTPoseFrame();
+	for (int nFrame = 0; nFrame < 45; nFrame++)
+	{
+		Calibrator.AddFrame(Frame);
+	}
+	VIVETRACKER_CHECK(Calibrator.GetNumFrames() == 45);
+	if (!VIVETRACKER_CHECK(Calibrator.Solve(Skeleton, 2.f, Result)))
+		return;
+
+	VIVETRACKER_CHECK(Result.Height > 150.f && Result.Height < 190.f);
+	VIVETRACKER_CHECK(Result.MaxMotion < 1.0e-3f);
+	VIVETRACKER_CHECK(Result.CalibratedMask == Frame.ValidMask);
+
+	// Both feet hang a shin length under their knees, at the solved hip width either side of the pelvis
+	const FVec3 FootL = Frame.Trackers[(int)EBodyTracker::Foot_L].Position + Result.TrackerToBone[(int)EBodyTracker::Foot_L].Position;
+	const FVec3 FootR = Frame.Trackers[(int)EBodyTracker::Foot_R].Position + Result.TrackerToBone[(int)EBodyTracker::Foot_R].Position;
+	VIVETRACKER_CHECK(std::fabs(FootL.Z - FootR.Z) < 1.0e-3f);
+	VIVETRACKER_CHECK(std::fabs(FootR.Y - FootL.Y - 2.f * Result.Skeleton.HipHalfWidth) < 1.0e-2f);
+}
+
+static void TestWithoutHead()
+{
+	const FBodySkeleton Skeleton;
+	const FCalibrationFrame Frame = MakeTPoseFrame();
+
+	FBodyCalibrator Reference;
+	FBodyCalibrator Calibrator;
+	for (int nFrame = 0; nFrame < 45; nFrame++)
+	{
+		Reference.AddFrame(Frame);
+		Calibrator.AddFrame(Frame);
+
+		// Frames where the HMD lost tracking, everything else moved away
+		FCalibrationFrame Lost = Frame;
+		Lost.bHeadValid = false;
+		Lost.Head.Position = FVec3{ 0.f, 0.f, 0.f };
+		Lost.Trackers[(int)EBodyTracker::Pelvis].Position = FVec3{ 50.f, 50.f, 50.f };
+		Calibrator.AddFrame(Lost);
+	}
+	VIVETRACKER_CHECK(Calibrator.GetNumFrames() == Reference.GetNumFrames());
+
+	FCalibrationResult Expected, Result;
+	VIVETRACKER_CHECK(Reference.Solve(Skeleton, 2.f, Expected));
+	VIVETRACKER_CHECK(Calibrator.Solve(Skeleton, 2.f, Result));
+	VIVETRACKER_CHECK(Result.Height == Expected.Height && Result.MaxMotion == Expected.MaxMotion);
+
+	// A capture without any head pose has nothing to solve
+	FBodyCalibrator Headless;
+	FCalibrationFrame Lost = Frame;
+	Lost.bHeadValid = false;
+	Headless.AddFrame(Lost);
+	FCalibrationResult Unsolved;
+	VIVETRACKER_CHECK(Headless.GetNumFrames() == 0);
+	VIVETRACKER_CHECK(!Headless.Solve(Skeleton, 2.f, Unsolved));
+}
+
+int main()
+{
+	TestTPose();
+	TestWithoutHead();
+	return VIVETRACKER_TEST_RESULT();
+}
@@ -0,0 +1,609 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerMockXr.h"
+#include "ViveTrackerTestSupport.h"
+#include "ViveTrackerCore/ViveTrackerMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace ViveTrackerCore
+{
+	static FMockXrRuntime* GActiveMockXrRuntime = nullptr;
+
+	// Handles are small integers, one range per handle type
+	static const XrInstance MockInstance = (XrInstance)(uintptr_t)0x1001;
+	static const XrSession MockSession = (XrSession)(uintptr_t)0x2001;
+	static const XrActionSet MockActionSet = (XrActionSet)(uintptr_t)0x3001;
+	static const XrSpace MockBaseSpace = (XrSpace)(uintptr_t)0x4001;
+	static constexpr uint64_t ActionHandleBase = 0x10000;
+	static constexpr uint64_t SpaceHandleBase = 0x20000;
+	static constexpr uint64_t HandleRangeSize = 0x10000;
+
+	template <typename HandleType>
+	static int GetHandleIndex(HandleType Handle, uint64_t Base, size_t Num)
+	{
+		const uint64_t nValue = (uint64_t)(uintptr_t)Handle;
+		return nValue > Base && nValue <= Base + (uint64_t)Num && nValue < Base + HandleRangeSize ? (int)(nValue - Base - 1) : -1;
+	}
+
+	static FQuat4 ToQuat(const XrQuaternionf& Q) { return { Q.x, Q.y, Q.z, Q.w }; }
+	static XrQuaternionf ToXrQuat(const FQuat4& Q) { return { Q.X, Q.Y, Q.Z, Q.W }; }
+
+	/** Rotation by an angle in radians around a unit axis */
+	static FQuat4 MakeAxisAngle(const FVec3& Axis, float Angle)
+	{
+		const float S = std::sin(0.5f * Angle);
+		return { Axis.X * S, Axis.Y * S, Axis.Z * S, std::cos(0.5f * Angle) };
+	}
+
+	bool FMockXrRuntime::Start(FTrackerSession& Session)
+	{
+		if (IsRunning())
+			return true;
+
+		if (GActiveMockXrRuntime)
+		{
+			std::printf("Another mock OpenXR runtime is already running\n");
+			return false;
+		}
+
+		GActiveMockXrRuntime = this;
+		m_pSession = &Session;
+		m_fSeconds = 0.0;
+		m_nNextScriptEvent = 0;
+		m_actionRoles.clear();
+		m_spaceActions.clear();
+		for (FTrackerState& Tracker : m_trackers)
+		{
+			Tracker.bConnected = false;
+			Tracker.Paths.rolePath = GetRolePath(Tracker.Script.Role);
+		}
+		RebuildRoleTrackers();
+
+		// The order the module sets a session up in
+		Session.SetEntryPoints(GetEntryPoints());
+		if (Session.CreateActionSet(MockInstance) != XR_SUCCESS || Session.CreateActions(MockSession) != XR_SUCCESS)
+		{
+			std::printf("Unable to create the tracker session's actions on the mock OpenXR runtime\n");
+			Stop();
+			return false;
+		}
+		Session.LocateRoles(MockBaseSpace, GetTime());
+		return true;
+	}
+
+	void FMockXrRuntime::Stop()
+	{
+		if (!IsRunning())
+			return;
+
+		// The session destroys its actions through the mock's entry points
+		m_pSession->Release();
+		m_pSession = nullptr;
+		GActiveMockXrRuntime = nullptr;
+	}
+
+	int FMockXrRuntime::AddTracker(const FMockTracker& Tracker, double ConnectSeconds)
+	{
+		FTrackerState State;
+		State.Script = Tracker;
+		State.Paths = XrViveTrackerPathsHTCX{ XR_TYPE_VIVE_TRACKER_PATHS_HTCX };
+		State.Paths.persistentPath = StringToPath(Tracker.PersistentPath.c_str());
+		State.Paths.rolePath = GetRolePath(Tracker.Role);
+		m_trackers.push_back(State);
+
+		const int nTracker = (int)m_trackers.size() - 1;
+		AddScriptEvent(FScriptEvent{ ConnectSeconds, nTracker, EScriptEvent::Connect, Tracker.Role });
+		return nTracker;
+	}
+
+	void FMockXrRuntime::Disconnect(int TrackerIndex, double Seconds)
+	{
+		AddScriptEvent(FScriptEvent{ Seconds, TrackerIndex, EScriptEvent::Disconnect, NumTrackerRoles });
+	}
+
+	void FMockXrRuntime::Connect(int TrackerIndex, double Seconds)
+	{
+		AddScriptEvent(FScriptEvent{ Seconds, TrackerIndex, EScriptEvent::Connect, m_trackers[TrackerIndex].Script.Role });
+	}
+
+	void FMockXrRuntime::ChangeRole(int TrackerIndex, int Role, double Seconds)
+	{
+		AddScriptEvent(FScriptEvent{ Seconds, TrackerIndex, EScriptEvent::ChangeRole, Role });
+	}
+
+	void FMockXrRuntime::AddScriptEvent(const FScriptEvent& Event)
+	{
+		// Kept in time order, events at the same time in the order they were scripted
+		const auto It = std::upper_bound(m_script.begin() + m_nNextScriptEvent, m_script.end(), Event.Seconds,
+			[](double Seconds, const FScriptEvent& ScriptEvent) { return Seconds < ScriptEvent.Seconds; });
+		m_script.insert(It, Event);
+	}
+
+	void FMockXrRuntime::ApplyScriptEvent(const FScriptEvent& Event)
+	{
+		if (Event.TrackerIndex < 0 || Event.TrackerIndex >= GetNumTrackers())
+			return;
+
+		FTrackerState& Tracker = m_trackers[Event.TrackerIndex];
+		switch (Event.Type)
+		{
+		case EScriptEvent::Connect:
+		case EScriptEvent::ChangeRole:
+			Tracker.bConnected = true;
+			Tracker.Script.Role = Event.Role;
+			Tracker.Paths.rolePath = GetRolePath(Event.Role);
+			break;
+
+		case EScriptEvent::Disconnect:
+			Tracker.bConnected = false;
+			break;
+		}
+		RebuildRoleTrackers();
+
+		// The extension only has a connect event, runtimes send it again when a role changes
+		if (Event.Type != EScriptEvent::Disconnect)
+		{
+			SendConnectEvent(Event.TrackerIndex);
+		}
+	}
+
+	void FMockXrRuntime::SendConnectEvent(int TrackerIndex)
+	{
+		if (!m_pSession || TrackerIndex < 0 || TrackerIndex >= GetNumTrackers() || !m_trackers[TrackerIndex].bConnected)
+			return;
+
+		XrEventDataViveTrackerConnectedHTCX xrEvent{ XR_TYPE_EVENT_DATA_VIVE_TRACKER_CONNECTED_HTCX };
+		xrEvent.paths = &m_trackers[TrackerIndex].Paths;
+		m_nEventsSent++;
+
+		m_bInEvent = true;
+		const uint64_t nStartAllocations = ViveTrackerTest::GetNumAllocations();
+		const double StartSeconds = ViveTrackerTest::GetSeconds();
+		const ETrackerSessionEvent Result = m_pSession->HandleEvent(reinterpret_cast<const XrEventDataBaseHeader*>(&xrEvent));
+		m_fEventSeconds += ViveTrackerTest::GetSeconds() - StartSeconds;
+		m_nEventAllocations += (int64_t)(ViveTrackerTest::GetNumAllocations() - nStartAllocations);
+		m_bInEvent = false;
+
+		m_nEventsHandled += Result == ETrackerSessionEvent::TrackerConnected ? 1 : 0;
+	}
+
+	void FMockXrRuntime::RebuildRoleTrackers()
+	{
+		std::fill(std::begin(m_roleTrackers), std::end(m_roleTrackers), -1);
+
+		// The first connected tracker wins a role, like a runtime would only bind one
+		for (int nTracker = 0; nTracker < GetNumTrackers(); nTracker++)
+		{
+			const FTrackerState& Tracker = m_trackers[nTracker];
+			if (Tracker.bConnected && Tracker.Script.Role >= 0 && Tracker.Script.Role < NumTrackerRoles && m_roleTrackers[Tracker.Script.Role] < 0)
+			{
+				m_roleTrackers[Tracker.Script.Role] = nTracker;
+			}
+		}
+	}
+
+	void FMockXrRuntime::RecordRuntimeCall()
+	{
+		if (GActiveMockXrRuntime && GActiveMockXrRuntime->m_bInEvent)
+		{
+			GActiveMockXrRuntime->m_nEventRuntimeCalls++;
+		}
+	}
+
+	XrPath FMockXrRuntime::StringToPath(const char* pString)
+	{
+		const auto It = std::find(m_pathStrings.begin(), m_pathStrings.end(), pString);
+		if (It != m_pathStrings.end())
+			return (XrPath)(It - m_pathStrings.begin() + 1);
+
+		m_pathStrings.push_back(pString);
+		return (XrPath)m_pathStrings.size();
+	}
+
+	XrPath FMockXrRuntime::GetRolePath(int Role)
+	{
+		const char* pRolePath = GetTrackerRolePath(Role);
+		return pRolePath ? StringToPath(pRolePath) : XR_NULL_PATH;
+	}
+
+	void FMockXrRuntime::Tick(double DeltaSeconds)
+	{
+		if (!IsRunning())
+			return;
+
+		m_fSeconds += DeltaSeconds;
+
+		// Events first, like the module polls them before the frame
+		while (m_nNextScriptEvent < m_script.size() && m_script[m_nNextScriptEvent].Seconds <= m_fSeconds)
+		{
+			ApplyScriptEvent(m_script[m_nNextScriptEvent++]);
+		}
+
+		m_pSession->RefreshTrackers();
+		m_pSession->LocateRoles(MockBaseSpace, GetTime());
+	}
+
+	XrTime FMockXrRuntime::GetTime() const
+	{
+		return StartTime + (XrTime)std::llround(m_fSeconds * 1.0e9);
+	}
+
+	bool FMockXrRuntime::GetExpectedPose(int TrackerIndex, double Seconds, XrPosef& OutPose) const
+	{
+		if (TrackerIndex < 0 || TrackerIndex >= GetNumTrackers())
+			return false;
+
+		// Replays the script up to the time, the tracker's state now may differ
+		bool bConnected = false;
+		int Role = NumTrackerRoles;
+		for (const FScriptEvent& Event : m_script)
+		{
+			if (Event.Seconds > Seconds)
+				break;
+
+			if (Event.TrackerIndex == TrackerIndex)
+			{
+				bConnected = Event.Type != EScriptEvent::Disconnect;
+				Role = Event.Type != EScriptEvent::Disconnect ? Event.Role : Role;
+			}
+		}
+
+		if (!bConnected || Role < 0 || Role >= NumTrackerRoles)
+			return false;
+
+		return GetScriptedPose(m_trackers[TrackerIndex], Seconds, OutPose);
+	}
+
+	bool FMockXrRuntime::GetScriptedPose(const FTrackerState& Tracker, double Seconds, XrPosef& OutPose) const
+	{
+		if (!Tracker.Script.Trajectory)
+			return false;
+
+		for (const std::pair<double, double>& Dropout : Tracker.Script.Dropouts)
+		{
+			if (Seconds >= Dropout.first && Seconds < Dropout.second)
+				return false;
+		}
+
+		OutPose = Tracker.Script.Trajectory(Seconds);
+		return true;
+	}
+
+	XrInstance FMockXrRuntime::GetInstance()
+	{
+		return MockInstance;
+	}
+
+	XrSession FMockXrRuntime::GetSession()
+	{
+		return MockSession;
+	}
+
+	XrSpace FMockXrRuntime::GetBaseSpace()
+	{
+		return MockBaseSpace;
+	}
+
+	FXrEntryPoints FMockXrRuntime::GetEntryPoints()
+	{
+		FXrEntryPoints xrEntryPoints;
+		xrEntryPoints.GetInstanceProcAddr = &FMockXrRuntime::GetInstanceProcAddr;
+		xrEntryPoints.CreateActionSet = &FMockXrRuntime::CreateActionSet;
+		xrEntryPoints.DestroyActionSet = &FMockXrRuntime::DestroyActionSet;
+		xrEntryPoints.CreateAction = &FMockXrRuntime::CreateAction;
+		xrEntryPoints.DestroyAction = &FMockXrRuntime::DestroyAction;
+		xrEntryPoints.CreateActionSpace = &FMockXrRuntime::CreateActionSpace;
+		xrEntryPoints.SuggestInteractionProfileBindings = &FMockXrRuntime::SuggestInteractionProfileBindings;
+		xrEntryPoints.LocateSpace = &FMockXrRuntime::LocateSpace;
+		xrEntryPoints.StringToPath = &FMockXrRuntime::StringToPathEntry;
+		xrEntryPoints.PathToString = &FMockXrRuntime::PathToString;
+		return xrEntryPoints;
+	}
+
+	FMockTracker FMockXrRuntime::MakeOrbitingTracker(int Index)
+	{
+		FMockTracker Tracker;
+		char sPath[64];
+		std::snprintf(sPath, sizeof(sPath), "/devices/htc/vive_trackerMOCK-%04d", Index);
+		Tracker.PersistentPath = sPath;
+		Tracker.Role = Index % NumTrackerRoles;
+
+		// Spread over a body sized volume in metres, Y up, each with its own orbit so no two trackers move alike
+		const FVec3 Center{ 0.2f * (Index % 5) - 0.4f, 0.2f + 0.15f * (Index % 11), 0.15f * ((Index / 5) % 5) - 0.3f };
+		const float Radius = 0.05f + 0.02f * (Index % 7);
+		const float Frequency = 0.3f + 0.17f * (Index % 13);
+		const float Phase = 0.7f * Index;
+		Tracker.Trajectory = [Center, Radius, Frequency, Phase](double Seconds)
+		{
+			const float Angle = (float)(2.0 * 3.14159265358979 * Frequency * Seconds) + Phase;
+			const FVec3 Position = Center + FVec3{ Radius * std::cos(Angle), 0.5f * Radius * std::sin(2.f * Angle), Radius * std::sin(Angle) };
+			const FQuat4 Rotation = MakeAxisAngle(FVec3{ 0.f, 1.f, 0.f }, Angle) * MakeAxisAngle(FVec3{ 1.f, 0.f, 0.f }, 0.35f * std::sin(Angle));
+
+			XrPosef Pose;
+			Pose.orientation = ToXrQuat(Rotation);
+			Pose.position = XrVector3f{ Position.X, Position.Y, Position.Z };
+			return Pose;
+		};
+		return Tracker;
+	}
+
+	XrResult FMockXrRuntime::GetInstanceProcAddr(XrInstance Instance, const char* pName, PFN_xrVoidFunction* pFunction)
+	{
+		RecordRuntimeCall();
+
+		if (!GActiveMockXrRuntime || Instance != MockInstance || !pName || !pFunction)
+			return XR_ERROR_HANDLE_INVALID;
+
+		if (std::strcmp(pName, "xrEnumerateViveTrackerPathsHTCX") == 0)
+		{
+			*pFunction = (PFN_xrVoidFunction)&FMockXrRuntime::EnumerateViveTrackerPaths;
+			return XR_SUCCESS;
+		}
+
+		*pFunction = nullptr;
+		return XR_ERROR_FUNCTION_UNSUPPORTED;
+	}
+
+	XrResult FMockXrRuntime::CreateActionSet(XrInstance Instance, const XrActionSetCreateInfo* pCreateInfo, XrActionSet* pActionSet)
+	{
+		RecordRuntimeCall();
+
+		if (!GActiveMockXrRuntime || Instance != MockInstance)
+			return XR_ERROR_HANDLE_INVALID;
+
+		*pActionSet = MockActionSet;
+		return XR_SUCCESS;
+	}
+
+	XrResult FMockXrRuntime::DestroyActionSet(XrActionSet ActionSet)
+	{
+		return ActionSet == MockActionSet ? XR_SUCCESS : XR_ERROR_HANDLE_INVALID;
+	}
+
+	XrResult FMockXrRuntime::CreateAction(XrActionSet ActionSet, const XrActionCreateInfo* pCreateInfo, XrAction* pAction)
+	{
+		RecordRuntimeCall();
+
+		if (!GActiveMockXrRuntime || ActionSet != MockActionSet)
+			return XR_ERROR_HANDLE_INVALID;
+
+		if (pCreateInfo->actionType != XR_ACTION_TYPE_POSE_INPUT || GActiveMockXrRuntime->m_actionRoles.size() + 1 >= HandleRangeSize)
+			return XR_ERROR_FEATURE_UNSUPPORTED;
+
+		GActiveMockXrRuntime->m_actionRoles.push_back(NumTrackerRoles);
+		*pAction = (XrAction)(uintptr_t)(ActionHandleBase + GActiveMockXrRuntime->m_actionRoles.size());
+		return XR_SUCCESS;
+	}
+
+	XrResult FMockXrRuntime::DestroyAction(XrAction Action)
+	{
+		if (!GActiveMockXrRuntime || GetHandleIndex(Action, ActionHandleBase, GActiveMockXrRuntime->m_actionRoles.size()) < 0)
+			return XR_ERROR_HANDLE_INVALID;
+
+		return XR_SUCCESS;
+	}
+
+	XrResult FMockXrRuntime::CreateActionSpace(XrSession Session, const XrActionSpaceCreateInfo* pCreateInfo, XrSpace* pSpace)
+	{
+		RecordRuntimeCall();
+
+		if (!GActiveMockXrRuntime || Session != MockSession)
+			return XR_ERROR_HANDLE_INVALID;
+
+		FMockXrRuntime& Mock = *GActiveMockXrRuntime;
+		const int nAction = GetHandleIndex(pCreateInfo->action, ActionHandleBase, Mock.m_actionRoles.size());
+		if (nAction < 0 || Mock.m_spaceActions.size() + 1 >= HandleRangeSize)
+			return XR_ERROR_HANDLE_INVALID;
+
+		Mock.m_spaceActions.push_back(nAction);
+		*pSpace = (XrSpace)(uintptr_t)(SpaceHandleBase + Mock.m_spaceActions.size());
+		return XR_SUCCESS;
+	}
+
+	XrResult FMockXrRuntime::SuggestInteractionProfileBindings(XrInstance Instance, const XrInteractionProfileSuggestedBinding* pSuggestedBindings)
+	{
+		RecordRuntimeCall();
+
+		if (!GActiveMockXrRuntime || Instance != MockInstance)
+			return XR_ERROR_HANDLE_INVALID;
+
+		FMockXrRuntime& Mock = *GActiveMockXrRuntime;
+		const size_t nProfile = (size_t)pSuggestedBindings->interactionProfile;
+		if (nProfile == 0 || nProfile > Mock.m_pathStrings.size() || Mock.m_pathStrings[nProfile - 1] != "/interaction_profiles/htc/vive_tracker_htcx")
+			return XR_ERROR_PATH_UNSUPPORTED;
+
+		// Bindings are <role path>/input/grip/pose
+		static const char PoseInputPath[] = "/input/grip/pose";
+		const size_t nPoseInputLength = sizeof(PoseInputPath) - 1;
+		for (uint32_t nBinding = 0; nBinding < pSuggestedBindings->countSuggestedBindings; nBinding++)
+		{
+			const XrActionSuggestedBinding& Binding = pSuggestedBindings->suggestedBindings[nBinding];
+			const int nAction = GetHandleIndex(Binding.action, ActionHandleBase, Mock.m_actionRoles.size());
+			const size_t nPath = (size_t)Binding.binding;
+			if (nAction < 0 || nPath == 0 || nPath > Mock.m_pathStrings.size())
+				return XR_ERROR_HANDLE_INVALID;
+
+			const std::string& sBinding = Mock.m_pathStrings[nPath - 1];
+			if (sBinding.size() <= nPoseInputLength || sBinding.compare(sBinding.size() - nPoseInputLength, nPoseInputLength, PoseInputPath) != 0)
+				return XR_ERROR_PATH_UNSUPPORTED;
+
+			const int Role = FindTrackerRole(sBinding.substr(0, sBinding.size() - nPoseInputLength).c_str());
+			if (Role == NumTrackerRoles)
+				return XR_ERROR_PATH_UNSUPPORTED;
+
+			Mock.m_actionRoles[nAction] = Role;
+		}
+		return XR_SUCCESS;
+	}
+
+	XrResult FMockXrRuntime::LocateSpace(XrSpace Space, XrSpace BaseSpace, XrTime Time, XrSpaceLocation* pLocation)
+	{
+		RecordRuntimeCall();
+
+		if (!GActiveMockXrRuntime || BaseSpace != MockBaseSpace)
+			return XR_ERROR_HANDLE_INVALID;
+
+		FMockXrRuntime& Mock = *GActiveMockXrRuntime;
+		const int nSpace = GetHandleIndex(Space, SpaceHandleBase, Mock.m_spaceActions.size());
+		if (nSpace < 0)
+			return XR_ERROR_HANDLE_INVALID;
+
+		Mock.m_nLocateCalls++;
+
+		XrSpaceVelocity* pVelocity = nullptr;
+		for (XrBaseOutStructure* pNext = reinterpret_cast<XrBaseOutStructure*>(pLocation->next); pNext; pNext = pNext->next)
+		{
+			if (pNext->type == XR_TYPE_SPACE_VELOCITY)
+			{
+				pVelocity = reinterpret_cast<XrSpaceVelocity*>(pNext);
+			}
+		}
+
+		pLocation->locationFlags = 0;
+		if (pVelocity)
+		{
+			pVelocity->velocityFlags = 0;
+		}
+
+		// Untracked actions still succeed, with no valid bits. The role's tracker is connected as of the last frame,
+		// so only its dropouts are checked rather than replaying the script. The frame's own time maps back to its
+		// exact seconds, so dropouts start and end on the frames GetExpectedPose says they do.
+		const double fSeconds = Time == Mock.GetTime() ? Mock.m_fSeconds : (Time - StartTime) * 1.0e-9;
+		const int Role = Mock.m_actionRoles[Mock.m_spaceActions[nSpace]];
+		const int nTracker = Role >= 0 && Role < NumTrackerRoles ? Mock.m_roleTrackers[Role] : -1;
+		if (nTracker < 0 || !Mock.GetScriptedPose(Mock.m_trackers[nTracker], fSeconds, pLocation->pose))
+			return XR_SUCCESS;
+
+		pLocation->locationFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT |
+			XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+
+		if (pVelocity)
+		{
+			// Central differences over a millisecond, in the base space
+			const double Step = 0.0005;
+			const std::function<XrPosef(double)>& Trajectory = Mock.m_trackers[nTracker].Script.Trajectory;
+			const XrPosef Before = Trajectory(fSeconds - Step);
+			const XrPosef After = Trajectory(fSeconds + Step);
+
+			FQuat4 Delta = ToQuat(After.orientation) * Conjugate(ToQuat(Before.orientation));
+			if (Delta.W < 0.f)
+			{
+				Delta = FQuat4{ -Delta.X, -Delta.Y, -Delta.Z, -Delta.W };
+			}
+			const FVec3 Axis{ Delta.X, Delta.Y, Delta.Z };
+			const float Angle = 2.f * std::atan2(Length(Axis), Delta.W);
+			const FVec3 AngularVelocity = SafeNormal(Axis, FVec3()) * (float)(Angle * 0.5 / Step);
+
+			pVelocity->velocityFlags = XR_SPACE_VELOCITY_LINEAR_VALID_BIT | XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
+			pVelocity->linearVelocity = XrVector3f{ (float)((After.position.x - Before.position.x) * 0.5 / Step),
+				(float)((After.position.y - Before.position.y) * 0.5 / Step), (float)((After.position.z - Before.position.z) * 0.5 / Step) };
+			pVelocity->angularVelocity = XrVector3f{ AngularVelocity.X, AngularVelocity.Y, AngularVelocity.Z };
+		}
+		return XR_SUCCESS;
+	}
+
+	XrResult FMockXrRuntime::StringToPathEntry(XrInstance Instance, const char* pPathString, XrPath* pPath)
+	{
+		RecordRuntimeCall();
+
+		if (!GActiveMockXrRuntime || Instance != MockInstance)
+			return XR_ERROR_HANDLE_INVALID;
+
+		if (!pPathString || pPathString[0] != '/')
+			return XR_ERROR_PATH_FORMAT_INVALID;
+
+		*pPath = GActiveMockXrRuntime->StringToPath(pPathString);
+		return XR_SUCCESS;
+	}
+
+	XrResult FMockXrRuntime::PathToString(XrInstance Instance, XrPath Path, uint32_t BufferCapacityInput, uint32_t* pBufferCountOutput, char* pBuffer)
+	{
+		RecordRuntimeCall();
+
+		if (!GActiveMockXrRuntime || Instance != MockInstance)
+			return XR_ERROR_HANDLE_INVALID;
+
+		const std::vector<std::string>& PathStrings = GActiveMockXrRuntime->m_pathStrings;
+		if (Path == XR_NULL_PATH || (size_t)Path > PathStrings.size())
+			return XR_ERROR_PATH_INVALID;
+
+		// Two call idiom, the count includes the terminator
+		const std::string& sPath = PathStrings[(size_t)Path - 1];
+		*pBufferCountOutput = (uint32_t)sPath.size() + 1;
+		if (BufferCapacityInput == 0)
+			return XR_SUCCESS;
+
+		if (BufferCapacityInput < *pBufferCountOutput)
+			return XR_ERROR_SIZE_INSUFFICIENT;
+
+		std::memcpy(pBuffer, sPath.c_str(), sPath.size() + 1);
+		return XR_SUCCESS;
+	}
+
+	XrResult FMockXrRuntime::EnumerateViveTrackerPaths(XrInstance Instance, uint32_t PathCapacityInput, uint32_t* pPathCountOutput, XrViveTrackerPathsHTCX* pPaths)
+	{
+		RecordRuntimeCall();
+
+		if (!GActiveMockXrRuntime || Instance != MockInstance)
+			return XR_ERROR_HANDLE_INVALID;
+
+		FMockXrRuntime& Mock = *GActiveMockXrRuntime;
+		Mock.m_nEnumerateCalls++;
+
+		uint32_t nConnected = 0;
+		for (const FTrackerState& Tracker : Mock.m_trackers)
+		{
+			nConnected += Tracker.bConnected ? 1 : 0;
+		}
+
+		*pPathCountOutput = nConnected;
+		if (PathCapacityInput == 0)
+			return XR_SUCCESS;
+
+		if (PathCapacityInput < nConnected)
+			return XR_ERROR_SIZE_INSUFFICIENT;
+
+		uint32_t nPath = 0;
+		for (const FTrackerState& Tracker : Mock.m_trackers)
+		{
+			if (Tracker.bConnected)
+			{
+				pPaths[nPath].persistentPath = Tracker.Paths.persistentPath;
+				pPaths[nPath].rolePath = Tracker.Paths.rolePath;
+				nPath++;
+			}
+		}
+		return XR_SUCCESS;
+	}
+}
@@ -0,0 +1,237 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// An in-process stand-in for an OpenXR runtime implementing XR_HTCX_vive_tracker_interaction, driving a
+// ViveTrackerCore::FTrackerSession outside of the engine. The engine independent counterpart of
+// FViveTrackerMockRuntime, which drives the whole module the same way.
+
+#include "ViveTrackerCore/ViveTrackerSession.h"
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ViveTrackerCore
+{
+	/** A tracker played by FMockXrRuntime */
+	struct FMockTracker
+	{
+		/** Persistent path the runtime reports for the tracker, e.g. /devices/htc/vive_trackerLHR-XXXXXXXX */
+		std::string PersistentPath;
+
+		/** Role assigned to the tracker when it connects, NumTrackerRoles for trackers listed without a role */
+		int Role = NumTrackerRoles;
+
+		/** Pose in the base space, in OpenXR units and axes, at a time in seconds since the mock runtime started */
+		std::function<XrPosef(double)> Trajectory;
+
+		/** Times in seconds, begin included and end excluded, during which the tracker stays connected but has lost tracking */
+		std::vector<std::pair<double, double>> Dropouts;
+	};
+
+	/**
+	* Serves the session's entry points (xrCreateActionSet, xrCreateAction, xrCreateActionSpace, xrSuggestInteractionProfileBindings,
+	* xrLocateSpace, xrStringToPath, xrPathToString and xrGetInstanceProcAddr for xrEnumerateViveTrackerPathsHTCX) from scripted
+	* trackers. Every Tick runs a frame like the module does: scripted connect events through HandleEvent, RefreshTrackers and
+	* LocateRoles at the frame's time. Time only moves with Tick, so runs are reproducible. One mock runs at a time.
+	*/
+	class FMockXrRuntime
+	{
+	public:
+		/** Runtime time of the mock's first frame */
+		static constexpr XrTime StartTime = 1000 * 1000 * 1000;
+
+		FMockXrRuntime() = default;
+		~FMockXrRuntime() { Stop(); }
+
+		FMockXrRuntime(const FMockXrRuntime&) = delete;
+		FMockXrRuntime& operator=(const FMockXrRuntime&) = delete;
+
+		/**
+		* Point a session at the mock's entry points and create its action set and actions
+		* @param FTrackerSession - The session to drive
+		* @return bool - Whether or not the mock started, it doesn't if another mock is running or the session failed
+		*/
+		bool Start(FTrackerSession& Session);
+
+		/** Release the session */
+		void Stop();
+
+		bool IsRunning() const { return m_pSession != nullptr; }
+
+		/**
+		* Add a tracker to the script
+		* @param FMockTracker - The tracker, its trajectory and dropouts
+		* @param double - Time in seconds since the start the tracker connects at
+		* @return int - Index of the tracker, for the other script calls
+		*/
+		int AddTracker(const FMockTracker& Tracker, double ConnectSeconds = 0.0);
+
+		/** Script a tracker to disconnect, it is no longer listed or located until it connects again */
+		void Disconnect(int TrackerIndex, double Seconds);
+
+		/** Script a tracker to connect again, with a connect event */
+		void Connect(int TrackerIndex, double Seconds);
+
+		/** Script a role change, sent with a connect event like SteamVR does when roles are reassigned */
+		void ChangeRole(int TrackerIndex, int Role, double Seconds);
+
+		/**
+		* Run a frame: send the events scripted up to the new time, refresh the trackers and locate every role
+		* @param double - Length of the frame in seconds
+		*/
+		void Tick(double DeltaSeconds);
+
+		/** Send a connected tracker's connect event right away, outside the script */
+		void SendConnectEvent(int TrackerIndex);
+
+		/** Seconds since the start, the time of the last frame */
+		double GetSeconds() const { return m_fSeconds; }
+
+		/** Runtime time of the last frame */
+		XrTime GetTime() const;
+
+		int GetNumTrackers() const { return (int)m_trackers.size(); }
+
+		/** A scripted tracker, with its role as of the last frame */
+		const FMockTracker& GetTracker(int TrackerIndex) const { return m_trackers[TrackerIndex].Script; }
+
+		/** Whether or not a scripted tracker is connected as of the last frame */
+		bool IsConnected(int TrackerIndex) const { return m_trackers[TrackerIndex].bConnected; }
+
+		/**
+		* What a tracker reports at a time, for checking results
+		* @param int - Index of the tracker
+		* @param double - Seconds since the start
+		* @param XrPosef - Receives the scripted pose
+		* @return bool - Whether or not the tracker is connected, has a role and is tracking at that time
+		*/
+		bool GetExpectedPose(int TrackerIndex, double Seconds, XrPosef& OutPose) const;
+
+		/** Number of xrLocateSpace calls, connect events sent and handled, and tracker path enumerations so far */
+		int64_t GetNumLocateCalls() const { return m_nLocateCalls; }
+		int64_t GetNumEventsSent() const { return m_nEventsSent; }
+		int64_t GetNumEventsHandled() const { return m_nEventsHandled; }
+		int64_t GetNumEnumerateCalls() const { return m_nEnumerateCalls; }
+
+		/** Number of calls the session made into the mock, heap allocations and seconds spent while handling connect events */
+		int64_t GetNumEventRuntimeCalls() const { return m_nEventRuntimeCalls; }
+		int64_t GetNumEventAllocations() const { return m_nEventAllocations; }
+		double GetEventSeconds() const { return m_fEventSeconds; }
+
+		/** Handles of the mock's instance, session and base space */
+		static XrInstance GetInstance();
+		static XrSession GetSession();
+		static XrSpace GetBaseSpace();
+
+		/** The mock's entry points, only valid while a mock is running */
+		static FXrEntryPoints GetEntryPoints();
+
+		/**
+		* A tracker orbiting a point of a body sized volume, with its own phase and speed
+		* @param int - Index of the tracker, picks the persistent path, the role (cycling through the roles) and the orbit
+		* @return FMockTracker - The tracker
+		*/
+		static FMockTracker MakeOrbitingTracker(int Index);
+
+	private:
+		enum class EScriptEvent : uint8_t
+		{
+			Connect,
+			Disconnect,
+			ChangeRole
+		};
+
+		struct FScriptEvent
+		{
+			double Seconds;
+			int TrackerIndex;
+			EScriptEvent Type;
+			int Role;
+		};
+
+		struct FTrackerState
+		{
+			FMockTracker Script;
+			XrViveTrackerPathsHTCX Paths;
+			bool bConnected = false;
+		};
+
+		void AddScriptEvent(const FScriptEvent& Event);
+		void ApplyScriptEvent(const FScriptEvent& Event);
+		void RebuildRoleTrackers();
+		XrPath StringToPath(const char* pString);
+		XrPath GetRolePath(int Role);
+		bool GetScriptedPose(const FTrackerState& Tracker, double Seconds, XrPosef& OutPose) const;
+		static void RecordRuntimeCall();
+
+		// Entry points, dispatched to the running mock
+		static XrResult XRAPI_CALL GetInstanceProcAddr(XrInstance Instance, const char* pName, PFN_xrVoidFunction* pFunction);
+		static XrResult XRAPI_CALL CreateActionSet(XrInstance Instance, const XrActionSetCreateInfo* pCreateInfo, XrActionSet* pActionSet);
+		static XrResult XRAPI_CALL DestroyActionSet(XrActionSet ActionSet);
+		static XrResult XRAPI_CALL CreateAction(XrActionSet ActionSet, const XrActionCreateInfo* pCreateInfo, XrAction* pAction);
+		static XrResult XRAPI_CALL DestroyAction(XrAction Action);
+		static XrResult XRAPI_CALL CreateActionSpace(XrSession Session, const XrActionSpaceCreateInfo* pCreateInfo, XrSpace* pSpace);
+		static XrResult XRAPI_CALL SuggestInteractionProfileBindings(XrInstance Instance, const XrInteractionProfileSuggestedBinding* pSuggestedBindings);
+		static XrResult XRAPI_CALL LocateSpace(XrSpace Space, XrSpace BaseSpace, XrTime Time, XrSpaceLocation* pLocation);
+		static XrResult XRAPI_CALL StringToPathEntry(XrInstance Instance, const char* pPathString, XrPath* pPath);
+		static XrResult XRAPI_CALL PathToString(XrInstance Instance, XrPath Path, uint32_t BufferCapacityInput, uint32_t* pBufferCountOutput, char* pBuffer);
+		static XrResult XRAPI_CALL EnumerateViveTrackerPaths(XrInstance Instance, uint32_t PathCapacityInput, uint32_t* pPathCountOutput, XrViveTrackerPathsHTCX* pPaths);
+
+		FTrackerSession* m_pSession = nullptr;
+
+		std::vector<FTrackerState> m_trackers;
+		std::vector<FScriptEvent> m_script;
+		size_t m_nNextScriptEvent = 0;
+
+		// Index of the connected tracker bound to each role, -1 if none, so locating never searches
+		int m_roleTrackers[NumTrackerRoles];
+
+		// Path strings, path n is m_pathStrings[n - 1]
+		std::vector<std::string> m_pathStrings;
+
+		// Role of every action, and action of every action space
+		std::vector<int> m_actionRoles;
+		std::vector<int> m_spaceActions;
+
+		double m_fSeconds = 0.0;
+		int64_t m_nLocateCalls = 0;
+		int64_t m_nEventsSent = 0;
+		int64_t m_nEventsHandled = 0;
+		int64_t m_nEnumerateCalls = 0;
+
+		bool m_bInEvent = false;
+		int64_t m_nEventRuntimeCalls = 0;
+		int64_t m_nEventAllocations = 0;
+		double m_fEventSeconds = 0.0;
+	};
+}
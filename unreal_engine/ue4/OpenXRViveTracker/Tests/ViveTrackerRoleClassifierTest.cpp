@@ -0,0 +1,314 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Classifies synthetic standing and walking bodies with the role classifier and checks every body worn tracker gets
+// its role and everything else none, and that roles only change once two consecutive windows agree on them.
+
+#include "ViveTrackerTestSupport.h"
+#include "ViveTrackerCore/ViveTrackerRoleClassifier.h"
+#include "ViveTrackerCore/ViveTrackerMath.h"
+
+#include <cmath>
+#include <random>
+
+using namespace ViveTrackerCore;
+
+/** Where a tracker is worn on a 170cm tall body, in centimeters along the body's heading, to its left and above the floor */
+struct FWornTracker
+{
+	EBodyTracker Role;
+	float Forward;
+	float Left;
+	float Height;
+};
+
+static const FWornTracker WornTrackers[] = {
+	{ EBodyTracker::Pelvis, 8.f, 0.f, 97.f },
+	{ EBodyTracker::Chest, 12.f, 0.f, 129.f },
+	{ EBodyTracker::Foot_L, 6.f, 12.f, 10.f },
+	{ EBodyTracker::Foot_R, 6.f, -12.f, 10.f },
+	{ EBodyTracker::Knee_L, 6.f, 12.f, 51.f },
+	{ EBodyTracker::Knee_R, 6.f, -12.f, 51.f },
+	{ EBodyTracker::Elbow_L, -4.f, 25.f, 112.f },
+	{ EBodyTracker::Elbow_R, -4.f, -25.f, 112.f },
+	{ EBodyTracker::Shoulder_L, 0.f, 19.f, 146.f },
+	{ EBodyTracker::Shoulder_R, 0.f, -19.f, 146.f },
+};
+
+static constexpr int NumWornTrackers = (int)(sizeof(WornTrackers) / sizeof(WornTrackers[0]));
+
+/** Tracker slots in the order the runtime enumerated them, the worn trackers shuffled, then one on a desk and one seen briefly */
+static const int WornTrackerSlots[NumWornTrackers] = { 7, 2, 9, 0, 4, 1, 8, 3, 6, 5 };
+static constexpr int DeskSlot = NumWornTrackers;
+static constexpr int BriefSlot = NumWornTrackers + 1;
+
+static constexpr float HeadHeight = 170.f;
+static constexpr float FrameRate = 90.f;
+static constexpr int FramesPerWindow = 180;
+
+/** Synthetic motion of one window */
+struct FMotion
+{
+	/** Radians from +X towards the body's left */
+	float Heading = 0.f;
+
+	/** Centimeters per second along the heading, 0 for standing in place */
+	float Speed = 0.f;
+
+	/** Wear the two foot trackers on the opposite feet */
+	bool bSwapFeet = false;
+};
+
+/** Classify one window of a body standing or walking */
+static void ClassifyWindow(const FMotion& Motion, std::mt19937& Random, FRoleClassification& OutClassification)
+{
+	const FVec3 Up{ 0.f, 0.f, 1.f };
+	const FVec3 Heading{ std::cos(Motion.Heading), -std::sin(Motion.Heading), 0.f };
+	const FVec3 Left = Cross(Heading, Up);
+	const FQuat4 HeadRotation{ 0.f, 0.f, -std::sin(Motion.Heading * 0.5f), std::cos(Motion.Heading * 0.5f) };
+	const FVec3 Start{ 50.f, 30.f, 0.f };
+	const FVec3 Desk{ 80.f, 60.f, 75.f };
+	std::normal_distribution<float> Noise(0.f, 0.3f);
+
+	FRoleClassifier Classifier;
+	for (int Frame = 0; Frame < FramesPerWindow; Frame++)
+	{
+		const float Time = (float)Frame / FrameRate;
+		const bool bWalking = Motion.Speed > 0.f;
+
+		// Standing sways a centimeter, walking bobs the head and swings the legs and arms, about one stride per second
+		const float Phase = Time * 2.f * 3.14159265f;
+		const float Sway = bWalking ? 0.f : std::sin(Phase * 0.3f);
+		const float Stride = bWalking ? std::sin(Phase) : 0.f;
+		const FVec3 Root = Start + Heading * (Motion.Speed * Time) + Left * Sway;
+
+		FRoleFrame RoleFrame;
+		RoleFrame.Head.Rotation = HeadRotation;
+		RoleFrame.Head.Position = Root + Up * (HeadHeight + (bWalking ? 2.f * std::fabs(std::cos(Phase)) : 0.f));
+
+		for (int i = 0; i < NumWornTrackers; i++)
+		{
+			const FWornTracker& Tracker = WornTrackers[i];
+			float Forward = Tracker.Forward;
+			float Height = Tracker.Height;
+			const float Side = Tracker.Left > 0.f ? 1.f : (Tracker.Left < 0.f ? -1.f : 0.f);
+
+			switch (Tracker.Role)
+			{
+			case EBodyTracker::Foot_L:
+			case EBodyTracker::Foot_R:
+				Forward += 30.f * Side * Stride;
+				Height += 8.f * std::fmax(0.f, Side * Stride);
+				break;
+			case EBodyTracker::Knee_L:
+			case EBodyTracker::Knee_R:
+				Forward += 15.f * Side * Stride;
+				break;
+			case EBodyTracker::Elbow_L:
+			case EBodyTracker::Elbow_R:
+				Forward -= 10.f * Side * Stride;
+				break;
+			default:
+				break;
+			}
+
+			const float Lateral = Motion.bSwapFeet && (Tracker.Role == EBodyTracker::Foot_L || Tracker.Role == EBodyTracker::Foot_R) ? -Tracker.Left : Tracker.Left;
+			const FVec3 Position = Root + Heading * Forward + Left * Lateral + Up * Height;
+
+			const int Slot = WornTrackerSlots[i];
+			RoleFrame.Trackers[Slot] = Position + FVec3{ Noise(Random), Noise(Random), Noise(Random) };
+			RoleFrame.ValidMask |= 1u << Slot;
+		}
+
+		RoleFrame.Trackers[DeskSlot] = Desk + FVec3{ Noise(Random), Noise(Random), Noise(Random) };
+		RoleFrame.ValidMask |= 1u << DeskSlot;
+
+		// Seen for a few frames only, right where the pelvis tracker is
+		if (Frame < 10)
+		{
+			RoleFrame.Trackers[BriefSlot] = RoleFrame.Trackers[WornTrackerSlots[0]];
+			RoleFrame.ValidMask |= 1u << BriefSlot;
+		}
+
+		Classifier.AddFrame(RoleFrame);
+	}
+
+	VIVETRACKER_CHECK(Classifier.GetNumFrames() == FramesPerWindow);
+	Classifier.Classify(OutClassification);
+}
+
+/** Role the body worn in a slot should be given */
+static EBodyTracker GetExpectedRole(int Slot, bool bSwapFeet)
+{
+	for (int i = 0; i < NumWornTrackers; i++)
+	{
+		if (WornTrackerSlots[i] != Slot)
+			continue;
+
+		const EBodyTracker Role = WornTrackers[i].Role;
+		if (bSwapFeet && Role == EBodyTracker::Foot_L)
+			return EBodyTracker::Foot_R;
+		if (bSwapFeet && Role == EBodyTracker::Foot_R)
+			return EBodyTracker::Foot_L;
+		return Role;
+	}
+	return EBodyTracker::Count;
+}
+
+static bool HasExpectedRoles(const FRoleClassification& Classification, bool bSwapFeet)
+{
+	bool bExpected = true;
+	for (int Slot = 0; Slot < MaxClassifiedTrackers; Slot++)
+	{
+		bExpected &= VIVETRACKER_CHECK(Classification.Roles[Slot] == GetExpectedRole(Slot, bSwapFeet));
+	}
+	return bExpected;
+}
+
+static bool HasExpectedRoles(const FRoleAgreement& Agreement, bool bSwapFeet)
+{
+	bool bExpected = true;
+	for (int Slot = 0; Slot < MaxClassifiedTrackers; Slot++)
+	{
+		bExpected &= VIVETRACKER_CHECK(Agreement.GetRole(Slot) == GetExpectedRole(Slot, bSwapFeet));
+	}
+	return bExpected;
+}
+
+static bool HasNoRoles(const FRoleAgreement& Agreement)
+{
+	bool bNone = true;
+	for (int Slot = 0; Slot < MaxClassifiedTrackers; Slot++)
+	{
+		bNone &= VIVETRACKER_CHECK(Agreement.GetRole(Slot) == EBodyTracker::Count);
+	}
+	return bNone;
+}
+
+static void TestStanding()
+{
+	std::mt19937 Random(1);
+	FRoleClassification Classification;
+
+	// Facing along +X, and turned so left and right can't be told apart by the space's axes
+	FMotion Motion;
+	ClassifyWindow(Motion, Random, Classification);
+	HasExpectedRoles(Classification, false);
+
+	Motion.Heading = 2.f;
+	ClassifyWindow(Motion, Random, Classification);
+	HasExpectedRoles(Classification, false);
+
+	Motion.bSwapFeet = true;
+	ClassifyWindow(Motion, Random, Classification);
+	HasExpectedRoles(Classification, true);
+}
+
+static void TestWalking()
+{
+	std::mt19937 Random(2);
+	FRoleClassification Classification;
+
+	FMotion Motion;
+	Motion.Speed = 120.f;
+	ClassifyWindow(Motion, Random, Classification);
+	HasExpectedRoles(Classification, false);
+
+	Motion.Heading = -0.6f;
+	ClassifyWindow(Motion, Random, Classification);
+	HasExpectedRoles(Classification, false);
+
+	Motion.Heading = 3.f;
+	Motion.bSwapFeet = true;
+	ClassifyWindow(Motion, Random, Classification);
+	HasExpectedRoles(Classification, true);
+}
+
+static void TestAgreement()
+{
+	std::mt19937 Random(3);
+	FRoleClassification Classification;
+	FRoleAgreement Agreement;
+
+	FMotion Worn;
+	Worn.Speed = 120.f;
+	FMotion Swapped = Worn;
+	Swapped.bSwapFeet = true;
+
+	// Nothing is accepted from a single window
+	ClassifyWindow(Worn, Random, Classification);
+	VIVETRACKER_CHECK(!Agreement.AddClassification(Classification));
+	HasNoRoles(Agreement);
+
+	ClassifyWindow(Worn, Random, Classification);
+	VIVETRACKER_CHECK(Agreement.AddClassification(Classification));
+	HasExpectedRoles(Agreement, false);
+
+	ClassifyWindow(Worn, Random, Classification);
+	VIVETRACKER_CHECK(!Agreement.AddClassification(Classification));
+	HasExpectedRoles(Agreement, false);
+
+	// One odd window between agreeing ones changes nothing
+	ClassifyWindow(Swapped, Random, Classification);
+	VIVETRACKER_CHECK(!Agreement.AddClassification(Classification));
+	HasExpectedRoles(Agreement, false);
+
+	ClassifyWindow(Worn, Random, Classification);
+	VIVETRACKER_CHECK(!Agreement.AddClassification(Classification));
+	HasExpectedRoles(Agreement, false);
+
+	// The feet change over once the second window in a row agrees
+	ClassifyWindow(Swapped, Random, Classification);
+	VIVETRACKER_CHECK(!Agreement.AddClassification(Classification));
+	HasExpectedRoles(Agreement, false);
+
+	ClassifyWindow(Swapped, Random, Classification);
+	VIVETRACKER_CHECK(Agreement.AddClassification(Classification));
+	HasExpectedRoles(Agreement, true);
+
+	// After a reset the same roles need two windows again, and their agreement counts as a change
+	Agreement.Reset();
+	HasNoRoles(Agreement);
+
+	ClassifyWindow(Swapped, Random, Classification);
+	VIVETRACKER_CHECK(!Agreement.AddClassification(Classification));
+	HasNoRoles(Agreement);
+
+	ClassifyWindow(Swapped, Random, Classification);
+	VIVETRACKER_CHECK(Agreement.AddClassification(Classification));
+	HasExpectedRoles(Agreement, true);
+}
+
+int main()
+{
+	TestStanding();
+	TestWalking();
+	TestAgreement();
+	return VIVETRACKER_TEST_RESULT();
+}
@@ -0,0 +1,332 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Drives a tracker session from the mock runtime at 90Hz and checks the role bindings, connect events, tracker
+// enumeration and every role's located pose against the script, through dropouts, a reconnect and a role swap.
+// Then fires a storm of connects, disconnects and role changes at it and checks every event's cost, and checks
+// that the per-frame refresh and locate doesn't allocate once warmed up.
+
+#include "ViveTrackerMockXr.h"
+#include "ViveTrackerTestSupport.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace ViveTrackerCore;
+
+static bool IsSamePose(const XrPosef& A, const XrPosef& B)
+{
+	const float Dot = A.orientation.x * B.orientation.x + A.orientation.y * B.orientation.y + A.orientation.z * B.orientation.z + A.orientation.w * B.orientation.w;
+	return std::fabs(A.position.x - B.position.x) < 1.0e-5f && std::fabs(A.position.y - B.position.y) < 1.0e-5f &&
+		std::fabs(A.position.z - B.position.z) < 1.0e-5f && std::fabs(Dot) > 1.f - 1.0e-6f;
+}
+
+static void TestRolePaths()
+{
+	for (int Role = 0; Role < NumTrackerRoles; Role++)
+	{
+		VIVETRACKER_CHECK(FindTrackerRole(GetTrackerRolePath(Role)) == Role);
+		VIVETRACKER_CHECK(FTrackerSession::GetRoleActionName(Role) != nullptr);
+	}
+	VIVETRACKER_CHECK(GetTrackerRolePath(NumTrackerRoles) == nullptr);
+	VIVETRACKER_CHECK(FindTrackerRole("/user/vive_tracker_htcx/role/tail") == NumTrackerRoles);
+	VIVETRACKER_CHECK(FindTrackerRole(nullptr) == NumTrackerRoles);
+}
+
+static void TestScriptedSession(double Duration, int NumTrackers)
+{
+	const double FrameSeconds = 1.0 / 90.0;
+
+	// One tracker per role, connecting over the first second, with dropouts, a reconnect and a role swap
+	FMockXrRuntime Mock;
+	for (int nTracker = 0; nTracker < NumTrackers; nTracker++)
+	{
+		FMockTracker Tracker = FMockXrRuntime::MakeOrbitingTracker(nTracker);
+		if (nTracker % 3 == 1)
+		{
+			const double DropoutStart = Duration * (0.1 + 0.05 * (nTracker % 4));
+			Tracker.Dropouts.emplace_back(DropoutStart, DropoutStart + 0.25);
+		}
+		Mock.AddTracker(Tracker, nTracker / (double)NumTrackers);
+	}
+	Mock.Disconnect(NumTrackers - 1, Duration * 0.4);
+	Mock.Connect(NumTrackers - 1, Duration * 0.6);
+	Mock.ChangeRole(0, Mock.GetTracker(1).Role, Duration * 0.5);
+	Mock.ChangeRole(1, Mock.GetTracker(0).Role, Duration * 0.5);
+
+	FTrackerSession Session;
+	if (!VIVETRACKER_CHECK(Mock.Start(Session)))
+		return;
+
+	VIVETRACKER_CHECK(Session.IsActionsGenerated());
+	for (int Role = 0; Role < NumTrackerRoles; Role++)
+	{
+		VIVETRACKER_CHECK(Session.GetRoleAction(Role).Result == XR_SUCCESS);
+	}
+
+	int nFrames = 0;
+	int nPoseMismatches = 0;
+	int nStatusMismatches = 0;
+	int nListMismatches = 0;
+	while (Mock.GetSeconds() + FrameSeconds <= Duration)
+	{
+		Mock.Tick(FrameSeconds);
+		nFrames++;
+
+		bool RoleExpected[NumTrackerRoles] = {};
+		for (int nTracker = 0; nTracker < NumTrackers; nTracker++)
+		{
+			// The extension has no disconnect event, a disconnected tracker stays listed until the next connect event
+			const FMockTracker& Tracker = Mock.GetTracker(nTracker);
+			if (Mock.IsConnected(nTracker))
+			{
+				bool bListed = false;
+				for (size_t nListed = 0; nListed < Session.GetNumTrackers(); nListed++)
+				{
+					bListed |= Session.GetTracker(nListed).PersistentPath == Tracker.PersistentPath && Session.GetTracker(nListed).Role == Tracker.Role;
+				}
+				nListMismatches += bListed ? 0 : 1;
+			}
+
+			XrPosef Expected;
+			if (!Mock.GetExpectedPose(nTracker, Mock.GetSeconds(), Expected))
+				continue;
+
+			RoleExpected[Tracker.Role] = true;
+			const FTrackerLocation& Location = Session.GetLocation(Tracker.Role);
+			const XrSpaceLocationFlags TrackedFlags = XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT |
+				XR_SPACE_LOCATION_POSITION_TRACKED_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT;
+			if (Location.Result != XR_SUCCESS || (Location.LocationFlags & TrackedFlags) != TrackedFlags ||
+				(Location.VelocityFlags & XR_SPACE_VELOCITY_LINEAR_VALID_BIT) == 0)
+			{
+				nStatusMismatches++;
+				continue;
+			}
+			nPoseMismatches += IsSamePose(Location.Pose, Expected) ? 0 : 1;
+		}
+
+		// Roles without a tracking tracker must not report a pose
+		for (int Role = 0; Role < NumTrackerRoles; Role++)
+		{
+			if (!RoleExpected[Role] && Session.GetLocation(Role).LocationFlags != 0)
+			{
+				nStatusMismatches++;
+			}
+		}
+	}
+
+	// Every scripted connect and role change is one event, and every frame locates every role once
+	VIVETRACKER_CHECK(nPoseMismatches == 0);
+	VIVETRACKER_CHECK(nStatusMismatches == 0);
+	VIVETRACKER_CHECK(nListMismatches == 0);
+	VIVETRACKER_CHECK(Mock.GetNumEventsHandled() == NumTrackers + 3);
+	VIVETRACKER_CHECK(Mock.GetNumLocateCalls() == (int64_t)(nFrames + 1) * NumTrackerRoles);
+	std::printf("Session: %d frames of %d trackers, %lld connect events, %lld enumerations, %d pose, %d status and %d tracker list mismatches\n",
+		nFrames, NumTrackers, (long long)Mock.GetNumEventsHandled(), (long long)Mock.GetNumEnumerateCalls(), nPoseMismatches, nStatusMismatches, nListMismatches);
+
+	Mock.Stop();
+	VIVETRACKER_CHECK(!Session.IsActionsGenerated());
+	VIVETRACKER_CHECK(Session.GetNumTrackers() == 0);
+}
+
+static void TestHotPlugStorm(double Duration, int NumTrackers, int EventsPerSecond)
+{
+	const double FrameSeconds = 1.0 / 90.0;
+	const double StormStart = 1.0;
+
+	// An event reads its tracker's persistent and role paths, generous enough for a debug build on a loaded machine
+	const int64_t MaxRuntimeCallsPerEvent = 2;
+	const double MaxMicrosecondsPerEvent = 50.0;
+
+	// The rack powers on within 100ms, the storm starts once every tracker connected once
+	FMockXrRuntime Mock;
+	for (int nTracker = 0; nTracker < NumTrackers; nTracker++)
+	{
+		Mock.AddTracker(FMockXrRuntime::MakeOrbitingTracker(nTracker), 0.1 * nTracker / NumTrackers);
+	}
+
+	std::mt19937 Random(NumTrackers);
+	const int NumScriptEvents = (int)((Duration - StormStart) * EventsPerSecond);
+	for (int nEvent = 0; nEvent < NumScriptEvents; nEvent++)
+	{
+		const double Seconds = StormStart + nEvent / (double)EventsPerSecond;
+		const int nTracker = (int)(Random() % NumTrackers);
+		switch (Random() % 3)
+		{
+		case 0:
+			Mock.Disconnect(nTracker, Seconds);
+			break;
+		case 1:
+			Mock.Connect(nTracker, Seconds);
+			break;
+		default:
+			Mock.ChangeRole(nTracker, (int)(Random() % (NumTrackerRoles + 1)), Seconds);
+			break;
+		}
+	}
+
+	FTrackerSession Session;
+	if (!VIVETRACKER_CHECK(Mock.Start(Session)))
+		return;
+
+	while (Mock.GetSeconds() + FrameSeconds <= StormStart)
+	{
+		Mock.Tick(FrameSeconds);
+	}
+
+	// From here on the session's strings have grown to the path length, events must not allocate
+	const int64_t nStartEvents = Mock.GetNumEventsSent();
+	const int64_t nStartEnumerateCalls = Mock.GetNumEnumerateCalls();
+	const int64_t nStartRuntimeCalls = Mock.GetNumEventRuntimeCalls();
+	const int64_t nStartAllocations = Mock.GetNumEventAllocations();
+	const double StartEventSeconds = Mock.GetEventSeconds();
+
+	int nFrames = 0;
+	int nRoleMismatches = 0;
+	while (Mock.GetSeconds() + FrameSeconds <= Duration)
+	{
+		Mock.Tick(FrameSeconds);
+		nFrames++;
+
+		// The extension has no disconnect event, a disconnected tracker stays listed until the next connect event
+		for (int nTracker = 0; nTracker < NumTrackers; nTracker++)
+		{
+			const FMockTracker& Tracker = Mock.GetTracker(nTracker);
+			if (!Mock.IsConnected(nTracker))
+				continue;
+
+			bool bListed = false;
+			for (size_t nListed = 0; nListed < Session.GetNumTrackers(); nListed++)
+			{
+				bListed |= Session.GetTracker(nListed).PersistentPath == Tracker.PersistentPath && Session.GetTracker(nListed).Role == Tracker.Role;
+			}
+			nRoleMismatches += bListed ? 0 : 1;
+		}
+	}
+
+	// Listing happens at most once per frame with the two call idiom, however many events came in
+	const int64_t nEvents = Mock.GetNumEventsSent() - nStartEvents;
+	const int64_t nEnumerateCalls = Mock.GetNumEnumerateCalls() - nStartEnumerateCalls;
+	const int64_t nRuntimeCalls = Mock.GetNumEventRuntimeCalls() - nStartRuntimeCalls;
+	const int64_t nAllocations = Mock.GetNumEventAllocations() - nStartAllocations;
+	const double EventSeconds = Mock.GetEventSeconds() - StartEventSeconds;
+	VIVETRACKER_CHECK(nEvents > 0);
+	VIVETRACKER_CHECK(nAllocations == 0);
+	VIVETRACKER_CHECK(nRuntimeCalls <= MaxRuntimeCallsPerEvent * nEvents);
+	VIVETRACKER_CHECK(EventSeconds * 1.0e6 <= MaxMicrosecondsPerEvent * nEvents);
+	VIVETRACKER_CHECK(nEnumerateCalls <= 2 * (int64_t)nFrames);
+	VIVETRACKER_CHECK(nRoleMismatches == 0);
+	VIVETRACKER_CHECK(Mock.GetNumEventsHandled() == Mock.GetNumEventsSent());
+	std::printf("Hot-plug storm: %lld connect events over %d frames with %d trackers, %.3f us and %.2f runtime calls per event, %lld allocations, %d role mismatches\n",
+		(long long)nEvents, nFrames, NumTrackers, nEvents > 0 ? EventSeconds * 1.0e6 / nEvents : 0.0, nEvents > 0 ? nRuntimeCalls / (double)nEvents : 0.0,
+		(long long)nAllocations, nRoleMismatches);
+
+	Mock.Stop();
+}
+
+static void TestZeroAllocation(int NumFrames, int NumTrackers)
+{
+	const double FrameSeconds = 1.0 / 90.0;
+	const int WarmupFrames = 90;
+
+	// A dropout and a reconnect during the checked frames, so the refresh after a connect event is covered too
+	FMockXrRuntime Mock;
+	for (int nTracker = 0; nTracker < NumTrackers; nTracker++)
+	{
+		FMockTracker Tracker = FMockXrRuntime::MakeOrbitingTracker(nTracker);
+		if (nTracker == 0)
+		{
+			Tracker.Dropouts.emplace_back(2.0, 2.5);
+		}
+		Mock.AddTracker(Tracker);
+	}
+	Mock.Disconnect(NumTrackers - 1, 3.0);
+	Mock.Connect(NumTrackers - 1, 4.0);
+
+	FTrackerSession Session;
+	if (!VIVETRACKER_CHECK(Mock.Start(Session)))
+		return;
+
+	int nAllocatingFrames = 0;
+	uint64_t nAllocations = 0;
+	for (int nFrame = 0; nFrame < WarmupFrames + NumFrames; nFrame++)
+	{
+		const uint64_t nStartAllocations = ViveTrackerTest::GetNumAllocations();
+		Mock.Tick(FrameSeconds);
+		const uint64_t nFrameAllocations = ViveTrackerTest::GetNumAllocations() - nStartAllocations;
+		if (nFrame < WarmupFrames || nFrameAllocations == 0)
+			continue;
+
+		nAllocatingFrames++;
+		nAllocations += nFrameAllocations;
+	}
+
+	VIVETRACKER_CHECK(nAllocatingFrames == 0);
+	std::printf("Zero allocation: %d of %d frames allocated with %d trackers, %llu allocations\n",
+		nAllocatingFrames, NumFrames, NumTrackers, (unsigned long long)nAllocations);
+
+	Mock.Stop();
+}
+
+static void TestWithoutExtension()
+{
+	// Without xrEnumerateViveTrackerPathsHTCX connect events are still reported, there just never are trackers to list.
+	// No mock is running, so the action set isn't created, the session keeps its instance for events regardless.
+	FXrEntryPoints xrEntryPoints = FMockXrRuntime::GetEntryPoints();
+	xrEntryPoints.GetInstanceProcAddr = nullptr;
+
+	FTrackerSession Session;
+	Session.SetEntryPoints(xrEntryPoints);
+	XrEventDataViveTrackerConnectedHTCX xrEvent{ XR_TYPE_EVENT_DATA_VIVE_TRACKER_CONNECTED_HTCX };
+	VIVETRACKER_CHECK(Session.HandleEvent(reinterpret_cast<const XrEventDataBaseHeader*>(&xrEvent)) == ETrackerSessionEvent::None);
+
+	XrEventDataSessionStateChanged xrStateEvent{ XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED };
+	xrStateEvent.state = XR_SESSION_STATE_FOCUSED;
+	VIVETRACKER_CHECK(Session.CreateActionSet(FMockXrRuntime::GetInstance()) == XR_ERROR_HANDLE_INVALID);
+	VIVETRACKER_CHECK(Session.HandleEvent(reinterpret_cast<const XrEventDataBaseHeader*>(&xrStateEvent)) == ETrackerSessionEvent::SessionStateChanged);
+	VIVETRACKER_CHECK(Session.GetSessionState() == XR_SESSION_STATE_FOCUSED);
+	VIVETRACKER_CHECK(Session.HandleEvent(reinterpret_cast<const XrEventDataBaseHeader*>(&xrEvent)) == ETrackerSessionEvent::TrackerConnected);
+	VIVETRACKER_CHECK(Session.RefreshTrackers());
+	VIVETRACKER_CHECK(Session.GetTrackersResult() == XR_ERROR_FUNCTION_UNSUPPORTED);
+	VIVETRACKER_CHECK(Session.GetNumTrackers() == 0);
+	VIVETRACKER_CHECK(!Session.RefreshTrackers());
+}
+
+int main()
+{
+	TestRolePaths();
+	TestScriptedSession(10.0, NumTrackerRoles);
+	TestScriptedSession(4.0, 3);
+	TestHotPlugStorm(5.0, 30, 600);
+	TestHotPlugStorm(3.0, 256, 2000);
+	TestZeroAllocation(450, NumTrackerRoles);
+	TestWithoutExtension();
+	return VIVETRACKER_TEST_RESULT();
+}
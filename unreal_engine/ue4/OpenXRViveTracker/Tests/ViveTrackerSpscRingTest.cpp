@@ -0,0 +1,173 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Checks the single producer, single consumer ring: capacity rounding, full and empty rings, wrapping, and a
+// producer and a consumer thread passing millions of elements through a small ring in order, without loss
+// and without allocating.
+
+#include "ViveTrackerTestSupport.h"
+#include "ViveTrackerCore/ViveTrackerSpscRing.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace ViveTrackerCore;
+
+/** Element whose payload is derived from its sequence number, so torn or stale copies are caught */
+struct FRingItem
+{
+	uint64_t Sequence = 0;
+	uint64_t Payload[7] = {};
+
+	static FRingItem Make(uint64_t Sequence)
+	{
+		FRingItem Item;
+		Item.Sequence = Sequence;
+		for (int n = 0; n < 7; n++)
+		{
+			Item.Payload[n] = Sequence * 0x9E3779B97F4A7C15ull + n;
+		}
+		return Item;
+	}
+
+	bool IsValid() const
+	{
+		for (int n = 0; n < 7; n++)
+		{
+			if (Payload[n] != Sequence * 0x9E3779B97F4A7C15ull + n)
+				return false;
+		}
+		return true;
+	}
+};
+
+static void TestSingleThread()
+{
+	TSpscRing<uint32_t> Ring(5);
+	VIVETRACKER_CHECK(Ring.GetCapacity() == 8);
+	VIVETRACKER_CHECK(Ring.Num() == 0);
+
+	uint32_t arrOut[16];
+	VIVETRACKER_CHECK(Ring.Pop(arrOut, 16) == 0);
+
+	// Fill up, a full ring refuses more
+	for (uint32_t n = 0; n < 8; n++)
+	{
+		VIVETRACKER_CHECK(Ring.Push(n));
+	}
+	VIVETRACKER_CHECK(!Ring.Push(8));
+	VIVETRACKER_CHECK(Ring.Num() == 8);
+
+	// Partial pops free room, the next pushes wrap around the end of the storage
+	VIVETRACKER_CHECK(Ring.Pop(arrOut, 5) == 5);
+	for (uint32_t n = 0; n < 5; n++)
+	{
+		VIVETRACKER_CHECK(arrOut[n] == n);
+		VIVETRACKER_CHECK(Ring.Push(8 + n));
+	}
+	VIVETRACKER_CHECK(!Ring.Push(13));
+
+	VIVETRACKER_CHECK(Ring.Pop(arrOut, 16) == 8);
+	for (uint32_t n = 0; n < 8; n++)
+	{
+		VIVETRACKER_CHECK(arrOut[n] == 5 + n);
+	}
+	VIVETRACKER_CHECK(Ring.Num() == 0);
+
+	Ring.Reset(100);
+	VIVETRACKER_CHECK(Ring.GetCapacity() == 128);
+	VIVETRACKER_CHECK(Ring.Num() == 0);
+	VIVETRACKER_CHECK(Ring.Pop(arrOut, 16) == 0);
+}
+
+static void TestTwoThreads(uint32_t Capacity, uint64_t NumItems)
+{
+	TSpscRing<FRingItem> Ring(Capacity);
+	std::atomic<bool> bConsumerReady{ false };
+
+	// The consumer pops batches of varying size so reads end everywhere in the storage
+	uint64_t nReceived = 0;
+	uint64_t nMismatches = 0;
+	std::thread Consumer([&]()
+	{
+		FRingItem arrOut[37];
+		uint32_t nBatch = 1;
+		bConsumerReady = true;
+		while (nReceived < NumItems)
+		{
+			const uint32_t nPopped = Ring.Pop(arrOut, nBatch);
+			for (uint32_t n = 0; n < nPopped; n++)
+			{
+				nMismatches += arrOut[n].Sequence == nReceived && arrOut[n].IsValid() ? 0 : 1;
+				nReceived++;
+			}
+			nBatch = nBatch % 37 + 1;
+			if (nPopped == 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	while (!bConsumerReady)
+	{
+		std::this_thread::yield();
+	}
+
+	// Neither end allocates, the storage was allocated by the constructor
+	const uint64_t nStartAllocations = ViveTrackerTest::GetNumAllocations();
+	uint64_t nFull = 0;
+	for (uint64_t nSequence = 0; nSequence < NumItems; nSequence++)
+	{
+		const FRingItem Item = FRingItem::Make(nSequence);
+		while (!Ring.Push(Item))
+		{
+			nFull++;
+			std::this_thread::yield();
+		}
+	}
+	const uint64_t nAllocations = ViveTrackerTest::GetNumAllocations() - nStartAllocations;
+
+	Consumer.join();
+	VIVETRACKER_CHECK(nReceived == NumItems);
+	VIVETRACKER_CHECK(nMismatches == 0);
+	VIVETRACKER_CHECK(nAllocations == 0);
+	VIVETRACKER_CHECK(Ring.Num() == 0);
+	std::printf("Two threads: %llu elements through a ring of %u, %llu pushes found it full, %llu lost, reordered or torn\n",
+		(unsigned long long)NumItems, Ring.GetCapacity(), (unsigned long long)nFull, (unsigned long long)nMismatches);
+}
+
+int main()
+{
+	TestSingleThread();
+	TestTwoThreads(2, 200000);
+	TestTwoThreads(64, 2000000);
+	TestTwoThreads(64 * 1024, 4000000);
+	return VIVETRACKER_TEST_RESULT();
+}
@@ -0,0 +1,212 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerTestSupport.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <thread>
+
+// Every allocation of the process goes through here, so tests can assert that a code path doesn't allocate
+static std::atomic<uint64_t> GNumAllocations{ 0 };
+
+static void* CountedAlloc(std::size_t Size)
+{
+	GNumAllocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(Size > 0 ? Size : 1);
+}
+
+static void* CountedAlignedAlloc(std::size_t Size, std::align_val_t Alignment)
+{
+	GNumAllocations.fetch_add(1, std::memory_order_relaxed);
+	const std::size_t nAlignment = static_cast<std::size_t>(Alignment);
+	return std::aligned_alloc(nAlignment, (Size + nAlignment - 1) / nAlignment * nAlignment);
+}
+
+void* operator new(std::size_t Size)
+{
+	if (void* p = CountedAlloc(Size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t Size)
+{
+	return operator new(Size);
+}
+
+void* operator new(std::size_t Size, const std::nothrow_t&) noexcept
+{
+	return CountedAlloc(Size);
+}
+
+void* operator new[](std::size_t Size, const std::nothrow_t&) noexcept
+{
+	return CountedAlloc(Size);
+}
+
+void* operator new(std::size_t Size, std::align_val_t Alignment)
+{
+	if (void* p = CountedAlignedAlloc(Size, Alignment))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t Size, std::align_val_t Alignment)
+{
+	return operator new(Size, Alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace ViveTrackerTest
+{
+	int& GetNumFailures()
+	{
+		static int nFailures = 0;
+		return nFailures;
+	}
+
+	uint64_t GetNumAllocations()
+	{
+		return GNumAllocations.load(std::memory_order_relaxed);
+	}
+
+	void ReportFailure(const char* pFile, int Line, const char* pCondition)
+	{
+		std::printf("%s(%d): check failed: %s\n", pFile, Line, pCondition);
+		GetNumFailures()++;
+	}
+
+	void MakeSyntheticCaptureSamples(int NumFrames, int NumTrackers, std::vector<ViveTrackerCore::FCaptureSample>& OutSamples)
+	{
+		const float Pi = 3.14159265f;
+
+		// Same noise on every platform, from a xorshift generator
+		uint32_t nState = 0x5EED;
+		auto Random = [&nState]()
+		{
+			nState ^= nState << 13;
+			nState ^= nState >> 17;
+			nState ^= nState << 5;
+			return (nState >> 8) * (1.f / 16777216.f);
+		};
+		auto Noise = [&Random](float Scale) { return (Random() + Random() + Random() - 1.5f) * 2.f * Scale; };
+
+		OutSamples.clear();
+		OutSamples.reserve((size_t)NumFrames * NumTrackers);
+		for (int nFrame = 0; nFrame < NumFrames; nFrame++)
+		{
+			const float Time = nFrame * 0.001f;
+			for (int nTracker = 0; nTracker < NumTrackers; nTracker++)
+			{
+				ViveTrackerCore::FCaptureSample Sample;
+				std::memset(&Sample, 0, sizeof(Sample));
+				Sample.Time = (int64_t)nFrame * 1000 * 1000;
+				Sample.PlatformTimeNs = Sample.Time + 1000 * 1000 * 1000;
+				Sample.TrackerId = (uint16_t)nTracker;
+				Sample.Role = (uint8_t)(nTracker % 12);
+				Sample.LocationFlags = 0xF;
+				Sample.VelocityFlags = 0x3;
+
+				const float Phase = nTracker * 0.7f;
+				for (int nAxis = 0; nAxis < 3; nAxis++)
+				{
+					const float Frequency = 2.f * Pi * (0.3f + 0.2f * nAxis + 0.05f * nTracker);
+					Sample.Position[nAxis] = 30.f * std::sin(Frequency * Time + Phase + nAxis) + 50.f * nAxis + Noise(0.003f);
+					Sample.LinearVelocity[nAxis] = 30.f * Frequency * std::cos(Frequency * Time + Phase + nAxis) + Noise(0.05f);
+					Sample.AngularVelocity[nAxis] = 0.5f * std::cos(Frequency * Time) + Noise(0.001f);
+				}
+
+				// Yaw, pitch and roll half angles, in Z, Y, X order
+				const float Yaw = 0.5f * (Pi / 2.f) * std::sin(0.4f * Time + Phase);
+				const float Pitch = 0.5f * (Pi / 9.f) * std::sin(1.3f * Time + Phase);
+				const float Roll = 0.5f * (Pi / 18.f) * std::cos(0.7f * Time);
+				const float CY = std::cos(Yaw), SY = std::sin(Yaw), CP = std::cos(Pitch), SP = std::sin(Pitch), CR = std::cos(Roll), SR = std::sin(Roll);
+				Sample.Rotation[0] = CR * SP * SY - SR * CP * CY + Noise(0.00002f);
+				Sample.Rotation[1] = -CR * SP * CY - SR * CP * SY + Noise(0.00002f);
+				Sample.Rotation[2] = CR * CP * SY - SR * SP * CY + Noise(0.00002f);
+				Sample.Rotation[3] = CR * CP * CY + SR * SP * SY + Noise(0.00002f);
+				OutSamples.push_back(Sample);
+			}
+		}
+	}
+
+	void AddBenchmarkResult(std::vector<FBenchmarkResult>& Results, const std::string& Name, int64_t Iterations, double SecondsPerOp,
+		const std::string& Label, int NumThreads)
+	{
+		FBenchmarkResult Result;
+		Result.Name = NumThreads > 0 ? Name + "/threads:" + std::to_string(NumThreads) : Name;
+		Result.Iterations = Iterations;
+		Result.NanosecondsPerOp = SecondsPerOp * 1.0e9;
+		Result.ItemsPerSecond = SecondsPerOp > 0.0 ? (NumThreads > 1 ? NumThreads : 1) / SecondsPerOp : 0.0;
+		Result.Label = Label;
+
+		std::printf("%-48s %12.1f ns %14.0f items/s  %s\n", Result.Name.c_str(), Result.NanosecondsPerOp, Result.ItemsPerSecond, Label.c_str());
+		Results.push_back(Result);
+	}
+
+	bool SaveBenchmarkResults(const char* pFilename, const char* pExecutable, const std::vector<FBenchmarkResult>& Results)
+	{
+		FILE* pFile = std::fopen(pFilename, "w");
+		if (!pFile)
+			return false;
+
+		char sDate[32];
+		const std::time_t Now = std::time(nullptr);
+		std::strftime(sDate, sizeof(sDate), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&Now));
+
+		std::fprintf(pFile, "{\n\t\"context\": {\n");
+		std::fprintf(pFile, "\t\t\"date\": \"%s\",\n", sDate);
+		std::fprintf(pFile, "\t\t\"executable\": \"%s\",\n", pExecutable);
+		std::fprintf(pFile, "\t\t\"num_cpus\": %u\n\t},\n", std::thread::hardware_concurrency());
+		std::fprintf(pFile, "\t\"benchmarks\": [\n");
+		for (size_t nResult = 0; nResult < Results.size(); nResult++)
+		{
+			const FBenchmarkResult& Result = Results[nResult];
+			std::fprintf(pFile, "\t\t{\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %lld, "
+				"\"real_time\": %.3f, \"cpu_time\": %.3f, \"time_unit\": \"ns\", \"items_per_second\": %.1f, \"label\": \"%s\"}%s\n",
+				Result.Name.c_str(), Result.Name.c_str(), (long long)Result.Iterations, Result.NanosecondsPerOp, Result.NanosecondsPerOp,
+				Result.ItemsPerSecond, Result.Label.c_str(), nResult + 1 < Results.size() ? "," : "");
+		}
+		std::fprintf(pFile, "\t]\n}\n");
+		return std::fclose(pFile) == 0;
+	}
+}
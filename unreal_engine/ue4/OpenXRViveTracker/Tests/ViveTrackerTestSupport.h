@@ -0,0 +1,106 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// Support for the ViveTrackerCore tests and benchmarks, which run outside of the engine without a test framework.
+// A test is an executable returning the number of failed checks, registered with CTest by CMakeLists.txt.
+
+#include "ViveTrackerCore/ViveTrackerCaptureFormat.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ViveTrackerTest
+{
+	/** Number of failed checks so far */
+	int& GetNumFailures();
+
+	/** Heap allocations made by the process so far, counted by the global operator new the test support replaces */
+	uint64_t GetNumAllocations();
+
+	/** Seconds on a monotonic clock */
+	inline double GetSeconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/** Log a failed check, see VIVETRACKER_CHECK */
+	void ReportFailure(const char* pFile, int Line, const char* pCondition);
+
+	/**
+	* Synthetic trajectories sampled at 1kHz, smooth motion plus sensor noise around the size of the codec's default error bounds
+	* @param int - Number of frames
+	* @param int - Number of trackers, each has a sample per frame
+	* @param std::vector<FCaptureSample> - Receives the samples, in time order
+	*/
+	void MakeSyntheticCaptureSamples(int NumFrames, int NumTrackers, std::vector<ViveTrackerCore::FCaptureSample>& OutSamples);
+
+	/** One measured case, as reported in the JSON output */
+	struct FBenchmarkResult
+	{
+		std::string Name;
+		int64_t Iterations = 0;
+		double NanosecondsPerOp = 0.0;
+		double ItemsPerSecond = 0.0;
+		std::string Label;
+	};
+
+	/**
+	* Print a result and add it to a list
+	* @param std::vector<FBenchmarkResult> - The list
+	* @param std::string - Name of the case, e.g. Locate/trackers:12
+	* @param int64_t - Number of operations measured
+	* @param double - Seconds per operation
+	* @param std::string - What an operation is
+	* @param int - Number of threads running operations concurrently, 0 for a single caller
+	*/
+	void AddBenchmarkResult(std::vector<FBenchmarkResult>& Results, const std::string& Name, int64_t Iterations, double SecondsPerOp,
+		const std::string& Label = std::string(), int NumThreads = 0);
+
+	/**
+	* Write results in Google Benchmark's JSON layout, so its comparison tools can diff two runs
+	* @param char* - File to write
+	* @param char* - Name of the benchmark executable
+	* @param std::vector<FBenchmarkResult> - The results
+	* @return bool - Whether or not the file was written
+	*/
+	bool SaveBenchmarkResults(const char* pFilename, const char* pExecutable, const std::vector<FBenchmarkResult>& Results);
+}
+
+/** Check a condition, a failed check is logged and fails the test without stopping it */
+#define VIVETRACKER_CHECK(Condition) \
+	((Condition) ? true : (ViveTrackerTest::ReportFailure(__FILE__, __LINE__, #Condition), false))
+
+/** Exit code of a test's main */
+#define VIVETRACKER_TEST_RESULT() \
+	(ViveTrackerTest::GetNumFailures() == 0 ? (std::printf("PASSED\n"), 0) : (std::printf("FAILED, %d failed checks\n", ViveTrackerTest::GetNumFailures()), 1))
@@ -25,7 +25,8 @@ public class OpenXRViveTracker : ModuleRules
 			{
 				"Core",
                 "OpenXRHMD",
-                "OpenXRInput"
+                "OpenXRInput",
+                "AnimGraphRuntime"
             }
 			);
 			
@@ -33,10 +34,13 @@ public class OpenXRViveTracker : ModuleRules
 		PrivateDependencyModuleNames.AddRange(
 			new string[]
 			{
+				"Chaos",
 				"CoreUObject",
 				"Engine",
 				"InputCore",
 				"InputDevice",
+				"PhysicsCore",
+				"RenderCore",
 				"Slate",
 				"SlateCore",
 				"HeadMountedDisplay"	// We need this for FXRMotionControllerBase
@@ -28,50 +28,133 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "OpenXRViveTracker.h"
+#include "ViveTrackerCapture.h"
+#include "ViveTrackerComponent.h"
+#include "ViveTrackerDebugDraw.h"
+#include "ViveTrackerLatency.h"
+#include "ViveTrackerReplay.h"
+#include "ViveTrackerStats.h"
+#include "ViveTrackerXrProfiler.h"
+#include "Features/IModularFeatures.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreMisc.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Parse.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+#include "UObject/UObjectIterator.h"
 
 #define LOCTEXT_NAMESPACE "FOpenXRViveTrackerModule"
 
+static_assert(ViveTrackerCore::NumTrackerRoles == (int32)ETrackerRole::Unassigned, "Tracker session roles must follow ETrackerRole");
+
+FOpenXRViveTrackerModule::~FOpenXRViveTrackerModule() = default;
+
 void FOpenXRViveTrackerModule::StartupModule()
 {
 	// Register this plugin as an OpenXR plugin	
 	RegisterOpenXRExtensionModularFeature();
 
-	// Fill-out tracker transform map
-	m_mapTrackerTransforms.Add(ETrackerRole::Foot_L, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Foot_R, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Shoulder_L, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Shoulder_R, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Elbow_L, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Elbow_R, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Knee_L, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Knee_R, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Waist, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Chest, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Camera, FTransform::Identity);
-	m_mapTrackerTransforms.Add(ETrackerRole::Keyboard, FTransform::Identity);
+	// Fill-out tracker sample map
+	m_mapTrackerSamples.Add(ETrackerRole::Foot_L, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Foot_R, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Shoulder_L, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Shoulder_R, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Elbow_L, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Elbow_R, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Knee_L, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Knee_R, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Waist, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Chest, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Camera, FViveTrackerSample());
+	m_mapTrackerSamples.Add(ETrackerRole::Keyboard, FViveTrackerSample());
+
+	// Fill-out tracker history map
+	m_mapTrackerHistory.Add(ETrackerRole::Foot_L, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Foot_R, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Shoulder_L, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Shoulder_R, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Elbow_L, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Elbow_R, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Knee_L, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Knee_R, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Waist, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Chest, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Camera, FViveTrackerPoseHistory());
+	m_mapTrackerHistory.Add(ETrackerRole::Keyboard, FViveTrackerPoseHistory());
+
+	// Expose trackers as motion controller sources
+	IModularFeatures::Get().RegisterModularFeature(IMotionController::GetModularFeatureName(), static_cast<IMotionController*>(this));
+
+	// Record the cost of every runtime call from the start, e.g. to compare runtime versions
+	if (FParse::Param(FCommandLine::Get(), TEXT("ViveTrackerXrProfile")))
+	{
+		FViveTrackerXrProfiler::SetEnabled(true);
+	}
+
+	// Show every tracker from the start, e.g. when checking a rig on site
+	if (FParse::Param(FCommandLine::Get(), TEXT("ViveTrackerDebugDraw")))
+	{
+		StartDebugDraw(FViveTrackerDebugDrawSettings());
+	}
 
 	UE_LOG( LogOpenXRViveTracker, Display, TEXT("Plugin started. OpenXR extension %s will be enabled."), 
 		*FString(UTF8_TO_TCHAR(XR_HTCX_VIVE_TRACKER_INTERACTION_EXTENSION_NAME)) );
+
+	// Serve trackers from a capture, e.g. on build agents without a headset
+	FString sReplayFilename;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ViveTrackerReplay="), sReplayFilename))
+	{
+		FViveTrackerReplaySettings replaySettings;
+		FParse::Value(FCommandLine::Get(), TEXT("ViveTrackerReplayStep="), replaySettings.FixedStepSeconds);
+		FParse::Value(FCommandLine::Get(), TEXT("ViveTrackerReplayRate="), replaySettings.PlaybackRate);
+		replaySettings.bLoop = FParse::Param(FCommandLine::Get(), TEXT("ViveTrackerReplayLoop"));
+		StartReplay(sReplayFilename, replaySettings);
+	}
 }
 
 void FOpenXRViveTrackerModule::ShutdownModule()
 {
-	// Cleanup actions
-	for (auto& Action : m_mapTrackerRoles)
+	ReleaseRuntimeResources();
+	StopCapture();
+	StopReplay();
+	StopDebugDraw();
+	m_pLatencyRecorder.Reset();
+
+	IModularFeatures::Get().UnregisterModularFeature(IMotionController::GetModularFeatureName(), static_cast<IMotionController*>(this));
+
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Plugin shut down."));
+}
+
+void FOpenXRViveTrackerModule::ReleaseRuntimeResources()
+{
+	// Cleanup actions and action set
+	m_session.Release();
+
+	m_baseSpace = XR_NULL_HANDLE;
+	m_predictedDisplayTime = 0;
+	m_arrPoseActions.Reset();
+	m_mapActionSpace.Reset();
+	m_clock.Reset();
+	for (XrResult& locateResult : m_arrLocateResults)
 	{
-		if (Action.Key != XR_NULL_HANDLE)
-		{
-			xrDestroyAction(Action.Key);
-		}
+		locateResult = XR_SUCCESS;
 	}
 
-	// Cleanup action set
-	if (m_xrActionSet != XR_NULL_HANDLE)
+	// The runtime's trackers are gone with it, a replay keeps showing the captured ones
+	FScopeLock poseLock(&m_poseLock);
+	if (m_pReplay)
 	{
-		xrDestroyActionSet(m_xrActionSet);
+		m_mapLivePersistentPathRoles.Reset();
+		return;
 	}
 
-	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Plugin shut down."));
+	m_mapPersistentPathRoles.Reset();
+	RebuildRoleOverrides();
+	ResetTrackerSamples();
+	m_nTrackerPathsGeneration++;
 }
 
 bool FOpenXRViveTrackerModule::GetRequiredExtensions(TArray<const ANSICHAR*>& OutExtensions)
@@ -80,18 +163,38 @@ bool FOpenXRViveTrackerModule::GetRequiredExtensions(TArray<const ANSICHAR*>& Ou
 	return true;
 }
 
+bool FOpenXRViveTrackerModule::GetOptionalExtensions(TArray<const ANSICHAR*>& OutExtensions)
+{
+	// Lets tracker samples be stamped with the platform's monotonic clock
+	OutExtensions.Add(FViveTrackerClock::GetExtensionName());
+	return true;
+}
+
 void FOpenXRViveTrackerModule::PostCreateInstance(XrInstance InInstance)
 {
-	// Cache instance handle
-	m_xrInstance = InInstance;
+	// Resolve runtime time conversion, if available
+	if (m_clock.Initialize(InInstance))
+	{
+		UE_LOG(LogOpenXRViveTracker, Display, TEXT("Tracker samples will be stamped with platform time using %s"),
+			*FString(UTF8_TO_TCHAR(FViveTrackerClock::GetExtensionName())));
+	}
 
-	// Create action set that'll host all tracker role actions
-	XrActionSetCreateInfo xrActionSetCreateInfo{ XR_TYPE_ACTION_SET_CREATE_INFO };
-	strcpy_s(xrActionSetCreateInfo.actionSetName, XR_MAX_ACTION_SET_NAME_SIZE, "tracker_actionset");
-	strcpy_s(xrActionSetCreateInfo.localizedActionSetName, XR_MAX_LOCALIZED_ACTION_SET_NAME_SIZE, "Actionset for vive tracker actions");
-	xrActionSetCreateInfo.priority = 0;
+	// The session calls into the runtime through the engine's OpenXR loader, profiled while FViveTrackerXrProfiler is enabled
+	ViveTrackerCore::FXrEntryPoints xrEntryPoints;
+	xrEntryPoints.GetInstanceProcAddr = xrGetInstanceProcAddr;
+	xrEntryPoints.CreateActionSet = xrCreateActionSet;
+	xrEntryPoints.DestroyActionSet = xrDestroyActionSet;
+	xrEntryPoints.CreateAction = xrCreateAction;
+	xrEntryPoints.DestroyAction = xrDestroyAction;
+	xrEntryPoints.CreateActionSpace = xrCreateActionSpace;
+	xrEntryPoints.SuggestInteractionProfileBindings = xrSuggestInteractionProfileBindings;
+	xrEntryPoints.LocateSpace = xrLocateSpace;
+	xrEntryPoints.StringToPath = xrStringToPath;
+	xrEntryPoints.PathToString = xrPathToString;
+	m_session.SetEntryPoints(FViveTrackerXrProfiler::Wrap(xrEntryPoints));
 
-	XrResult result = xrCreateActionSet(m_xrInstance, &xrActionSetCreateInfo, &m_xrActionSet);
+	// Create action set that'll host all tracker role actions
+	XrResult result = m_session.CreateActionSet(InInstance);
 	
 	if (result != XR_SUCCESS)
 	{
@@ -99,172 +202,389 @@ void FOpenXRViveTrackerModule::PostCreateInstance(XrInstance InInstance)
 	}
 	else
 	{
-		UE_LOG(LogOpenXRViveTracker, Display, TEXT("Created action set for trackers [tracker_actionset]"));
+		UE_LOG(LogOpenXRViveTracker, Display, TEXT("Created action set for trackers [%s]"), *FString(UTF8_TO_TCHAR(ViveTrackerCore::FTrackerSession::GetActionSetName())));
 	}
 
 }
 
 void FOpenXRViveTrackerModule::PostCreateSession(XrSession InSession)
 {
-	// Cache session handle
-	m_xrSession = InSession;
+	// Create and bind tracker actions
+	XrResult result = m_session.CreateActions(InSession);
 
-	// Bind tracker actions
-	CreateTrackerBinding(ETrackerRole::Foot_L, CreatePoseAction("tracker_foot_l"));
-	CreateTrackerBinding(ETrackerRole::Foot_R, CreatePoseAction("tracker_foot_r"));
-	CreateTrackerBinding(ETrackerRole::Shoulder_L, CreatePoseAction("tracker_shoulder_l"));
-	CreateTrackerBinding(ETrackerRole::Shoulder_R, CreatePoseAction("tracker_shoulder_r"));
-	CreateTrackerBinding(ETrackerRole::Elbow_L, CreatePoseAction("tracker_elbow_l"));
-	CreateTrackerBinding(ETrackerRole::Elbow_R, CreatePoseAction("tracker_elbow_r"));
-	CreateTrackerBinding(ETrackerRole::Knee_L, CreatePoseAction("tracker_knee_l"));
-	CreateTrackerBinding(ETrackerRole::Knee_R, CreatePoseAction("tracker_knee_r"));
-	CreateTrackerBinding(ETrackerRole::Waist, CreatePoseAction("tracker_waist"));
-	CreateTrackerBinding(ETrackerRole::Chest, CreatePoseAction("tracker_chest"));
-	CreateTrackerBinding(ETrackerRole::Camera, CreatePoseAction("tracker_camera"));
-	CreateTrackerBinding(ETrackerRole::Keyboard, CreatePoseAction("tracker_keyboard"));
-
-	m_bActionsGenerated = true;
-
-	// Bind actions to tracker interaction profile and suggest bindings
-	if (m_arrActionBindings.Num() > 0)
+	for (int32 role = 0; role < (int32)ETrackerRole::Unassigned; role++)
 	{
-		XrPath xrPath;
-		xrStringToPath(m_xrInstance, "/interaction_profiles/htc/vive_tracker_htcx", &xrPath);
-
-		XrInteractionProfileSuggestedBinding xrInteractionProfileSuggestedBinding{ XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING };
-		xrInteractionProfileSuggestedBinding.interactionProfile = xrPath;
-		xrInteractionProfileSuggestedBinding.suggestedBindings = m_arrActionBindings.GetData();
-		xrInteractionProfileSuggestedBinding.countSuggestedBindings = (uint32_t)m_arrActionBindings.Num();
+		const ViveTrackerCore::FTrackerRoleAction& roleAction = m_session.GetRoleAction(role);
+		const FString sActionName(UTF8_TO_TCHAR(ViveTrackerCore::FTrackerSession::GetRoleActionName(role)));
 
-		XrResult result = xrSuggestInteractionProfileBindings(m_xrInstance, &xrInteractionProfileSuggestedBinding);
+		if (roleAction.Space != XR_NULL_HANDLE)
+		{
+			// Add action to array of created actions for this session
+			m_arrPoseActions.Add(roleAction.Action);
+			m_mapActionSpace.Add(roleAction.Action, roleAction.Space);
+		}
 
-		if (result != XR_SUCCESS)
-			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to suggest vive tracker interaction profile bindings to runtime (%i)"), (int32_t)result);
+		if (roleAction.Result == XR_SUCCESS)
+		{
+			UE_LOG(LogOpenXRViveTracker, Display, TEXT("Created tracker pose action [%s] bound to [%s/input/grip/pose]"),
+				*sActionName, UTF8_TO_TCHAR(GetTrackerRolePath((ETrackerRole)role)));
+		}
+		else
+		{
+			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to create and bind action %s. Runtime returned error (%i)"),
+				*sActionName, (int32_t)roleAction.Result);
+		}
 	}
+
+	if (result != XR_SUCCESS)
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to suggest vive tracker interaction profile bindings to runtime (%i)"), (int32_t)result);
 }
 
 
 void FOpenXRViveTrackerModule::UpdateDeviceLocations(XrSession InSession, XrTime DisplayTime, XrSpace TrackingSpace)
 {
-	m_predictedDisplayTime = DisplayTime;
+	FScopeLock poseLock(&m_poseLock);
 	m_baseSpace = TrackingSpace;
+
+	// A replay runs on the capture's clock
+	if (!m_pReplay)
+	{
+		m_predictedDisplayTime = DisplayTime;
+	}
 }
 
 void FOpenXRViveTrackerModule::OnEvent(XrSession InSession, const XrEventDataBaseHeader* InHeader)
 {
-	if (m_xrInstance == XR_NULL_HANDLE)
+	SCOPE_CYCLE_COUNTER(STAT_ViveTracker_Events);
+
+	// Session state changes are tracked by the session, only newly connected trackers concern the module
+	if (m_session.HandleEvent(InHeader) != ViveTrackerCore::ETrackerSessionEvent::TrackerConnected)
 		return;
 
-	const XrEventDataSessionStateChanged& xrEventDataSessionStateChanged = *reinterpret_cast<const XrEventDataSessionStateChanged*>(InHeader);
-	const XrEventDataViveTrackerConnectedHTCX& xrEventDataViveTrackerConnectedHTCX = *reinterpret_cast<const XrEventDataViveTrackerConnectedHTCX*>(InHeader);
+	// A rack of trackers powering on sends dozens of these, so an event costs the same however many trackers there
+	// are and doesn't allocate. The trackers are listed again once per frame in PostSyncActions.
+	const ViveTrackerCore::FTrackerPathRole& connectedTracker = m_session.GetConnectedTracker();
+	const ETrackerRole connectedRole = (ETrackerRole)connectedTracker.Role;
+	AssignPathString(m_sConnectedPath, connectedTracker.PersistentPath);
+	INC_DWORD_STAT(STAT_ViveTracker_ConnectEvents);
+	VIVETRACKER_TRACE_CONNECTED(connectedRole);
+
+	UE_LOG(LogOpenXRViveTracker, Verbose, TEXT("Tracker connected event received for [%s] with role [%s]"),
+		*m_sConnectedPath, connectedRole != ETrackerRole::Unassigned ? UTF8_TO_TCHAR(GetTrackerRolePath(connectedRole)) : TEXT(""));
 
-	// Check for session state change
-	if (InHeader->type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED && xrEventDataSessionStateChanged.type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED)
+	if (m_pCaptureWriter)
 	{
-		m_xrCurrentSessionState = xrEventDataSessionStateChanged.state;
+		m_pCaptureWriter->AddEvent(ViveTrackerCore::ECaptureEvent::Connected, m_sConnectedPath, connectedRole,
+			GetPredictedDisplayTime(), m_clock.XrTimeToPlatformTime(GetPredictedDisplayTime()));
+	}
 
-		//UE_LOG(LogOpenXRViveTracker, Display, TEXT("Session State changing from %s to %s"),
-		//	XrEnumToString(m_xrCurrentSessionState), XrEnumToString(xrEventDataSessionStateChanged.state));
+	// Replayed trackers stand in for the runtime's ones
+	if (!m_pReplay)
+	{
+		m_onTrackerConnected.Broadcast(m_sConnectedPath, connectedRole);
 	}
+}
 
-	// Check for newly connected tracker
-	else if (InHeader->type == XR_TYPE_EVENT_DATA_VIVE_TRACKER_CONNECTED_HTCX && xrEventDataViveTrackerConnectedHTCX.type == XR_TYPE_EVENT_DATA_VIVE_TRACKER_CONNECTED_HTCX)
+void FOpenXRViveTrackerModule::AssignPathString(FString& OutString, const std::string& Path)
+{
+	// OpenXR paths are ASCII, copied in place so the string keeps its storage
+	OutString.Reset();
+	for (const char c : Path)
 	{
-		// Log tracker reported by runtime
-		uint32_t nCount;
-		char sPersistentPath[XR_MAX_PATH_LENGTH];
-		char sRolePath[XR_MAX_PATH_LENGTH];
+		OutString.AppendChar((TCHAR)c);
+	}
+}
+
+void FOpenXRViveTrackerModule::UpdateTrackerPaths()
+{
+	const int32 nTrackers = (int32)m_session.GetNumTrackers();
 
-		xrPathToString(m_xrInstance, xrEventDataViveTrackerConnectedHTCX.paths->persistentPath, sizeof(sPersistentPath), &nCount, sPersistentPath);
-		xrPathToString(m_xrInstance, xrEventDataViveTrackerConnectedHTCX.paths->rolePath, sizeof(sRolePath), &nCount, sRolePath);
+	FScopeLock poseLock(&m_poseLock);
 
-		UE_LOG( LogOpenXRViveTracker, Display, TEXT("Tracker connected event received for [%s] with role [%s]"), 
-			*FString(UTF8_TO_TCHAR(sPersistentPath)), *FString(UTF8_TO_TCHAR(sRolePath)) );
+	// The runtime's trackers are restored once the replay stops
+	TMap<FString, ETrackerRole>& mapPersistentPathRoles = m_pReplay ? m_mapLivePersistentPathRoles : m_mapPersistentPathRoles;
 
+	// Role changes are applied in place, the map is only rebuilt when trackers come or go
+	bool bSameTrackers = mapPersistentPathRoles.Num() == nTrackers;
+	for (int32 nTracker = 0; nTracker < nTrackers && bSameTrackers; nTracker++)
+	{
+		AssignPathString(m_sPathKey, m_session.GetTracker(nTracker).PersistentPath);
+		bSameTrackers = mapPersistentPathRoles.Contains(m_sPathKey);
+	}
 
-		// Report all active trackers
-		PFN_xrEnumerateViveTrackerPathsHTCX xrEnumerateViveTrackerPathsHTCX = nullptr;
-		XrResult result = xrGetInstanceProcAddr(m_xrInstance, "xrEnumerateViveTrackerPathsHTCX", (PFN_xrVoidFunction*)&xrEnumerateViveTrackerPathsHTCX);
+	if (!bSameTrackers)
+	{
+		mapPersistentPathRoles.Reset();
+	}
 
-		uint32_t nPaths;
-		TArray< XrViveTrackerPathsHTCX > allViveTrackerPaths;
-		result = xrEnumerateViveTrackerPathsHTCX(m_xrInstance, 0, &nPaths, nullptr);
-		if (result == XR_SUCCESS)
+	for (int32 nTracker = 0; nTracker < nTrackers; nTracker++)
+	{
+		const ViveTrackerCore::FTrackerPathRole& trackerPathRole = m_session.GetTracker(nTracker);
+		AssignPathString(m_sPathKey, trackerPathRole.PersistentPath);
+		if (bSameTrackers)
 		{
-			UE_LOG(LogOpenXRViveTracker, Display, TEXT("Number of tracker paths now active is %i"), nPaths);
+			mapPersistentPathRoles[m_sPathKey] = (ETrackerRole)trackerPathRole.Role;
+		}
+		else
+		{
+			mapPersistentPathRoles.Add(m_sPathKey, (ETrackerRole)trackerPathRole.Role);
+		}
+	}
 
-			for (size_t i = 0; i < nPaths; i++)
-			{
-				XrViveTrackerPathsHTCX xrViveTrackerPaths{ XR_TYPE_VIVE_TRACKER_PATHS_HTCX };
-				allViveTrackerPaths.Add(xrViveTrackerPaths);
-			}
+	if (m_pCaptureWriter)
+	{
+		m_pCaptureWriter->SetTrackerPaths(mapPersistentPathRoles);
+		m_pCaptureWriter->AddEvent(ViveTrackerCore::ECaptureEvent::PathsChanged, FString(), ETrackerRole::Unassigned,
+			GetPredictedDisplayTime(), m_clock.XrTimeToPlatformTime(GetPredictedDisplayTime()));
+	}
+
+	if (m_pReplay)
+		return;
+
+	RebuildRoleOverrides();
+	m_nTrackerPathsGeneration++;
+}
+
+void FOpenXRViveTrackerModule::SetInferredTrackerRoles(const TMap<FString, ETrackerRole>& InferredRoles)
+{
+	FScopeLock poseLock(&m_poseLock);
+	m_mapInferredPathRoles = InferredRoles;
+	RebuildRoleOverrides();
+	m_nTrackerPathsGeneration++;
+}
 
-			result = xrEnumerateViveTrackerPathsHTCX(m_xrInstance, allViveTrackerPaths.Num(), &nPaths, allViveTrackerPaths.GetData());
+void FOpenXRViveTrackerModule::RebuildRoleOverrides()
+{
+	// Callers hold m_poseLock
+	m_mapRoleOverrides.Reset();
+
+	TArray<ETrackerRole, TInlineAllocator<16>> arrReassignedRoles;
+	for (const TPair<FString, ETrackerRole>& inferredRole : m_mapInferredPathRoles)
+	{
+		// Only trackers bound to some role in the runtime can be located
+		const ETrackerRole* pBoundRole = m_mapPersistentPathRoles.Find(inferredRole.Key);
+		if (!pBoundRole || *pBoundRole == ETrackerRole::Unassigned || inferredRole.Value == ETrackerRole::Unassigned || inferredRole.Value == *pBoundRole)
+			continue;
+
+		m_mapRoleOverrides.Add(inferredRole.Value, *pBoundRole);
+		arrReassignedRoles.Add(*pBoundRole);
+	}
+
+	// A runtime role whose tracker moved to another role is hidden, unless another tracker took it over
+	for (ETrackerRole reassignedRole : arrReassignedRoles)
+	{
+		if (!m_mapRoleOverrides.Contains(reassignedRole))
+		{
+			m_mapRoleOverrides.Add(reassignedRole, ETrackerRole::Unassigned);
 		}
 	}
 }
 
+ETrackerRole FOpenXRViveTrackerModule::GetBoundRole(ETrackerRole role) const
+{
+	// Callers hold m_poseLock
+	const ETrackerRole* pBoundRole = m_mapRoleOverrides.Find(role);
+	return pBoundRole ? *pBoundRole : role;
+}
+
+ETrackerRole FOpenXRViveTrackerModule::GetPathRole(const FString& persistentPath, ETrackerRole boundRole) const
+{
+	// Callers hold m_poseLock
+	const ETrackerRole* pInferredRole = m_mapInferredPathRoles.Find(persistentPath);
+	if (pInferredRole && *pInferredRole != ETrackerRole::Unassigned && boundRole != ETrackerRole::Unassigned)
+		return *pInferredRole;
+
+	return boundRole;
+}
+
 void FOpenXRViveTrackerModule::AddActionSets(TArray<XrActiveActionSet>& OutActionSets)
 {
-	XrActiveActionSet xrActiveActionSet{ m_xrActionSet, XR_NULL_PATH };
+	XrActiveActionSet xrActiveActionSet{ m_session.GetActionSet(), XR_NULL_PATH };
 	OutActionSets.Add(xrActiveActionSet);
 }
 
 void FOpenXRViveTrackerModule::PostSyncActions(XrSession InSession)
 {
+	SCOPE_CYCLE_COUNTER(STAT_ViveTracker_Sync);
+
+	const double fSyncStartSeconds = FPlatformTime::Seconds();
+	ON_SCOPE_EXIT
+	{
+		const double fSyncSeconds = FPlatformTime::Seconds() - fSyncStartSeconds;
+		m_syncStats.NumFrames++;
+		m_syncStats.SumSeconds += fSyncSeconds;
+		m_syncStats.MaxSeconds = FMath::Max(m_syncStats.MaxSeconds, fSyncSeconds);
+	};
+
+	// However many connect events came in since the last frame, the trackers are listed once
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ViveTracker_TrackerPaths);
+		if (m_session.RefreshTrackers() && m_session.GetTrackersResult() == XR_SUCCESS)
+		{
+			const int32 nTrackers = (int32)m_session.GetNumTrackers();
+			if (nTrackers != m_mapPersistentPathRoles.Num() && !m_pReplay)
+			{
+				UE_LOG(LogOpenXRViveTracker, Display, TEXT("Number of tracker paths now active is %i"), nTrackers);
+			}
+			SET_DWORD_STAT(STAT_ViveTracker_ConnectedTrackers, nTrackers);
+			UpdateTrackerPaths();
+		}
+	}
+
 	if (GetBaseSpace() == XR_NULL_HANDLE && m_arrPoseActions.Num() > 0)
 		return;
 
-	for (XrAction action : m_arrPoseActions)
+	// Poses come from the capture while replaying
+	if (m_pReplay)
+		return;
+
+	// Refresh the runtime to platform clock estimate, this only calls into the runtime a few times per second
+	m_clock.Update();
+	const XrTime locateTime = GetLocateTime();
+	const int64 nPlatformTime = m_clock.XrTimeToPlatformTime(locateTime);
+	const double fSampledSeconds = FPlatformTime::Seconds();
+	const int64 nSampledPlatformTime = nPlatformTime != 0 ? FViveTrackerClock::GetPlatformTimeNs() : 0;
+
 	{
-		XrSpace* pSpace = m_mapActionSpace.Find(action);
-		ETrackerRole* pRole = m_mapTrackerRoles.Find(action);
+		SCOPE_CYCLE_COUNTER(STAT_ViveTracker_Locate);
+		m_session.LocateRoles(GetBaseSpace(), locateTime);
+	}
 
-		if (pSpace && pRole)
+	const double fPublishStartSeconds = FPlatformTime::Seconds();
+	m_syncStats.SumLocateSeconds += fPublishStartSeconds - fSampledSeconds;
+
+	SCOPE_CYCLE_COUNTER(STAT_ViveTracker_Publish);
+	for (int32 nRole = 0; nRole < (int32)ETrackerRole::Unassigned; nRole++)
+	{
+		const ETrackerRole role = (ETrackerRole)nRole;
+
+		if (m_session.GetRoleAction(nRole).Space != XR_NULL_HANDLE)
 		{
-			XrSpaceLocation spaceLocation{ XR_TYPE_SPACE_LOCATION };
-			XrResult result = xrLocateSpace(*pSpace, GetBaseSpace(), GetPredictedDisplayTime(), &spaceLocation);
+			const ViveTrackerCore::FTrackerLocation& spaceLocation = m_session.GetLocation(nRole);
+			XrResult result = spaceLocation.Result;
 
 			// Update tracker poses
 			if (result == XR_SUCCESS)
 			{
-				FTransform* trackerTransform = m_mapTrackerTransforms.Find(*pRole);
-				if (trackerTransform)
+				FScopeLock poseLock(&m_poseLock);
+
+				FViveTrackerSample* trackerSample = m_mapTrackerSamples.Find(role);
+				if (trackerSample)
 				{
-					if (spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT &&
-						spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT)
+					trackerSample->LocationFlags = spaceLocation.LocationFlags;
+
+					if (spaceLocation.LocationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT &&
+						spaceLocation.LocationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT)
 					{
+						FTransform* trackerTransform = &trackerSample->Transform;
+
 						// Set orientation
-						trackerTransform->SetRotation(ToFQuat(spaceLocation.pose.orientation));
+						trackerTransform->SetRotation(ToFQuat(spaceLocation.Pose.orientation));
 
 						// Set location
-						FVector location = ToFVector(spaceLocation.pose.position, 100.f);
+						FVector location = ToFVector(spaceLocation.Pose.position, 100.f);
 						trackerTransform->SetLocation(FVector(location.X, location.Y, location.Z));
 
-						//FString sRole = StaticEnum<ETrackerRole>()->GetValueAsString(*pRole);
+						// Set velocities, angular velocity is an axis so it flips with the change of handedness
+						trackerSample->VelocityFlags = spaceLocation.VelocityFlags;
+						trackerSample->LinearVelocity = ToFVector(spaceLocation.LinearVelocity, 100.f);
+						trackerSample->AngularVelocity = -ToFVector(spaceLocation.AngularVelocity);
+
+						// Stamp with both clocks
+						trackerSample->Time = locateTime;
+						trackerSample->PlatformTimeNs = nPlatformTime;
+						trackerSample->SampledSeconds = fSampledSeconds;
+
+						// Keep a short history for sub-frame evaluation
+						FViveTrackerPoseHistory* trackerHistory = m_mapTrackerHistory.Find(role);
+						if (trackerHistory)
+						{
+							trackerHistory->Push(*trackerSample);
+						}
+
+						if (m_pLatencyRecorder)
+						{
+							m_pLatencyRecorder->RecordPublished(*trackerSample);
+						}
+
+						INC_DWORD_STAT(STAT_ViveTracker_LocatedTrackers);
+						VIVETRACKER_TRACE_POSE(role, *trackerSample);
+
+						//FString sRole = StaticEnum<ETrackerRole>()->GetValueAsString(role);
 						//UE_LOG(LogOpenXRViveTracker, Display, TEXT("[Tracker %s] x[%f] y[%f] z[%f]"), *sRole,
 						//	trackerTransform->GetLocation().X, trackerTransform->GetLocation().Y, trackerTransform->GetLocation().Z);
 					}
+
+					// Lost tracking is captured too, with the last known pose and the current flags
+					if (m_pCaptureWriter)
+					{
+						FViveTrackerSample capturedSample = *trackerSample;
+						capturedSample.VelocityFlags = spaceLocation.VelocityFlags;
+						capturedSample.Time = locateTime;
+						capturedSample.PlatformTimeNs = nPlatformTime;
+						m_pCaptureWriter->AddSample(role, capturedSample);
+					}
 				}
 			}
-			else
+			else if (result != m_arrLocateResults[nRole])
 			{
-				FString sRole = StaticEnum<ETrackerRole>()->GetValueAsString(*pRole);
+				// Logged when the error changes rather than every frame, logging allocates
 				UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to get tracker pose for role (%s), error. Runtime returned error (%i)"), 
-					*sRole, (int32_t)result);
+					UTF8_TO_TCHAR(GetTrackerRolePath(role)), (int32_t)result);
 			}
+			m_arrLocateResults[nRole] = result;
+			UpdateRoleStats(nRole, spaceLocation, fSampledSeconds, nSampledPlatformTime, nPlatformTime);
 		}
 	}
+	m_syncStats.SumPublishSeconds += FPlatformTime::Seconds() - fPublishStartSeconds;
+
+	// Records drops and wakes the capture writer thread, outside of the pose lock
+	if (m_pCaptureWriter)
+	{
+		m_pCaptureWriter->Update();
+	}
+}
+
+ETrackerRole FOpenXRViveTrackerModule::GetMotionSourceRole(const FName MotionSource) const
+{
+	// Motion sources are named after the roles, e.g. "Foot_L"
+	static const TArray<FName> arrSourceNames = []()
+	{
+		TArray<FName> arrNames;
+		for (int32 role = 0; role < (int32)ETrackerRole::Unassigned; role++)
+		{
+			arrNames.Add(FName(*StaticEnum<ETrackerRole>()->GetNameStringByValue(role)));
+		}
+		return arrNames;
+	}();
+
+	const int32 nRole = arrSourceNames.IndexOfByKey(MotionSource);
+	return nRole != INDEX_NONE ? (ETrackerRole)nRole : ETrackerRole::Unassigned;
 }
 
 bool FOpenXRViveTrackerModule::GetControllerOrientationAndPosition(const int32 ControllerIndex, const FName MotionSource, FRotator& OutOrientation, FVector& OutPosition, float WorldToMetersScale) const
 {
+	const ETrackerRole role = GetMotionSourceRole(MotionSource);
+	if (ControllerIndex != 0 || role == ETrackerRole::Unassigned)
+		return false;
+
+	FScopeLock poseLock(&m_poseLock);
+
+	const ETrackerRole boundRole = GetBoundRole(role);
+	const FViveTrackerSample* trackerSample = boundRole != ETrackerRole::Unassigned ? m_mapTrackerSamples.Find(boundRole) : nullptr;
+	if (!trackerSample || !trackerSample->HasValidPose())
+		return false;
+
+	// Samples are in cm
+	OutOrientation = trackerSample->Transform.Rotator();
+	OutPosition = trackerSample->Transform.GetLocation() * (WorldToMetersScale / 100.f);
 	return true;
 }
 
 bool FOpenXRViveTrackerModule::GetControllerOrientationAndPosition(const int32 ControllerIndex, const EControllerHand DeviceHand, FRotator& OutOrientation, FVector& OutPosition, float WorldToMetersScale) const
 {
-	return true;
+	// Trackers are only exposed through their named motion sources
+	return false;
 }
 
 ETrackingStatus FOpenXRViveTrackerModule::GetControllerTrackingStatus(const int32 ControllerIndex, const EControllerHand DeviceHand) const
@@ -272,6 +592,22 @@ ETrackingStatus FOpenXRViveTrackerModule::GetControllerTrackingStatus(const int3
 	return ETrackingStatus::NotTracked;
 }
 
+ETrackingStatus FOpenXRViveTrackerModule::GetControllerTrackingStatus(const int32 ControllerIndex, const FName MotionSource) const
+{
+	const ETrackerRole role = GetMotionSourceRole(MotionSource);
+	if (ControllerIndex != 0 || role == ETrackerRole::Unassigned)
+		return ETrackingStatus::NotTracked;
+
+	FScopeLock poseLock(&m_poseLock);
+
+	const ETrackerRole boundRole = GetBoundRole(role);
+	const FViveTrackerSample* trackerSample = boundRole != ETrackerRole::Unassigned ? m_mapTrackerSamples.Find(boundRole) : nullptr;
+	if (!trackerSample || !(trackerSample->LocationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT))
+		return ETrackingStatus::NotTracked;
+
+	return (trackerSample->LocationFlags & XR_SPACE_LOCATION_POSITION_TRACKED_BIT) ? ETrackingStatus::Tracked : ETrackingStatus::InertialOnly;
+}
+
 FName FOpenXRViveTrackerModule::GetMotionControllerDeviceTypeName() const
 {
 	return FName("ViveTracker");
@@ -279,7 +615,10 @@ FName FOpenXRViveTrackerModule::GetMotionControllerDeviceTypeName() const
 
 void FOpenXRViveTrackerModule::EnumerateSources(TArray<FMotionControllerSource>& SourcesOut) const
 {
-
+	for (int32 role = 0; role < (int32)ETrackerRole::Unassigned; role++)
+	{
+		SourcesOut.Add(FMotionControllerSource(FName(*StaticEnum<ETrackerRole>()->GetNameStringByValue(role))));
+	}
 }
 
 void FOpenXRViveTrackerModule::Tick(float DeltaTime)
@@ -297,146 +636,772 @@ void FOpenXRViveTrackerModule::SetMessageHandler(const TSharedRef<FGenericApplic
 
 }
 
+// Name of a role as in the motion sources, e.g. "Foot_L"
+static FString GetRoleName(int32 nRole)
+{
+	return StaticEnum<ETrackerRole>()->GetNameStringByValue(nRole);
+}
+
+// "on", "off", "1", "0"... or the opposite of the current state without an argument
+static bool ParseToggle(const TCHAR* Cmd, bool bCurrent)
+{
+	FString sToken;
+	return FParse::Token(Cmd, sToken, false) ? FCString::ToBool(*sToken) : !bCurrent;
+}
+
 bool FOpenXRViveTrackerModule::Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar)
 {
-	return true;
+	if (FParse::Command(&Cmd, TEXT("vivetracker.Status")))
+	{
+		DumpStatus(Ar);
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.Stats")))
+	{
+		DumpStats(Ar);
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.ResetStats")))
+	{
+		ResetStats();
+		Ar.Logf(TEXT("Vive tracker statistics reset"));
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.Filter")))
+	{
+		SetPoseFilterEnabled(ParseToggle(Cmd, IsPoseFilterEnabled()));
+		Ar.Logf(TEXT("Vive tracker history filter %s"), IsPoseFilterEnabled() ? TEXT("on") : TEXT("off, poses at any time are the latest pose"));
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.Prediction")))
+	{
+		SetPosePredictionEnabled(ParseToggle(Cmd, IsPosePredictionEnabled()));
+		Ar.Logf(TEXT("Vive tracker pose prediction %s%s"), IsPosePredictionEnabled() ? TEXT("on") : TEXT("off"),
+			!IsPosePredictionEnabled() && !m_clock.IsValid() ? TEXT(", but the runtime can't convert time so poses stay predicted") : TEXT(""));
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.StartCapture")))
+	{
+		FString sFilename;
+		FParse::Token(Cmd, sFilename, false);
+		if (StartCapture(sFilename))
+		{
+			Ar.Logf(TEXT("Capturing vive tracker samples to %s"), *m_pCaptureWriter->GetFilename());
+		}
+		else
+		{
+			Ar.Logf(TEXT("Unable to start the vive tracker capture"));
+		}
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.StopCapture")))
+	{
+		if (m_pCaptureWriter)
+		{
+			Ar.Logf(TEXT("Stopped capturing %lld vive tracker samples to %s"), m_pCaptureWriter->GetNumSamples(), *m_pCaptureWriter->GetFilename());
+		}
+		StopCapture();
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.XrProfile")))
+	{
+		FViveTrackerXrProfiler::SetEnabled(ParseToggle(Cmd, FViveTrackerXrProfiler::IsEnabled()));
+		Ar.Logf(TEXT("OpenXR call profiling %s"), FViveTrackerXrProfiler::IsEnabled() ? TEXT("on") : TEXT("off"));
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.XrProfileDump")))
+	{
+		FString sFilename;
+		if (!FParse::Token(Cmd, sFilename, false))
+		{
+			sFilename = FPaths::ProjectSavedDir() / TEXT("ViveTracker") / FString::Printf(TEXT("XrProfile-%s.csv"), *FDateTime::Now().ToString());
+		}
+
+		FViveTrackerXrProfiler::LogReport(Ar);
+		if (FViveTrackerXrProfiler::WriteCsv(sFilename))
+		{
+			Ar.Logf(TEXT("Wrote OpenXR call profile to %s"), *sFilename);
+		}
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.DebugDraw")))
+	{
+		if (ParseToggle(Cmd, m_pDebugDraw.IsValid()))
+		{
+			StartDebugDraw(m_pDebugDraw ? m_pDebugDraw->GetSettings() : FViveTrackerDebugDrawSettings());
+		}
+		else
+		{
+			StopDebugDraw();
+		}
+		Ar.Logf(TEXT("Vive tracker debug draw %s"), m_pDebugDraw ? TEXT("on") : TEXT("off"));
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.DebugDrawTrail")))
+	{
+		FViveTrackerDebugDrawSettings settings = m_pDebugDraw ? m_pDebugDraw->GetSettings() : FViveTrackerDebugDrawSettings();
+		FString sToken;
+		if (FParse::Token(Cmd, sToken, false))
+		{
+			settings.TrailLength = FMath::Clamp(FCString::Atoi(*sToken), 0, FViveTrackerDebugDrawSettings::MaxTrailLength);
+		}
+		StartDebugDraw(settings);
+		Ar.Logf(TEXT("Vive tracker debug draw on, trails of %d positions"), settings.TrailLength);
+		return true;
+	}
+
+	if (FParse::Command(&Cmd, TEXT("vivetracker.Help")))
+	{
+		Ar.Logf(TEXT("vivetracker.Status - Runtime, replay and capture state and the current pose of every role"));
+		Ar.Logf(TEXT("vivetracker.Stats - PostSyncActions cost and how every role was located since the last reset"));
+		Ar.Logf(TEXT("vivetracker.ResetStats - Reset the statistics shown by vivetracker.Stats and vivetracker.XrProfileDump"));
+		Ar.Logf(TEXT("vivetracker.Filter [on|off] - Interpolate and extrapolate the tracker history for substeps and animation"));
+		Ar.Logf(TEXT("vivetracker.Prediction [on|off] - Locate poses at the predicted display time or when they are sampled"));
+		Ar.Logf(TEXT("vivetracker.StartCapture [file] - Capture every tracker sample, to Saved/ViveTracker without a file"));
+		Ar.Logf(TEXT("vivetracker.StopCapture - Finish the capture in progress"));
+		Ar.Logf(TEXT("vivetracker.DebugDraw [on|off] - Draw every tracker's axes, velocity, trail and status (green tracked, yellow inferred, red lost)"));
+		Ar.Logf(TEXT("vivetracker.DebugDrawTrail [positions] - Draw trackers with trails of this many past positions, 0 hides trails"));
+		Ar.Logf(TEXT("vivetracker.XrProfile [on|off] - Record the duration of every OpenXR call the plugin makes"));
+		Ar.Logf(TEXT("vivetracker.XrProfileDump [file] - Show OpenXR call percentiles and write them as csv, to Saved/ViveTracker without a file"));
+		Ar.Logf(TEXT("vivetracker.BenchmarkCapture [seconds] - Queue samples of 30 trackers into a capture writer and report the write rate and drops"));
+		Ar.Logf(TEXT("vivetracker.BenchmarkCodec [file] - Compression ratio, throughput and errors of the capture codec on synthetic trajectories and a capture file"));
+		Ar.Logf(TEXT("vivetracker.BenchmarkPipeline [frames] [file] - Time every stage of the per-frame pipeline against the mock runtime"));
+		Ar.Logf(TEXT("vivetracker.BenchmarkIK [avatars] - Time the batched full-body IK solver, single threaded and on task graph workers"));
+		Ar.Logf(TEXT("vivetracker.MeasureLatency [seconds] [trackers] - Sample to render submit latency over real frames"));
+		Ar.Logf(TEXT("vivetracker.TestMockRuntime [seconds] [trackers] - Check every pose and event of a scripted mock runtime"));
+		Ar.Logf(TEXT("vivetracker.TestHotPlugStorm [seconds] [trackers] [events per second] - Check connect events stay allocation free at a constant cost"));
+		Ar.Logf(TEXT("vivetracker.TestZeroAllocation [frames] [trackers] [capture] - Check the per-frame pose path doesn't allocate"));
+		Ar.Logf(TEXT("vivetracker.TestCaptureSeek [seconds] [seeks] - Check replay seeks against playing a synthetic capture from the start"));
+		Ar.Logf(TEXT("Every command also shows in the console's auto complete and in \"help vivetracker.\", the tests run as OpenXRViveTracker automation tests"));
+		return true;
+	}
+
+	// Other input devices' commands
+	return false;
 }
 
+/** Reaches the module's commands from any console, whichever input devices the engine passes commands to */
+static bool ViveTrackerExec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar)
+{
+	FOpenXRViveTrackerModule* pModule = FModuleManager::GetModulePtr<FOpenXRViveTrackerModule>("OpenXRViveTracker");
+	return pModule && pModule->Exec(InWorld, Cmd, Ar);
+}
 
-FTransform FOpenXRViveTrackerModule::GetTrackerTransform(ETrackerRole trackerRole)
+static FStaticSelfRegisteringExec ViveTrackerExecRegistration(&ViveTrackerExec);
+
+void FOpenXRViveTrackerModule::DumpStatus(FOutputDevice& Ar) const
 {
-	if (trackerRole == ETrackerRole::Unassigned)
-		return FTransform::Identity;
+	Ar.Logf(TEXT("Vive trackers: %s, session state %d, actions %s, %d tracker paths, prediction %s, history filter %s"),
+		m_pReplay ? TEXT("replaying a capture") : (m_session.GetSession() != XR_NULL_HANDLE ? TEXT("runtime session") : TEXT("no runtime session")),
+		(int32)m_session.GetSessionState(), m_session.IsActionsGenerated() ? TEXT("generated") : TEXT("not generated"),
+		(int32)m_session.GetNumTrackers(), m_bPosePrediction ? TEXT("on") : TEXT("off"), m_bPoseFilter ? TEXT("on") : TEXT("off"));
+
+	Ar.Logf(TEXT("Clock: %s, drift %.2f ppm. Capture: %s. Replay: %s"),
+		m_clock.IsValid() ? TEXT("runtime time conversion") : TEXT("no time conversion"), m_clock.GetDriftPPM(),
+		m_pCaptureWriter ? *FString::Printf(TEXT("%s, %lld samples, %lld dropped"), *m_pCaptureWriter->GetFilename(), m_pCaptureWriter->GetNumSamples(), m_pCaptureWriter->GetNumDroppedSamples()) : TEXT("off"),
+		m_pReplay ? *FString::Printf(TEXT("%.2f of %.2f s%s"), GetReplayPosition(), GetReplayDuration(), m_bReplayPaused ? TEXT(", paused") : TEXT("")) : TEXT("off"));
+
+	// A snapshot, so physics and animation threads aren't held up by the output device
+	FViveTrackerSample arrSamples[(int32)ETrackerRole::Unassigned];
+	ETrackerRole arrBoundRoles[(int32)ETrackerRole::Unassigned];
+	FString arrPaths[(int32)ETrackerRole::Unassigned];
+	{
+		FScopeLock poseLock(&m_poseLock);
 
-	FTransform* trackerTransform = m_mapTrackerTransforms.Find(trackerRole);
-	if (trackerTransform)
-		return *trackerTransform;
+		for (int32 nRole = 0; nRole < (int32)ETrackerRole::Unassigned; nRole++)
+		{
+			arrBoundRoles[nRole] = GetBoundRole((ETrackerRole)nRole);
+			const FViveTrackerSample* trackerSample = arrBoundRoles[nRole] != ETrackerRole::Unassigned ? m_mapTrackerSamples.Find(arrBoundRoles[nRole]) : nullptr;
+			arrSamples[nRole] = trackerSample ? *trackerSample : FViveTrackerSample();
+		}
 
-	UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Unable to obtain tracker pose - Unknown tracker role."));
-	return FTransform::Identity;
+		for (const TPair<FString, ETrackerRole>& pathRole : m_mapPersistentPathRoles)
+		{
+			const ETrackerRole pathRoleValue = GetPathRole(pathRole.Key, pathRole.Value);
+			if (pathRoleValue != ETrackerRole::Unassigned)
+			{
+				arrPaths[pathRoleValue] = pathRole.Key;
+			}
+		}
+	}
+
+	const double fNowSeconds = FPlatformTime::Seconds();
+	for (int32 nRole = 0; nRole < (int32)ETrackerRole::Unassigned; nRole++)
+	{
+		const FViveTrackerSample& trackerSample = arrSamples[nRole];
+		const FVector location = trackerSample.Transform.GetLocation();
+		const FRotator rotation = trackerSample.Transform.Rotator();
+
+		Ar.Logf(TEXT("  %s%s%s [%s] %s, location (%.1f %.1f %.1f) rotation (%.1f %.1f %.1f) speed %.1f cm/s, age %s"),
+			*GetRoleName(nRole), arrBoundRoles[nRole] != (ETrackerRole)nRole ? TEXT(" as ") : TEXT(""),
+			arrBoundRoles[nRole] != (ETrackerRole)nRole ? *GetRoleName(arrBoundRoles[nRole]) : TEXT(""),
+			arrPaths[nRole].IsEmpty() ? TEXT("-") : *arrPaths[nRole],
+			trackerSample.HasValidPose() ? TEXT("valid") : (trackerSample.Time != 0 ? TEXT("lost") : TEXT("none")),
+			location.X, location.Y, location.Z, rotation.Pitch, rotation.Yaw, rotation.Roll, trackerSample.LinearVelocity.Size(),
+			trackerSample.SampledSeconds > 0.0 ? *FString::Printf(TEXT("%.1f ms"), (fNowSeconds - trackerSample.SampledSeconds) * 1000.0) : TEXT("-"));
+	}
+}
+
+void FOpenXRViveTrackerModule::DumpStats(FOutputDevice& Ar) const
+{
+	const double fFrames = (double)FMath::Max<int64>(m_syncStats.NumFrames, 1);
+	Ar.Logf(TEXT("PostSyncActions: %lld frames, mean %.3f ms (locate %.3f ms, publish %.3f ms), max %.3f ms"),
+		m_syncStats.NumFrames, m_syncStats.SumSeconds * 1000.0 / fFrames, m_syncStats.SumLocateSeconds * 1000.0 / fFrames,
+		m_syncStats.SumPublishSeconds * 1000.0 / fFrames, m_syncStats.MaxSeconds * 1000.0);
+
+	const double fNowSeconds = FPlatformTime::Seconds();
+	for (int32 nRole = 0; nRole < (int32)ETrackerRole::Unassigned; nRole++)
+	{
+		const FViveTrackerRoleStats& roleStats = m_arrRoleStats[nRole];
+		const int64 nFrames = roleStats.NumLocated + roleStats.NumLost + roleStats.NumErrors;
+		if (nFrames == 0)
+			continue;
+
+		Ar.Logf(TEXT("  %s: located %lld, lost %lld (%.1f%%), errors %lld, interval mean %.2f ms max %.2f ms, prediction mean %s, last pose %s"),
+			*GetRoleName(nRole), roleStats.NumLocated, roleStats.NumLost, 100.0 * roleStats.NumLost / nFrames, roleStats.NumErrors,
+			roleStats.NumIntervals > 0 ? roleStats.SumIntervalSeconds * 1000.0 / roleStats.NumIntervals : 0.0, roleStats.MaxIntervalSeconds * 1000.0,
+			roleStats.NumPredictions > 0 ? *FString::Printf(TEXT("%.2f ms"), roleStats.SumPredictionSeconds * 1000.0 / roleStats.NumPredictions) : TEXT("-"),
+			roleStats.LastLocatedSeconds > 0.0 ? *FString::Printf(TEXT("%.2f s ago"), fNowSeconds - roleStats.LastLocatedSeconds) : TEXT("never"));
+	}
+}
+
+void FOpenXRViveTrackerModule::ResetStats()
+{
+	for (FViveTrackerRoleStats& roleStats : m_arrRoleStats)
+	{
+		roleStats = FViveTrackerRoleStats();
+	}
+
+	m_syncStats = FViveTrackerSyncStats();
+
+	FViveTrackerXrProfiler::Reset();
+}
+
+void FOpenXRViveTrackerModule::UpdateRoleStats(int32 nRole, const ViveTrackerCore::FTrackerLocation& location, double fSampledSeconds, int64 nSampledPlatformTime, int64 nPlatformTime)
+{
+	FViveTrackerRoleStats& roleStats = m_arrRoleStats[nRole];
+	if (location.Result != XR_SUCCESS)
+	{
+		roleStats.NumErrors++;
+		return;
+	}
+
+	if (!(location.LocationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) || !(location.LocationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT))
+	{
+		roleStats.NumLost++;
+		return;
+	}
+
+	roleStats.NumLocated++;
+	if (roleStats.LastLocatedSeconds > 0.0)
+	{
+		const double fIntervalSeconds = fSampledSeconds - roleStats.LastLocatedSeconds;
+		roleStats.SumIntervalSeconds += fIntervalSeconds;
+		roleStats.MaxIntervalSeconds = FMath::Max(roleStats.MaxIntervalSeconds, fIntervalSeconds);
+		roleStats.NumIntervals++;
+	}
+	roleStats.LastLocatedSeconds = fSampledSeconds;
+
+	if (nPlatformTime != 0 && nSampledPlatformTime != 0)
+	{
+		roleStats.SumPredictionSeconds += (nPlatformTime - nSampledPlatformTime) * 1.0e-9;
+		roleStats.NumPredictions++;
+	}
+}
+
+XrTime FOpenXRViveTrackerModule::GetLocateTime() const
+{
+	// Without prediction, the runtime's time now
+	if (!m_bPosePrediction && m_clock.IsValid())
+	{
+		const XrTime nowTime = m_clock.PlatformTimeToXrTime(FViveTrackerClock::GetPlatformTimeNs());
+		if (nowTime != 0)
+			return nowTime;
+	}
+
+	return m_predictedDisplayTime;
+}
+
+void FOpenXRViveTrackerModule::SetPoseFilterEnabled(bool bEnabled)
+{
+	FScopeLock poseLock(&m_poseLock);
+	m_bPoseFilter = bEnabled;
 }
 
-XrAction FOpenXRViveTrackerModule::CreatePoseAction(const char* pName)
+bool FOpenXRViveTrackerModule::StartCapture(const FString& Filename, bool bCompress)
 {
-	if (m_xrSession == XR_NULL_HANDLE || m_bActionsGenerated)
-		return XR_NULL_HANDLE;
+	StopCapture();
 
-	// Create action
-	XrActionCreateInfo xrActionCreateInfo{ XR_TYPE_ACTION_CREATE_INFO };
-	strcpy_s(xrActionCreateInfo.actionName, XR_MAX_ACTION_SET_NAME_SIZE, pName);
-	strcpy_s(xrActionCreateInfo.localizedActionName, XR_MAX_ACTION_SET_NAME_SIZE, pName);
-	xrActionCreateInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
-	xrActionCreateInfo.countSubactionPaths = 0;
-	xrActionCreateInfo.subactionPaths = NULL;
+	const FString sFilename = Filename.IsEmpty() ?
+		FPaths::ProjectSavedDir() / TEXT("ViveTracker") / FString::Printf(TEXT("Capture-%s.vtcap"), *FDateTime::Now().ToString()) : Filename;
 
-	XrAction xrAction = XR_NULL_HANDLE;
-	XrResult result = xrCreateAction(m_xrActionSet, &xrActionCreateInfo, &xrAction);
+	const ViveTrackerCore::FCaptureCodecSettings CodecSettings;
+	TUniquePtr<FViveTrackerCaptureWriter> pCaptureWriter = MakeUnique<FViveTrackerCaptureWriter>();
+	if (!pCaptureWriter->Open(sFilename, GetPredictedDisplayTime(), m_clock.XrTimeToPlatformTime(GetPredictedDisplayTime()), bCompress ? &CodecSettings : nullptr))
+		return false;
 
-	if (result == XR_SUCCESS)
 	{
-		// Create a corresponding action space
-		XrPosef xrPose{};
-		xrPose.orientation.w = 1.f;
+		FScopeLock poseLock(&m_poseLock);
+		pCaptureWriter->SetTrackerPaths(m_mapPersistentPathRoles);
+	}
 
-		XrActionSpaceCreateInfo xrActionSpaceCreateInfo{ XR_TYPE_ACTION_SPACE_CREATE_INFO };
-		xrActionSpaceCreateInfo.action = xrAction;
-		xrActionSpaceCreateInfo.poseInActionSpace = xrPose;
-		xrActionSpaceCreateInfo.subactionPath = XR_NULL_PATH;
+	m_pCaptureWriter = MoveTemp(pCaptureWriter);
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Capturing tracker samples to %s"), *sFilename);
+	return true;
+}
 
-		XrSpace xrSpace = XR_NULL_HANDLE;
-		result = xrCreateActionSpace(m_xrSession, &xrActionSpaceCreateInfo, &xrSpace);
+void FOpenXRViveTrackerModule::StopCapture()
+{
+	if (!m_pCaptureWriter)
+		return;
+
+	m_pCaptureWriter->Close();
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Captured %lld tracker samples (%lld dropped) to %s"),
+		m_pCaptureWriter->GetNumSamples(), m_pCaptureWriter->GetNumDroppedSamples(), *m_pCaptureWriter->GetFilename());
+	m_pCaptureWriter.Reset();
+}
 
-		if (result == XR_SUCCESS)
+void FOpenXRViveTrackerModule::StartDebugDraw(const FViveTrackerDebugDrawSettings& Settings)
+{
+	if (m_pDebugDraw)
+	{
+		m_pDebugDraw->SetSettings(Settings);
+		return;
+	}
+
+	m_pDebugDraw = MakeUnique<FViveTrackerDebugDraw>(*this, Settings);
+}
+
+void FOpenXRViveTrackerModule::StopDebugDraw()
+{
+	m_pDebugDraw.Reset();
+}
+
+void FOpenXRViveTrackerModule::StartLatencyRecording()
+{
+	if (!m_pLatencyRecorder)
+	{
+		m_pLatencyRecorder = MakeUnique<FViveTrackerLatencyRecorder>();
+	}
+	m_pLatencyRecorder->Start();
+}
+
+void FOpenXRViveTrackerModule::StopLatencyRecording()
+{
+	if (m_pLatencyRecorder)
+	{
+		m_pLatencyRecorder->Stop();
+	}
+}
+
+void FOpenXRViveTrackerModule::NotifySampleConsumed(const FViveTrackerSample& Sample)
+{
+	if (m_pLatencyRecorder)
+	{
+		m_pLatencyRecorder->RecordConsumed(Sample);
+	}
+}
+
+bool FOpenXRViveTrackerModule::StartReplay(const FString& Filename, const FViveTrackerReplaySettings& Settings)
+{
+	StopReplay();
+
+	TUniquePtr<FViveTrackerReplay> pReplay = MakeUnique<FViveTrackerReplay>();
+	if (!pReplay->Open(Filename, Settings))
+		return false;
+
+	// The captured trackers replace the runtime's ones until the replay stops
+	TMap<FString, ETrackerRole> mapReplayPathRoles;
+	for (const FViveTrackerCaptureTracker& captureTracker : pReplay->GetReader().GetTrackers())
+	{
+		if (!captureTracker.PersistentPath.IsEmpty())
 		{
-			// Add action to array of created actions for this session
-			m_arrPoseActions.Add(xrAction);
-			m_mapActionSpace.Add(xrAction, xrSpace);
-			UE_LOG(LogOpenXRViveTracker, Display, TEXT("Created tracker pose action [%s]"), *FString(UTF8_TO_TCHAR(pName)));
+			mapReplayPathRoles.Add(captureTracker.PersistentPath, captureTracker.Role);
 		}
-		else
+	}
+
+	{
+		FScopeLock poseLock(&m_poseLock);
+		m_mapLivePersistentPathRoles = MoveTemp(m_mapPersistentPathRoles);
+		m_mapPersistentPathRoles = MoveTemp(mapReplayPathRoles);
+		RebuildRoleOverrides();
+		ResetTrackerSamples();
+		m_predictedDisplayTime = pReplay->GetReader().GetStartTime();
+		m_nTrackerPathsGeneration++;
+	}
+
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Replaying %lld tracker samples (%.1fs) from %s"), pReplay->GetReader().GetNumSamples(),
+		(pReplay->GetReader().GetEndTime() - pReplay->GetReader().GetStartTime()) * 1.0e-9, *Filename);
+
+	m_pReplay = MoveTemp(pReplay);
+	m_fReplayElapsed = 0.0;
+	m_fReplaySeekSeconds = -1.0;
+	m_bReplayPaused = false;
+	m_hReplayTick = FCoreDelegates::OnBeginFrame.AddRaw(this, &FOpenXRViveTrackerModule::TickReplay);
+
+#if WITH_EDITOR
+	// Tracker components of levels being edited follow the replay, StopReplay puts them back
+	for (TObjectIterator<UViveTrackerComponent> itComponent; itComponent; ++itComponent)
+	{
+		itComponent->SaveEditorTransform();
+	}
+#endif
+	return true;
+}
+
+void FOpenXRViveTrackerModule::StopReplay()
+{
+	if (!m_pReplay)
+		return;
+
+	FCoreDelegates::OnBeginFrame.Remove(m_hReplayTick);
+	m_hReplayTick.Reset();
+
+	{
+		FScopeLock poseLock(&m_poseLock);
+		m_pReplay.Reset();
+		m_mapPersistentPathRoles = MoveTemp(m_mapLivePersistentPathRoles);
+		m_mapLivePersistentPathRoles.Reset();
+		RebuildRoleOverrides();
+		ResetTrackerSamples();
+		m_nTrackerPathsGeneration++;
+	}
+
+#if WITH_EDITOR
+	// Nothing is left to restore once the object system is gone at shutdown
+	if (UObjectInitialized())
+	{
+		for (TObjectIterator<UViveTrackerComponent> itComponent; itComponent; ++itComponent)
 		{
-			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to create an action space for action %s. Runtime returned error (%i)"), 
-				*FString(UTF8_TO_TCHAR(pName)), (int32_t) (result));
-			return XR_NULL_HANDLE;
+			itComponent->RestoreEditorTransform();
 		}
 	}
+#endif
+
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Tracker replay stopped"));
+}
+
+bool FOpenXRViveTrackerModule::IsReplayFinished() const
+{
+	return m_pReplay && m_pReplay->IsFinished();
+}
+
+void FOpenXRViveTrackerModule::SeekReplay(double Seconds)
+{
+	if (m_pReplay)
+	{
+		m_fReplaySeekSeconds = FMath::Clamp(Seconds, 0.0, GetReplayDuration());
+	}
+}
+
+double FOpenXRViveTrackerModule::GetReplayPosition() const
+{
+	if (!m_pReplay)
+		return 0.0;
+
+	return FMath::Min(m_fReplaySeekSeconds >= 0.0 ? m_fReplaySeekSeconds : m_fReplayElapsed, GetReplayDuration());
+}
+
+double FOpenXRViveTrackerModule::GetReplayDuration() const
+{
+	return m_pReplay ? (m_pReplay->GetReader().GetEndTime() - m_pReplay->GetReader().GetStartTime()) * 1.0e-9 : 0.0;
+}
+
+const FViveTrackerReplaySettings* FOpenXRViveTrackerModule::GetReplaySettings() const
+{
+	return m_pReplay ? &m_pReplay->GetSettings() : nullptr;
+}
+
+void FOpenXRViveTrackerModule::SetReplaySettings(const FViveTrackerReplaySettings& Settings)
+{
+	if (m_pReplay)
+	{
+		m_pReplay->SetSettings(Settings);
+	}
+}
+
+void FOpenXRViveTrackerModule::TickReplay()
+{
+	if (!m_pReplay)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ViveTracker_Replay);
+
+	// Follows the engine clock, or a fixed step for deterministic runs
+	const FViveTrackerReplaySettings& replaySettings = m_pReplay->GetSettings();
+	const bool bSeeking = m_fReplaySeekSeconds >= 0.0;
+	if (bSeeking)
+	{
+		m_fReplayElapsed = m_fReplaySeekSeconds;
+		m_fReplaySeekSeconds = -1.0;
+	}
+	else if (!m_bReplayPaused)
+	{
+		m_fReplayElapsed += (replaySettings.FixedStepSeconds > 0.f ? replaySettings.FixedStepSeconds : FApp::GetDeltaTime()) * replaySettings.PlaybackRate;
+	}
 	else
 	{
-		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to create action %s. Runtime returned error (%i)"),
-			*FString(UTF8_TO_TCHAR(pName)), (int32_t)(result));
-		return XR_NULL_HANDLE;
+		return;
+	}
+	const XrTime replayTime = m_pReplay->GetReader().GetStartTime() + (XrTime)(m_fReplayElapsed * 1.0e9);
+
+	// Events are handled once the lock is released, they call out to game code
+	TArray<ViveTrackerCore::FCaptureEvent, TInlineAllocator<16>> arrEvents;
+	{
+		FScopeLock poseLock(&m_poseLock);
+
+		// Starts over from the keyframe before the time, everything up to it is applied within this frame
+		if (bSeeking)
+		{
+			ResetTrackerSamples();
+			m_pReplay->Seek(replayTime);
+		}
+
+		m_pReplay->Advance(replayTime,
+			[this](const ViveTrackerCore::FCaptureSample& captureSample) { ApplyReplaySample(captureSample); },
+			[&arrEvents, bSeeking](const ViveTrackerCore::FCaptureEvent& captureEvent)
+			{
+				if (!bSeeking || captureEvent.Type == ViveTrackerCore::ECaptureEvent::PathsChanged)
+				{
+					arrEvents.Add(captureEvent);
+				}
+			});
+		m_predictedDisplayTime = replayTime;
+	}
+
+	for (const ViveTrackerCore::FCaptureEvent& captureEvent : arrEvents)
+	{
+		ApplyReplayEvent(captureEvent);
 	}
 
-	return xrAction;
+	if (replaySettings.bLoop && !m_bReplayPaused && m_pReplay->IsFinished())
+	{
+		FScopeLock poseLock(&m_poseLock);
+		ResetTrackerSamples();
+		m_pReplay->Seek(m_pReplay->GetReader().GetStartTime());
+		m_fReplayElapsed = 0.0;
+	}
 }
 
-void FOpenXRViveTrackerModule::CreateTrackerBinding(ETrackerRole role, XrAction xrAction)
+void FOpenXRViveTrackerModule::ApplyReplaySample(const ViveTrackerCore::FCaptureSample& captureSample)
 {
-	if (m_xrInstance == XR_NULL_HANDLE || xrAction == XR_NULL_HANDLE || m_bActionsGenerated)
+	// Callers hold m_poseLock. Same as a located sample in PostSyncActions, lost tracking only updates the flags.
+	if (captureSample.Role >= (uint8)ETrackerRole::Unassigned)
 		return;
 
-	
-	FString sInputPath;
-	switch (role)
+	const ETrackerRole role = (ETrackerRole)captureSample.Role;
+	FViveTrackerSample* trackerSample = m_mapTrackerSamples.Find(role);
+	if (!trackerSample)
+		return;
+
+	const FViveTrackerSample replayedSample = FViveTrackerCaptureReader::ToTrackerSample(captureSample);
+	trackerSample->LocationFlags = replayedSample.LocationFlags;
+
+	if (replayedSample.HasValidPose())
 	{
-	case Foot_L:
-		sInputPath = "/user/vive_tracker_htcx/role/left_foot/input/grip/pose";
-		break;
-	case Foot_R:
-		sInputPath = "/user/vive_tracker_htcx/role/right_foot/input/grip/pose";
-		break;
-	case Shoulder_L:
-		sInputPath = "/user/vive_tracker_htcx/role/left_shoulder/input/grip/pose";
-		break;
-	case Shoulder_R:
-		sInputPath = "/user/vive_tracker_htcx/role/right_shoulder/input/grip/pose";
-		break;
-	case Elbow_L:
-		sInputPath = "/user/vive_tracker_htcx/role/left_elbow/input/grip/pose";
-		break;
-	case Elbow_R:
-		sInputPath = "/user/vive_tracker_htcx/role/right_elbow/input/grip/pose";
-		break;
-	case Knee_L:
-		sInputPath = "/user/vive_tracker_htcx/role/left_knee/input/grip/pose";
-		break;
-	case Knee_R:
-		sInputPath = "/user/vive_tracker_htcx/role/right_knee/input/grip/pose";
-		break;
-	case Waist:
-		sInputPath = "/user/vive_tracker_htcx/role/waist/input/grip/pose";
-		break;
-	case Chest:
-		sInputPath = "/user/vive_tracker_htcx/role/chest/input/grip/pose";
+		*trackerSample = replayedSample;
+
+		FViveTrackerPoseHistory* trackerHistory = m_mapTrackerHistory.Find(role);
+		if (trackerHistory)
+		{
+			trackerHistory->Push(replayedSample);
+		}
+
+		VIVETRACKER_TRACE_POSE(role, replayedSample);
+	}
+}
+
+void FOpenXRViveTrackerModule::ApplyReplayEvent(const ViveTrackerCore::FCaptureEvent& captureEvent)
+{
+	const TArray<FViveTrackerCaptureTracker>& arrTrackers = m_pReplay->GetReader().GetTrackers();
+	const FString sPersistentPath = arrTrackers.IsValidIndex(captureEvent.TrackerId) ? arrTrackers[captureEvent.TrackerId].PersistentPath : FString();
+	const ETrackerRole role = captureEvent.Role < (uint8)ETrackerRole::Unassigned ? (ETrackerRole)captureEvent.Role : ETrackerRole::Unassigned;
+
+	switch (captureEvent.Type)
+	{
+	case ViveTrackerCore::ECaptureEvent::Connected:
+		UE_LOG(LogOpenXRViveTracker, Display, TEXT("Replayed tracker connected event for [%s] with role [%s]"),
+			*sPersistentPath, *StaticEnum<ETrackerRole>()->GetNameStringByValue(role));
+		m_onTrackerConnected.Broadcast(sPersistentPath, role);
 		break;
-	case Camera:
-		sInputPath = "/user/vive_tracker_htcx/role/camera/input/grip/pose";
+
+	case ViveTrackerCore::ECaptureEvent::PathsChanged:
+		m_nTrackerPathsGeneration++;
 		break;
-	case Keyboard:
-		sInputPath = "/user/vive_tracker_htcx/role/keyboard/input/grip/pose";
+
+	case ViveTrackerCore::ECaptureEvent::SamplesDropped:
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Replayed capture dropped %u tracker samples here"), captureEvent.Value);
 		break;
-	case Unassigned:
+
 	default:
-		return;
 		break;
 	}
+}
 
+void FOpenXRViveTrackerModule::ResetTrackerSamples()
+{
+	// Callers hold m_poseLock
+	for (TPair<ETrackerRole, FViveTrackerSample>& trackerSample : m_mapTrackerSamples)
+	{
+		trackerSample.Value = FViveTrackerSample();
+	}
 
-	XrPath xrPath;
-	XrResult result = xrStringToPath(m_xrInstance, TCHAR_TO_UTF8(*sInputPath), &xrPath);
+	for (TPair<ETrackerRole, FViveTrackerPoseHistory>& trackerHistory : m_mapTrackerHistory)
+	{
+		trackerHistory.Value.Reset();
+	}
+}
+
+FTransform FOpenXRViveTrackerModule::GetTrackerTransform(ETrackerRole trackerRole)
+{
+	FScopeLock poseLock(&m_poseLock);
+
+	const ETrackerRole boundRole = GetBoundRole(trackerRole);
+	if (boundRole == ETrackerRole::Unassigned)
+		return FTransform::Identity;
+
+	const FViveTrackerSample* trackerSample = m_mapTrackerSamples.Find(boundRole);
+	if (trackerSample)
+		return trackerSample->Transform;
+
+	// Called per role every frame, a role that was never sampled is expected and not worth a log line
+	return FTransform::Identity;
+}
+
+bool FOpenXRViveTrackerModule::GetTrackerSample(ETrackerRole trackerRole, FViveTrackerSample& OutSample) const
+{
+	FScopeLock poseLock(&m_poseLock);
 
-	if (result == XR_SUCCESS)
+	const FViveTrackerSample* trackerSample = m_mapTrackerSamples.Find(GetBoundRole(trackerRole));
+	if (trackerSample)
 	{
-		// Add action binding
-		XrActionSuggestedBinding xrActionSuggestedBinding;
-		xrActionSuggestedBinding.action = xrAction;
-		xrActionSuggestedBinding.binding = xrPath;
-		m_arrActionBindings.Add(xrActionSuggestedBinding);
+		OutSample = *trackerSample;
+		return true;
+	}
+
+	return false;
+}
+
+bool FOpenXRViveTrackerModule::GetTrackerTransformAtTime(ETrackerRole trackerRole, XrTime Time, FTransform& OutTransform) const
+{
+	FScopeLock poseLock(&m_poseLock);
+
+	return EvaluateHistory(m_mapTrackerHistory.Find(GetBoundRole(trackerRole)), Time, OutTransform);
+}
+
+void FOpenXRViveTrackerModule::GetTrackerSamples(TArrayView<const ETrackerRole> Roles, TArrayView<FViveTrackerSample> OutSamples) const
+{
+	check(OutSamples.Num() >= Roles.Num());
+
+	FScopeLock poseLock(&m_poseLock);
+
+	for (int32 nRole = 0; nRole < Roles.Num(); nRole++)
+	{
+		const FViveTrackerSample* trackerSample = m_mapTrackerSamples.Find(GetBoundRole(Roles[nRole]));
+		OutSamples[nRole] = trackerSample ? *trackerSample : FViveTrackerSample();
+	}
+}
+
+bool FOpenXRViveTrackerModule::GetTrackerRoleFromPersistentPath(const FString& PersistentPath, ETrackerRole& OutRole) const
+{
+	FScopeLock poseLock(&m_poseLock);
+
+	const ETrackerRole* pRole = m_mapPersistentPathRoles.Find(PersistentPath);
+	if (pRole)
+	{
+		OutRole = GetPathRole(PersistentPath, *pRole);
+		return true;
+	}
+
+	return false;
+}
+
+void FOpenXRViveTrackerModule::GetTrackerPersistentPaths(TArray<FString>& OutPersistentPaths, TArray<ETrackerRole>& OutRoles) const
+{
+	FScopeLock poseLock(&m_poseLock);
+
+	OutPersistentPaths.Reset(m_mapPersistentPathRoles.Num());
+	OutRoles.Reset(m_mapPersistentPathRoles.Num());
+
+	for (const TPair<FString, ETrackerRole>& pathRole : m_mapPersistentPathRoles)
+	{
+		OutPersistentPaths.Add(pathRole.Key);
+		OutRoles.Add(GetPathRole(pathRole.Key, pathRole.Value));
+	}
+}
+
+XrTime FOpenXRViveTrackerModule::GetSubstepTime(float StepDeltaTime, int32 SubstepIndex, int32 NumSubsteps) const
+{
+	// The display time is written by the frame and by replay under the lock
+	FScopeLock poseLock(&m_poseLock);
+
+	return GetSubstepTime(m_predictedDisplayTime, StepDeltaTime, SubstepIndex, NumSubsteps);
+}
+
+XrTime FOpenXRViveTrackerModule::GetSubstepTime(XrTime StepEndTime, float StepDeltaTime, int32 SubstepIndex, int32 NumSubsteps)
+{
+	const XrTime StepNs = (XrTime)((double)StepDeltaTime * 1.0e9);
+	const int32 Substeps = FMath::Max(NumSubsteps, 1);
+	return StepEndTime - StepNs + (StepNs * (SubstepIndex + 1)) / Substeps;
+}
+
+void FOpenXRViveTrackerModule::GetTrackerSubstepTransforms(TArrayView<const ETrackerRole> Roles, float StepDeltaTime, int32 NumSubsteps, TArrayView<FTransform> OutTransforms) const
+{
+	check(OutTransforms.Num() >= Roles.Num() * NumSubsteps);
 
-		// Add to tracker roles map
-		m_mapTrackerRoles.Add(xrAction, role);
-		UE_LOG(LogOpenXRViveTracker, Display, TEXT("... bound to [%s]"), *sInputPath);
+	FScopeLock poseLock(&m_poseLock);
+
+	// Every substep of the batch is relative to the same display time
+	const XrTime StepEndTime = m_predictedDisplayTime;
+	for (int32 nSubstep = 0; nSubstep < NumSubsteps; nSubstep++)
+	{
+		const XrTime SubstepTime = GetSubstepTime(StepEndTime, StepDeltaTime, nSubstep, NumSubsteps);
+
+		for (int32 nRole = 0; nRole < Roles.Num(); nRole++)
+		{
+			FTransform& OutTransform = OutTransforms[nSubstep * Roles.Num() + nRole];
+
+			if (!EvaluateHistory(m_mapTrackerHistory.Find(GetBoundRole(Roles[nRole])), SubstepTime, OutTransform))
+			{
+				OutTransform = FTransform::Identity;
+			}
+		}
+	}
+}
+
+bool FOpenXRViveTrackerModule::EvaluateHistory(const FViveTrackerPoseHistory* trackerHistory, XrTime Time, FTransform& OutTransform) const
+{
+	// Callers hold m_poseLock
+	if (!trackerHistory || trackerHistory->Num() == 0)
+		return false;
+
+	if (!m_bPoseFilter)
+	{
+		OutTransform = trackerHistory->Get(0).Transform;
+		return true;
 	}
+
+	return trackerHistory->Evaluate(Time, OutTransform);
+}
+
+const char* FOpenXRViveTrackerModule::GetTrackerRolePath(ETrackerRole role)
+{
+	return ViveTrackerCore::GetTrackerRolePath((int32)role);
+}
+
+ETrackerRole FOpenXRViveTrackerModule::GetTrackerRoleFromPath(const char* pRolePath)
+{
+	return (ETrackerRole)ViveTrackerCore::FindTrackerRole(pRolePath);
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,188 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerClock.h"
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerXrProfiler.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include "Windows/WindowsHWrapper.h"
+#include "Windows/HideWindowsPlatformTypes.h"
+typedef XrResult(XRAPI_PTR* PFN_ViveTrackerPlatformToXrTime)(XrInstance instance, const LARGE_INTEGER* performanceCounter, XrTime* time);
+#define VIVETRACKER_CONVERT_FUNCTION_NAME "xrConvertWin32PerformanceCounterToTimeKHR"
+#define VIVETRACKER_CONVERT_EXTENSION_NAME "XR_KHR_win32_convert_performance_counter_time"
+#else
+#include <time.h>
+typedef XrResult(XRAPI_PTR* PFN_ViveTrackerPlatformToXrTime)(XrInstance instance, const struct timespec* timespecTime, XrTime* time);
+#define VIVETRACKER_CONVERT_FUNCTION_NAME "xrConvertTimespecTimeToTimeKHR"
+#define VIVETRACKER_CONVERT_EXTENSION_NAME "XR_KHR_convert_timespec_time"
+#endif
+
+static constexpr int64 NanosecondsPerSecond = 1000 * 1000 * 1000;
+
+#if PLATFORM_WINDOWS
+static int64 GetPerformanceFrequency()
+{
+	static const int64 nFrequency = []()
+	{
+		LARGE_INTEGER Frequency;
+		QueryPerformanceFrequency(&Frequency);
+		return (int64)Frequency.QuadPart;
+	}();
+	return nFrequency;
+}
+#endif
+
+const char* FViveTrackerClock::GetExtensionName()
+{
+	return VIVETRACKER_CONVERT_EXTENSION_NAME;
+}
+
+const TCHAR* FViveTrackerClock::GetConvertFunctionName()
+{
+	return TEXT(VIVETRACKER_CONVERT_FUNCTION_NAME);
+}
+
+int64 FViveTrackerClock::GetPlatformTimeNs()
+{
+#if PLATFORM_WINDOWS
+	LARGE_INTEGER Counter;
+	QueryPerformanceCounter(&Counter);
+	const int64 nFrequency = GetPerformanceFrequency();
+	return (Counter.QuadPart / nFrequency) * NanosecondsPerSecond + ((Counter.QuadPart % nFrequency) * NanosecondsPerSecond) / nFrequency;
+#else
+	struct timespec Now;
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (int64)Now.tv_sec * NanosecondsPerSecond + (int64)Now.tv_nsec;
+#endif
+}
+
+bool FViveTrackerClock::Initialize(XrInstance InInstance)
+{
+	Reset();
+	m_xrInstance = InInstance;
+
+	// The entry point is only available if the runtime enabled the matching optional extension
+	XrResult result = xrGetInstanceProcAddr(m_xrInstance, VIVETRACKER_CONVERT_FUNCTION_NAME, &m_pfnPlatformToXrTime);
+	if (result != XR_SUCCESS || m_pfnPlatformToXrTime == nullptr)
+	{
+		m_pfnPlatformToXrTime = nullptr;
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Runtime doesn't support %s (%i). Tracker samples won't carry platform timestamps."),
+			TEXT(VIVETRACKER_CONVERT_FUNCTION_NAME), (int32_t)result);
+		return false;
+	}
+
+	Update();
+	return IsValid();
+}
+
+void FViveTrackerClock::Reset()
+{
+	*this = FViveTrackerClock();
+}
+
+bool FViveTrackerClock::QueryRuntime(int64 PlatformTimeNs, XrTime& OutXrTime) const
+{
+	if (m_pfnPlatformToXrTime == nullptr)
+		return false;
+
+	PFN_ViveTrackerPlatformToXrTime pfnConvert = (PFN_ViveTrackerPlatformToXrTime)m_pfnPlatformToXrTime;
+	VIVETRACKER_XR_CALL_SCOPE(ConvertTime);
+
+#if PLATFORM_WINDOWS
+	const int64 nFrequency = GetPerformanceFrequency();
+	LARGE_INTEGER Counter;
+	Counter.QuadPart = (PlatformTimeNs / NanosecondsPerSecond) * nFrequency + ((PlatformTimeNs % NanosecondsPerSecond) * nFrequency) / NanosecondsPerSecond;
+	return pfnConvert(m_xrInstance, &Counter, &OutXrTime) == XR_SUCCESS;
+#else
+	struct timespec PlatformTime;
+	PlatformTime.tv_sec = (time_t)(PlatformTimeNs / NanosecondsPerSecond);
+	PlatformTime.tv_nsec = (long)(PlatformTimeNs % NanosecondsPerSecond);
+	return pfnConvert(m_xrInstance, &PlatformTime, &OutXrTime) == XR_SUCCESS;
+#endif
+}
+
+void FViveTrackerClock::Update()
+{
+	const int64 nNow = GetPlatformTimeNs();
+	if (m_nSamples > 0 && nNow - m_nLastSamplePlatformTime < SampleIntervalNs)
+		return;
+
+	XrTime xrTime = 0;
+	if (!QueryRuntime(nNow, xrTime))
+		return;
+
+	if (m_nSamples == 0)
+	{
+		m_nPlatformOrigin = nNow;
+		m_nXrOrigin = xrTime;
+	}
+
+	m_nLastSamplePlatformTime = nNow;
+	m_nSamples++;
+
+	// Exponentially weighted running means and co-moments, relative to the first sample
+	const double x = (double)(nNow - m_nPlatformOrigin);
+	const double y = (double)(xrTime - m_nXrOrigin);
+
+	m_fWeight = m_fWeight * ForgettingFactor + 1.0;
+	const double dx = x - m_fMeanPlatform;
+	m_fMeanPlatform += dx / m_fWeight;
+	m_fMeanXr += (y - m_fMeanXr) / m_fWeight;
+	m_fVarPlatform = m_fVarPlatform * ForgettingFactor + dx * (x - m_fMeanPlatform);
+	m_fCovar = m_fCovar * ForgettingFactor + dx * (y - m_fMeanXr);
+
+	// Until the samples span a measurable interval, assume both clocks tick at the same rate
+	if (m_fVarPlatform > 1.0)
+	{
+		m_fSlope = FMath::Clamp(m_fCovar / m_fVarPlatform, 1.0 - MaxDrift, 1.0 + MaxDrift);
+	}
+}
+
+int64 FViveTrackerClock::XrTimeToPlatformTime(XrTime Time) const
+{
+	if (!IsValid() || Time == 0)
+		return 0;
+
+	const double y = (double)(Time - m_nXrOrigin);
+	return m_nPlatformOrigin + (int64)FMath::RoundToDouble(m_fMeanPlatform + (y - m_fMeanXr) / m_fSlope);
+}
+
+XrTime FViveTrackerClock::PlatformTimeToXrTime(int64 PlatformTimeNs) const
+{
+	if (!IsValid() || PlatformTimeNs == 0)
+		return 0;
+
+	const double x = (double)(PlatformTimeNs - m_nPlatformOrigin);
+	return m_nXrOrigin + (XrTime)FMath::RoundToDouble(m_fMeanXr + (x - m_fMeanPlatform) * m_fSlope);
+}
+
+#undef VIVETRACKER_CONVERT_FUNCTION_NAME
+#undef VIVETRACKER_CONVERT_EXTENSION_NAME
@@ -30,12 +30,17 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "ViveTrackerComponent.h"
 #include "OpenXRViveTracker.h"
+#include "ViveTrackerStats.h"
+#include "Engine/World.h"
 
 // Sets default values for this component's properties
 UViveTrackerComponent::UViveTrackerComponent()
 {
 	// Set this component to be initialized when the game starts.
 	PrimaryComponentTick.bCanEverTick = true;
+
+	// Follows tracker replays in the editor's level viewports too, see TickComponent
+	bTickInEditor = true;
 }
 
 
@@ -54,8 +59,55 @@ void UViveTrackerComponent::TickComponent(float DeltaTime, ELevelTick TickType,
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
+	SCOPE_CYCLE_COUNTER(STAT_ViveTracker_Component);
+
+	// BeginPlay doesn't run for components of a level being edited, which only move while a capture is replayed
+	if (!m_trackerModule)
+	{
+		m_trackerModule = &FOpenXRViveTrackerModule::Get();
+	}
+
+	if (TickType == LEVELTICK_ViewportsOnly && !m_trackerModule->IsReplaying())
+		return;
+
+	// Roles without a sample stay where they are rather than jumping to the origin
+	FViveTrackerSample sample;
+	if (!m_trackerModule->GetTrackerSample(TrackerRole, sample))
+		return;
+
+#if WITH_EDITOR
+	// Components added to the level while replaying weren't saved when the replay started
+	if (TickType == LEVELTICK_ViewportsOnly)
+	{
+		SaveEditorTransform();
+	}
+#endif
+
 	// Update this scene component's location and orientation from values obtained from the runtime
-	FTransform transform = m_trackerModule->GetTrackerTransform(TrackerRole);
-	SetWorldLocationAndRotation(transform.GetLocation() + PlayerStartLocation, transform.GetRotation() );
+	SetWorldLocationAndRotation(sample.Transform.GetLocation() + PlayerStartLocation, sample.Transform.GetRotation() );
+
+	// Sampled poses carry their sample time, for latency measurements
+	m_trackerModule->NotifySampleConsumed(sample);
+}
+
+#if WITH_EDITOR
+void UViveTrackerComponent::SaveEditorTransform()
+{
+	const UWorld* pWorld = GetWorld();
+	if (m_bEditorTransformSaved || !pWorld || pWorld->WorldType != EWorldType::Editor)
+		return;
+
+	m_editorTransform = GetRelativeTransform();
+	m_bEditorTransformSaved = true;
+}
+
+void UViveTrackerComponent::RestoreEditorTransform()
+{
+	if (!m_bEditorTransformSaved)
+		return;
+
+	SetRelativeTransform(m_editorTransform);
+	m_bEditorTransformSaved = false;
 }
+#endif
 
@@ -0,0 +1,426 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerCore/ViveTrackerCalibration.h"
+#include "ViveTrackerMath.h"
+
+namespace ViveTrackerCore
+{
+	/** Unknowns of the proportion fit, in FBodySkeleton order */
+	enum ELength { Length_Thigh, Length_Shin, Length_Spine, Length_Neck, Length_UpperArm, Length_LowerArm, Length_ShoulderHalf, Length_HipHalf, Length_Count };
+
+	/** Segment lengths as ratios of standing height, after Drillis and Contini, measured to the solver's joints */
+	static const float LengthRatios[Length_Count] = { 0.245f, 0.246f, 0.288f, 0.118f, 0.186f, 0.160f, 0.105f, 0.055f };
+	static constexpr float EyeHeightRatio = 0.936f;
+	static constexpr float AnkleHeightRatio = 0.039f;
+
+	/** Weight of the anthropometric priors relative to measurements, keeps lengths without measurements at their ratio */
+	static constexpr float PriorWeight = 0.1f;
+
+	/** Number of relinearizations of the arm measurements, which depend on the shoulder estimate */
+	static constexpr int NumFitIterations = 3;
+
+	/** Accumulates weighted normal equations of a small linear least-squares problem */
+	struct FLengthFit
+	{
+		double AtA[Length_Count][Length_Count] = {};
+		double Atb[Length_Count] = {};
+
+		/** Measurements are kept to report their residuals */
+		struct FRow { float Coefficients[Length_Count]; float Value; };
+		FRow Rows[16];
+		int NumRows = 0;
+
+		void Add(const float(&Coefficients)[Length_Count], float Value, float Weight)
+		{
+			for (int i = 0; i < Length_Count; i++)
+			{
+				for (int j = 0; j < Length_Count; j++)
+				{
+					AtA[i][j] += Weight * Coefficients[i] * Coefficients[j];
+				}
+				Atb[i] += Weight * Coefficients[i] * Value;
+			}
+		}
+
+		void AddMeasurement(const float(&Coefficients)[Length_Count], float Value)
+		{
+			Add(Coefficients, Value, 1.f);
+			if (NumRows < (int)(sizeof(Rows) / sizeof(Rows[0])))
+			{
+				FRow& Row = Rows[NumRows++];
+				for (int i = 0; i < Length_Count; i++)
+				{
+					Row.Coefficients[i] = Coefficients[i];
+				}
+				Row.Value = Value;
+			}
+		}
+
+		/** Cholesky solve, the priors keep AtA positive definite */
+		bool Solve(float(&OutLengths)[Length_Count]) const
+		{
+			double L[Length_Count][Length_Count] = {};
+			for (int i = 0; i < Length_Count; i++)
+			{
+				for (int j = 0; j <= i; j++)
+				{
+					double Sum = AtA[i][j];
+					for (int k = 0; k < j; k++)
+					{
+						Sum -= L[i][k] * L[j][k];
+					}
+
+					if (i == j)
+					{
+						if (Sum <= 0.0)
+							return false;
+						L[i][i] = std::sqrt(Sum);
+					}
+					else
+					{
+						L[i][j] = Sum / L[j][j];
+					}
+				}
+			}
+
+			double Y[Length_Count];
+			for (int i = 0; i < Length_Count; i++)
+			{
+				double Sum = Atb[i];
+				for (int k = 0; k < i; k++)
+				{
+					Sum -= L[i][k] * Y[k];
+				}
+				Y[i] = Sum / L[i][i];
+			}
+
+			for (int i = Length_Count - 1; i >= 0; i--)
+			{
+				double Sum = Y[i];
+				for (int k = i + 1; k < Length_Count; k++)
+				{
+					Sum -= L[k][i] * OutLengths[k];
+				}
+				OutLengths[i] = (float)(Sum / L[i][i]);
+			}
+			return true;
+		}
+
+		float ResidualRMS(const float(&Lengths)[Length_Count]) const
+		{
+			if (NumRows == 0)
+				return 0.f;
+
+			double SumSq = 0.0;
+			for (int r = 0; r < NumRows; r++)
+			{
+				double Predicted = 0.0;
+				for (int i = 0; i < Length_Count; i++)
+				{
+					Predicted += Rows[r].Coefficients[i] * Lengths[i];
+				}
+				SumSq += (Predicted - Rows[r].Value) * (Predicted - Rows[r].Value);
+			}
+			return (float)std::sqrt(SumSq / NumRows);
+		}
+	};
+
+	void FBodyCalibrator::FPoseSum::Add(const FPose& Pose)
+	{
+		if (Count == 0)
+		{
+			Reference = Pose.Rotation;
+		}
+
+		// q and -q are the same rotation, keep every sample in the reference's hemisphere so they average
+		const FQuat4& Q = Pose.Rotation;
+		const float Sign = (Q.X * Reference.X + Q.Y * Reference.Y + Q.Z * Reference.Z + Q.W * Reference.W) < 0.f ? -1.f : 1.f;
+
+		Position[0] += Pose.Position.X;
+		Position[1] += Pose.Position.Y;
+		Position[2] += Pose.Position.Z;
+		PositionSq += (double)Dot(Pose.Position, Pose.Position);
+		Rotation[0] += Sign * Q.X;
+		Rotation[1] += Sign * Q.Y;
+		Rotation[2] += Sign * Q.Z;
+		Rotation[3] += Sign * Q.W;
+		Count++;
+	}
+
+	FPose FBodyCalibrator::FPoseSum::Mean() const
+	{
+		// The normalized sum is the chordal least-squares mean for the small spreads of a held pose
+		FPose Pose;
+		const double Inv = Count > 0 ? 1.0 / Count : 0.0;
+		Pose.Position = { (float)(Position[0] * Inv), (float)(Position[1] * Inv), (float)(Position[2] * Inv) };
+		Pose.Rotation = Normalize(FQuat4{ (float)Rotation[0], (float)Rotation[1], (float)Rotation[2], (float)Rotation[3] });
+		return Pose;
+	}
+
+	float FBodyCalibrator::FPoseSum::Deviation() const
+	{
+		if (Count == 0)
+			return 0.f;
+
+		const double Inv = 1.0 / Count;
+		const double MeanSq = (Position[0] * Position[0] + Position[1] * Position[1] + Position[2] * Position[2]) * Inv * Inv;
+		const double Variance = PositionSq * Inv - MeanSq;
+		return Variance > 0.0 ? (float)std::sqrt(Variance) : 0.f;
+	}
+
+	void FBodyCalibrator::Reset()
+	{
+		for (FPoseSum& Sum : m_sums)
+		{
+			Sum = FPoseSum();
+		}
+		m_nFrames = 0;
+	}
+
+	void FBodyCalibrator::AddFrame(const FCalibrationFrame& Frame)
+	{
+		// Everything is measured relative to the head
+		if (!Frame.bHeadValid)
+			return;
+
+		m_sums[Sum_Head].Add(Frame.Head);
+
+		for (int Side = 0; Side < 2; Side++)
+		{
+			if (Frame.bHandsValid[Side])
+			{
+				m_sums[Sum_Hand_L + Side].Add(Frame.Hands[Side]);
+			}
+		}
+
+		for (int i = 0; i < (int)EBodyTracker::Count; i++)
+		{
+			if (Frame.ValidMask & (1u << i))
+			{
+				m_sums[i].Add(Frame.Trackers[i]);
+			}
+		}
+
+		m_nFrames++;
+	}
+
+	bool FBodyCalibrator::Solve(const FBodySkeleton& Skeleton, float MaxMotion, FCalibrationResult& OutResult) const
+	{
+		OutResult = FCalibrationResult();
+		OutResult.Skeleton = Skeleton;
+
+		if (m_nFrames == 0)
+			return false;
+
+		// Poses seen in less than half of the frames flickered during capture and are left out
+		FPose Means[Sum_Count];
+		bool bValid[Sum_Count];
+		for (int i = 0; i < Sum_Count; i++)
+		{
+			bValid[i] = m_sums[i].Count * 2 >= m_nFrames;
+			if (!bValid[i])
+				continue;
+
+			Means[i] = m_sums[i].Mean();
+			const float Deviation = m_sums[i].Deviation();
+			OutResult.MaxMotion = Deviation > OutResult.MaxMotion ? Deviation : OutResult.MaxMotion;
+		}
+
+		if (OutResult.MaxMotion > MaxMotion)
+			return false;
+
+		auto IsTrackerValid = [&bValid](EBodyTracker Tracker) { return bValid[(int)Tracker]; };
+		auto TrackerMean = [&Means](EBodyTracker Tracker) -> const FPose& { return Means[(int)Tracker]; };
+
+		const FVec3 Up = SafeNormal(Skeleton.Up, FVec3{ 0.f, 0.f, 1.f });
+		const FVec3 HeadForward = Rotate(Means[Sum_Head].Rotation, Skeleton.Forward);
+		const FVec3 Forward = SafeNormal(HeadForward - Up * Dot(HeadForward, Up), Skeleton.Forward);
+		const FVec3 Left = Cross(Forward, Up);
+		const FVec3 HeadPosition = Means[Sum_Head].Position;
+		const float HeadLevel = Dot(HeadPosition, Up);
+
+		// Height from the head over the ankles when both feet are tracked, otherwise over the floor at 0
+		const bool bFeetValid = IsTrackerValid(EBodyTracker::Foot_L) && IsTrackerValid(EBodyTracker::Foot_R);
+		float Height, AnkleLevel;
+		if (bFeetValid)
+		{
+			AnkleLevel = 0.5f * (Dot(TrackerMean(EBodyTracker::Foot_L).Position, Up) + Dot(TrackerMean(EBodyTracker::Foot_R).Position, Up));
+			Height = (HeadLevel - AnkleLevel) / (EyeHeightRatio - AnkleHeightRatio);
+		}
+		else
+		{
+			Height = HeadLevel / EyeHeightRatio;
+			AnkleLevel = Height * AnkleHeightRatio;
+		}
+
+		if (Height <= 0.f)
+			return false;
+
+		// Start from the priors, then refit with the shoulders placed by the previous iteration
+		float Lengths[Length_Count];
+		for (int i = 0; i < Length_Count; i++)
+		{
+			Lengths[i] = LengthRatios[i] * Height;
+		}
+
+		FLengthFit Fit;
+		for (int Iteration = 0; Iteration < NumFitIterations; Iteration++)
+		{
+			Fit = FLengthFit();
+
+			for (int i = 0; i < Length_Count; i++)
+			{
+				float Prior[Length_Count] = {};
+				Prior[i] = 1.f;
+				Fit.Add(Prior, LengthRatios[i] * Height, PriorWeight);
+			}
+
+			// Vertical chain, head over pelvis over knees over ankles
+			Fit.AddMeasurement({ 1.f, 1.f, 1.f, 1.f, 0.f, 0.f, 0.f, 0.f }, HeadLevel - AnkleLevel);
+
+			if (IsTrackerValid(EBodyTracker::Pelvis))
+			{
+				Fit.AddMeasurement({ 1.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f }, Dot(TrackerMean(EBodyTracker::Pelvis).Position, Up) - AnkleLevel);
+			}
+
+			const EBodyTracker Knees[2] = { EBodyTracker::Knee_L, EBodyTracker::Knee_R };
+			for (EBodyTracker Knee : Knees)
+			{
+				if (IsTrackerValid(Knee))
+				{
+					Fit.AddMeasurement({ 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f }, Dot(TrackerMean(Knee).Position, Up) - AnkleLevel);
+				}
+			}
+
+			// Widths across the body
+			auto HalfSpan = [&Left](const FVec3& L, const FVec3& R) { return 0.5f * Dot(L - R, Left); };
+
+			if (IsTrackerValid(EBodyTracker::Shoulder_L) && IsTrackerValid(EBodyTracker::Shoulder_R))
+			{
+				Fit.AddMeasurement({ 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f },
+					HalfSpan(TrackerMean(EBodyTracker::Shoulder_L).Position, TrackerMean(EBodyTracker::Shoulder_R).Position));
+			}
+
+			if (bFeetValid)
+			{
+				Fit.AddMeasurement({ 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f },
+					HalfSpan(TrackerMean(EBodyTracker::Foot_L).Position, TrackerMean(EBodyTracker::Foot_R).Position));
+			}
+
+			// Arms measured from the current shoulder estimate, so T and A poses both work
+			const FVec3 Chest = HeadPosition - Up * Lengths[Length_Neck];
+			const EBodyTracker Elbows[2] = { EBodyTracker::Elbow_L, EBodyTracker::Elbow_R };
+			for (int Side = 0; Side < 2; Side++)
+			{
+				const FVec3 Shoulder = Chest + Left * (Lengths[Length_ShoulderHalf] * (Side == 0 ? 1.f : -1.f));
+
+				if (bValid[Sum_Hand_L + Side])
+				{
+					Fit.AddMeasurement({ 0.f, 0.f, 0.f, 0.f, 1.f, 1.f, 0.f, 0.f }, Length(Means[Sum_Hand_L + Side].Position - Shoulder));
+				}
+
+				if (IsTrackerValid(Elbows[Side]))
+				{
+					Fit.AddMeasurement({ 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f }, Length(TrackerMean(Elbows[Side]).Position - Shoulder));
+				}
+			}
+
+			if (!Fit.Solve(Lengths))
+				return false;
+
+			for (float& SegmentLength : Lengths)
+			{
+				SegmentLength = SegmentLength > 0.01f * Height ? SegmentLength : 0.01f * Height;
+			}
+		}
+
+		OutResult.Height = Height;
+		OutResult.ResidualRMS = Fit.ResidualRMS(Lengths);
+		OutResult.Skeleton.ThighLength = Lengths[Length_Thigh];
+		OutResult.Skeleton.ShinLength = Lengths[Length_Shin];
+		OutResult.Skeleton.SpineLength = Lengths[Length_Spine];
+		OutResult.Skeleton.NeckLength = Lengths[Length_Neck];
+		OutResult.Skeleton.UpperArmLength = Lengths[Length_UpperArm];
+		OutResult.Skeleton.LowerArmLength = Lengths[Length_LowerArm];
+		OutResult.Skeleton.ShoulderHalfWidth = Lengths[Length_ShoulderHalf];
+		OutResult.Skeleton.HipHalfWidth = Lengths[Length_HipHalf];
+
+		// Bones of the calibrated body in the captured pose, using the solver's bone axes
+		FPose Bones[(int)EBodyTracker::Count];
+		const FQuat4 TorsoRotation = MakeFromXZ(Up, Forward);
+		const FQuat4 LegRotation = MakeFromXZ(Up * -1.f, Forward);
+		const FVec3 ChestPosition = HeadPosition - Up * Lengths[Length_Neck];
+		const FVec3 PelvisPosition = ChestPosition - Up * Lengths[Length_Spine];
+
+		Bones[(int)EBodyTracker::Pelvis] = { TorsoRotation, PelvisPosition };
+		Bones[(int)EBodyTracker::Chest] = { TorsoRotation, ChestPosition };
+
+		for (int Side = 0; Side < 2; Side++)
+		{
+			const float Sign = Side == 0 ? 1.f : -1.f;
+
+			// Arms point at the tracked hand or elbow, straight out to the side otherwise
+			const FVec3 Shoulder = ChestPosition + Left * (Lengths[Length_ShoulderHalf] * Sign);
+			const EBodyTracker Elbow = Side == 0 ? EBodyTracker::Elbow_L : EBodyTracker::Elbow_R;
+			FVec3 ArmDirection = Left * Sign;
+			if (bValid[Sum_Hand_L + Side])
+			{
+				ArmDirection = SafeNormal(Means[Sum_Hand_L + Side].Position - Shoulder, ArmDirection);
+			}
+			else if (IsTrackerValid(Elbow))
+			{
+				ArmDirection = SafeNormal(TrackerMean(Elbow).Position - Shoulder, ArmDirection);
+			}
+			const FQuat4 ArmRotation = MakeFromXZ(ArmDirection, Forward * -1.f - Up * 0.5f);
+
+			const FVec3 Hip = PelvisPosition + Left * (Lengths[Length_HipHalf] * Sign);
+			const FVec3 Knee = Hip - Up * Lengths[Length_Thigh];
+
+			Bones[(int)(Side == 0 ? EBodyTracker::Shoulder_L : EBodyTracker::Shoulder_R)] = { ArmRotation, Shoulder };
+			Bones[(int)Elbow] = { ArmRotation, Shoulder + ArmDirection * Lengths[Length_UpperArm] };
+			Bones[(int)(Side == 0 ? EBodyTracker::Knee_L : EBodyTracker::Knee_R)] = { LegRotation, Knee };
+			Bones[(int)(Side == 0 ? EBodyTracker::Foot_L : EBodyTracker::Foot_R)] = { LegRotation, Knee - Up * Lengths[Length_Shin] };
+		}
+
+		// Offset of each bone in its tracker's frame
+		for (int i = 0; i < (int)EBodyTracker::Count; i++)
+		{
+			if (!bValid[i])
+				continue;
+
+			const FQuat4 InverseTracker = Conjugate(Means[i].Rotation);
+			OutResult.TrackerToBone[i].Rotation = Normalize(InverseTracker * Bones[i].Rotation);
+			OutResult.TrackerToBone[i].Position = Rotate(InverseTracker, Bones[i].Position - Means[i].Position);
+			OutResult.CalibratedMask |= 1u << i;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,747 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerCore/ViveTrackerCaptureCodec.h"
+#include "ViveTrackerSimd.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace ViveTrackerCore
+{
+	/** Samples per bit-packed block of residuals */
+	constexpr uint32_t PackedBlockSamples = 32;
+
+	/** Pose and velocity components, as four groups of four lanes */
+	constexpr uint32_t NumGroups = 4;
+	constexpr uint32_t NumLanes = NumGroups * 4;
+
+	/** Byte offset of each group in FCaptureSample. Groups overlap the next field by one lane, which is always zero. */
+	static const uint32_t GroupOffsets[NumGroups] = {
+		offsetof(FCaptureSample, Position),
+		offsetof(FCaptureSample, Rotation),
+		offsetof(FCaptureSample, LinearVelocity),
+		offsetof(FCaptureSample, AngularVelocity),
+	};
+	static_assert(offsetof(FCaptureSample, AngularVelocity) + 16 <= offsetof(FCaptureSample, VelocityFlags), "Lane stores must not reach fields written before them");
+
+	/** Groups whose fourth lane belongs to the next field */
+	static const bool GroupHasPadLane[NumGroups] = { true, false, true, true };
+
+	enum ECodecFlags : uint8_t
+	{
+		/** Trackers appear in the same order every frame, only the first frame's order is stored */
+		CodecFlag_PeriodicOrder = 1 << 0,
+	};
+
+	struct FCodecBlockHeader
+	{
+		uint32_t NumSamples;
+		uint16_t NumStreams;
+		uint8_t Flags;
+		uint8_t Reserved;
+		/** Quantization step per group */
+		float Steps[NumGroups];
+	};
+	static_assert(sizeof(FCodecBlockHeader) == 24, "Codec block header layout changed");
+
+	//------------------------------------------------------------------------------------------------
+	// Shared helpers
+
+	static uint32_t ZigZag32(uint32_t Value) { return (Value << 1) ^ (uint32_t)((int32_t)Value >> 31); }
+	static uint64_t ZigZag64(uint64_t Value) { return (Value << 1) ^ (uint64_t)((int64_t)Value >> 63); }
+	static uint64_t UnZigZag64(uint64_t Value) { return (Value >> 1) ^ (0 - (Value & 1)); }
+
+	static uint32_t BitWidth(uint32_t Value)
+	{
+		uint32_t nBits = 0;
+		while (Value)
+		{
+			nBits++;
+			Value >>= 1;
+		}
+		return nBits;
+	}
+
+	static uint32_t PackedFlags(const FCaptureSample& Sample)
+	{
+		return (uint32_t)Sample.LocationFlags | ((uint32_t)Sample.VelocityFlags << 8) | ((uint32_t)Sample.Role << 16);
+	}
+
+	static size_t Align4(size_t Size) { return (Size + 3) & ~(size_t)3; }
+
+	static void GetInverseSteps(const float Steps[NumGroups], float OutInverseSteps[NumGroups])
+	{
+		for (uint32_t nGroup = 0; nGroup < NumGroups; nGroup++)
+		{
+			OutInverseSteps[nGroup] = 1.f / Steps[nGroup];
+		}
+	}
+
+	/** Round to the nearest step, ties to even, out of range and NaN go to INT32_MIN like cvtps2dq */
+	static int32_t QuantizeScalar(float Value, float InverseStep)
+	{
+		const float Scaled = std::nearbyint(Value * InverseStep);
+		return (Scaled >= -2147483648.f && Scaled < 2147483648.f) ? (int32_t)Scaled : INT32_MIN;
+	}
+
+	static void QuantizeSample(const FCaptureSample& Sample, const float InverseSteps[NumGroups], int32_t OutLanes[NumLanes])
+	{
+		const uint8_t* pSample = reinterpret_cast<const uint8_t*>(&Sample);
+		for (uint32_t nGroup = 0; nGroup < NumGroups; nGroup++)
+		{
+			float Values[4];
+			memcpy(Values, pSample + GroupOffsets[nGroup], sizeof(Values));
+
+			for (uint32_t nLane = 0; nLane < 4; nLane++)
+			{
+				OutLanes[nGroup * 4 + nLane] = (GroupHasPadLane[nGroup] && nLane == 3) ? 0 : QuantizeScalar(Values[nLane], InverseSteps[nGroup]);
+			}
+		}
+	}
+
+	static void WriteVarint(uint8_t*& pOut, uint64_t Value)
+	{
+		while (Value >= 0x80)
+		{
+			*pOut++ = (uint8_t)(Value | 0x80);
+			Value >>= 7;
+		}
+		*pOut++ = (uint8_t)Value;
+	}
+
+	static bool ReadVarint(const uint8_t*& pIn, const uint8_t* pEnd, uint64_t& OutValue)
+	{
+		OutValue = 0;
+		for (uint32_t nShift = 0; nShift < 64; nShift += 7)
+		{
+			if (pIn >= pEnd)
+				return false;
+
+			const uint8_t Byte = *pIn++;
+			OutValue |= (uint64_t)(Byte & 0x7F) << nShift;
+			if ((Byte & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	/** Writes mostly zero values as alternating zero run lengths and zigzagged values, ending with a run */
+	struct FZeroRunWriter
+	{
+		uint8_t*& pOut;
+		uint64_t nRun = 0;
+
+		explicit FZeroRunWriter(uint8_t*& pInOut) : pOut(pInOut) {}
+
+		void Add(uint64_t Value)
+		{
+			if (Value == 0)
+			{
+				nRun++;
+				return;
+			}
+
+			WriteVarint(pOut, nRun);
+			WriteVarint(pOut, ZigZag64(Value));
+			nRun = 0;
+		}
+
+		void Finish() { WriteVarint(pOut, nRun); }
+	};
+
+	struct FZeroRunReader
+	{
+		const uint8_t*& pIn;
+		const uint8_t* pEnd;
+		uint64_t nRun = 0;
+		bool bValid;
+
+		FZeroRunReader(const uint8_t*& pInOut, const uint8_t* pInEnd) : pIn(pInOut), pEnd(pInEnd)
+		{
+			bValid = ReadVarint(pIn, pEnd, nRun);
+		}
+
+		uint64_t Next()
+		{
+			if (nRun > 0)
+			{
+				nRun--;
+				return 0;
+			}
+
+			uint64_t Value = 0;
+			bValid = bValid && ReadVarint(pIn, pEnd, Value) && ReadVarint(pIn, pEnd, nRun);
+			return UnZigZag64(Value);
+		}
+
+		/** Every value was read and the stream ended with the final run */
+		bool Finish() const { return bValid && nRun == 0; }
+	};
+
+	//------------------------------------------------------------------------------------------------
+	// Bit-packing. Lane l's values are packed into its own run of 32 bit words, and the runs are
+	// interleaved word by word, so word w of all four lanes is one 16 byte load.
+
+	/** Size of a packed block, the last block of a stream only stores the words its values reach into */
+	static size_t PackedBlockSize(uint32_t nBits, uint32_t nValues)
+	{
+		return (size_t)((nBits * nValues + 31) / 32) * 4 * sizeof(uint32_t);
+	}
+
+	static void PackBlock(const uint32_t Values[PackedBlockSamples][4], uint32_t nBits, uint32_t nValues, uint8_t* pOut)
+	{
+		uint32_t Words[32 * 4];
+		memset(Words, 0, nBits * 4 * sizeof(uint32_t));
+
+		for (uint32_t nLane = 0; nLane < 4; nLane++)
+		{
+			uint32_t nBit = 0;
+			for (uint32_t nValue = 0; nValue < PackedBlockSamples; nValue++, nBit += nBits)
+			{
+				const uint32_t nWord = nBit >> 5;
+				const uint32_t nShift = nBit & 31;
+				Words[nWord * 4 + nLane] |= Values[nValue][nLane] << nShift;
+				if (nShift + nBits > 32)
+				{
+					Words[(nWord + 1) * 4 + nLane] |= Values[nValue][nLane] >> (32 - nShift);
+				}
+			}
+		}
+
+		memcpy(pOut, Words, PackedBlockSize(nBits, nValues));
+	}
+
+#if VIVETRACKER_SIMD_SSE
+	typedef __m128i FLanes;
+
+	template <uint32_t Bits>
+	static void UnpackBlock(const uint8_t* pIn, FLanes* pOut)
+	{
+		if (Bits == 0)
+		{
+			for (uint32_t nValue = 0; nValue < PackedBlockSamples; nValue++)
+			{
+				pOut[nValue] = _mm_setzero_si128();
+			}
+			return;
+		}
+
+		const __m128i* pWords = reinterpret_cast<const __m128i*>(pIn);
+		const __m128i Mask = _mm_set1_epi32(Bits >= 32 ? -1 : (int32_t)((1u << (Bits & 31)) - 1));
+		__m128i Word = _mm_loadu_si128(pWords++);
+
+		// Bits is constant, so the compiler resolves every shift and load
+		uint32_t nShift = 0;
+		for (uint32_t nValue = 0; nValue < PackedBlockSamples; nValue++)
+		{
+			__m128i Value = _mm_srl_epi32(Word, _mm_cvtsi32_si128((int)nShift));
+			if (nShift + Bits > 32)
+			{
+				Word = _mm_loadu_si128(pWords++);
+				Value = _mm_or_si128(Value, _mm_sll_epi32(Word, _mm_cvtsi32_si128((int)(32 - nShift))));
+				nShift = nShift + Bits - 32;
+			}
+			else if (nShift + Bits == 32)
+			{
+				if (nValue + 1 < PackedBlockSamples)
+				{
+					Word = _mm_loadu_si128(pWords++);
+				}
+				nShift = 0;
+			}
+			else
+			{
+				nShift += Bits;
+			}
+			pOut[nValue] = _mm_and_si128(Value, Mask);
+		}
+	}
+#else
+	struct FLanes
+	{
+		uint32_t V[4];
+	};
+
+	template <uint32_t Bits>
+	static void UnpackBlock(const uint8_t* pIn, FLanes* pOut)
+	{
+		uint32_t Words[32 * 4];
+		memcpy(Words, pIn, Bits * 4 * sizeof(uint32_t));
+
+		const uint32_t Mask = Bits >= 32 ? 0xFFFFFFFFu : (1u << (Bits & 31)) - 1;
+		for (uint32_t nLane = 0; nLane < 4; nLane++)
+		{
+			uint32_t nBit = 0;
+			for (uint32_t nValue = 0; nValue < PackedBlockSamples; nValue++, nBit += Bits)
+			{
+				const uint32_t nWord = nBit >> 5;
+				const uint32_t nShift = nBit & 31;
+				uint32_t Value = Bits ? Words[nWord * 4 + nLane] >> nShift : 0;
+				if (nShift + Bits > 32)
+				{
+					Value |= Words[(nWord + 1) * 4 + nLane] << (32 - nShift);
+				}
+				pOut[nValue].V[nLane] = Value & Mask;
+			}
+		}
+	}
+#endif
+
+	typedef void (*FUnpackBlockFunction)(const uint8_t*, FLanes*);
+
+	template <uint32_t... Bits>
+	struct TUnpackTable
+	{
+		static constexpr FUnpackBlockFunction Functions[] = { &UnpackBlock<Bits>... };
+	};
+
+	template <uint32_t... Bits>
+	constexpr FUnpackBlockFunction TUnpackTable<Bits...>::Functions[];
+
+	typedef TUnpackTable<0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+		17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32> FUnpackTable;
+
+	/**
+	* Turn a block of unpacked zigzagged residuals into dequantized values and store them into the samples.
+	* Every lane predicts its next value by extending the line through its previous two values.
+	*/
+	static void ReconstructBlock(const FLanes* pResiduals, uint32_t nValues, FLanes& InOutPrevious, FLanes& InOutBeforePrevious,
+		float Step, uint32_t nGroupOffset, FCaptureSample* pOut, const uint32_t* pPositions)
+	{
+#if VIVETRACKER_SIMD_SSE
+		const __m128i One = _mm_set1_epi32(1);
+		const __m128 Steps = _mm_set1_ps(Step);
+		__m128i Previous = InOutPrevious;
+		__m128i BeforePrevious = InOutBeforePrevious;
+
+		for (uint32_t nValue = 0; nValue < nValues; nValue++)
+		{
+			const __m128i Encoded = pResiduals[nValue];
+			const __m128i Residual = _mm_xor_si128(_mm_srli_epi32(Encoded, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(Encoded, One)));
+			const __m128i Value = _mm_add_epi32(Residual, _mm_sub_epi32(_mm_add_epi32(Previous, Previous), BeforePrevious));
+			BeforePrevious = Previous;
+			Previous = Value;
+
+			uint8_t* pSample = reinterpret_cast<uint8_t*>(&pOut[pPositions[nValue]]);
+			_mm_storeu_ps(reinterpret_cast<float*>(pSample + nGroupOffset), _mm_mul_ps(_mm_cvtepi32_ps(Value), Steps));
+		}
+
+		InOutPrevious = Previous;
+		InOutBeforePrevious = BeforePrevious;
+#else
+		for (uint32_t nValue = 0; nValue < nValues; nValue++)
+		{
+			float Values[4];
+			for (uint32_t nLane = 0; nLane < 4; nLane++)
+			{
+				const uint32_t Encoded = pResiduals[nValue].V[nLane];
+				const uint32_t Residual = (Encoded >> 1) ^ (0u - (Encoded & 1));
+				const uint32_t Value = Residual + 2 * InOutPrevious.V[nLane] - InOutBeforePrevious.V[nLane];
+				InOutBeforePrevious.V[nLane] = InOutPrevious.V[nLane];
+				InOutPrevious.V[nLane] = Value;
+				Values[nLane] = (float)(int32_t)Value * Step;
+			}
+
+			uint8_t* pSample = reinterpret_cast<uint8_t*>(&pOut[pPositions[nValue]]);
+			memcpy(pSample + nGroupOffset, Values, sizeof(Values));
+		}
+#endif
+	}
+
+	static FLanes LoadLanes(const int32_t* pLanes)
+	{
+#if VIVETRACKER_SIMD_SSE
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pLanes));
+#else
+		FLanes Lanes;
+		memcpy(Lanes.V, pLanes, sizeof(Lanes.V));
+		return Lanes;
+#endif
+	}
+
+	//------------------------------------------------------------------------------------------------
+	// Encoder
+
+	size_t FCaptureEncoder::GetMaxEncodedSize(uint32_t NumSamples)
+	{
+		// A stream of n samples has ceil((n - 1) / 32) blocks, which never exceeds n / 2. Residuals take
+		// at most 32 bits per lane, plus up to a word per lane of rounding in every block.
+		const size_t nBlocks = NumSamples / 2;
+		const size_t MaxVarintSize = 10;
+		return sizeof(FCodecBlockHeader) + Align4((size_t)NumSamples * (sizeof(uint32_t) + sizeof(uint16_t))) +
+			(size_t)NumSamples * (sizeof(FCaptureSample) + 3 * 2 * MaxVarintSize + NumLanes * sizeof(uint32_t)) +
+			nBlocks * (NumGroups + NumGroups * 4 * sizeof(uint32_t));
+	}
+
+	size_t FCaptureEncoder::Encode(const FCaptureSample* pSamples, uint32_t NumSamples, uint8_t* pOut)
+	{
+		uint8_t* const pStart = pOut;
+
+		// Split the samples into one stream per tracker, in order of first appearance
+		m_arrOrder.resize(NumSamples);
+		m_arrStreamTrackers.clear();
+		m_arrStreamOffsets.clear();
+
+		uint32_t nLastStream = 0;
+		for (uint32_t nSample = 0; nSample < NumSamples; nSample++)
+		{
+			const uint16_t TrackerId = pSamples[nSample].TrackerId;
+
+			// Trackers usually follow each other in the same order, try the one after the previous match first
+			uint32_t nStream = nLastStream + 1 < m_arrStreamTrackers.size() ? nLastStream + 1 : 0;
+			if (nStream >= m_arrStreamTrackers.size() || m_arrStreamTrackers[nStream] != TrackerId)
+			{
+				nStream = 0;
+				while (nStream < m_arrStreamTrackers.size() && m_arrStreamTrackers[nStream] != TrackerId)
+				{
+					nStream++;
+				}
+
+				if (nStream == m_arrStreamTrackers.size())
+				{
+					m_arrStreamTrackers.push_back(TrackerId);
+					m_arrStreamOffsets.push_back(0);
+				}
+			}
+
+			m_arrOrder[nSample] = (uint16_t)nStream;
+			m_arrStreamOffsets[nStream]++;
+			nLastStream = nStream;
+		}
+
+		const uint32_t nStreams = (uint32_t)m_arrStreamTrackers.size();
+
+		bool bPeriodic = true;
+		for (uint32_t nSample = nStreams; nSample < NumSamples && bPeriodic; nSample++)
+		{
+			bPeriodic = m_arrOrder[nSample] == m_arrOrder[nSample - nStreams];
+		}
+
+		// Header, samples per stream and order
+		FCodecBlockHeader Header{};
+		Header.NumSamples = NumSamples;
+		Header.NumStreams = (uint16_t)nStreams;
+		Header.Flags = bPeriodic ? CodecFlag_PeriodicOrder : 0;
+		Header.Steps[0] = 2.f * m_settings.PositionError;
+		Header.Steps[1] = 2.f * m_settings.RotationError;
+		Header.Steps[2] = 2.f * m_settings.LinearVelocityError;
+		Header.Steps[3] = 2.f * m_settings.AngularVelocityError;
+		memcpy(pOut, &Header, sizeof(Header));
+		pOut += sizeof(Header);
+
+		memcpy(pOut, m_arrStreamOffsets.data(), nStreams * sizeof(uint32_t));
+		pOut += nStreams * sizeof(uint32_t);
+
+		const uint32_t nOrder = bPeriodic ? (NumSamples < nStreams ? NumSamples : nStreams) : NumSamples;
+		memcpy(pOut, m_arrOrder.data(), nOrder * sizeof(uint16_t));
+		pOut += nOrder * sizeof(uint16_t);
+		while ((pOut - pStart) & 3)
+		{
+			*pOut++ = 0;
+		}
+
+		// Sample indices grouped by stream
+		m_arrStreamSamples.resize(NumSamples);
+		uint32_t nOffset = 0;
+		for (uint32_t& nStreamOffset : m_arrStreamOffsets)
+		{
+			const uint32_t nCount = nStreamOffset;
+			nStreamOffset = nOffset;
+			nOffset += nCount;
+		}
+		for (uint32_t nSample = 0; nSample < NumSamples; nSample++)
+		{
+			m_arrStreamSamples[m_arrStreamOffsets[m_arrOrder[nSample]]++] = nSample;
+		}
+
+		float InverseSteps[NumGroups];
+		GetInverseSteps(Header.Steps, InverseSteps);
+
+		uint32_t nStreamStart = 0;
+		for (uint32_t nStream = 0; nStream < nStreams; nStream++)
+		{
+			const uint32_t nStreamEnd = m_arrStreamOffsets[nStream];
+			const uint32_t* pIndices = m_arrStreamSamples.data() + nStreamStart;
+			const uint32_t nCount = nStreamEnd - nStreamStart;
+			nStreamStart = nStreamEnd;
+
+			// The first sample is kept as is
+			const FCaptureSample& First = pSamples[pIndices[0]];
+			memcpy(pOut, &First, sizeof(FCaptureSample));
+			pOut += sizeof(FCaptureSample);
+
+			// Pose and velocities, residuals of a linear prediction from the previous two quantized samples
+			m_arrQuantized.resize((size_t)nCount * NumLanes);
+			for (uint32_t nSample = 0; nSample < nCount; nSample++)
+			{
+				QuantizeSample(pSamples[pIndices[nSample]], InverseSteps, &m_arrQuantized[(size_t)nSample * NumLanes]);
+			}
+
+			for (uint32_t nBlockStart = 1; nBlockStart < nCount; nBlockStart += PackedBlockSamples)
+			{
+				const uint32_t nBlockValues = nCount - nBlockStart < PackedBlockSamples ? nCount - nBlockStart : PackedBlockSamples;
+
+				uint8_t* pWidths = pOut;
+				pOut += NumGroups;
+
+				for (uint32_t nGroup = 0; nGroup < NumGroups; nGroup++)
+				{
+					uint32_t Residuals[PackedBlockSamples][4] = {};
+					uint32_t AllBits = 0;
+
+					for (uint32_t nValue = 0; nValue < nBlockValues; nValue++)
+					{
+						const uint32_t nSample = nBlockStart + nValue;
+						const int32_t* pCurrent = &m_arrQuantized[(size_t)nSample * NumLanes + nGroup * 4];
+						const int32_t* pPrevious = &m_arrQuantized[(size_t)(nSample - 1) * NumLanes + nGroup * 4];
+						const int32_t* pBeforePrevious = &m_arrQuantized[(size_t)(nSample > 1 ? nSample - 2 : 0) * NumLanes + nGroup * 4];
+
+						for (uint32_t nLane = 0; nLane < 4; nLane++)
+						{
+							const uint32_t Prediction = 2 * (uint32_t)pPrevious[nLane] - (uint32_t)pBeforePrevious[nLane];
+							Residuals[nValue][nLane] = ZigZag32((uint32_t)pCurrent[nLane] - Prediction);
+							AllBits |= Residuals[nValue][nLane];
+						}
+					}
+
+					const uint32_t nBits = BitWidth(AllBits);
+					pWidths[nGroup] = (uint8_t)nBits;
+					PackBlock(Residuals, nBits, nBlockValues, pOut);
+					pOut += PackedBlockSize(nBits, nBlockValues);
+				}
+			}
+
+			// Times advance at a steady rate, the offset between both clocks barely moves and flags rarely change
+			FZeroRunWriter TimeWriter(pOut);
+			uint64_t PreviousDelta = 0;
+			for (uint32_t nSample = 1; nSample < nCount; nSample++)
+			{
+				const uint64_t Delta = (uint64_t)pSamples[pIndices[nSample]].Time - (uint64_t)pSamples[pIndices[nSample - 1]].Time;
+				TimeWriter.Add(Delta - PreviousDelta);
+				PreviousDelta = Delta;
+			}
+			TimeWriter.Finish();
+
+			FZeroRunWriter ClockWriter(pOut);
+			for (uint32_t nSample = 1; nSample < nCount; nSample++)
+			{
+				const FCaptureSample& Sample = pSamples[pIndices[nSample]];
+				const FCaptureSample& Previous = pSamples[pIndices[nSample - 1]];
+				ClockWriter.Add(((uint64_t)Sample.PlatformTimeNs - (uint64_t)Sample.Time) - ((uint64_t)Previous.PlatformTimeNs - (uint64_t)Previous.Time));
+			}
+			ClockWriter.Finish();
+
+			FZeroRunWriter FlagsWriter(pOut);
+			for (uint32_t nSample = 1; nSample < nCount; nSample++)
+			{
+				FlagsWriter.Add(PackedFlags(pSamples[pIndices[nSample]]) ^ PackedFlags(pSamples[pIndices[nSample - 1]]));
+			}
+			FlagsWriter.Finish();
+		}
+
+		return (size_t)(pOut - pStart);
+	}
+
+	//------------------------------------------------------------------------------------------------
+	// Decoder
+
+	uint32_t FCaptureDecoder::GetNumSamples(const uint8_t* pData, size_t Size)
+	{
+		if (Size < sizeof(FCodecBlockHeader))
+			return 0;
+
+		FCodecBlockHeader Header;
+		memcpy(&Header, pData, sizeof(Header));
+		return Header.NumSamples;
+	}
+
+	bool FCaptureDecoder::Decode(const uint8_t* pData, size_t Size, FCaptureSample* pOut)
+	{
+		const uint8_t* pIn = pData;
+		const uint8_t* const pEnd = pData + Size;
+
+		if (Size < sizeof(FCodecBlockHeader))
+			return false;
+
+		FCodecBlockHeader Header;
+		memcpy(&Header, pIn, sizeof(Header));
+		pIn += sizeof(Header);
+
+		const uint32_t nSamples = Header.NumSamples;
+		const uint32_t nStreams = Header.NumStreams;
+		const bool bPeriodic = (Header.Flags & CodecFlag_PeriodicOrder) != 0;
+		if (nSamples == 0)
+			return true;
+
+		const uint32_t nOrder = bPeriodic ? (nSamples < nStreams ? nSamples : nStreams) : nSamples;
+		if (nStreams == 0 || (size_t)(pEnd - pIn) < Align4((size_t)nStreams * sizeof(uint32_t) + nOrder * sizeof(uint16_t)))
+			return false;
+
+		// Sample positions grouped by stream, checked against the stored counts
+		m_arrStreamCounts.resize(nStreams);
+		memcpy(m_arrStreamCounts.data(), pIn, nStreams * sizeof(uint32_t));
+		pIn += nStreams * sizeof(uint32_t);
+
+		const uint16_t* pOrder = reinterpret_cast<const uint16_t*>(pIn);
+		pIn += Align4((size_t)nStreams * sizeof(uint32_t) + nOrder * sizeof(uint16_t)) - nStreams * sizeof(uint32_t);
+
+		m_arrStreamOffsets.resize(nStreams + 1);
+		uint64_t nTotal = 0;
+		for (uint32_t nStream = 0; nStream < nStreams; nStream++)
+		{
+			m_arrStreamOffsets[nStream] = (uint32_t)nTotal;
+			nTotal += m_arrStreamCounts[nStream];
+			if (m_arrStreamCounts[nStream] == 0)
+				return false;
+		}
+		if (nTotal != nSamples)
+			return false;
+		m_arrStreamOffsets[nStreams] = nSamples;
+
+		m_arrPositions.resize(nSamples);
+		for (uint32_t nSample = 0; nSample < nSamples; nSample++)
+		{
+			uint16_t nStream;
+			memcpy(&nStream, pOrder + (bPeriodic ? nSample % nStreams : nSample), sizeof(nStream));
+			if (nStream >= nStreams || m_arrStreamOffsets[nStream] >= m_arrStreamOffsets[nStream + 1])
+				return false;
+
+			m_arrPositions[m_arrStreamOffsets[nStream]++] = nSample;
+		}
+
+		float InverseSteps[NumGroups];
+		GetInverseSteps(Header.Steps, InverseSteps);
+
+		uint32_t nStreamStart = 0;
+		for (uint32_t nStream = 0; nStream < nStreams; nStream++)
+		{
+			const uint32_t* pPositions = m_arrPositions.data() + nStreamStart;
+			const uint32_t nCount = m_arrStreamCounts[nStream];
+			nStreamStart += nCount;
+
+			if ((size_t)(pEnd - pIn) < sizeof(FCaptureSample))
+				return false;
+
+			FCaptureSample& First = pOut[pPositions[0]];
+			memcpy(&First, pIn, sizeof(FCaptureSample));
+			pIn += sizeof(FCaptureSample);
+
+			int32_t FirstLanes[NumLanes];
+			QuantizeSample(First, InverseSteps, FirstLanes);
+
+			FLanes Previous[NumGroups];
+			FLanes BeforePrevious[NumGroups];
+			for (uint32_t nGroup = 0; nGroup < NumGroups; nGroup++)
+			{
+				Previous[nGroup] = BeforePrevious[nGroup] = LoadLanes(FirstLanes + nGroup * 4);
+			}
+
+			// Pose and velocities, group by group so later groups overwrite the pad lanes of earlier ones
+			for (uint32_t nBlockStart = 1; nBlockStart < nCount; nBlockStart += PackedBlockSamples)
+			{
+				const uint32_t nBlockValues = nCount - nBlockStart < PackedBlockSamples ? nCount - nBlockStart : PackedBlockSamples;
+
+				if (pEnd - pIn < (ptrdiff_t)NumGroups)
+					return false;
+
+				const uint8_t* pWidths = pIn;
+				pIn += NumGroups;
+
+				for (uint32_t nGroup = 0; nGroup < NumGroups; nGroup++)
+				{
+					const uint32_t nBits = pWidths[nGroup];
+					if (nBits > 32)
+						return false;
+
+					const size_t nBytes = PackedBlockSize(nBits, nBlockValues);
+					if ((size_t)(pEnd - pIn) < nBytes)
+						return false;
+
+					FLanes Residuals[PackedBlockSamples];
+					if (nBlockValues == PackedBlockSamples)
+					{
+						FUnpackTable::Functions[nBits](pIn, Residuals);
+					}
+					else
+					{
+						// Pad a partial block so the unpacker never reads past its end
+						uint32_t Words[32 * 4] = {};
+						memcpy(Words, pIn, nBytes);
+						FUnpackTable::Functions[nBits](reinterpret_cast<const uint8_t*>(Words), Residuals);
+					}
+					pIn += nBytes;
+
+					ReconstructBlock(Residuals, nBlockValues, Previous[nGroup], BeforePrevious[nGroup], Header.Steps[nGroup], GroupOffsets[nGroup],
+						pOut, pPositions + nBlockStart);
+				}
+			}
+
+			// Times, clock offsets and flags, which also overwrite the pad lane of the last group
+			FZeroRunReader TimeReader(pIn, pEnd);
+			uint64_t Delta = 0;
+			for (uint32_t nSample = 1; nSample < nCount; nSample++)
+			{
+				Delta += TimeReader.Next();
+				pOut[pPositions[nSample]].Time = (int64_t)((uint64_t)pOut[pPositions[nSample - 1]].Time + Delta);
+			}
+			if (!TimeReader.Finish())
+				return false;
+
+			FZeroRunReader ClockReader(pIn, pEnd);
+			uint64_t ClockOffset = (uint64_t)First.PlatformTimeNs - (uint64_t)First.Time;
+			for (uint32_t nSample = 1; nSample < nCount; nSample++)
+			{
+				FCaptureSample& Sample = pOut[pPositions[nSample]];
+				ClockOffset += ClockReader.Next();
+				Sample.PlatformTimeNs = (int64_t)((uint64_t)Sample.Time + ClockOffset);
+			}
+			if (!ClockReader.Finish())
+				return false;
+
+			FZeroRunReader FlagsReader(pIn, pEnd);
+			uint32_t Flags = PackedFlags(First);
+			for (uint32_t nSample = 1; nSample < nCount; nSample++)
+			{
+				FCaptureSample& Sample = pOut[pPositions[nSample]];
+				Flags ^= (uint32_t)FlagsReader.Next();
+				Sample.TrackerId = First.TrackerId;
+				Sample.LocationFlags = (uint8_t)Flags;
+				Sample.VelocityFlags = (uint8_t)(Flags >> 8);
+				Sample.Role = (uint8_t)(Flags >> 16);
+				memset(Sample.Reserved, 0, sizeof(Sample.Reserved));
+			}
+			if (!FlagsReader.Finish())
+				return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,358 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerCore/ViveTrackerIK.h"
+#include "ViveTrackerMath.h"
+#include "ViveTrackerSimd.h"
+
+namespace ViveTrackerCore
+{
+	/** Four independent two bone chains, one per SIMD lane */
+	struct FTwoBoneChains
+	{
+		FVec3 Root[4];
+		FVec3 Target[4];
+		FVec3 Pole[4];
+		/** Up axis of the chain's body, the bend direction when the pole is in line with the chain */
+		FVec3 Up[4];
+		float UpperLength[4];
+		float LowerLength[4];
+
+		/** Cosines of the middle joint's largest and smallest interior angles */
+		float CosMin[4];
+		float CosMax[4];
+
+		FVec3 Mid[4];
+		FVec3 End[4];
+		FVec3 Bend[4];
+	};
+
+	static inline FVec3x4 LoadVec3x4(const FVec3* In)
+	{
+		return { FFloat4(In[0].X, In[1].X, In[2].X, In[3].X), FFloat4(In[0].Y, In[1].Y, In[2].Y, In[3].Y), FFloat4(In[0].Z, In[1].Z, In[2].Z, In[3].Z) };
+	}
+
+	static inline void StoreVec3x4(const FVec3x4& In, FVec3* Out)
+	{
+		float X[4], Y[4], Z[4];
+		In.X.Store(X);
+		In.Y.Store(Y);
+		In.Z.Store(Z);
+		for (int i = 0; i < 4; i++)
+		{
+			Out[i] = FVec3{ X[i], Y[i], Z[i] };
+		}
+	}
+
+	/** Joint limits of a skeleton as cosines, computed once per skeleton rather than per chain */
+	struct FJointCosines
+	{
+		float ElbowMin, ElbowMax;
+		float KneeMin, KneeMax;
+		float SpineMin, SpineMax;
+
+		explicit FJointCosines(const FBodySkeleton& Skeleton)
+		{
+			// Cosine decreases with the angle, the largest angle gives the smallest cosine
+			ElbowMin = std::cos(Skeleton.ElbowMaxAngle);
+			ElbowMax = std::cos(Skeleton.ElbowMinAngle);
+			KneeMin = std::cos(Skeleton.KneeMaxAngle);
+			KneeMax = std::cos(Skeleton.KneeMinAngle);
+			SpineMin = -1.f;
+			SpineMax = std::cos(Skeleton.SpineMinAngle);
+		}
+	};
+
+	/**
+	* Analytic two bone IK on four chains at once. The interior angle at the middle joint is clamped
+	* to its limits through the law of cosines, so no trigonometry is needed per solve.
+	*/
+	static void SolveTwoBoneChains(FTwoBoneChains& Chains)
+	{
+		const FFloat4 One(1.f), MinusOne(-1.f), Two(2.f), Epsilon(1.0e-6f);
+
+		const FVec3x4 Root = LoadVec3x4(Chains.Root);
+		const FVec3x4 Target = LoadVec3x4(Chains.Target);
+		const FVec3x4 Pole = LoadVec3x4(Chains.Pole);
+		const FVec3x4 Up = LoadVec3x4(Chains.Up);
+		const FFloat4 U = FFloat4::Load(Chains.UpperLength);
+		const FFloat4 L = FFloat4::Load(Chains.LowerLength);
+
+		const FVec3x4 ToTarget = Target - Root;
+		const FVec3x4 ToPole = Pole - Root;
+		const FVec3x4 Dir = SafeNormal(ToTarget, ToPole);
+
+		// Interior angle at the middle joint needed to reach the target, clamped to the joint's range
+		const FFloat4 DistSq = Dot(ToTarget, ToTarget);
+		const FFloat4 UU = U * U, LL = L * L, UL2 = Two * U * L;
+		FFloat4 CosJoint = (UU + LL - DistSq) / Max(UL2, Epsilon);
+		CosJoint = Max(Min(CosJoint, FFloat4::Load(Chains.CosMax)), FFloat4::Load(Chains.CosMin));
+		CosJoint = Max(Min(CosJoint, One), MinusOne);
+
+		// Reachable distance for that angle, and the root's angle off the target direction
+		const FFloat4 Dist = Sqrt(Max(UU + LL - UL2 * CosJoint, Epsilon));
+		FFloat4 CosRoot = (UU + Dist * Dist - LL) / Max(Two * U * Dist, Epsilon);
+		CosRoot = Max(Min(CosRoot, One), MinusOne);
+		const FFloat4 SinRoot = Sqrt(Max(One - CosRoot * CosRoot, FFloat4(0.f)));
+
+		// Bend towards the pole, projected perpendicular to the chain
+		const FVec3x4 PolePerp = ToPole - Dir * Dot(ToPole, Dir);
+		const FVec3x4 Bend = SafeNormal(PolePerp, SafeNormal(Up - Dir * Dot(Up, Dir), FVec3x4{ One, FFloat4(0.f), FFloat4(0.f) }));
+
+		const FVec3x4 Mid = Root + Dir * (U * CosRoot) + Bend * (U * SinRoot);
+		const FVec3x4 End = Root + Dir * Dist;
+
+		StoreVec3x4(Mid, Chains.Mid);
+		StoreVec3x4(End, Chains.End);
+		StoreVec3x4(Bend, Chains.Bend);
+	}
+
+	/** Pelvis rotation, +X up, +Y left and +Z forward, facing the heading of a rotation with only its yaw kept */
+	static FQuat4 MakeUprightRotation(const FBodySkeleton& Skeleton, const FVec3& Up, const FQuat4& Rotation)
+	{
+		const FVec3 Forward = Rotate(Rotation, Skeleton.Forward);
+		const FVec3 Heading = SafeNormal(Forward - Up * Dot(Forward, Up), Skeleton.Forward);
+		return MakeFromXZ(Up, Heading);
+	}
+
+	/** Pelvis from the waist tracker, or hanging under the head facing the head's heading */
+	static FPose SolvePelvis(const FBodySkeleton& Skeleton, const FBodyTargets& Targets, const FVec3& Up)
+	{
+		if (Targets.ValidMask & Target_Pelvis)
+			return Targets.Pelvis;
+
+		FPose Pelvis;
+		Pelvis.Position = Targets.Head.Position - Up * ((Skeleton.SpineLength + Skeleton.NeckLength) * 0.95f);
+		Pelvis.Rotation = MakeUprightRotation(Skeleton, Up, Targets.Head.Rotation);
+		return Pelvis;
+	}
+
+	FPose MakeUprightPelvis(const FBodySkeleton& Skeleton, const FPose& Waist)
+	{
+		FPose Pelvis;
+		Pelvis.Position = Waist.Position;
+		Pelvis.Rotation = MakeUprightRotation(Skeleton, SafeNormal(Skeleton.Up, FVec3{ 0.f, 0.f, 1.f }), Waist.Rotation);
+		return Pelvis;
+	}
+
+	/** Spine chain of one body in one lane, pelvis to chest to head, bending towards the chest tracker if there is one */
+	static void SetupSpine(const FBodySkeleton& Skeleton, const FJointCosines& Limits, const FBodyTargets& Targets, const FVec3& Up, const FPose& Pelvis, FTwoBoneChains& Spine, int Lane)
+	{
+		const uint32_t Valid = Targets.ValidMask;
+		const FVec3 PelvisForward = Rotate(Pelvis.Rotation, FVec3{ 0.f, 0.f, 1.f });
+
+		Spine.Root[Lane] = Pelvis.Position;
+		Spine.Target[Lane] = (Valid & Target_Head) ? Targets.Head.Position : Pelvis.Position + Up * (Skeleton.SpineLength + Skeleton.NeckLength);
+		Spine.Pole[Lane] = (Valid & Target_Chest) ? Targets.Chest.Position : Pelvis.Position + PelvisForward * Skeleton.SpineLength;
+		Spine.Up[Lane] = Up;
+		Spine.UpperLength[Lane] = Skeleton.SpineLength;
+		Spine.LowerLength[Lane] = Skeleton.NeckLength;
+		Spine.CosMin[Lane] = Limits.SpineMin;
+		Spine.CosMax[Lane] = Limits.SpineMax;
+	}
+
+	/** Chest and head from a solved spine lane */
+	static void FinishSpine(const FBodyTargets& Targets, const FTwoBoneChains& Spine, int Lane, FBodyPose& OutPose)
+	{
+		FPose& Chest = OutPose.Bones[(int)EBodyBone::Chest];
+		Chest.Position = Spine.Mid[Lane];
+		Chest.Rotation = MakeFromXZ(Spine.End[Lane] - Spine.Mid[Lane], Spine.Bend[Lane]);
+
+		FPose& Head = OutPose.Bones[(int)EBodyBone::Head];
+		Head.Position = Spine.End[Lane];
+		Head.Rotation = (Targets.ValidMask & Target_Head) ? Targets.Head.Rotation : Chest.Rotation;
+	}
+
+	/** Bones of each limb: left arm, right arm, left leg, right leg */
+	static const EBodyBone LimbBones[4][3] = {
+		{ EBodyBone::UpperArm_L, EBodyBone::LowerArm_L, EBodyBone::Hand_L },
+		{ EBodyBone::UpperArm_R, EBodyBone::LowerArm_R, EBodyBone::Hand_R },
+		{ EBodyBone::Thigh_L, EBodyBone::Calf_L, EBodyBone::Foot_L },
+		{ EBodyBone::Thigh_R, EBodyBone::Calf_R, EBodyBone::Foot_R },
+	};
+
+	/**
+	* Chain of one limb of one body in one lane, needs the body's pelvis and chest. Arms hang down with elbows
+	* bending back and out, legs stand straight under the hips with knees bending forward, unless an elbow
+	* or knee tracker says otherwise.
+	*/
+	static void SetupLimb(const FBodySkeleton& Skeleton, const FJointCosines& Limits, const FBodyTargets& Targets, const FVec3& Up, const FBodyPose& Pose, int Limb, FTwoBoneChains& Limbs, int Lane)
+	{
+		const uint32_t Valid = Targets.ValidMask;
+		const int Side = Limb & 1;
+		const float Sign = Side == 0 ? 1.f : -1.f;
+		Limbs.Up[Lane] = Up;
+
+		if (Limb < 2)
+		{
+			const FPose& Chest = Pose.Bones[(int)EBodyBone::Chest];
+			const FVec3 ChestLeft = Rotate(Chest.Rotation, FVec3{ 0.f, 1.f, 0.f });
+			const FVec3 ChestForward = Rotate(Chest.Rotation, FVec3{ 0.f, 0.f, 1.f });
+			const float ArmLength = Skeleton.UpperArmLength + Skeleton.LowerArmLength;
+
+			Limbs.Root[Lane] = Chest.Position + ChestLeft * (Skeleton.ShoulderHalfWidth * Sign);
+			Limbs.Target[Lane] = (Valid & (Side == 0 ? Target_Hand_L : Target_Hand_R)) ? Targets.Hands[Side].Position : Limbs.Root[Lane] - Up * ArmLength;
+			Limbs.Pole[Lane] = (Valid & (Side == 0 ? Target_Elbow_L : Target_Elbow_R)) ? Targets.Elbows[Side] :
+				Limbs.Root[Lane] + (ChestLeft * (0.5f * Sign) - ChestForward - Up * 0.5f) * ArmLength;
+			Limbs.UpperLength[Lane] = Skeleton.UpperArmLength;
+			Limbs.LowerLength[Lane] = Skeleton.LowerArmLength;
+			Limbs.CosMin[Lane] = Limits.ElbowMin;
+			Limbs.CosMax[Lane] = Limits.ElbowMax;
+		}
+		else
+		{
+			const FPose& Pelvis = Pose.Bones[(int)EBodyBone::Pelvis];
+			const FVec3 PelvisUp = Rotate(Pelvis.Rotation, FVec3{ 1.f, 0.f, 0.f });
+			const FVec3 PelvisLeft = Rotate(Pelvis.Rotation, FVec3{ 0.f, 1.f, 0.f });
+			const FVec3 PelvisForward = Rotate(Pelvis.Rotation, FVec3{ 0.f, 0.f, 1.f });
+			const float LegLength = Skeleton.ThighLength + Skeleton.ShinLength;
+
+			Limbs.Root[Lane] = Pelvis.Position + PelvisLeft * (Skeleton.HipHalfWidth * Sign);
+			Limbs.Target[Lane] = (Valid & (Side == 0 ? Target_Foot_L : Target_Foot_R)) ? Targets.Feet[Side].Position : Limbs.Root[Lane] - PelvisUp * LegLength;
+			Limbs.Pole[Lane] = (Valid & (Side == 0 ? Target_Knee_L : Target_Knee_R)) ? Targets.Knees[Side] : Limbs.Root[Lane] + PelvisForward * LegLength;
+			Limbs.UpperLength[Lane] = Skeleton.ThighLength;
+			Limbs.LowerLength[Lane] = Skeleton.ShinLength;
+			Limbs.CosMin[Lane] = Limits.KneeMin;
+			Limbs.CosMax[Lane] = Limits.KneeMax;
+		}
+	}
+
+	/** Bones of one limb from a solved lane */
+	static void FinishLimb(const FBodyTargets& Targets, const FTwoBoneChains& Limbs, int Lane, int Limb, FBodyPose& OutPose)
+	{
+		static const uint32_t EndTargets[4] = { Target_Hand_L, Target_Hand_R, Target_Foot_L, Target_Foot_R };
+		const FPose* EndPoses[4] = { &Targets.Hands[0], &Targets.Hands[1], &Targets.Feet[0], &Targets.Feet[1] };
+
+		FPose& Upper = OutPose.Bones[(int)LimbBones[Limb][0]];
+		FPose& Lower = OutPose.Bones[(int)LimbBones[Limb][1]];
+		FPose& End = OutPose.Bones[(int)LimbBones[Limb][2]];
+
+		Upper.Position = Limbs.Root[Lane];
+		Upper.Rotation = MakeFromXZ(Limbs.Mid[Lane] - Limbs.Root[Lane], Limbs.Bend[Lane]);
+		Lower.Position = Limbs.Mid[Lane];
+		Lower.Rotation = MakeFromXZ(Limbs.End[Lane] - Limbs.Mid[Lane], Limbs.Bend[Lane]);
+		End.Position = Limbs.End[Lane];
+		End.Rotation = (Targets.ValidMask & EndTargets[Limb]) ? EndPoses[Limb]->Rotation : Lower.Rotation;
+	}
+
+	void SolveBody(const FBodySkeleton& Skeleton, const FBodyTargets& Targets, FBodyPose& OutPose)
+	{
+		const FVec3 Up = SafeNormal(Skeleton.Up, FVec3{ 0.f, 0.f, 1.f });
+		const FJointCosines Limits(Skeleton);
+		OutPose.Bones[(int)EBodyBone::Pelvis] = SolvePelvis(Skeleton, Targets, Up);
+
+		// Only lane 0 of the spine is used, the spine goes first because the arms hang off the chest
+		FTwoBoneChains Spine;
+		for (int Lane = 0; Lane < 4; Lane++)
+		{
+			SetupSpine(Skeleton, Limits, Targets, Up, OutPose.Bones[(int)EBodyBone::Pelvis], Spine, Lane);
+		}
+		SolveTwoBoneChains(Spine);
+		FinishSpine(Targets, Spine, 0, OutPose);
+
+		// One limb per lane
+		FTwoBoneChains Limbs;
+		for (int Limb = 0; Limb < 4; Limb++)
+		{
+			SetupLimb(Skeleton, Limits, Targets, Up, OutPose, Limb, Limbs, Limb);
+		}
+		SolveTwoBoneChains(Limbs);
+
+		for (int Limb = 0; Limb < 4; Limb++)
+		{
+			FinishLimb(Targets, Limbs, Limb, Limb, OutPose);
+		}
+	}
+
+	void SolveBodies(const FBodyBatch& Batch, int Begin, int End)
+	{
+		End = End < Batch.Count ? End : Batch.Count;
+		Begin = Begin > 0 ? Begin : 0;
+		if (Begin >= End || !Batch.Skeletons || !Batch.ValidMasks || !Batch.Poses)
+			return;
+
+		// A shared skeleton's limits are computed once for the whole range
+		const FJointCosines SharedLimits(*Batch.Skeletons);
+
+		// Four bodies per group, one body per lane, so every lane of every chain solve does useful work
+		for (int GroupBegin = Begin; GroupBegin < End; GroupBegin += 4)
+		{
+			const int GroupSize = End - GroupBegin < 4 ? End - GroupBegin : 4;
+
+			FBodyTargets Targets[4];
+			const FBodySkeleton* Skeletons[4];
+			FJointCosines Limits[4] = { SharedLimits, SharedLimits, SharedLimits, SharedLimits };
+			FVec3 Ups[4];
+			FBodyPose* Poses[4];
+
+			for (int Lane = 0; Lane < 4; Lane++)
+			{
+				// Short groups repeat their first body in the spare lanes, whose results are discarded
+				const int Body = GroupBegin + (Lane < GroupSize ? Lane : 0);
+				Batch.GatherTargets(Body, Targets[Lane]);
+				Skeletons[Lane] = Batch.bPerBodySkeletons ? &Batch.Skeletons[Body] : Batch.Skeletons;
+				Ups[Lane] = SafeNormal(Skeletons[Lane]->Up, FVec3{ 0.f, 0.f, 1.f });
+				if (Batch.bPerBodySkeletons)
+				{
+					Limits[Lane] = FJointCosines(*Skeletons[Lane]);
+				}
+				Poses[Lane] = &Batch.Poses[Body];
+			}
+
+			FTwoBoneChains Spine;
+			for (int Lane = 0; Lane < 4; Lane++)
+			{
+				FPose& Pelvis = Poses[Lane]->Bones[(int)EBodyBone::Pelvis];
+				Pelvis = SolvePelvis(*Skeletons[Lane], Targets[Lane], Ups[Lane]);
+				SetupSpine(*Skeletons[Lane], Limits[Lane], Targets[Lane], Ups[Lane], Pelvis, Spine, Lane);
+			}
+			SolveTwoBoneChains(Spine);
+
+			for (int Lane = 0; Lane < GroupSize; Lane++)
+			{
+				FinishSpine(Targets[Lane], Spine, Lane, *Poses[Lane]);
+			}
+
+			for (int Limb = 0; Limb < 4; Limb++)
+			{
+				FTwoBoneChains Limbs;
+				for (int Lane = 0; Lane < 4; Lane++)
+				{
+					SetupLimb(*Skeletons[Lane], Limits[Lane], Targets[Lane], Ups[Lane], *Poses[Lane], Limb, Limbs, Lane);
+				}
+				SolveTwoBoneChains(Limbs);
+
+				for (int Lane = 0; Lane < GroupSize; Lane++)
+				{
+					FinishLimb(Targets[Lane], Limbs, Lane, Limb, *Poses[Lane]);
+				}
+			}
+		}
+	}
+}
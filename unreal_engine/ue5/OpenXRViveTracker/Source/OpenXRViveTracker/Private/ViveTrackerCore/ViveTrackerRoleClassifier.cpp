@@ -0,0 +1,233 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerCore/ViveTrackerRoleClassifier.h"
+#include "ViveTrackerMath.h"
+
+#include <algorithm>
+
+namespace ViveTrackerCore
+{
+	/** Where a body tracker sits relative to the head, as ratios of head height. Lateral is positive to the left. */
+	struct FRoleTemplate
+	{
+		float Height;
+		float Lateral;
+		bool bTorso;
+	};
+
+	/** Templates in EBodyTracker order, arms assumed relaxed at the sides */
+	static const FRoleTemplate RoleTemplates[(int)EBodyTracker::Count] = {
+		{ 0.57f, 0.f, true },		// Pelvis
+		{ 0.76f, 0.f, true },		// Chest
+		{ 0.06f, 0.07f, false },	// Foot_L
+		{ 0.06f, -0.07f, false },	// Foot_R
+		{ 0.30f, 0.07f, false },	// Knee_L
+		{ 0.30f, -0.07f, false },	// Knee_R
+		{ 0.66f, 0.15f, false },	// Elbow_L
+		{ 0.66f, -0.15f, false },	// Elbow_R
+		{ 0.86f, 0.11f, true },		// Shoulder_L
+		{ 0.86f, -0.11f, true },	// Shoulder_R
+	};
+
+	/** Spread of the templates, as ratios of head height and as a correlation */
+	static constexpr float HeightDeviation = 0.05f;
+	static constexpr float LateralDeviation = 0.05f;
+	static constexpr float CorrelationDeviation = 0.1f;
+
+	void FRoleClassifier::Reset()
+	{
+		for (FTrackerSums& Sums : m_sums)
+		{
+			Sums = FTrackerSums();
+		}
+		m_dHeadHeight = 0.0;
+		m_nFrames = 0;
+	}
+
+	void FRoleClassifier::AddFrame(const FRoleFrame& Frame)
+	{
+		const FVec3 Up = SafeNormal(m_settings.Up, FVec3{ 0.f, 0.f, 1.f });
+		const FVec3 Forward = SafeNormal(m_settings.Forward - Up * Dot(m_settings.Forward, Up), FVec3{ 1.f, 0.f, 0.f });
+		const FVec3 Left = Cross(Forward, Up);
+
+		// A head below the floor means the space isn't floor level, nothing can be inferred from it
+		const float HeadHeight = Dot(Frame.Head.Position, Up);
+		if (HeadHeight <= 0.f)
+			return;
+
+		// Sideways offsets are measured across the head's heading
+		const FVec3 HeadForward = Rotate(Frame.Head.Rotation, Forward);
+		const FVec3 Heading = SafeNormal(HeadForward - Up * Dot(HeadForward, Up), Forward);
+		const FVec3 HeadingLeft = Cross(Heading, Up);
+		const float HeadX = Dot(Frame.Head.Position, Forward);
+		const float HeadY = Dot(Frame.Head.Position, Left);
+
+		for (int i = 0; i < MaxClassifiedTrackers; i++)
+		{
+			if (!(Frame.ValidMask & (1u << i)))
+				continue;
+
+			const FVec3& Position = Frame.Trackers[i];
+			const float X = Dot(Position, Forward);
+			const float Y = Dot(Position, Left);
+
+			FTrackerSums& Sums = m_sums[i];
+			Sums.Count++;
+			Sums.Height += Dot(Position, Up) / HeadHeight;
+			Sums.Lateral += Dot(Position - Frame.Head.Position, HeadingLeft) / HeadHeight;
+			Sums.Position[0] += X;
+			Sums.Position[1] += Y;
+			Sums.PositionSq += (double)X * X + (double)Y * Y;
+			Sums.HeadPosition[0] += HeadX;
+			Sums.HeadPosition[1] += HeadY;
+			Sums.HeadPositionSq += (double)HeadX * HeadX + (double)HeadY * HeadY;
+			Sums.Product += (double)X * HeadX + (double)Y * HeadY;
+		}
+
+		m_dHeadHeight += HeadHeight;
+		m_nFrames++;
+	}
+
+	void FRoleClassifier::Classify(FRoleClassification& OutClassification) const
+	{
+		OutClassification = FRoleClassification();
+		if (m_nFrames == 0)
+			return;
+
+		const double MeanHeadHeight = m_dHeadHeight / m_nFrames;
+
+		struct FCandidate
+		{
+			float Cost;
+			int Slot;
+			int Role;
+		};
+		FCandidate Candidates[MaxClassifiedTrackers * (int)EBodyTracker::Count];
+		int NumCandidates = 0;
+		float Lateral[MaxClassifiedTrackers] = {};
+
+		for (int i = 0; i < MaxClassifiedTrackers; i++)
+		{
+			const FTrackerSums& Sums = m_sums[i];
+			if (Sums.Count < m_settings.MinFrames)
+				continue;
+
+			const double N = Sums.Count;
+			const float Height = (float)(Sums.Height / N);
+			Lateral[i] = (float)(Sums.Lateral / N);
+
+			// Vector correlation of the horizontal motion of tracker and head, only trusted once the head moved
+			const double TrackerVariance = Sums.PositionSq - (Sums.Position[0] * Sums.Position[0] + Sums.Position[1] * Sums.Position[1]) / N;
+			const double HeadVariance = Sums.HeadPositionSq - (Sums.HeadPosition[0] * Sums.HeadPosition[0] + Sums.HeadPosition[1] * Sums.HeadPosition[1]) / N;
+			const double Covariance = Sums.Product - (Sums.Position[0] * Sums.HeadPosition[0] + Sums.Position[1] * Sums.HeadPosition[1]) / N;
+			const double HeadMotion = HeadVariance > 0.0 ? std::sqrt(HeadVariance / N) / MeanHeadHeight : 0.0;
+			const bool bCorrelationValid = HeadMotion >= m_settings.MinHeadMotion;
+			const float Correlation = bCorrelationValid && TrackerVariance > 0.0 ? (float)(Covariance / std::sqrt(TrackerVariance * HeadVariance)) : 0.f;
+
+			for (int Role = 0; Role < (int)EBodyTracker::Count; Role++)
+			{
+				const FRoleTemplate& Template = RoleTemplates[Role];
+				const float HeightError = (Height - Template.Height) / HeightDeviation;
+				const float LateralError = (Lateral[i] - Template.Lateral) / LateralDeviation;
+				float Cost = HeightError * HeightError + LateralError * LateralError;
+
+				if (Template.bTorso && bCorrelationValid && Correlation < m_settings.MinTorsoCorrelation)
+				{
+					const float CorrelationError = (m_settings.MinTorsoCorrelation - Correlation) / CorrelationDeviation;
+					Cost += CorrelationError * CorrelationError;
+				}
+
+				if (Cost <= m_settings.MaxCost)
+				{
+					Candidates[NumCandidates++] = { Cost, i, Role };
+				}
+			}
+		}
+
+		// Cheapest matches first, every tracker and every role used at most once
+		std::sort(Candidates, Candidates + NumCandidates, [](const FCandidate& A, const FCandidate& B) { return A.Cost < B.Cost; });
+
+		bool bSlotAssigned[MaxClassifiedTrackers] = {};
+		int RoleSlots[(int)EBodyTracker::Count];
+		std::fill(RoleSlots, RoleSlots + (int)EBodyTracker::Count, -1);
+
+		for (int c = 0; c < NumCandidates; c++)
+		{
+			const FCandidate& Candidate = Candidates[c];
+			if (bSlotAssigned[Candidate.Slot] || RoleSlots[Candidate.Role] >= 0)
+				continue;
+
+			bSlotAssigned[Candidate.Slot] = true;
+			RoleSlots[Candidate.Role] = Candidate.Slot;
+			OutClassification.Roles[Candidate.Slot] = (EBodyTracker)Candidate.Role;
+			OutClassification.Costs[Candidate.Slot] = Candidate.Cost;
+		}
+
+		// Mirrored pairs are ordered by each other rather than by the head, which survives a turned head
+		static const EBodyTracker Pairs[][2] = {
+			{ EBodyTracker::Foot_L, EBodyTracker::Foot_R },
+			{ EBodyTracker::Knee_L, EBodyTracker::Knee_R },
+			{ EBodyTracker::Elbow_L, EBodyTracker::Elbow_R },
+			{ EBodyTracker::Shoulder_L, EBodyTracker::Shoulder_R },
+		};
+
+		for (const auto& Pair : Pairs)
+		{
+			const int Left = RoleSlots[(int)Pair[0]];
+			const int Right = RoleSlots[(int)Pair[1]];
+			if (Left >= 0 && Right >= 0 && Lateral[Left] < Lateral[Right])
+			{
+				std::swap(OutClassification.Roles[Left], OutClassification.Roles[Right]);
+			}
+		}
+	}
+
+	void FRoleAgreement::Reset()
+	{
+		std::fill(m_pendingRoles, m_pendingRoles + MaxClassifiedTrackers, EBodyTracker::Count);
+		std::fill(m_acceptedRoles, m_acceptedRoles + MaxClassifiedTrackers, EBodyTracker::Count);
+		m_bHasPending = false;
+		m_bHasAccepted = false;
+	}
+
+	bool FRoleAgreement::AddClassification(const FRoleClassification& Classification)
+	{
+		const bool bConsistent = m_bHasPending && std::equal(m_pendingRoles, m_pendingRoles + MaxClassifiedTrackers, Classification.Roles);
+		std::copy(Classification.Roles, Classification.Roles + MaxClassifiedTrackers, m_pendingRoles);
+		m_bHasPending = true;
+
+		if (!bConsistent || (m_bHasAccepted && std::equal(m_acceptedRoles, m_acceptedRoles + MaxClassifiedTrackers, m_pendingRoles)))
+			return false;
+
+		std::copy(m_pendingRoles, m_pendingRoles + MaxClassifiedTrackers, m_acceptedRoles);
+		m_bHasAccepted = true;
+		return true;
+	}
+}
@@ -0,0 +1,127 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// Minimal four wide float vector used by the engine independent kernels. Maps to SSE on x86
+// and to plain scalar code elsewhere, so results are identical on every build machine.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define VIVETRACKER_SIMD_SSE 1
+#include <emmintrin.h>
+#else
+#define VIVETRACKER_SIMD_SSE 0
+#include <cmath>
+#endif
+
+namespace ViveTrackerCore
+{
+#if VIVETRACKER_SIMD_SSE
+	struct FFloat4
+	{
+		__m128 V;
+
+		FFloat4() : V(_mm_setzero_ps()) {}
+		FFloat4(__m128 In) : V(In) {}
+		explicit FFloat4(float In) : V(_mm_set1_ps(In)) {}
+		FFloat4(float A, float B, float C, float D) : V(_mm_setr_ps(A, B, C, D)) {}
+
+		static FFloat4 Load(const float* In) { return FFloat4(_mm_loadu_ps(In)); }
+		void Store(float* Out) const { _mm_storeu_ps(Out, V); }
+
+		friend FFloat4 operator+(FFloat4 A, FFloat4 B) { return _mm_add_ps(A.V, B.V); }
+		friend FFloat4 operator-(FFloat4 A, FFloat4 B) { return _mm_sub_ps(A.V, B.V); }
+		friend FFloat4 operator*(FFloat4 A, FFloat4 B) { return _mm_mul_ps(A.V, B.V); }
+		friend FFloat4 operator/(FFloat4 A, FFloat4 B) { return _mm_div_ps(A.V, B.V); }
+		friend FFloat4 Min(FFloat4 A, FFloat4 B) { return _mm_min_ps(A.V, B.V); }
+		friend FFloat4 Max(FFloat4 A, FFloat4 B) { return _mm_max_ps(A.V, B.V); }
+		friend FFloat4 Sqrt(FFloat4 A) { return _mm_sqrt_ps(A.V); }
+
+		/** Per lane A > B ? IfTrue : IfFalse */
+		friend FFloat4 SelectGreater(FFloat4 A, FFloat4 B, FFloat4 IfTrue, FFloat4 IfFalse)
+		{
+			const __m128 Mask = _mm_cmpgt_ps(A.V, B.V);
+			return _mm_or_ps(_mm_and_ps(Mask, IfTrue.V), _mm_andnot_ps(Mask, IfFalse.V));
+		}
+	};
+#else
+	struct FFloat4
+	{
+		float V[4];
+
+		FFloat4() : V{ 0.f, 0.f, 0.f, 0.f } {}
+		explicit FFloat4(float In) : V{ In, In, In, In } {}
+		FFloat4(float A, float B, float C, float D) : V{ A, B, C, D } {}
+
+		static FFloat4 Load(const float* In) { return FFloat4(In[0], In[1], In[2], In[3]); }
+		void Store(float* Out) const { for (int i = 0; i < 4; i++) Out[i] = V[i]; }
+
+#define VIVETRACKER_FLOAT4_OP(Expr) FFloat4 R; for (int i = 0; i < 4; i++) R.V[i] = (Expr); return R;
+		friend FFloat4 operator+(FFloat4 A, FFloat4 B) { VIVETRACKER_FLOAT4_OP(A.V[i] + B.V[i]) }
+		friend FFloat4 operator-(FFloat4 A, FFloat4 B) { VIVETRACKER_FLOAT4_OP(A.V[i] - B.V[i]) }
+		friend FFloat4 operator*(FFloat4 A, FFloat4 B) { VIVETRACKER_FLOAT4_OP(A.V[i] * B.V[i]) }
+		friend FFloat4 operator/(FFloat4 A, FFloat4 B) { VIVETRACKER_FLOAT4_OP(A.V[i] / B.V[i]) }
+		friend FFloat4 Min(FFloat4 A, FFloat4 B) { VIVETRACKER_FLOAT4_OP(A.V[i] < B.V[i] ? A.V[i] : B.V[i]) }
+		friend FFloat4 Max(FFloat4 A, FFloat4 B) { VIVETRACKER_FLOAT4_OP(A.V[i] > B.V[i] ? A.V[i] : B.V[i]) }
+		friend FFloat4 Sqrt(FFloat4 A) { VIVETRACKER_FLOAT4_OP(std::sqrt(A.V[i])) }
+		friend FFloat4 SelectGreater(FFloat4 A, FFloat4 B, FFloat4 IfTrue, FFloat4 IfFalse) { VIVETRACKER_FLOAT4_OP(A.V[i] > B.V[i] ? IfTrue.V[i] : IfFalse.V[i]) }
+#undef VIVETRACKER_FLOAT4_OP
+	};
+#endif
+
+	/** Four 3D vectors in structure of arrays layout */
+	struct FVec3x4
+	{
+		FFloat4 X, Y, Z;
+
+		friend FVec3x4 operator+(const FVec3x4& A, const FVec3x4& B) { return { A.X + B.X, A.Y + B.Y, A.Z + B.Z }; }
+		friend FVec3x4 operator-(const FVec3x4& A, const FVec3x4& B) { return { A.X - B.X, A.Y - B.Y, A.Z - B.Z }; }
+		friend FVec3x4 operator*(const FVec3x4& A, FFloat4 S) { return { A.X * S, A.Y * S, A.Z * S }; }
+
+		friend FFloat4 Dot(const FVec3x4& A, const FVec3x4& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+
+		friend FVec3x4 Cross(const FVec3x4& A, const FVec3x4& B)
+		{
+			return { A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X };
+		}
+
+		/** Per lane A if its length is above the tolerance, Fallback otherwise, normalized */
+		friend FVec3x4 SafeNormal(const FVec3x4& A, const FVec3x4& Fallback)
+		{
+			const FFloat4 Tolerance(1.0e-8f);
+			const FFloat4 LengthSq = Dot(A, A);
+			const FFloat4 FallbackLengthSq = Max(Dot(Fallback, Fallback), Tolerance);
+			const FFloat4 Inv = SelectGreater(LengthSq, Tolerance, FFloat4(1.f) / Sqrt(Max(LengthSq, Tolerance)), FFloat4(1.f) / Sqrt(FallbackLengthSq));
+			return {
+				SelectGreater(LengthSq, Tolerance, A.X, Fallback.X) * Inv,
+				SelectGreater(LengthSq, Tolerance, A.Y, Fallback.Y) * Inv,
+				SelectGreater(LengthSq, Tolerance, A.Z, Fallback.Z) * Inv };
+		}
+	};
+}
@@ -0,0 +1,179 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerDebugDraw.h"
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerStats.h"
+#include "Engine/World.h"
+
+// Green for a tracked pose, yellow for a valid but inferred one, red for a lost tracker
+static FLinearColor GetStatusColor(const FViveTrackerSample& Sample)
+{
+	if (!Sample.HasValidPose())
+		return FLinearColor::Red;
+
+	const bool bTracked = (Sample.LocationFlags & XR_SPACE_LOCATION_POSITION_TRACKED_BIT) && (Sample.LocationFlags & XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT);
+	return bTracked ? FLinearColor::Green : FLinearColor::Yellow;
+}
+
+FViveTrackerDebugDraw::FViveTrackerDebugDraw(const FOpenXRViveTrackerModule& Module, const FViveTrackerDebugDrawSettings& Settings)
+	: m_module(Module)
+{
+	for (int32 nRole = 0; nRole < (int32)ETrackerRole::Unassigned; nRole++)
+	{
+		m_arrRoles.Add((ETrackerRole)nRole);
+	}
+	m_arrSamples.SetNum(m_arrRoles.Num());
+	m_arrTrails.SetNum(m_arrRoles.Num());
+
+	SetSettings(Settings);
+
+	m_hPostActorTick = FWorldDelegates::OnWorldPostActorTick.AddRaw(this, &FViveTrackerDebugDraw::OnWorldPostActorTick);
+}
+
+FViveTrackerDebugDraw::~FViveTrackerDebugDraw()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(m_hPostActorTick);
+}
+
+void FViveTrackerDebugDraw::SetSettings(const FViveTrackerDebugDrawSettings& Settings)
+{
+	const int32 nTrailLength = FMath::Clamp(Settings.TrailLength, 0, FViveTrackerDebugDrawSettings::MaxTrailLength);
+	const bool bTrailsChanged = nTrailLength != m_settings.TrailLength || m_arrTrailPoints.Num() == 0;
+	m_settings = Settings;
+	m_settings.TrailLength = nTrailLength;
+
+	if (bTrailsChanged)
+	{
+		for (FTrail& trail : m_arrTrails)
+		{
+			trail = FTrail();
+		}
+		m_arrTrailPoints.SetNumUninitialized(m_arrRoles.Num() * m_settings.TrailLength);
+	}
+
+	// Every role's axes, velocity and trail, so building a frame never grows the arrays
+	m_arrLines.Reserve(m_arrRoles.Num() * (4 + FMath::Max(m_settings.TrailLength - 1, 0)));
+	m_arrPoints.Reserve(m_arrRoles.Num());
+}
+
+void FViveTrackerDebugDraw::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ViveTracker_DebugDraw);
+
+	// Level editor worlds only show trackers while a capture is replayed, like UViveTrackerComponent
+	if (!World || (TickType == LEVELTICK_ViewportsOnly && !m_module.IsReplaying()))
+		return;
+
+	ULineBatchComponent* pLineBatcher = m_settings.bForeground ? World->ForegroundLineBatcher : World->LineBatcher;
+	if (!pLineBatcher)
+		return;
+
+	// Several worlds can tick in a frame, e.g. in play in editor, the trackers only move once
+	if (m_nLastUpdateFrame != GFrameCounter)
+	{
+		m_nLastUpdateFrame = GFrameCounter;
+		m_module.GetTrackerSamples(m_arrRoles, m_arrSamples);
+		UpdateTrails();
+		BuildPrimitives(m_settings.bForeground ? SDPG_Foreground : SDPG_World);
+	}
+
+	// The whole frame as one batch, which lasts until the world's next tick like any non-persistent debug line
+	if (m_arrLines.Num() > 0 || m_arrPoints.Num() > 0)
+	{
+		pLineBatcher->BatchedLines.Append(m_arrLines);
+		pLineBatcher->BatchedPoints.Append(m_arrPoints);
+		pLineBatcher->MarkRenderStateDirty();
+	}
+}
+
+void FViveTrackerDebugDraw::UpdateTrails()
+{
+	const int32 nTrailLength = m_settings.TrailLength;
+	if (nTrailLength == 0)
+		return;
+
+	for (int32 nRole = 0; nRole < m_arrRoles.Num(); nRole++)
+	{
+		const FViveTrackerSample& sample = m_arrSamples[nRole];
+		FTrail& trail = m_arrTrails[nRole];
+		if (!sample.HasValidPose() || sample.Time == trail.LastTime)
+			continue;
+
+		trail.LastTime = sample.Time;
+		trail.Head = (trail.Head + 1) % nTrailLength;
+		trail.Num = FMath::Min(trail.Num + 1, nTrailLength);
+		m_arrTrailPoints[nRole * nTrailLength + trail.Head] = sample.Transform.GetLocation();
+	}
+}
+
+void FViveTrackerDebugDraw::BuildPrimitives(uint8 DepthPriority)
+{
+	m_arrLines.Reset();
+	m_arrPoints.Reset();
+
+	const int32 nTrailLength = m_settings.TrailLength;
+	const FVector offset = m_settings.PlayerStartLocation;
+
+	for (int32 nRole = 0; nRole < m_arrRoles.Num(); nRole++)
+	{
+		// Roles that were never located have nothing to show
+		const FViveTrackerSample& sample = m_arrSamples[nRole];
+		if (sample.Time == 0)
+			continue;
+
+		const FVector location = sample.Transform.GetLocation() + offset;
+		const FLinearColor statusColor = GetStatusColor(sample);
+		m_arrPoints.Emplace(location, statusColor, m_settings.PointSize, 0.f, DepthPriority);
+
+		if (m_settings.AxisLength > 0.f)
+		{
+			const FQuat rotation = sample.Transform.GetRotation();
+			m_arrLines.Emplace(location, location + rotation.GetAxisX() * m_settings.AxisLength, FLinearColor::Red, 0.f, 0.f, DepthPriority);
+			m_arrLines.Emplace(location, location + rotation.GetAxisY() * m_settings.AxisLength, FLinearColor::Green, 0.f, 0.f, DepthPriority);
+			m_arrLines.Emplace(location, location + rotation.GetAxisZ() * m_settings.AxisLength, FLinearColor::Blue, 0.f, 0.f, DepthPriority);
+		}
+
+		if (m_settings.VelocitySeconds > 0.f && (sample.VelocityFlags & XR_SPACE_VELOCITY_LINEAR_VALID_BIT))
+		{
+			m_arrLines.Emplace(location, location + sample.LinearVelocity * m_settings.VelocitySeconds, FLinearColor(0.f, 1.f, 1.f), 0.f, 0.f, DepthPriority);
+		}
+
+		// The trail fades out from the newest position to the oldest
+		const FTrail& trail = m_arrTrails[nRole];
+		const FVector* pTrailPoints = m_arrTrailPoints.GetData() + nRole * nTrailLength;
+		for (int32 nAge = 1; nAge < trail.Num; nAge++)
+		{
+			const FVector& newer = pTrailPoints[(trail.Head - nAge + 1 + nTrailLength) % nTrailLength];
+			const FVector& older = pTrailPoints[(trail.Head - nAge + nTrailLength) % nTrailLength];
+			const float fFade = 1.f - (float)nAge / trail.Num;
+			m_arrLines.Emplace(newer + offset, older + offset, FLinearColor(statusColor.R * fFade, statusColor.G * fFade, statusColor.B * fFade), 0.f, 0.f, DepthPriority);
+		}
+	}
+}
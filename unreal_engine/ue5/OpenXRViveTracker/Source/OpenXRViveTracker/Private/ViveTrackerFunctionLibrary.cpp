@@ -29,8 +29,123 @@ POSSIBILITY OF SUCH DAMAGE.
 
 
 #include "ViveTrackerFunctionLibrary.h"
+#include "ViveTrackerDebugDraw.h"
+#include "ViveTrackerReplay.h"
 
 FTransform UViveTrackerFunctionLibrary::GetTrackerTransform(ETrackerRole TrackerRole)
 {
 	return FOpenXRViveTrackerModule::Get().GetTrackerTransform(TrackerRole);
 }
+
+FViveTrackerBodyPose UViveTrackerFunctionLibrary::SolveFullBodyIK(const FViveTrackerBodyIKSettings& Settings, const FTransform& HeadTransform,
+	const FTransform& LeftHandTransform, bool bLeftHandTracked, const FTransform& RightHandTransform, bool bRightHandTracked)
+{
+	ViveTrackerCore::FBodySkeleton Skeleton;
+	FViveTrackerBodyIK::MakeSkeleton(Settings, Skeleton);
+
+	ViveTrackerCore::FBodyTargets Targets;
+	FViveTrackerBodyIK::GatherTargets(FOpenXRViveTrackerModule::Get(), HeadTransform,
+		bLeftHandTracked ? &LeftHandTransform : nullptr, bRightHandTracked ? &RightHandTransform : nullptr, Targets);
+
+	ViveTrackerCore::FBodyPose Pose;
+	ViveTrackerCore::SolveBody(Skeleton, Targets, Pose);
+
+	FViveTrackerBodyPose BodyPose;
+	FViveTrackerBodyIK::ToBodyPose(Pose, BodyPose);
+	return BodyPose;
+}
+
+FViveTrackerBodyPose UViveTrackerFunctionLibrary::SolveCalibratedFullBodyIK(const FViveTrackerCalibration& Calibration, const FTransform& HeadTransform,
+	const FTransform& LeftHandTransform, bool bLeftHandTracked, const FTransform& RightHandTransform, bool bRightHandTracked)
+{
+	ViveTrackerCore::FBodySkeleton Skeleton;
+	FViveTrackerBodyIK::MakeSkeleton(Calibration.Proportions, Skeleton);
+
+	ViveTrackerCore::FBodyTargets Targets;
+	FViveTrackerBodyIK::GatherTargets(FOpenXRViveTrackerModule::Get(), HeadTransform,
+		bLeftHandTracked ? &LeftHandTransform : nullptr, bRightHandTracked ? &RightHandTransform : nullptr, Targets, &Calibration);
+
+	ViveTrackerCore::FBodyPose Pose;
+	ViveTrackerCore::SolveBody(Skeleton, Targets, Pose);
+
+	FViveTrackerBodyPose BodyPose;
+	FViveTrackerBodyIK::ToBodyPose(Pose, BodyPose);
+	return BodyPose;
+}
+
+bool UViveTrackerFunctionLibrary::StartTrackerCapture(const FString& Filename, bool bCompress)
+{
+	return FOpenXRViveTrackerModule::Get().StartCapture(Filename, bCompress);
+}
+
+void UViveTrackerFunctionLibrary::StopTrackerCapture()
+{
+	FOpenXRViveTrackerModule::Get().StopCapture();
+}
+
+bool UViveTrackerFunctionLibrary::IsCapturingTrackers()
+{
+	return FOpenXRViveTrackerModule::Get().IsCapturing();
+}
+
+bool UViveTrackerFunctionLibrary::StartTrackerReplay(const FString& Filename, float PlaybackRate, float FixedStepSeconds, bool bLoop)
+{
+	FViveTrackerReplaySettings Settings;
+	Settings.PlaybackRate = PlaybackRate;
+	Settings.FixedStepSeconds = FixedStepSeconds;
+	Settings.bLoop = bLoop;
+	return FOpenXRViveTrackerModule::Get().StartReplay(Filename, Settings);
+}
+
+void UViveTrackerFunctionLibrary::StopTrackerReplay()
+{
+	FOpenXRViveTrackerModule::Get().StopReplay();
+}
+
+bool UViveTrackerFunctionLibrary::IsReplayingTrackers()
+{
+	return FOpenXRViveTrackerModule::Get().IsReplaying();
+}
+
+void UViveTrackerFunctionLibrary::SetTrackerReplayPaused(bool bPaused)
+{
+	FOpenXRViveTrackerModule::Get().SetReplayPaused(bPaused);
+}
+
+void UViveTrackerFunctionLibrary::SeekTrackerReplay(float Seconds)
+{
+	FOpenXRViveTrackerModule::Get().SeekReplay(Seconds);
+}
+
+void UViveTrackerFunctionLibrary::SetTrackerReplayRate(float PlaybackRate)
+{
+	FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	if (const FViveTrackerReplaySettings* pSettings = TrackerModule.GetReplaySettings())
+	{
+		FViveTrackerReplaySettings Settings = *pSettings;
+		Settings.PlaybackRate = PlaybackRate;
+		TrackerModule.SetReplaySettings(Settings);
+	}
+}
+
+float UViveTrackerFunctionLibrary::GetTrackerReplayPosition(float& Duration)
+{
+	const FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	Duration = (float)TrackerModule.GetReplayDuration();
+	return (float)TrackerModule.GetReplayPosition();
+}
+
+void UViveTrackerFunctionLibrary::SetTrackerDebugDraw(bool bEnabled, FVector PlayerStartLocation, int32 TrailLength)
+{
+	FOpenXRViveTrackerModule& TrackerModule = FOpenXRViveTrackerModule::Get();
+	if (!bEnabled)
+	{
+		TrackerModule.StopDebugDraw();
+		return;
+	}
+
+	FViveTrackerDebugDrawSettings Settings = TrackerModule.GetDebugDraw() ? TrackerModule.GetDebugDraw()->GetSettings() : FViveTrackerDebugDrawSettings();
+	Settings.PlayerStartLocation = PlayerStartLocation;
+	Settings.TrailLength = FMath::Clamp(TrailLength, 0, FViveTrackerDebugDrawSettings::MaxTrailLength);
+	TrackerModule.StartDebugDraw(Settings);
+}
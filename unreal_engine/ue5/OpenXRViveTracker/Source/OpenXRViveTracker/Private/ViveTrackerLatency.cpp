@@ -0,0 +1,358 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerLatency.h"
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerComponent.h"
+#include "ViveTrackerMockRuntime.h"
+#include "Async/Async.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CoreDelegates.h"
+#include "RenderingThread.h"
+
+void FViveTrackerLatencyHistogram::Add(double Seconds)
+{
+	Seconds = FMath::Max(Seconds, 0.0);
+	m_arrBuckets[FMath::Min((int32)(Seconds / BucketSeconds), NumBuckets - 1)]++;
+	m_nCount++;
+	m_fSum += Seconds;
+	m_fMax = FMath::Max(m_fMax, Seconds);
+}
+
+void FViveTrackerLatencyHistogram::Reset()
+{
+	for (uint32& nBucket : m_arrBuckets)
+	{
+		nBucket = 0;
+	}
+	m_nCount = 0;
+	m_fSum = 0.0;
+	m_fMax = 0.0;
+}
+
+double FViveTrackerLatencyHistogram::GetPercentile(double Percentile) const
+{
+	if (m_nCount == 0)
+		return 0.0;
+
+	const int64 nRank = FMath::Max((int64)FMath::CeilToDouble(FMath::Clamp(Percentile, 0.0, 1.0) * m_nCount), (int64)1);
+	int64 nBelow = 0;
+	for (int32 nBucket = 0; nBucket < NumBuckets; nBucket++)
+	{
+		nBelow += m_arrBuckets[nBucket];
+		if (nBelow >= nRank)
+			return FMath::Min((nBucket + 1) * BucketSeconds, m_fMax);
+	}
+	return m_fMax;
+}
+
+FViveTrackerLatencyRecorder::~FViveTrackerLatencyRecorder()
+{
+	Stop();
+}
+
+void FViveTrackerLatencyRecorder::Start()
+{
+	Stop();
+
+	for (FViveTrackerLatencyHistogram& Histogram : m_arrHistograms)
+	{
+		Histogram.Reset();
+	}
+	m_frameSamples.Num = 0;
+	m_fFirstFrameSeconds = 0.0;
+	m_fLastFrameSeconds = 0.0;
+	m_nFrames = 0;
+
+	m_hEndFrame = FCoreDelegates::OnEndFrame.AddRaw(this, &FViveTrackerLatencyRecorder::OnEndFrame);
+}
+
+void FViveTrackerLatencyRecorder::Stop()
+{
+	if (!IsRecording())
+		return;
+
+	FCoreDelegates::OnEndFrame.Remove(m_hEndFrame);
+	m_hEndFrame.Reset();
+
+	// Render commands still in flight point at this recorder
+	FlushRenderingCommands();
+}
+
+void FViveTrackerLatencyRecorder::RecordPublished(const FViveTrackerSample& Sample)
+{
+	if (IsRecording() && Sample.SampledSeconds > 0.0)
+	{
+		m_arrHistograms[(int32)EViveTrackerLatencyStage::Publish].Add(FPlatformTime::Seconds() - Sample.SampledSeconds);
+	}
+}
+
+void FViveTrackerLatencyRecorder::RecordConsumed(const FViveTrackerSample& Sample)
+{
+	if (!IsRecording() || Sample.SampledSeconds <= 0.0)
+		return;
+
+	m_arrHistograms[(int32)EViveTrackerLatencyStage::Component].Add(FPlatformTime::Seconds() - Sample.SampledSeconds);
+
+	// Every consumer of a frame usually applies poses from the same sync, only distinct ones are followed to the render thread
+	for (int32 nSample = 0; nSample < m_frameSamples.Num; nSample++)
+	{
+		if (m_frameSamples.SampledSeconds[nSample] == Sample.SampledSeconds)
+			return;
+	}
+
+	if (m_frameSamples.Num < FFrameSamples::Capacity)
+	{
+		m_frameSamples.SampledSeconds[m_frameSamples.Num++] = Sample.SampledSeconds;
+	}
+}
+
+void FViveTrackerLatencyRecorder::OnEndFrame()
+{
+	const double fNow = FPlatformTime::Seconds();
+	m_fFirstFrameSeconds = m_nFrames == 0 ? fNow : m_fFirstFrameSeconds;
+	m_fLastFrameSeconds = fNow;
+	m_nFrames++;
+
+	if (m_frameSamples.Num == 0)
+		return;
+
+	// Queued behind the frame's rendering, so it runs once the render thread has submitted the frame
+	const FFrameSamples FrameSamples = m_frameSamples;
+	m_frameSamples.Num = 0;
+	FViveTrackerLatencyRecorder* pRecorder = this;
+	ENQUEUE_RENDER_COMMAND(ViveTrackerLatencyRenderSubmit)(
+		[pRecorder, FrameSamples](FRHICommandListImmediate& RHICmdList)
+		{
+			pRecorder->RecordRenderSubmit(FrameSamples);
+		});
+}
+
+void FViveTrackerLatencyRecorder::RecordRenderSubmit(const FFrameSamples& FrameSamples)
+{
+	const double fNow = FPlatformTime::Seconds();
+	for (int32 nSample = 0; nSample < FrameSamples.Num; nSample++)
+	{
+		m_arrHistograms[(int32)EViveTrackerLatencyStage::RenderSubmit].Add(fNow - FrameSamples.SampledSeconds[nSample]);
+	}
+}
+
+double FViveTrackerLatencyRecorder::GetMeanFrameSeconds() const
+{
+	return m_nFrames > 1 ? (m_fLastFrameSeconds - m_fFirstFrameSeconds) / (m_nFrames - 1) : 0.0;
+}
+
+void FViveTrackerLatencyRecorder::LogReport() const
+{
+	static const TCHAR* StageNames[] = { TEXT("sample->publish"), TEXT("sample->component"), TEXT("sample->render submit") };
+	static_assert(UE_ARRAY_COUNT(StageNames) == (int32)EViveTrackerLatencyStage::Num, "Name every latency stage");
+
+	const double fFrameSeconds = GetMeanFrameSeconds();
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Tracker latency over %lld frames, %.3f ms per frame"), m_nFrames, fFrameSeconds * 1.0e3);
+
+	for (int32 nStage = 0; nStage < (int32)EViveTrackerLatencyStage::Num; nStage++)
+	{
+		const FViveTrackerLatencyHistogram& Histogram = m_arrHistograms[nStage];
+		if (Histogram.Num() == 0)
+		{
+			UE_LOG(LogOpenXRViveTracker, Display, TEXT("  %-22s no samples"), StageNames[nStage]);
+			continue;
+		}
+
+		const double fP99 = Histogram.GetPercentile(0.99);
+		UE_LOG(LogOpenXRViveTracker, Display, TEXT("  %-22s %8lld samples  mean %7.3f  p50 %7.3f  p90 %7.3f  p99 %7.3f  max %7.3f ms  (p99 %.2f frames)"),
+			StageNames[nStage], Histogram.Num(), Histogram.GetMean() * 1.0e3, Histogram.GetPercentile(0.5) * 1.0e3,
+			Histogram.GetPercentile(0.9) * 1.0e3, fP99 * 1.0e3, Histogram.GetMax() * 1.0e3, fFrameSeconds > 0.0 ? fP99 / fFrameSeconds : 0.0);
+	}
+}
+
+/**
+* Runs a latency measurement over real engine frames, with a tracker component per role in the game world if there
+* is one. The module's trackers come from the mock runtime, or from the real one if it already has a session.
+*/
+class FViveTrackerLatencyHarness
+{
+public:
+	~FViveTrackerLatencyHarness()
+	{
+		Finish();
+	}
+
+	bool Start(double Duration, int32 NumTrackers)
+	{
+		FOpenXRViveTrackerModule& Module = FOpenXRViveTrackerModule::Get();
+		if (Module.IsReplaying())
+		{
+			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Latency measurement: stop the tracker replay first"));
+			return false;
+		}
+
+		if (!GEngine)
+		{
+			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Latency measurement: needs the engine's frame loop"));
+			return false;
+		}
+
+		if (!Module.IsActionsGenerated())
+		{
+			for (int32 nTracker = 0; nTracker < NumTrackers; nTracker++)
+			{
+				m_mock.AddTracker(FViveTrackerMockRuntime::MakeOrbitingTracker(nTracker));
+			}
+
+			if (!m_mock.Start(Module))
+				return false;
+		}
+
+		SpawnComponents();
+
+		m_fDuration = Duration;
+		m_fStartSeconds = FPlatformTime::Seconds();
+		m_hBeginFrame = FCoreDelegates::OnBeginFrame.AddRaw(this, &FViveTrackerLatencyHarness::OnBeginFrame);
+		Module.StartLatencyRecording();
+
+		UE_LOG(LogOpenXRViveTracker, Display, TEXT("Measuring tracker latency for %.1f seconds with the %s runtime and %d tracker components"),
+			Duration, m_mock.IsRunning() ? TEXT("mock") : TEXT("OpenXR"), m_pActor.IsValid() ? (int32)ETrackerRole::Unassigned : 0);
+		return true;
+	}
+
+	void Finish()
+	{
+		if (!m_hBeginFrame.IsValid())
+			return;
+
+		FCoreDelegates::OnBeginFrame.Remove(m_hBeginFrame);
+		m_hBeginFrame.Reset();
+
+		FOpenXRViveTrackerModule& Module = FOpenXRViveTrackerModule::Get();
+		Module.StopLatencyRecording();
+		if (const FViveTrackerLatencyRecorder* pRecorder = Module.GetLatencyRecorder())
+		{
+			pRecorder->LogReport();
+		}
+
+		if (AActor* pActor = m_pActor.Get())
+		{
+			pActor->Destroy();
+		}
+		m_mock.Stop();
+	}
+
+private:
+	FViveTrackerMockRuntime m_mock;
+	TWeakObjectPtr<AActor> m_pActor;
+	FDelegateHandle m_hBeginFrame;
+	double m_fDuration = 0.0;
+	double m_fStartSeconds = 0.0;
+
+	void SpawnComponents()
+	{
+		UWorld* pWorld = nullptr;
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World() && Context.World()->HasBegunPlay())
+			{
+				pWorld = Context.World();
+				break;
+			}
+		}
+
+		if (!pWorld)
+		{
+			UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Latency measurement: no game world, only the publish stage will be measured"));
+			return;
+		}
+
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		AActor* pActor = pWorld->SpawnActor<AActor>(SpawnParameters);
+		if (!pActor)
+			return;
+
+		USceneComponent* pRoot = NewObject<USceneComponent>(pActor, TEXT("Root"));
+		pActor->SetRootComponent(pRoot);
+		pRoot->RegisterComponent();
+
+		for (int32 nRole = 0; nRole < (int32)ETrackerRole::Unassigned; nRole++)
+		{
+			UViveTrackerComponent* pComponent = NewObject<UViveTrackerComponent>(pActor);
+			pComponent->TrackerRole = (ETrackerRole)nRole;
+			pComponent->SetupAttachment(pRoot);
+			pComponent->RegisterComponent();
+		}
+		m_pActor = pActor;
+	}
+
+	void OnBeginFrame()
+	{
+		// Stands in for the OpenXR plugin syncing actions at the start of the frame
+		if (m_mock.IsRunning())
+		{
+			m_mock.Tick(FMath::Clamp(FApp::GetDeltaTime(), 0.0, 0.1));
+		}
+
+		if (FPlatformTime::Seconds() - m_fStartSeconds >= m_fDuration)
+		{
+			Finish();
+		}
+	}
+};
+
+static TUniquePtr<FViveTrackerLatencyHarness> GLatencyHarness;
+
+/** Measure the latency distributions from sampling to publishing, tracker components and render submission over real frames */
+static void MeasureLatency(const TArray<FString>& Args)
+{
+	const double Duration = Args.Num() > 0 ? FMath::Clamp(FCString::Atod(*Args[0]), 1.0, 3600.0) : 10.0;
+	const int32 NumTrackers = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 1, (int32)ETrackerRole::Unassigned) : (int32)ETrackerRole::Unassigned;
+
+	// A measurement still running at exit is finished while the module is still loaded
+	static FDelegateHandle hPreExit;
+	if (!hPreExit.IsValid())
+	{
+		hPreExit = FCoreDelegates::OnPreExit.AddLambda([]() { GLatencyHarness.Reset(); });
+	}
+
+	GLatencyHarness.Reset();
+	TUniquePtr<FViveTrackerLatencyHarness> pHarness = MakeUnique<FViveTrackerLatencyHarness>();
+	if (pHarness->Start(Duration, NumTrackers))
+	{
+		GLatencyHarness = MoveTemp(pHarness);
+	}
+}
+
+static FAutoConsoleCommand MeasureLatencyCommand(
+	TEXT("vivetracker.MeasureLatency"),
+	TEXT("Report sample->publish->component->render submit latency distributions over real frames, with tracker components spawned in the game world. ")
+	TEXT("Uses the mock runtime unless an OpenXR session is running. Args: [seconds=10] [trackers=12]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MeasureLatency));
@@ -0,0 +1,1038 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerMockRuntime.h"
+#include "ViveTrackerAllocationCounter.h"
+#include "ViveTrackerComponent.h"
+#include "Algo/BinarySearch.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+
+// Entry points the mock takes over, with the engine's global each one replaces
+#define VIVETRACKER_MOCK_ENTRY_POINTS(Entry) \
+	Entry(PFN_xrGetInstanceProcAddr, xrGetInstanceProcAddr, GetInstanceProcAddr) \
+	Entry(PFN_xrCreateActionSet, xrCreateActionSet, CreateActionSet) \
+	Entry(PFN_xrDestroyActionSet, xrDestroyActionSet, DestroyActionSet) \
+	Entry(PFN_xrCreateAction, xrCreateAction, CreateAction) \
+	Entry(PFN_xrDestroyAction, xrDestroyAction, DestroyAction) \
+	Entry(PFN_xrCreateActionSpace, xrCreateActionSpace, CreateActionSpace) \
+	Entry(PFN_xrSuggestInteractionProfileBindings, xrSuggestInteractionProfileBindings, SuggestInteractionProfileBindings) \
+	Entry(PFN_xrLocateSpace, xrLocateSpace, LocateSpace) \
+	Entry(PFN_xrStringToPath, xrStringToPath, StringToPathEntry) \
+	Entry(PFN_xrPathToString, xrPathToString, PathToString)
+
+#define VIVETRACKER_MOCK_DECLARE_REAL(Type, Global, Mock) static Type GReal_##Global = nullptr;
+VIVETRACKER_MOCK_ENTRY_POINTS(VIVETRACKER_MOCK_DECLARE_REAL)
+#undef VIVETRACKER_MOCK_DECLARE_REAL
+
+static FViveTrackerMockRuntime* GActiveMockRuntime = nullptr;
+
+// Handles are small integers, one range per handle type
+static const XrInstance MockInstance = (XrInstance)(uintptr_t)0x1001;
+static const XrSession MockSession = (XrSession)(uintptr_t)0x2001;
+static const XrActionSet MockActionSet = (XrActionSet)(uintptr_t)0x3001;
+static const XrSpace MockBaseSpace = (XrSpace)(uintptr_t)0x4001;
+static constexpr uint64 ActionHandleBase = 0x10000;
+static constexpr uint64 SpaceHandleBase = 0x20000;
+static constexpr uint64 HandleRangeSize = 0x10000;
+
+template <typename HandleType>
+static int32 GetHandleIndex(HandleType Handle, uint64 Base, int32 Num)
+{
+	const uint64 nValue = (uint64)(uintptr_t)Handle;
+	return nValue > Base && nValue <= Base + (uint64)Num && nValue < Base + HandleRangeSize ? (int32)(nValue - Base - 1) : INDEX_NONE;
+}
+
+FViveTrackerMockRuntime::~FViveTrackerMockRuntime()
+{
+	Stop();
+}
+
+bool FViveTrackerMockRuntime::Start(FOpenXRViveTrackerModule& Module)
+{
+	if (IsRunning())
+		return true;
+
+	if (GActiveMockRuntime)
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Another mock OpenXR runtime is already running"));
+		return false;
+	}
+
+	if (Module.IsActionsGenerated())
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to start the mock OpenXR runtime, the module already has a runtime session"));
+		return false;
+	}
+
+#define VIVETRACKER_MOCK_INSTALL(Type, Global, Mock) GReal_##Global = Global; Global = &FViveTrackerMockRuntime::Mock;
+	VIVETRACKER_MOCK_ENTRY_POINTS(VIVETRACKER_MOCK_INSTALL)
+#undef VIVETRACKER_MOCK_INSTALL
+
+	GActiveMockRuntime = this;
+	m_pModule = &Module;
+	m_fSeconds = 0.0;
+	m_nNextScriptEvent = 0;
+	for (FTrackerState& Tracker : m_arrTrackers)
+	{
+		Tracker.bConnected = false;
+		Tracker.Paths.rolePath = Tracker.Script.Role != ETrackerRole::Unassigned ? StringToPath(FOpenXRViveTrackerModule::GetTrackerRolePath(Tracker.Script.Role)) : XR_NULL_PATH;
+	}
+	RebuildRoleTrackers();
+
+	// The order the OpenXR plugin creates things in
+	Module.PostCreateInstance(MockInstance);
+	Module.PostCreateSession(MockSession);
+	Module.UpdateDeviceLocations(MockSession, GetTime(), MockBaseSpace);
+
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Mock OpenXR runtime started with %d scripted trackers"), m_arrTrackers.Num());
+	return true;
+}
+
+void FViveTrackerMockRuntime::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	// The module destroys its actions through the mock's entry points
+	m_pModule->ReleaseRuntimeResources();
+	m_pModule = nullptr;
+
+#define VIVETRACKER_MOCK_RESTORE(Type, Global, Mock) Global = GReal_##Global; GReal_##Global = nullptr;
+	VIVETRACKER_MOCK_ENTRY_POINTS(VIVETRACKER_MOCK_RESTORE)
+#undef VIVETRACKER_MOCK_RESTORE
+
+	GActiveMockRuntime = nullptr;
+	m_arrActions.Reset();
+	m_arrSpaceActions.Reset();
+
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Mock OpenXR runtime stopped after %lld locates and %lld events"), m_nLocateCalls, m_nEventsSent);
+}
+
+int32 FViveTrackerMockRuntime::AddTracker(const FViveTrackerMockTracker& Tracker, double ConnectSeconds)
+{
+	FTrackerState& State = m_arrTrackers.AddDefaulted_GetRef();
+	State.Script = Tracker;
+	State.Paths = XrViveTrackerPathsHTCX{ XR_TYPE_VIVE_TRACKER_PATHS_HTCX };
+	State.Paths.persistentPath = StringToPath(TCHAR_TO_UTF8(*Tracker.PersistentPath));
+	State.Paths.rolePath = Tracker.Role != ETrackerRole::Unassigned ? StringToPath(FOpenXRViveTrackerModule::GetTrackerRolePath(Tracker.Role)) : XR_NULL_PATH;
+
+	const int32 nTracker = m_arrTrackers.Num() - 1;
+	AddScriptEvent(FScriptEvent{ ConnectSeconds, nTracker, EScriptEvent::Connect, Tracker.Role });
+	return nTracker;
+}
+
+void FViveTrackerMockRuntime::Disconnect(int32 TrackerIndex, double Seconds)
+{
+	AddScriptEvent(FScriptEvent{ Seconds, TrackerIndex, EScriptEvent::Disconnect, ETrackerRole::Unassigned });
+}
+
+void FViveTrackerMockRuntime::Connect(int32 TrackerIndex, double Seconds)
+{
+	AddScriptEvent(FScriptEvent{ Seconds, TrackerIndex, EScriptEvent::Connect, m_arrTrackers[TrackerIndex].Script.Role });
+}
+
+void FViveTrackerMockRuntime::ChangeRole(int32 TrackerIndex, ETrackerRole Role, double Seconds)
+{
+	AddScriptEvent(FScriptEvent{ Seconds, TrackerIndex, EScriptEvent::ChangeRole, Role });
+}
+
+void FViveTrackerMockRuntime::AddScriptEvent(const FScriptEvent& Event)
+{
+	// Kept in time order, events at the same time in the order they were scripted
+	const int32 nIndex = Algo::UpperBoundBy(m_arrScript, Event.Seconds, [](const FScriptEvent& ScriptEvent) { return ScriptEvent.Seconds; });
+	m_arrScript.Insert(Event, FMath::Max(nIndex, m_nNextScriptEvent));
+}
+
+void FViveTrackerMockRuntime::ApplyScriptEvent(const FScriptEvent& Event)
+{
+	if (!m_arrTrackers.IsValidIndex(Event.TrackerIndex))
+		return;
+
+	FTrackerState& Tracker = m_arrTrackers[Event.TrackerIndex];
+	switch (Event.Type)
+	{
+	case EScriptEvent::Connect:
+	case EScriptEvent::ChangeRole:
+		Tracker.bConnected = true;
+		Tracker.Script.Role = Event.Role;
+		Tracker.Paths.rolePath = Event.Role != ETrackerRole::Unassigned ? StringToPath(FOpenXRViveTrackerModule::GetTrackerRolePath(Event.Role)) : XR_NULL_PATH;
+		break;
+
+	case EScriptEvent::Disconnect:
+		Tracker.bConnected = false;
+		break;
+	}
+	RebuildRoleTrackers();
+
+	// The extension only has a connect event, runtimes send it again when a role changes
+	if (Event.Type != EScriptEvent::Disconnect)
+	{
+		SendConnectEvent(Event.TrackerIndex);
+	}
+}
+
+void FViveTrackerMockRuntime::SendConnectEvent(int32 TrackerIndex)
+{
+	if (!m_pModule || !m_arrTrackers.IsValidIndex(TrackerIndex) || !m_arrTrackers[TrackerIndex].bConnected)
+		return;
+
+	XrEventDataViveTrackerConnectedHTCX xrEvent{ XR_TYPE_EVENT_DATA_VIVE_TRACKER_CONNECTED_HTCX };
+	xrEvent.paths = &m_arrTrackers[TrackerIndex].Paths;
+	m_nEventsSent++;
+
+	m_bInEvent = true;
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	if (m_bCountEventAllocations)
+	{
+		FViveTrackerAllocationScope AllocationScope;
+		m_pModule->OnEvent(MockSession, reinterpret_cast<const XrEventDataBaseHeader*>(&xrEvent));
+		m_nEventAllocations += (int64)AllocationScope.GetNumAllocations();
+	}
+	else
+	{
+		m_pModule->OnEvent(MockSession, reinterpret_cast<const XrEventDataBaseHeader*>(&xrEvent));
+	}
+	m_fEventSeconds += FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	m_bInEvent = false;
+}
+
+void FViveTrackerMockRuntime::RebuildRoleTrackers()
+{
+	for (int32& nTracker : m_arrRoleTrackers)
+	{
+		nTracker = INDEX_NONE;
+	}
+
+	// The first connected tracker wins a role, like a runtime would only bind one
+	for (int32 nTracker = 0; nTracker < m_arrTrackers.Num(); nTracker++)
+	{
+		const FTrackerState& Tracker = m_arrTrackers[nTracker];
+		if (Tracker.bConnected && Tracker.Script.Role != ETrackerRole::Unassigned && m_arrRoleTrackers[Tracker.Script.Role] == INDEX_NONE)
+		{
+			m_arrRoleTrackers[Tracker.Script.Role] = nTracker;
+		}
+	}
+}
+
+int32 FViveTrackerMockRuntime::FindRoleTracker(ETrackerRole Role) const
+{
+	return Role < ETrackerRole::Unassigned ? m_arrRoleTrackers[Role] : INDEX_NONE;
+}
+
+void FViveTrackerMockRuntime::RecordRuntimeCall()
+{
+	if (GActiveMockRuntime && GActiveMockRuntime->m_bInEvent)
+	{
+		GActiveMockRuntime->m_nEventRuntimeCalls++;
+	}
+}
+
+XrPath FViveTrackerMockRuntime::StringToPath(const char* pString)
+{
+	const FString sPath(UTF8_TO_TCHAR(pString));
+	if (const XrPath* pPath = m_mapPaths.Find(sPath))
+		return *pPath;
+
+	m_arrPathStrings.Add(sPath);
+	const XrPath xrPath = (XrPath)m_arrPathStrings.Num();
+	m_mapPaths.Add(sPath, xrPath);
+	return xrPath;
+}
+
+void FViveTrackerMockRuntime::Tick(double DeltaSeconds)
+{
+	if (!IsRunning())
+		return;
+
+	m_fSeconds += DeltaSeconds;
+
+	// Events first, like the OpenXR plugin polls them before the frame
+	while (m_nNextScriptEvent < m_arrScript.Num() && m_arrScript[m_nNextScriptEvent].Seconds <= m_fSeconds)
+	{
+		ApplyScriptEvent(m_arrScript[m_nNextScriptEvent++]);
+	}
+
+	m_pModule->UpdateDeviceLocations(MockSession, GetTime(), MockBaseSpace);
+	m_pModule->PostSyncActions(MockSession);
+}
+
+bool FViveTrackerMockRuntime::GetExpectedPose(int32 TrackerIndex, double Seconds, FTransform& OutPose) const
+{
+	if (!m_arrTrackers.IsValidIndex(TrackerIndex))
+		return false;
+
+	// Replays the script up to the time, the tracker's state now may differ
+	const FTrackerState& Tracker = m_arrTrackers[TrackerIndex];
+	bool bConnected = false;
+	ETrackerRole role = ETrackerRole::Unassigned;
+	for (const FScriptEvent& Event : m_arrScript)
+	{
+		if (Event.Seconds > Seconds)
+			break;
+
+		if (Event.TrackerIndex == TrackerIndex)
+		{
+			bConnected = Event.Type != EScriptEvent::Disconnect;
+			role = Event.Type != EScriptEvent::Disconnect ? Event.Role : role;
+		}
+	}
+
+	if (!bConnected || role == ETrackerRole::Unassigned)
+		return false;
+
+	return GetScriptedPose(Tracker, Seconds, OutPose);
+}
+
+bool FViveTrackerMockRuntime::GetScriptedPose(const FTrackerState& Tracker, double Seconds, FTransform& OutPose) const
+{
+	if (!Tracker.Script.Trajectory)
+		return false;
+
+	for (const TRange<double>& Dropout : Tracker.Script.Dropouts)
+	{
+		if (Dropout.Contains(Seconds))
+			return false;
+	}
+
+	OutPose = Tracker.Script.Trajectory(Seconds);
+	return true;
+}
+
+XrInstance FViveTrackerMockRuntime::GetInstance() const
+{
+	return MockInstance;
+}
+
+XrSession FViveTrackerMockRuntime::GetSession() const
+{
+	return MockSession;
+}
+
+XrSpace FViveTrackerMockRuntime::GetBaseSpace() const
+{
+	return MockBaseSpace;
+}
+
+ViveTrackerCore::FXrEntryPoints FViveTrackerMockRuntime::GetEntryPoints()
+{
+	ViveTrackerCore::FXrEntryPoints xrEntryPoints;
+	xrEntryPoints.GetInstanceProcAddr = &FViveTrackerMockRuntime::GetInstanceProcAddr;
+	xrEntryPoints.CreateActionSet = &FViveTrackerMockRuntime::CreateActionSet;
+	xrEntryPoints.DestroyActionSet = &FViveTrackerMockRuntime::DestroyActionSet;
+	xrEntryPoints.CreateAction = &FViveTrackerMockRuntime::CreateAction;
+	xrEntryPoints.DestroyAction = &FViveTrackerMockRuntime::DestroyAction;
+	xrEntryPoints.CreateActionSpace = &FViveTrackerMockRuntime::CreateActionSpace;
+	xrEntryPoints.SuggestInteractionProfileBindings = &FViveTrackerMockRuntime::SuggestInteractionProfileBindings;
+	xrEntryPoints.LocateSpace = &FViveTrackerMockRuntime::LocateSpace;
+	xrEntryPoints.StringToPath = &FViveTrackerMockRuntime::StringToPathEntry;
+	xrEntryPoints.PathToString = &FViveTrackerMockRuntime::PathToString;
+	return xrEntryPoints;
+}
+
+FViveTrackerMockTracker FViveTrackerMockRuntime::MakeOrbitingTracker(int32 Index)
+{
+	FViveTrackerMockTracker Tracker;
+	Tracker.PersistentPath = FString::Printf(TEXT("/devices/htc/vive_trackerMOCK-%04d"), Index);
+	Tracker.Role = (ETrackerRole)(Index % (int32)ETrackerRole::Unassigned);
+
+	// Spread over a body sized volume, each with its own orbit so no two trackers move alike
+	const FVector Center(20.f * (Index % 5) - 40.f, 15.f * ((Index / 5) % 5) - 30.f, 20.f + 15.f * (Index % 11));
+	const float Radius = 5.f + 2.f * (Index % 7);
+	const float Frequency = 0.3f + 0.17f * (Index % 13);
+	const float Phase = 0.7f * Index;
+	Tracker.Trajectory = [Center, Radius, Frequency, Phase](double Seconds)
+	{
+		const float Angle = (float)(2.0 * PI * Frequency * Seconds) + Phase;
+		const FVector Location = Center + FVector(Radius * FMath::Cos(Angle), Radius * FMath::Sin(Angle), 0.5f * Radius * FMath::Sin(2.f * Angle));
+		const FRotator Rotation(20.f * FMath::Sin(Angle), FMath::RadiansToDegrees(Angle), 10.f * FMath::Cos(3.f * Angle));
+		return FTransform(Rotation, Location);
+	};
+	return Tracker;
+}
+
+XrResult FViveTrackerMockRuntime::GetInstanceProcAddr(XrInstance Instance, const char* pName, PFN_xrVoidFunction* pFunction)
+{
+	RecordRuntimeCall();
+
+	if (!GActiveMockRuntime || Instance != MockInstance || !pName || !pFunction)
+		return XR_ERROR_HANDLE_INVALID;
+
+	if (FCStringAnsi::Strcmp(pName, "xrEnumerateViveTrackerPathsHTCX") == 0)
+	{
+		*pFunction = (PFN_xrVoidFunction)&FViveTrackerMockRuntime::EnumerateViveTrackerPaths;
+		return XR_SUCCESS;
+	}
+
+	*pFunction = nullptr;
+	return XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+XrResult FViveTrackerMockRuntime::CreateActionSet(XrInstance Instance, const XrActionSetCreateInfo* pCreateInfo, XrActionSet* pActionSet)
+{
+	RecordRuntimeCall();
+
+	if (!GActiveMockRuntime || Instance != MockInstance)
+		return XR_ERROR_HANDLE_INVALID;
+
+	*pActionSet = MockActionSet;
+	return XR_SUCCESS;
+}
+
+XrResult FViveTrackerMockRuntime::DestroyActionSet(XrActionSet ActionSet)
+{
+	return ActionSet == MockActionSet ? XR_SUCCESS : XR_ERROR_HANDLE_INVALID;
+}
+
+XrResult FViveTrackerMockRuntime::CreateAction(XrActionSet ActionSet, const XrActionCreateInfo* pCreateInfo, XrAction* pAction)
+{
+	RecordRuntimeCall();
+
+	if (!GActiveMockRuntime || ActionSet != MockActionSet)
+		return XR_ERROR_HANDLE_INVALID;
+
+	if (pCreateInfo->actionType != XR_ACTION_TYPE_POSE_INPUT || GActiveMockRuntime->m_arrActions.Num() + 1 >= (int32)HandleRangeSize)
+		return XR_ERROR_FEATURE_UNSUPPORTED;
+
+	GActiveMockRuntime->m_arrActions.AddDefaulted();
+	*pAction = (XrAction)(uintptr_t)(ActionHandleBase + GActiveMockRuntime->m_arrActions.Num());
+	return XR_SUCCESS;
+}
+
+XrResult FViveTrackerMockRuntime::DestroyAction(XrAction Action)
+{
+	if (!GActiveMockRuntime || GetHandleIndex(Action, ActionHandleBase, GActiveMockRuntime->m_arrActions.Num()) == INDEX_NONE)
+		return XR_ERROR_HANDLE_INVALID;
+
+	return XR_SUCCESS;
+}
+
+XrResult FViveTrackerMockRuntime::CreateActionSpace(XrSession Session, const XrActionSpaceCreateInfo* pCreateInfo, XrSpace* pSpace)
+{
+	RecordRuntimeCall();
+
+	if (!GActiveMockRuntime || Session != MockSession)
+		return XR_ERROR_HANDLE_INVALID;
+
+	const int32 nAction = GetHandleIndex(pCreateInfo->action, ActionHandleBase, GActiveMockRuntime->m_arrActions.Num());
+	if (nAction == INDEX_NONE || GActiveMockRuntime->m_arrSpaceActions.Num() + 1 >= (int32)HandleRangeSize)
+		return XR_ERROR_HANDLE_INVALID;
+
+	GActiveMockRuntime->m_arrSpaceActions.Add(nAction);
+	*pSpace = (XrSpace)(uintptr_t)(SpaceHandleBase + GActiveMockRuntime->m_arrSpaceActions.Num());
+	return XR_SUCCESS;
+}
+
+XrResult FViveTrackerMockRuntime::SuggestInteractionProfileBindings(XrInstance Instance, const XrInteractionProfileSuggestedBinding* pSuggestedBindings)
+{
+	RecordRuntimeCall();
+
+	if (!GActiveMockRuntime || Instance != MockInstance)
+		return XR_ERROR_HANDLE_INVALID;
+
+	FViveTrackerMockRuntime& Mock = *GActiveMockRuntime;
+	if (!Mock.m_arrPathStrings.IsValidIndex((int32)pSuggestedBindings->interactionProfile - 1) ||
+		Mock.m_arrPathStrings[(int32)pSuggestedBindings->interactionProfile - 1] != TEXT("/interaction_profiles/htc/vive_tracker_htcx"))
+		return XR_ERROR_PATH_UNSUPPORTED;
+
+	// Bindings are <role path>/input/grip/pose
+	for (uint32_t nBinding = 0; nBinding < pSuggestedBindings->countSuggestedBindings; nBinding++)
+	{
+		const XrActionSuggestedBinding& Binding = pSuggestedBindings->suggestedBindings[nBinding];
+		const int32 nAction = GetHandleIndex(Binding.action, ActionHandleBase, Mock.m_arrActions.Num());
+		if (nAction == INDEX_NONE || !Mock.m_arrPathStrings.IsValidIndex((int32)Binding.binding - 1))
+			return XR_ERROR_HANDLE_INVALID;
+
+		FString sRolePath = Mock.m_arrPathStrings[(int32)Binding.binding - 1];
+		if (!sRolePath.RemoveFromEnd(TEXT("/input/grip/pose")))
+			return XR_ERROR_PATH_UNSUPPORTED;
+
+		const ETrackerRole role = FOpenXRViveTrackerModule::GetTrackerRoleFromPath(TCHAR_TO_UTF8(*sRolePath));
+		if (role == ETrackerRole::Unassigned)
+			return XR_ERROR_PATH_UNSUPPORTED;
+
+		Mock.m_arrActions[nAction].Role = role;
+	}
+	return XR_SUCCESS;
+}
+
+XrResult FViveTrackerMockRuntime::LocateSpace(XrSpace Space, XrSpace BaseSpace, XrTime Time, XrSpaceLocation* pLocation)
+{
+	RecordRuntimeCall();
+
+	if (!GActiveMockRuntime || BaseSpace != MockBaseSpace)
+		return XR_ERROR_HANDLE_INVALID;
+
+	FViveTrackerMockRuntime& Mock = *GActiveMockRuntime;
+	const int32 nSpace = GetHandleIndex(Space, SpaceHandleBase, Mock.m_arrSpaceActions.Num());
+	if (nSpace == INDEX_NONE)
+		return XR_ERROR_HANDLE_INVALID;
+
+	Mock.m_nLocateCalls++;
+
+	XrSpaceVelocity* pVelocity = nullptr;
+	for (XrBaseOutStructure* pNext = reinterpret_cast<XrBaseOutStructure*>(pLocation->next); pNext; pNext = pNext->next)
+	{
+		if (pNext->type == XR_TYPE_SPACE_VELOCITY)
+		{
+			pVelocity = reinterpret_cast<XrSpaceVelocity*>(pNext);
+		}
+	}
+
+	pLocation->locationFlags = 0;
+	if (pVelocity)
+	{
+		pVelocity->velocityFlags = 0;
+	}
+
+	// Untracked actions still succeed, with no valid bits. The role's tracker is connected as of the last frame,
+	// so only its dropouts are checked rather than replaying the script
+	const double fSeconds = (Time - StartTime) * 1.0e-9;
+	const int32 nTracker = Mock.FindRoleTracker(Mock.m_arrActions[Mock.m_arrSpaceActions[nSpace]].Role);
+	FTransform Pose;
+	if (nTracker == INDEX_NONE || !Mock.GetScriptedPose(Mock.m_arrTrackers[nTracker], fSeconds, Pose))
+		return XR_SUCCESS;
+
+	pLocation->locationFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT |
+		XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+	pLocation->pose.orientation = ToXrQuat(Pose.GetRotation());
+	pLocation->pose.position = ToXrVector(Pose.GetLocation(), 100.f);
+
+	if (pVelocity)
+	{
+		// Central differences over a millisecond, angular velocity flips with the change of handedness like the module expects
+		constexpr double Step = 0.0005;
+		const TFunction<FTransform(double)>& Trajectory = Mock.m_arrTrackers[nTracker].Script.Trajectory;
+		const FTransform Before = Trajectory(fSeconds - Step);
+		const FTransform After = Trajectory(fSeconds + Step);
+
+		FQuat Delta = After.GetRotation() * Before.GetRotation().Inverse();
+		if (Delta.W < 0.f)
+		{
+			Delta *= -1.f;
+		}
+
+		pVelocity->velocityFlags = XR_SPACE_VELOCITY_LINEAR_VALID_BIT | XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
+		pVelocity->linearVelocity = ToXrVector((After.GetLocation() - Before.GetLocation()) * (float)(0.5 / Step), 100.f);
+		pVelocity->angularVelocity = ToXrVector(-Delta.GetRotationAxis() * (float)(Delta.GetAngle() * 0.5 / Step));
+	}
+	return XR_SUCCESS;
+}
+
+XrResult FViveTrackerMockRuntime::StringToPathEntry(XrInstance Instance, const char* pPathString, XrPath* pPath)
+{
+	RecordRuntimeCall();
+
+	if (!GActiveMockRuntime || Instance != MockInstance)
+		return XR_ERROR_HANDLE_INVALID;
+
+	if (!pPathString || pPathString[0] != '/')
+		return XR_ERROR_PATH_FORMAT_INVALID;
+
+	*pPath = GActiveMockRuntime->StringToPath(pPathString);
+	return XR_SUCCESS;
+}
+
+XrResult FViveTrackerMockRuntime::PathToString(XrInstance Instance, XrPath Path, uint32_t BufferCapacityInput, uint32_t* pBufferCountOutput, char* pBuffer)
+{
+	RecordRuntimeCall();
+
+	if (!GActiveMockRuntime || Instance != MockInstance)
+		return XR_ERROR_HANDLE_INVALID;
+
+	if (!GActiveMockRuntime->m_arrPathStrings.IsValidIndex((int32)Path - 1))
+		return XR_ERROR_PATH_INVALID;
+
+	// Two call idiom, the count includes the terminator
+	const FTCHARToUTF8 PathString(*GActiveMockRuntime->m_arrPathStrings[(int32)Path - 1]);
+	*pBufferCountOutput = (uint32_t)PathString.Length() + 1;
+	if (BufferCapacityInput == 0)
+		return XR_SUCCESS;
+
+	if (BufferCapacityInput < *pBufferCountOutput)
+		return XR_ERROR_SIZE_INSUFFICIENT;
+
+	FMemory::Memcpy(pBuffer, PathString.Get(), PathString.Length());
+	pBuffer[PathString.Length()] = '\0';
+	return XR_SUCCESS;
+}
+
+XrResult FViveTrackerMockRuntime::EnumerateViveTrackerPaths(XrInstance Instance, uint32_t PathCapacityInput, uint32_t* pPathCountOutput, XrViveTrackerPathsHTCX* pPaths)
+{
+	RecordRuntimeCall();
+
+	if (!GActiveMockRuntime || Instance != MockInstance)
+		return XR_ERROR_HANDLE_INVALID;
+
+	FViveTrackerMockRuntime& Mock = *GActiveMockRuntime;
+	Mock.m_nEnumerateCalls++;
+
+	uint32_t nConnected = 0;
+	for (const FTrackerState& Tracker : Mock.m_arrTrackers)
+	{
+		nConnected += Tracker.bConnected ? 1 : 0;
+	}
+
+	*pPathCountOutput = nConnected;
+	if (PathCapacityInput == 0)
+		return XR_SUCCESS;
+
+	if (PathCapacityInput < nConnected)
+		return XR_ERROR_SIZE_INSUFFICIENT;
+
+	uint32_t nPath = 0;
+	for (const FTrackerState& Tracker : Mock.m_arrTrackers)
+	{
+		if (Tracker.bConnected)
+		{
+			pPaths[nPath].persistentPath = Tracker.Paths.persistentPath;
+			pPaths[nPath].rolePath = Tracker.Paths.rolePath;
+			nPath++;
+		}
+	}
+	return XR_SUCCESS;
+}
+
+/**
+* Drive the module from a scripted mock runtime at 90Hz and check every role's sample against the script each frame
+* @param double - Seconds of script to run
+* @param int32 - Number of scripted trackers, 2 to one per role
+* @return bool - Whether every pose, event and tracking status matched the script
+*/
+static bool RunMockRuntimeTest(double Duration, int32 NumTrackers)
+{
+	constexpr double FrameSeconds = 1.0 / 90.0;
+
+	FOpenXRViveTrackerModule& Module = FOpenXRViveTrackerModule::Get();
+	if (Module.IsReplaying())
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Mock runtime test: stop the tracker replay first"));
+		return false;
+	}
+
+	// One tracker per role, connecting over the first second, with dropouts, a reconnect and a role swap
+	FViveTrackerMockRuntime Mock;
+	for (int32 nTracker = 0; nTracker < NumTrackers; nTracker++)
+	{
+		FViveTrackerMockTracker Tracker = FViveTrackerMockRuntime::MakeOrbitingTracker(nTracker);
+		if (nTracker % 3 == 1)
+		{
+			const double DropoutStart = Duration * (0.1 + 0.05 * (nTracker % 4));
+			Tracker.Dropouts.Add(TRange<double>(DropoutStart, DropoutStart + 0.25));
+		}
+		Mock.AddTracker(Tracker, nTracker / (double)NumTrackers);
+	}
+	Mock.Disconnect(NumTrackers - 1, Duration * 0.4);
+	Mock.Connect(NumTrackers - 1, Duration * 0.6);
+	Mock.ChangeRole(0, Mock.GetTracker(1).Role, Duration * 0.5);
+	Mock.ChangeRole(1, Mock.GetTracker(0).Role, Duration * 0.5);
+
+	int32 nConnectEvents = 0;
+	const FDelegateHandle hConnected = Module.OnTrackerConnected().AddLambda([&nConnectEvents](const FString&, ETrackerRole) { nConnectEvents++; });
+
+	if (!Mock.Start(Module))
+	{
+		Module.OnTrackerConnected().Remove(hConnected);
+		return false;
+	}
+
+	int32 nFrames = 0;
+	int32 nPoseMismatches = 0;
+	int32 nStatusMismatches = 0;
+	int32 nRoleMismatches = 0;
+	float fMaxPositionError = 0.f;
+	while (Mock.GetSeconds() + FrameSeconds <= Duration)
+	{
+		Mock.Tick(FrameSeconds);
+		nFrames++;
+
+		bool arrRoleExpected[ETrackerRole::Unassigned] = {};
+		for (int32 nTracker = 0; nTracker < NumTrackers; nTracker++)
+		{
+			FTransform Expected;
+			if (!Mock.GetExpectedPose(nTracker, Mock.GetSeconds(), Expected))
+				continue;
+
+			const ETrackerRole role = Mock.GetTracker(nTracker).Role;
+			arrRoleExpected[role] = true;
+
+			FViveTrackerSample Sample;
+			if (!Module.GetTrackerSample(role, Sample) || !Sample.HasValidPose() || !Sample.HasValidVelocity() || Sample.Time != Mock.GetTime())
+			{
+				nStatusMismatches++;
+				continue;
+			}
+
+			const float PositionError = FVector::Dist(Sample.Transform.GetLocation(), Expected.GetLocation());
+			fMaxPositionError = FMath::Max(fMaxPositionError, PositionError);
+			if (PositionError > 0.01f || !Sample.Transform.GetRotation().Equals(Expected.GetRotation(), 1.0e-4f))
+			{
+				nPoseMismatches++;
+			}
+
+			ETrackerRole pathRole;
+			if (!Module.GetTrackerRoleFromPersistentPath(Mock.GetTracker(nTracker).PersistentPath, pathRole) || pathRole != role)
+			{
+				nRoleMismatches++;
+			}
+		}
+
+		// Roles without a tracking tracker must not report a pose
+		for (int32 nRole = 0; nRole < ETrackerRole::Unassigned; nRole++)
+		{
+			FViveTrackerSample Sample;
+			if (!arrRoleExpected[nRole] && Module.GetTrackerSample((ETrackerRole)nRole, Sample) && Sample.HasValidPose())
+			{
+				nStatusMismatches++;
+			}
+		}
+	}
+
+	// Every scripted connect and role change is one event
+	const int32 ExpectedEvents = NumTrackers + 3;
+	const int64 NumLocateCalls = Mock.GetNumLocateCalls();
+	Mock.Stop();
+	Module.OnTrackerConnected().Remove(hConnected);
+
+	const bool bPassed = nPoseMismatches == 0 && nStatusMismatches == 0 && nRoleMismatches == 0 && nConnectEvents == ExpectedEvents &&
+		NumLocateCalls == (int64)nFrames * ETrackerRole::Unassigned && !Module.IsActionsGenerated();
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Mock runtime: %d frames of %d trackers, %lld locates, %d of %d connect events, max position error %.5f cm"),
+		nFrames, NumTrackers, NumLocateCalls, nConnectEvents, ExpectedEvents, fMaxPositionError);
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Mock runtime: %s, %d pose, %d tracking status and %d persistent path role mismatches"),
+		bPassed ? TEXT("PASSED") : TEXT("FAILED"), nPoseMismatches, nStatusMismatches, nRoleMismatches);
+	return bPassed;
+}
+
+static void TestMockRuntime(const TArray<FString>& Args)
+{
+	const double Duration = Args.Num() > 0 ? FMath::Clamp(FCString::Atod(*Args[0]), 1.0, 3600.0) : 10.0;
+	const int32 NumTrackers = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 2, (int32)ETrackerRole::Unassigned) : (int32)ETrackerRole::Unassigned;
+	RunMockRuntimeTest(Duration, NumTrackers);
+}
+
+static FAutoConsoleCommand TestMockRuntimeCommand(
+	TEXT("vivetracker.TestMockRuntime"),
+	TEXT("Drive the module from a mock OpenXR runtime for N seconds (default 10) with M scripted trackers (default 12) at 90Hz and check every pose, dropout, reconnect and role change"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&TestMockRuntime));
+
+/**
+* Power a rack of trackers on, then fire hundreds of disconnects, reconnects and role changes per second at the module.
+* Checks that connect events cost a constant number of runtime calls without allocating, that the trackers are only
+* listed once per frame however many events came in, and that the persistent path roles stay right every frame.
+* @param double - Seconds to run, the storm starts after the first second
+* @param int32 - Number of trackers in the rack
+* @param int32 - Connect, disconnect and role change events per second
+* @return bool - Whether no event allocated, every event stayed within its cost and every role matched the script
+*/
+static bool RunHotPlugStormTest(double Duration, int32 NumTrackers, int32 EventsPerSecond)
+{
+	constexpr double FrameSeconds = 1.0 / 90.0;
+	constexpr double StormStart = 1.0;
+
+	// An event reads its tracker's persistent and role paths, generous enough for a debug build on a loaded machine
+	constexpr int64 MaxRuntimeCallsPerEvent = 2;
+	constexpr double MaxMicrosecondsPerEvent = 50.0;
+
+	FOpenXRViveTrackerModule& Module = FOpenXRViveTrackerModule::Get();
+	if (Module.IsReplaying())
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Hot-plug storm test: stop the tracker replay first"));
+		return false;
+	}
+
+	// The rack powers on within 100ms, the storm starts once every tracker connected once
+	FViveTrackerMockRuntime Mock;
+	for (int32 nTracker = 0; nTracker < NumTrackers; nTracker++)
+	{
+		Mock.AddTracker(FViveTrackerMockRuntime::MakeOrbitingTracker(nTracker), 0.1 * nTracker / NumTrackers);
+	}
+
+	FRandomStream Random(NumTrackers);
+	const int32 NumScriptEvents = (int32)((Duration - StormStart) * EventsPerSecond);
+	for (int32 nEvent = 0; nEvent < NumScriptEvents; nEvent++)
+	{
+		const double Seconds = StormStart + nEvent / (double)EventsPerSecond;
+		const int32 nTracker = Random.RandHelper(NumTrackers);
+		switch (Random.RandHelper(3))
+		{
+		case 0:
+			Mock.Disconnect(nTracker, Seconds);
+			break;
+		case 1:
+			Mock.Connect(nTracker, Seconds);
+			break;
+		default:
+			Mock.ChangeRole(nTracker, (ETrackerRole)Random.RandHelper((int32)ETrackerRole::Unassigned + 1), Seconds);
+			break;
+		}
+	}
+
+	int64 nConnectEvents = 0;
+	const FDelegateHandle hConnected = Module.OnTrackerConnected().AddLambda([&nConnectEvents](const FString&, ETrackerRole) { nConnectEvents++; });
+
+	if (!Mock.Start(Module))
+	{
+		Module.OnTrackerConnected().Remove(hConnected);
+		return false;
+	}
+
+	while (Mock.GetSeconds() + FrameSeconds <= StormStart)
+	{
+		Mock.Tick(FrameSeconds);
+	}
+
+	// From here on the module's strings have grown to the path length, events must not allocate
+	Mock.SetCountEventAllocations(true);
+	const int64 nStartEvents = Mock.GetNumEventsSent();
+	const int64 nStartEnumerateCalls = Mock.GetNumEnumerateCalls();
+	const int64 nStartRuntimeCalls = Mock.GetNumEventRuntimeCalls();
+	const double fStartEventSeconds = Mock.GetEventSeconds();
+
+	int32 nFrames = 0;
+	int32 nRoleMismatches = 0;
+	while (Mock.GetSeconds() + FrameSeconds <= Duration)
+	{
+		Mock.Tick(FrameSeconds);
+		nFrames++;
+
+		// The extension has no disconnect event, a disconnected tracker stays listed until the next connect event
+		for (int32 nTracker = 0; nTracker < NumTrackers; nTracker++)
+		{
+			ETrackerRole pathRole;
+			if (Mock.IsConnected(nTracker) &&
+				(!Module.GetTrackerRoleFromPersistentPath(Mock.GetTracker(nTracker).PersistentPath, pathRole) || pathRole != Mock.GetTracker(nTracker).Role))
+			{
+				nRoleMismatches++;
+			}
+		}
+	}
+
+	const int64 nEvents = Mock.GetNumEventsSent() - nStartEvents;
+	const int64 nEnumerateCalls = Mock.GetNumEnumerateCalls() - nStartEnumerateCalls;
+	const int64 nRuntimeCalls = Mock.GetNumEventRuntimeCalls() - nStartRuntimeCalls;
+	const double fEventSeconds = Mock.GetEventSeconds() - fStartEventSeconds;
+	const int64 nAllocations = Mock.GetNumEventAllocations();
+	const int64 nTotalEvents = Mock.GetNumEventsSent();
+	Mock.Stop();
+	Module.OnTrackerConnected().Remove(hConnected);
+
+	// Listing happens at most once per frame with the two call idiom, however many events came in
+	const bool bPassed = nEvents > 0 && nAllocations == 0 && nRuntimeCalls <= MaxRuntimeCallsPerEvent * nEvents &&
+		fEventSeconds * 1.0e6 <= MaxMicrosecondsPerEvent * nEvents && nEnumerateCalls <= 2 * (int64)nFrames &&
+		nRoleMismatches == 0 && nConnectEvents == nTotalEvents;
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Hot-plug storm: %lld connect events over %d frames with %d trackers, %.3f us and %.2f runtime calls per event, %.2f enumerations per frame"),
+		nEvents, nFrames, NumTrackers, nEvents > 0 ? fEventSeconds * 1.0e6 / nEvents : 0.0, nEvents > 0 ? nRuntimeCalls / (double)nEvents : 0.0,
+		nFrames > 0 ? nEnumerateCalls / (2.0 * nFrames) : 0.0);
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Hot-plug storm: %s, %lld allocations while handling events, %d persistent path role mismatches, %lld of %lld connect events broadcast"),
+		bPassed ? TEXT("PASSED") : TEXT("FAILED"), nAllocations, nRoleMismatches, nConnectEvents, nTotalEvents);
+	return bPassed;
+}
+
+static void TestHotPlugStorm(const TArray<FString>& Args)
+{
+	const double Duration = Args.Num() > 0 ? FMath::Clamp(FCString::Atod(*Args[0]), 2.0, 600.0) : 5.0;
+	const int32 NumTrackers = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 2, 256) : 30;
+	const int32 EventsPerSecond = Args.Num() > 2 ? FMath::Clamp(FCString::Atoi(*Args[2]), 10, 100000) : 600;
+	RunHotPlugStormTest(Duration, NumTrackers, EventsPerSecond);
+}
+
+static FAutoConsoleCommand TestHotPlugStormCommand(
+	TEXT("vivetracker.TestHotPlugStorm"),
+	TEXT("Fire connect, disconnect and role change events at the module from a mock runtime and check each costs the same and doesn't allocate. Args: [seconds=5] [trackers=30] [events per second=600]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&TestHotPlugStorm));
+
+/**
+* Run the per-frame pose path against a mock runtime and fail if any frame allocates once warmed up: PostSyncActions
+* with its locates, history and optional capture, GetTrackerTransform for every role and a tracker component per role.
+* @param int32 - Number of frames checked after the warm up
+* @param int32 - Number of scripted trackers
+* @param bool - Whether or not to capture the trackers while running
+* @return bool - Whether no frame allocated once warmed up
+*/
+static bool RunZeroAllocationTest(int32 NumFrames, int32 NumTrackers, bool bCapture)
+{
+	constexpr double FrameSeconds = 1.0 / 90.0;
+	constexpr int32 WarmupFrames = 90;
+
+	FOpenXRViveTrackerModule& Module = FOpenXRViveTrackerModule::Get();
+	if (Module.IsReplaying())
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Zero allocation test: stop the tracker replay first"));
+		return false;
+	}
+
+	if (bCapture && Module.IsCapturing())
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Zero allocation test: stop the tracker capture first"));
+		return false;
+	}
+
+	FViveTrackerMockRuntime Mock;
+	for (int32 nTracker = 0; nTracker < NumTrackers; nTracker++)
+	{
+		Mock.AddTracker(FViveTrackerMockRuntime::MakeOrbitingTracker(nTracker));
+	}
+
+	if (!Mock.Start(Module))
+		return false;
+
+	const FString sCaptureFilename = FPaths::ProjectSavedDir() / TEXT("ViveTracker") / TEXT("ZeroAllocationTest.vtcap");
+	if (bCapture && !Module.StartCapture(sCaptureFilename))
+	{
+		Mock.Stop();
+		return false;
+	}
+
+	// A world of its own, so the test runs the same in the editor, in game and headless
+	UWorld* pWorld = UWorld::CreateWorld(EWorldType::None, false);
+	AActor* pActor = pWorld->SpawnActor<AActor>();
+	USceneComponent* pRoot = NewObject<USceneComponent>(pActor, TEXT("Root"));
+	pActor->SetRootComponent(pRoot);
+	pRoot->RegisterComponent();
+
+	TArray<UViveTrackerComponent*> arrComponents;
+	for (int32 nRole = 0; nRole < (int32)ETrackerRole::Unassigned; nRole++)
+	{
+		UViveTrackerComponent* pComponent = NewObject<UViveTrackerComponent>(pActor);
+		pComponent->TrackerRole = (ETrackerRole)nRole;
+		pComponent->SetupAttachment(pRoot);
+		pComponent->RegisterComponent();
+		arrComponents.Add(pComponent);
+	}
+
+	// Warm up frames grow the module's, the engine's and the allocator's caches to their steady state size
+	uint64 nSyncAllocations = 0;
+	uint64 nTransformAllocations = 0;
+	uint64 nComponentAllocations = 0;
+	int32 nAllocatingFrames = 0;
+	for (int32 nFrame = 0; nFrame < WarmupFrames + NumFrames; nFrame++)
+	{
+		uint64 nSync = 0;
+		uint64 nTransform = 0;
+		uint64 nComponent = 0;
+
+		{
+			FViveTrackerAllocationScope allocationScope;
+			Mock.Tick(FrameSeconds);
+			nSync = allocationScope.GetNumAllocations();
+		}
+
+		{
+			FViveTrackerAllocationScope allocationScope;
+			for (int32 nRole = 0; nRole < (int32)ETrackerRole::Unassigned; nRole++)
+			{
+				Module.GetTrackerTransform((ETrackerRole)nRole);
+			}
+			nTransform = allocationScope.GetNumAllocations();
+		}
+
+		{
+			FViveTrackerAllocationScope allocationScope;
+			for (UViveTrackerComponent* pComponent : arrComponents)
+			{
+				pComponent->TickComponent((float)FrameSeconds, LEVELTICK_All, nullptr);
+			}
+			nComponent = allocationScope.GetNumAllocations();
+		}
+
+		if (nFrame < WarmupFrames || nSync + nTransform + nComponent == 0)
+			continue;
+
+		if (nAllocatingFrames++ == 0)
+		{
+			UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Zero allocation test: frame %d allocated %llu times in PostSyncActions, %llu in GetTrackerTransform, %llu in tracker components"),
+				nFrame - WarmupFrames, nSync, nTransform, nComponent);
+		}
+		nSyncAllocations += nSync;
+		nTransformAllocations += nTransform;
+		nComponentAllocations += nComponent;
+	}
+
+	pWorld->DestroyWorld(false);
+	if (bCapture)
+	{
+		Module.StopCapture();
+		IFileManager::Get().Delete(*sCaptureFilename);
+	}
+	Mock.Stop();
+
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Zero allocation test: %s, %d of %d frames allocated with %d trackers%s (%llu in PostSyncActions, %llu in GetTrackerTransform, %llu in tracker components)"),
+		nAllocatingFrames == 0 ? TEXT("PASSED") : TEXT("FAILED"), nAllocatingFrames, NumFrames, NumTrackers, bCapture ? TEXT(" while capturing") : TEXT(""),
+		nSyncAllocations, nTransformAllocations, nComponentAllocations);
+	return nAllocatingFrames == 0;
+}
+
+static void TestZeroAllocation(const TArray<FString>& Args)
+{
+	const int32 NumFrames = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 1, 1000000) : 900;
+	const int32 NumTrackers = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 1, 256) : (int32)ETrackerRole::Unassigned;
+	const bool bCapture = Args.Num() > 2 && FCString::Atoi(*Args[2]) != 0;
+	RunZeroAllocationTest(NumFrames, NumTrackers, bCapture);
+}
+
+static FAutoConsoleCommand TestZeroAllocationCommand(
+	TEXT("vivetracker.TestZeroAllocation"),
+	TEXT("Run the per-frame pose path against a mock runtime and check that no frame allocates once warmed up. Args: [frames=900] [trackers=12] [capture=0]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&TestZeroAllocation));
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// The tests take the module over with the mock, so they only run without a real OpenXR session
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FViveTrackerMockRuntimeTest, "OpenXRViveTracker.MockRuntime.Poses",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FViveTrackerMockRuntimeTest::RunTest(const FString& Parameters)
+{
+	return RunMockRuntimeTest(10.0, (int32)ETrackerRole::Unassigned);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FViveTrackerHotPlugStormTest, "OpenXRViveTracker.MockRuntime.HotPlugStorm",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FViveTrackerHotPlugStormTest::RunTest(const FString& Parameters)
+{
+	return RunHotPlugStormTest(5.0, 30, 600);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FViveTrackerZeroAllocationTest, "OpenXRViveTracker.MockRuntime.ZeroAllocation",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FViveTrackerZeroAllocationTest::RunTest(const FString& Parameters)
+{
+	const bool bPassed = RunZeroAllocationTest(900, (int32)ETrackerRole::Unassigned, false);
+	return RunZeroAllocationTest(900, (int32)ETrackerRole::Unassigned, true) && bPassed;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,231 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerRoleClassifierComponent.h"
+#include "ViveTrackerBodyIK.h"
+#include "Async/Async.h"
+#include "Engine/Engine.h"
+#include "IXRTrackingSystem.h"
+
+using namespace ViveTrackerCore;
+
+// Sets default values for this component's properties
+UViveTrackerRoleClassifierComponent::UViveTrackerRoleClassifierComponent()
+{
+	// Set this component to be initialized when the game starts.
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+
+// Called when the game starts
+void UViveTrackerRoleClassifierComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Obtain a reference of the main plugin module
+	m_trackerModule = &FOpenXRViveTrackerModule::Get();
+}
+
+
+// Called when the game ends or the component is destroyed
+void UViveTrackerRoleClassifierComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (m_classification.IsValid())
+	{
+		m_classification.Wait();
+		m_classification = TFuture<FRoleClassification>();
+	}
+
+	if (m_bRolesApplied && m_trackerModule)
+	{
+		m_trackerModule->SetInferredTrackerRoles(TMap<FString, ETrackerRole>());
+		m_bRolesApplied = false;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void UViveTrackerRoleClassifierComponent::RefreshTrackers()
+{
+	TArray<FString> arrPaths;
+	TArray<ETrackerRole> arrRoles;
+	m_trackerModule->GetTrackerPersistentPaths(arrPaths, arrRoles);
+
+	TArray<int32> arrOrder;
+	int32 nWithoutRole = 0;
+	for (int32 i = 0; i < arrPaths.Num(); i++)
+	{
+		if (arrRoles[i] == ETrackerRole::Unassigned)
+		{
+			nWithoutRole++;
+			continue;
+		}
+		arrOrder.Add(i);
+	}
+	arrOrder.Sort([&arrPaths](int32 A, int32 B) { return arrPaths[A] < arrPaths[B]; });
+
+	if (nWithoutRole > 0)
+	{
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("%i trackers have no role in the runtime, assign them any role so they can be located and classified"), nWithoutRole);
+	}
+
+	if (arrOrder.Num() > MaxClassifiedTrackers)
+	{
+		UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Only the first %i of %i trackers will be classified"), MaxClassifiedTrackers, arrOrder.Num());
+		arrOrder.SetNum(MaxClassifiedTrackers);
+	}
+
+	TArray<FString> arrSlotPaths;
+	m_arrSlotRoles.Reset(arrOrder.Num());
+	for (int32 i : arrOrder)
+	{
+		arrSlotPaths.Add(arrPaths[i]);
+		m_arrSlotRoles.Add(arrRoles[i]);
+	}
+	m_arrSamples.SetNum(m_arrSlotRoles.Num());
+
+	// Roles changing under the same trackers keep the window, a different set of trackers starts a new one
+	if (arrSlotPaths != m_arrSlotPaths)
+	{
+		m_arrSlotPaths = MoveTemp(arrSlotPaths);
+		m_classifier.Reset();
+		m_fWindowTime = 0.f;
+	}
+}
+
+
+void UViveTrackerRoleClassifierComponent::ApplyClassification(const FRoleClassification& Classification)
+{
+	// A single window can be fooled by the user crouching or waving, wait for two in a row to agree
+	if (!m_roleAgreement.AddClassification(Classification))
+		return;
+
+	const TArrayView<const ETrackerRole> BodyTrackerRoles = FViveTrackerBodyIK::GetBodyTrackerRoles();
+
+	TMap<FString, ETrackerRole> mapRoles;
+	for (int32 i = 0; i < m_arrClassifiedPaths.Num(); i++)
+	{
+		const EBodyTracker Role = m_roleAgreement.GetRole(i);
+		if (Role != EBodyTracker::Count)
+		{
+			mapRoles.Add(m_arrClassifiedPaths[i], BodyTrackerRoles[(int32)Role]);
+		}
+	}
+
+	bool bChanged = mapRoles.Num() != InferredRoles.Num();
+	for (const TPair<FString, ETrackerRole>& pathRole : mapRoles)
+	{
+		const TEnumAsByte<ETrackerRole>* pRole = InferredRoles.Find(pathRole.Key);
+		bChanged |= !pRole || *pRole != pathRole.Value;
+	}
+
+	if (!bChanged)
+		return;
+
+	InferredRoles.Reset();
+	for (const TPair<FString, ETrackerRole>& pathRole : mapRoles)
+	{
+		InferredRoles.Add(pathRole.Key, pathRole.Value);
+		UE_LOG(LogOpenXRViveTracker, Display, TEXT("Tracker [%s] looks like it is worn at [%s]"), *pathRole.Key, ANSI_TO_TCHAR(FOpenXRViveTrackerModule::GetTrackerRolePath(pathRole.Value)));
+	}
+
+	if (bApplyInferredRoles)
+	{
+		m_trackerModule->SetInferredTrackerRoles(mapRoles);
+		m_bRolesApplied = true;
+	}
+
+	OnTrackerRolesInferred.Broadcast();
+}
+
+
+// Called every frame
+void UViveTrackerRoleClassifierComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Pick up the previous window's result without ever waiting for it
+	if (m_classification.IsValid() && m_classification.IsReady())
+	{
+		const FRoleClassification Classification = m_classification.Get();
+		m_classification = TFuture<FRoleClassification>();
+		ApplyClassification(Classification);
+	}
+
+	if (m_trackerModule->GetTrackerPathsGeneration() != m_nTrackerPathsGeneration)
+	{
+		m_nTrackerPathsGeneration = m_trackerModule->GetTrackerPathsGeneration();
+		RefreshTrackers();
+	}
+
+	FQuat HeadOrientation;
+	FVector HeadPosition;
+	if (m_arrSlotRoles.Num() == 0 || !GEngine || !GEngine->XRSystem.IsValid() ||
+		!GEngine->XRSystem->GetCurrentPose(IXRTrackingSystem::HMDDeviceId, HeadOrientation, HeadPosition))
+		return;
+
+	// Every tracker in one batch
+	m_trackerModule->GetTrackerSamples(m_arrSlotRoles, m_arrSamples);
+
+	FRoleFrame Frame;
+	Frame.Head = FViveTrackerBodyIK::ToCorePose(FTransform(HeadOrientation, HeadPosition));
+	for (int32 i = 0; i < m_arrSamples.Num(); i++)
+	{
+		const FViveTrackerSample& Sample = m_arrSamples[i];
+		if (!Sample.HasValidPose() || Sample.Time == 0 || !(Sample.LocationFlags & XR_SPACE_LOCATION_POSITION_TRACKED_BIT))
+			continue;
+
+		Frame.Trackers[i] = FViveTrackerBodyIK::ToCorePose(Sample.Transform).Position;
+		Frame.ValidMask |= 1u << i;
+	}
+	m_classifier.AddFrame(Frame);
+
+	// The classifier is a small value, a copy goes to a worker thread while the next window fills up
+	m_fWindowTime += DeltaTime;
+	if (m_fWindowTime >= WindowDuration && !m_classification.IsValid())
+	{
+		// Windows of another set of trackers don't vote on this one's roles
+		if (m_arrClassifiedPaths != m_arrSlotPaths)
+		{
+			m_arrClassifiedPaths = m_arrSlotPaths;
+			m_roleAgreement.Reset();
+		}
+
+		m_classification = Async(EAsyncExecution::ThreadPool, [Classifier = m_classifier]()
+		{
+			FRoleClassification Classification;
+			Classifier.Classify(Classification);
+			return Classification;
+		});
+
+		m_classifier.Reset();
+		m_fWindowTime = 0.f;
+	}
+}
@@ -0,0 +1,98 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoneContainer.h"
+#include "BonePose.h"
+#include "BoneControllers/AnimNode_SkeletalControlBase.h"
+#include "OpenXRViveTracker.h"
+#include "AnimNode_ViveTrackerBones.generated.h"
+
+/** Drives one bone from one tracker role */
+USTRUCT(BlueprintType)
+struct OPENXRVIVETRACKER_API FViveTrackerBoneMapping
+{
+	GENERATED_BODY()
+
+	/** The assigned tracker role in the openxr runtime */
+	UPROPERTY(EditAnywhere, Category = "ViveTracker")
+	TEnumAsByte<ETrackerRole> TrackerRole = ETrackerRole::Unassigned;
+
+	/** The bone moved to the tracker */
+	UPROPERTY(EditAnywhere, Category = "ViveTracker")
+	FBoneReference Bone;
+
+	/** Transform of the bone relative to the tracker, i.e. how the tracker is strapped on */
+	UPROPERTY(EditAnywhere, Category = "ViveTracker")
+	FTransform TrackerToBone = FTransform::Identity;
+
+	/** Whether or not the bone also takes the tracker's rotation, or only its location */
+	UPROPERTY(EditAnywhere, Category = "ViveTracker")
+	bool bApplyRotation = true;
+};
+
+/**
+* Moves bones to the latest tracker poses in component space. Tracker samples are read directly from the
+* plugin module during worker thread evaluation, so no game thread copy into anim instance variables is needed.
+*/
+USTRUCT(BlueprintInternalUseOnly)
+struct OPENXRVIVETRACKER_API FAnimNode_ViveTrackerBones : public FAnimNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+	/** Trackers and the bones they drive */
+	UPROPERTY(EditAnywhere, Category = "ViveTracker")
+	TArray<FViveTrackerBoneMapping> Mappings;
+
+	/** The vr pawn/character's player start location */
+	UPROPERTY(EditAnywhere, Category = "ViveTracker", meta = (PinHiddenByDefault))
+	FVector PlayerStartLocation = FVector::ZeroVector;
+
+	// FAnimNode_Base interface
+	virtual bool HasPreUpdate() const override { return true; }
+	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+
+	// FAnimNode_SkeletalControlBase interface
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
+
+private:
+	// FAnimNode_SkeletalControlBase interface
+	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
+
+	// Cached on the game thread, module lookup isn't safe from worker threads
+	const FOpenXRViveTrackerModule* m_trackerModule = nullptr;
+
+	// Scratch sized in InitializeBoneReferences so evaluation doesn't allocate
+	TArray<ETrackerRole> m_arrRoles;
+	TArray<FViveTrackerSample> m_arrSamples;
+};
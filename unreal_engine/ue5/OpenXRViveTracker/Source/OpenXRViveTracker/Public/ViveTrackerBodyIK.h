@@ -0,0 +1,285 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerCore/ViveTrackerIK.h"
+#include "ViveTrackerBodyIK.generated.h"
+
+struct FViveTrackerCalibration;
+
+/** Proportions and joint limits used by the full-body IK solver */
+USTRUCT(BlueprintType)
+struct OPENXRVIVETRACKER_API FViveTrackerBodyIKSettings
+{
+	GENERATED_BODY()
+
+	/** Pelvis to chest, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "1"))
+	float SpineLength = 50.f;
+
+	/** Chest to head, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "1"))
+	float NeckLength = 25.f;
+
+	/** Chest to each shoulder, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "0"))
+	float ShoulderHalfWidth = 18.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "1"))
+	float UpperArmLength = 28.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "1"))
+	float LowerArmLength = 27.f;
+
+	/** Pelvis to each hip, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "0"))
+	float HipHalfWidth = 10.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "1"))
+	float ThighLength = 45.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "1"))
+	float ShinLength = 45.f;
+
+	/** Smallest elbow angle in degrees, 180 being a straight arm */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "0", ClampMax = "180"))
+	float ElbowMinAngle = 20.f;
+
+	/** Smallest knee angle in degrees, 180 being a straight leg */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "0", ClampMax = "180"))
+	float KneeMinAngle = 20.f;
+
+	/** Smallest angle between pelvis, chest and head in degrees, limits how far the spine bends */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|IK", meta = (ClampMin = "90", ClampMax = "180"))
+	float SpineMinAngle = 135.f;
+};
+
+/**
+* Component space bone transforms produced by the full-body IK solver. Every limb bone's X axis
+* points at its child bone and its Z axis towards the limb's bend direction.
+*/
+USTRUCT(BlueprintType)
+struct OPENXRVIVETRACKER_API FViveTrackerBodyPose
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Pelvis;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Chest;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Head;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform UpperArm_L;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform LowerArm_L;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Hand_L;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform UpperArm_R;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform LowerArm_R;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Hand_R;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Thigh_L;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Calf_L;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Foot_L;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Thigh_R;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Calf_R;
+
+	UPROPERTY(BlueprintReadOnly, Category = "ViveTracker|IK")
+	FTransform Foot_R;
+};
+
+/** Glue between the module's tracker roles and the engine independent full-body IK solver */
+class OPENXRVIVETRACKER_API FViveTrackerBodyIK
+{
+public:
+	/**
+	* Convert solver settings to the core solver's skeleton
+	* @param FViveTrackerBodyIKSettings - The solver settings
+	* @param ViveTrackerCore::FBodySkeleton - Receives the core skeleton
+	*/
+	static void MakeSkeleton(const FViveTrackerBodyIKSettings& Settings, ViveTrackerCore::FBodySkeleton& OutSkeleton);
+
+	/**
+	* Fill solver targets from the latest body tracker samples plus the HMD and controllers.
+	* Waist, Chest and Foot roles are targets, Elbow and Knee roles steer the bend of their limb.
+	* Without a calibration the waist tracker only gives the pelvis its position and heading.
+	* @param FOpenXRViveTrackerModule - The module to read tracker samples from
+	* @param FTransform - HMD transform, in the same tracking space as the trackers
+	* @param FTransform* - Left controller transform, null if it isn't tracked
+	* @param FTransform* - Right controller transform, null if it isn't tracked
+	* @param ViveTrackerCore::FBodyTargets - Receives the targets
+	* @param FViveTrackerCalibration* - Optional calibration whose tracker to bone offsets are applied to the samples
+	*/
+	static void GatherTargets(const FOpenXRViveTrackerModule& Module, const FTransform& Head, const FTransform* LeftHand, const FTransform* RightHand, ViveTrackerCore::FBodyTargets& OutTargets,
+		const FViveTrackerCalibration* Calibration = nullptr);
+
+	/**
+	* Tracker role of every body tracker known to the engine independent core
+	* @return TArrayView<const ETrackerRole> - One role per ViveTrackerCore::EBodyTracker, in order
+	*/
+	static TArrayView<const ETrackerRole> GetBodyTrackerRoles();
+
+	/**
+	* Convert the core solver's output to engine transforms
+	* @param ViveTrackerCore::FBodyPose - The solved pose
+	* @param FViveTrackerBodyPose - Receives the bone transforms
+	*/
+	static void ToBodyPose(const ViveTrackerCore::FBodyPose& Pose, FViveTrackerBodyPose& OutPose);
+
+	static FORCEINLINE ViveTrackerCore::FPose ToCorePose(const FTransform& Transform)
+	{
+		const FQuat Rotation = Transform.GetRotation();
+		const FVector Location = Transform.GetLocation();
+
+		ViveTrackerCore::FPose Pose;
+		Pose.Rotation = { (float)Rotation.X, (float)Rotation.Y, (float)Rotation.Z, (float)Rotation.W };
+		Pose.Position = { (float)Location.X, (float)Location.Y, (float)Location.Z };
+		return Pose;
+	}
+
+	static FORCEINLINE FTransform ToTransform(const ViveTrackerCore::FPose& Pose)
+	{
+		return FTransform(FQuat(Pose.Rotation.X, Pose.Rotation.Y, Pose.Rotation.Z, Pose.Rotation.W), FVector(Pose.Position.X, Pose.Position.Y, Pose.Position.Z));
+	}
+};
+
+/**
+* Full-body IK for many avatars at once, e.g. live local users, network peers and recorded performances.
+* Targets are stored as a structure of arrays in the plugin's role layout, and avatars are solved four
+* per SIMD lane group with groups spread over task graph workers.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerBodyIKBatch
+{
+public:
+	/**
+	* Resize the batch, new avatars start without targets
+	* @param int32 - Number of avatars
+	*/
+	void SetNum(int32 NumAvatars);
+
+	int32 Num() const { return m_arrValidMasks.Num(); }
+
+	/**
+	* Set the proportions of every avatar that wasn't given its own
+	* @param FViveTrackerBodyIKSettings - Proportions and joint limits
+	*/
+	void SetSharedSkeleton(const FViveTrackerBodyIKSettings& Settings);
+
+	/**
+	* Give one avatar its own proportions, e.g. from its calibration
+	* @param int32 - Index of the avatar
+	* @param FViveTrackerBodyIKSettings - Proportions and joint limits
+	*/
+	void SetAvatarSkeleton(int32 Avatar, const FViveTrackerBodyIKSettings& Settings);
+
+	/**
+	* Replace all targets of an avatar
+	* @param int32 - Index of the avatar
+	* @param ViveTrackerCore::FBodyTargets - The avatar's targets
+	*/
+	void SetTargets(int32 Avatar, const ViveTrackerCore::FBodyTargets& Targets);
+
+	/**
+	* Clear all targets of an avatar before setting the ones of a new frame one by one
+	* @param int32 - Index of the avatar
+	*/
+	void ResetTargets(int32 Avatar);
+
+	/**
+	* Set the HMD or controller targets of an avatar
+	* @param int32 - Index of the avatar
+	* @param FTransform - HMD transform
+	* @param FTransform* - Left controller transform, null if it isn't tracked
+	* @param FTransform* - Right controller transform, null if it isn't tracked
+	*/
+	void SetHeadAndHands(int32 Avatar, const FTransform& Head, const FTransform* LeftHand, const FTransform* RightHand);
+
+	/**
+	* Set a body tracker target by role, e.g. from a network peer or a recording.
+	* Waist, Chest and Foot roles are targets, Elbow and Knee roles steer the bend of their limb.
+	* Trackers are uncalibrated, the waist tracker only gives the pelvis its position and heading.
+	* @param int32 - Index of the avatar
+	* @param ETrackerRole - Role of the tracker
+	* @param FTransform - Transform of the tracker
+	* @return bool - Whether the role is used by the solver
+	*/
+	bool SetTrackerTarget(int32 Avatar, ETrackerRole TrackerRole, const FTransform& Transform);
+
+	/**
+	* Solve every avatar
+	* @param bool - Whether to spread groups of avatars over task graph workers
+	*/
+	void Solve(bool bParallel = true);
+
+	const ViveTrackerCore::FBodyPose& GetPose(int32 Avatar) const { return m_arrPoses[Avatar]; }
+
+	void GetBodyPose(int32 Avatar, FViveTrackerBodyPose& OutPose) const { FViveTrackerBodyIK::ToBodyPose(m_arrPoses[Avatar], OutPose); }
+
+	/** Avatars solved per task, a multiple of the SIMD width so every lane does useful work */
+	static constexpr int32 AvatarsPerTask = 16;
+
+private:
+	ViveTrackerCore::FBodySkeleton m_sharedSkeleton;
+	TArray<ViveTrackerCore::FBodySkeleton> m_arrSkeletons;
+
+	TArray<ViveTrackerCore::FPose> m_arrHeads;
+	TArray<ViveTrackerCore::FPose> m_arrHands[2];
+	TArray<ViveTrackerCore::FPose> m_arrPelvis;
+	TArray<ViveTrackerCore::FPose> m_arrChests;
+	TArray<ViveTrackerCore::FPose> m_arrFeet[2];
+	TArray<ViveTrackerCore::FVec3> m_arrElbows[2];
+	TArray<ViveTrackerCore::FVec3> m_arrKnees[2];
+	TArray<uint32> m_arrValidMasks;
+
+	TArray<ViveTrackerCore::FBodyPose> m_arrPoses;
+};
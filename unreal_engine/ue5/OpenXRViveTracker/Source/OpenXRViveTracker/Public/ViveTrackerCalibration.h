@@ -0,0 +1,154 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SaveGame.h"
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerBodyIK.h"
+#include "ViveTrackerCore/ViveTrackerCalibration.h"
+#include "ViveTrackerCalibration.generated.h"
+
+/** Result of a T-pose calibration, proportions of the user and the offset of each body tracker to its bone */
+USTRUCT(BlueprintType)
+struct OPENXRVIVETRACKER_API FViveTrackerCalibration
+{
+	GENERATED_BODY()
+
+	/** Solved proportions, joint limits are copied from the settings the calibration was solved with */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|Calibration")
+	FViveTrackerBodyIKSettings Proportions;
+
+	/** Bone transform relative to its tracker indexed by ETrackerRole, identity for roles that weren't calibrated */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|Calibration")
+	TArray<FTransform> TrackerToBone;
+
+	/** Estimated standing height of the user, in cm */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|Calibration")
+	float Height = 0.f;
+
+	/** Root mean square error of the proportion fit, in cm. Large values hint at a poor pose or a misassigned role. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|Calibration")
+	float ResidualError = 0.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|Calibration")
+	bool bIsValid = false;
+
+	/**
+	* Offset of a role's bone relative to its tracker
+	* @param ETrackerRole - The tracker role
+	* @return FTransform - The offset, identity if the role wasn't calibrated
+	*/
+	FTransform GetTrackerToBone(ETrackerRole TrackerRole) const
+	{
+		return TrackerToBone.IsValidIndex(TrackerRole) ? TrackerToBone[TrackerRole] : FTransform::Identity;
+	}
+};
+
+/** Save game slot holding a calibration, so users don't recalibrate between sessions */
+UCLASS()
+class OPENXRVIVETRACKER_API UViveTrackerCalibrationSaveGame : public USaveGame
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(VisibleAnywhere, Category = "ViveTracker|Calibration")
+	FViveTrackerCalibration Calibration;
+};
+
+/**
+* Captures a short window of samples while the user holds a T-pose or A-pose, then solves body
+* proportions and tracker to bone offsets. Call BeginCapture, AddFrame every tick until it
+* returns true, then Solve. Frames are reduced to running sums, the solve itself takes microseconds.
+*/
+UCLASS(BlueprintType)
+class OPENXRVIVETRACKER_API UViveTrackerCalibrator : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Length of the capture window in seconds */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|Calibration", meta = (ClampMin = "0.1"))
+	float CaptureDuration = 0.5f;
+
+	/** Largest positional standard deviation of any tracker during capture, in cm, above which the user moved too much */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker|Calibration", meta = (ClampMin = "0"))
+	float MaxMotion = 2.f;
+
+	/** Start a new capture, discarding any previous frames */
+	UFUNCTION(BlueprintCallable, Category = "ViveTracker|Calibration")
+	void BeginCapture();
+
+	/**
+	* Add the current body tracker samples plus the HMD and controllers to the capture
+	* @param FTransform - HMD transform, in the same tracking space as the trackers
+	* @param FTransform - Left controller transform, ignored if bLeftHandTracked is false
+	* @param bool - Whether or not the left controller is tracked
+	* @param FTransform - Right controller transform, ignored if bRightHandTracked is false
+	* @param bool - Whether or not the right controller is tracked
+	* @return bool - True once the capture window is full, false if BeginCapture wasn't called
+	*/
+	UFUNCTION(BlueprintCallable, Category = "ViveTracker|Calibration")
+	bool AddFrame(const FTransform& HeadTransform, const FTransform& LeftHandTransform, bool bLeftHandTracked,
+		const FTransform& RightHandTransform, bool bRightHandTracked);
+
+	/**
+	* Solve the captured frames
+	* @param FViveTrackerBodyIKSettings - Joint limits for the result, its lengths are replaced by the solved ones
+	* @param FViveTrackerCalibration - Receives the calibration
+	* @return bool - Whether the calibration succeeded, false if nothing was captured or the user moved
+	*/
+	UFUNCTION(BlueprintCallable, Category = "ViveTracker|Calibration")
+	bool Solve(const FViveTrackerBodyIKSettings& Settings, FViveTrackerCalibration& OutCalibration) const;
+
+	/**
+	* Persist a calibration to a save game slot
+	* @param FViveTrackerCalibration - The calibration to save
+	* @param FString - Name of the save game slot
+	* @param int32 - Platform user index
+	* @return bool - Whether the calibration was saved
+	*/
+	UFUNCTION(BlueprintCallable, Category = "ViveTracker|Calibration")
+	static bool SaveCalibration(const FViveTrackerCalibration& Calibration, const FString& SlotName, int32 UserIndex = 0);
+
+	/**
+	* Load a calibration from a save game slot
+	* @param FString - Name of the save game slot
+	* @param int32 - Platform user index
+	* @param FViveTrackerCalibration - Receives the calibration
+	* @return bool - Whether a calibration was loaded
+	*/
+	UFUNCTION(BlueprintCallable, Category = "ViveTracker|Calibration")
+	static bool LoadCalibration(const FString& SlotName, int32 UserIndex, FViveTrackerCalibration& OutCalibration);
+
+private:
+	ViveTrackerCore::FBodyCalibrator m_calibrator;
+	double m_dCaptureStartTime = 0.0;
+};
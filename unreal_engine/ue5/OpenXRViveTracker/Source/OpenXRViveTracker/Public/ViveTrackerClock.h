@@ -0,0 +1,134 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "tracker_openxr/openxr.h"
+
+/**
+* Maps runtime XrTime values onto the platform's monotonic clock (CLOCK_MONOTONIC on Linux,
+* QueryPerformanceCounter on Windows) so tracker samples can be aligned with external sensors.
+*
+* The runtime is only queried through XR_KHR_convert_timespec_time (or its win32 equivalent)
+* a few times per second. In between, conversions use an online least-squares fit of
+* offset and drift between the two clocks, so per-sample conversions never call into the runtime.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerClock
+{
+public:
+	/**
+	* Resolve the runtime's time conversion entry points for this instance
+	* @param XrInstance - The active OpenXR instance
+	* @return bool - Whether or not the runtime supports converting to the platform clock
+	*/
+	bool Initialize(XrInstance InInstance);
+
+	/** Drop the resolved entry points and all accumulated clock samples */
+	void Reset();
+
+	/**
+	* Query the runtime for a new clock pair if the sampling interval has elapsed
+	* and fold it into the offset/drift estimate
+	*/
+	void Update();
+
+	/**
+	* Check whether or not the estimator has enough data to convert between clocks
+	* @return bool - Whether or not conversions are valid
+	*/
+	bool IsValid() const { return m_nSamples > 0; }
+
+	/**
+	* Convert a runtime time to the platform's monotonic clock
+	* @param XrTime - The runtime time in nanoseconds
+	* @return int64 - The platform monotonic time in nanoseconds, or 0 if the estimator isn't valid
+	*/
+	int64 XrTimeToPlatformTime(XrTime Time) const;
+
+	/**
+	* Convert a platform monotonic time to runtime time
+	* @param int64 - The platform monotonic time in nanoseconds
+	* @return XrTime - The runtime time in nanoseconds, or 0 if the estimator isn't valid
+	*/
+	XrTime PlatformTimeToXrTime(int64 PlatformTimeNs) const;
+
+	/**
+	* Current estimated drift of the runtime clock relative to the platform clock
+	* @return double - Drift in parts per million
+	*/
+	double GetDriftPPM() const { return (m_fSlope - 1.0) * 1.0e6; }
+
+	/**
+	* Read the platform's monotonic clock
+	* @return int64 - Platform monotonic time in nanoseconds
+	*/
+	static int64 GetPlatformTimeNs();
+
+	/**
+	* Name of the optional OpenXR extension that converts platform time to XrTime on this platform
+	* @return const char* - XR_KHR_convert_timespec_time, or XR_KHR_win32_convert_performance_counter_time on Windows
+	*/
+	static const char* GetExtensionName();
+
+	/**
+	* Name of the extension's function the clock calls to convert platform time
+	* @return TCHAR - xrConvertTimespecTimeToTimeKHR, or xrConvertWin32PerformanceCounterToTimeKHR on Windows
+	*/
+	static const TCHAR* GetConvertFunctionName();
+
+	/** Minimum time between two runtime clock queries, in nanoseconds */
+	static constexpr int64 SampleIntervalNs = 250 * 1000 * 1000;
+
+	/** Weight given to older clock pairs on every new sample, lower values track drift changes faster */
+	static constexpr double ForgettingFactor = 0.98;
+
+	/** Largest drift the estimator will accept before treating the fit as an outlier, as a rate ratio */
+	static constexpr double MaxDrift = 1.0e-3;
+
+private:
+	bool QueryRuntime(int64 PlatformTimeNs, XrTime& OutXrTime) const;
+
+	XrInstance m_xrInstance = XR_NULL_HANDLE;
+	PFN_xrVoidFunction m_pfnPlatformToXrTime = nullptr;
+
+	// Origin keeps the fit in a small numeric range so doubles stay exact to the nanosecond
+	int64 m_nPlatformOrigin = 0;
+	XrTime m_nXrOrigin = 0;
+	int64 m_nLastSamplePlatformTime = 0;
+	int32 m_nSamples = 0;
+
+	// Exponentially weighted means and co-moments for the fit of XrTime against platform time
+	double m_fWeight = 0.0;
+	double m_fMeanPlatform = 0.0;
+	double m_fMeanXr = 0.0;
+	double m_fVarPlatform = 0.0;
+	double m_fCovar = 0.0;
+	double m_fSlope = 1.0;
+};
@@ -52,9 +52,23 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker")
 	FVector PlayerStartLocation = FVector::ZeroVector;
 
+#if WITH_EDITOR
+	/** Remember where this component sits in a level being edited before a replay moves it, once per replay */
+	void SaveEditorTransform();
+
+	/** Put a component of a level being edited back where it was before the replay moved it */
+	void RestoreEditorTransform();
+#endif
+
 private:
 	FOpenXRViveTrackerModule* m_trackerModule = nullptr;
 
+#if WITH_EDITOR
+	// Relative transform in the edited level from before the replay, so replays never leave level actors moved
+	FTransform m_editorTransform;
+	bool m_bEditorTransformSaved = false;
+#endif
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
@@ -0,0 +1,229 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// Engine independent full-body IK solver. This header must not include any Unreal headers
+// so the solver can be built and exercised outside of the engine.
+
+#include <cstdint>
+
+namespace ViveTrackerCore
+{
+	struct FVec3
+	{
+		float X = 0.f, Y = 0.f, Z = 0.f;
+	};
+
+	struct FQuat4
+	{
+		float X = 0.f, Y = 0.f, Z = 0.f, W = 1.f;
+	};
+
+	struct FPose
+	{
+		FQuat4 Rotation;
+		FVec3 Position;
+	};
+
+	/** Bones produced by the solver. Every bone's +X axis points at its child, +Z towards the chain's bend direction */
+	enum class EBodyBone : uint8_t
+	{
+		Pelvis,
+		Chest,
+		Head,
+		UpperArm_L,
+		LowerArm_L,
+		Hand_L,
+		UpperArm_R,
+		LowerArm_R,
+		Hand_R,
+		Thigh_L,
+		Calf_L,
+		Foot_L,
+		Thigh_R,
+		Calf_R,
+		Foot_R,
+		Count
+	};
+
+	/** Body targets, a bit per target in FBodyTargets::ValidMask */
+	enum EBodyTarget : uint32_t
+	{
+		Target_Head = 1 << 0,
+		Target_Hand_L = 1 << 1,
+		Target_Hand_R = 1 << 2,
+		Target_Pelvis = 1 << 3,
+		Target_Chest = 1 << 4,
+		Target_Foot_L = 1 << 5,
+		Target_Foot_R = 1 << 6,
+		Target_Elbow_L = 1 << 7,
+		Target_Elbow_R = 1 << 8,
+		Target_Knee_L = 1 << 9,
+		Target_Knee_R = 1 << 10,
+	};
+
+	/** Body worn trackers, as calibrated and inferred from tracker poses */
+	enum class EBodyTracker : uint8_t
+	{
+		Pelvis,
+		Chest,
+		Foot_L,
+		Foot_R,
+		Knee_L,
+		Knee_R,
+		Elbow_L,
+		Elbow_R,
+		Shoulder_L,
+		Shoulder_R,
+		Count
+	};
+
+	/** Poses fed to the solver, typically HMD, controllers and body tracker roles, all in the same space */
+	struct FBodyTargets
+	{
+		FPose Head;
+		FPose Hands[2];
+		/** Pelvis bone, +X up, +Y left and +Z forward, see MakeUprightPelvis for an uncalibrated waist tracker */
+		FPose Pelvis;
+		FPose Chest;
+		FPose Feet[2];
+
+		/** Elbow and knee positions only steer the bend direction of their limb */
+		FVec3 Elbows[2];
+		FVec3 Knees[2];
+
+		uint32_t ValidMask = 0;
+	};
+
+	/** Proportions and joint limits of the solved body, lengths in the same unit as the targets */
+	struct FBodySkeleton
+	{
+		float SpineLength = 50.f;
+		float NeckLength = 25.f;
+		float ShoulderHalfWidth = 18.f;
+		float UpperArmLength = 28.f;
+		float LowerArmLength = 27.f;
+		float HipHalfWidth = 10.f;
+		float ThighLength = 45.f;
+		float ShinLength = 45.f;
+
+		/** Interior angle range of the elbows and knees, in radians. Pi is a straight limb. */
+		float ElbowMinAngle = 0.35f;
+		float ElbowMaxAngle = 3.14159265f;
+		float KneeMinAngle = 0.35f;
+		float KneeMaxAngle = 3.14159265f;
+
+		/** Smallest interior angle at the chest between pelvis and head, limits how far the spine bends */
+		float SpineMinAngle = 2.35f;
+
+		/** Axes of the targets' space */
+		FVec3 Up{ 0.f, 0.f, 1.f };
+		FVec3 Forward{ 1.f, 0.f, 0.f };
+	};
+
+	/** Solved component space bone poses, indexed by EBodyBone */
+	struct FBodyPose
+	{
+		FPose Bones[(int)EBodyBone::Count];
+	};
+
+	/**
+	* Targets of many bodies as a structure of arrays, one array of Count entries per target in the
+	* plugin's role layout. Arrays of targets no body has set in its valid mask may be null.
+	*/
+	struct FBodyBatch
+	{
+		int Count = 0;
+
+		/** One skeleton shared by every body, or Count skeletons if bPerBodySkeletons is set */
+		const FBodySkeleton* Skeletons = nullptr;
+		bool bPerBodySkeletons = false;
+
+		const FPose* Heads = nullptr;
+		const FPose* Hands[2] = { nullptr, nullptr };
+		const FPose* Pelvis = nullptr;
+		const FPose* Chests = nullptr;
+		const FPose* Feet[2] = { nullptr, nullptr };
+		const FVec3* Elbows[2] = { nullptr, nullptr };
+		const FVec3* Knees[2] = { nullptr, nullptr };
+		const uint32_t* ValidMasks = nullptr;
+
+		/** Receives Count solved poses */
+		FBodyPose* Poses = nullptr;
+
+		/** Copy one body's targets out of the arrays */
+		void GatherTargets(int Body, FBodyTargets& OutTargets) const
+		{
+			const uint32_t Valid = ValidMasks[Body];
+			OutTargets.ValidMask = Valid;
+
+			if (Valid & Target_Head) OutTargets.Head = Heads[Body];
+			if (Valid & Target_Hand_L) OutTargets.Hands[0] = Hands[0][Body];
+			if (Valid & Target_Hand_R) OutTargets.Hands[1] = Hands[1][Body];
+			if (Valid & Target_Pelvis) OutTargets.Pelvis = Pelvis[Body];
+			if (Valid & Target_Chest) OutTargets.Chest = Chests[Body];
+			if (Valid & Target_Foot_L) OutTargets.Feet[0] = Feet[0][Body];
+			if (Valid & Target_Foot_R) OutTargets.Feet[1] = Feet[1][Body];
+			if (Valid & Target_Elbow_L) OutTargets.Elbows[0] = Elbows[0][Body];
+			if (Valid & Target_Elbow_R) OutTargets.Elbows[1] = Elbows[1][Body];
+			if (Valid & Target_Knee_L) OutTargets.Knees[0] = Knees[0][Body];
+			if (Valid & Target_Knee_R) OutTargets.Knees[1] = Knees[1][Body];
+		}
+	};
+
+	/**
+	* Pelvis target from an uncalibrated waist tracker. The solver reads the pelvis as +X up, +Y left and +Z forward,
+	* which a tracker worn without a calibration isn't, so the pelvis stands upright at the tracker facing its heading.
+	* @param FBodySkeleton - Skeleton whose up and forward axes are used
+	* @param FPose - The waist tracker's pose
+	* @return FPose - The pelvis target
+	*/
+	FPose MakeUprightPelvis(const FBodySkeleton& Skeleton, const FPose& Waist);
+
+	/**
+	* Solve a full body from its targets. Missing targets are estimated from the ones present:
+	* the pelvis from the head, hands hang down and feet stand under the hips. Limbs are solved
+	* as analytic two bone chains, four at a time with SIMD.
+	* @param FBodySkeleton - Proportions and limits of the body
+	* @param FBodyTargets - The targets to reach
+	* @param FBodyPose - Receives the solved bones
+	*/
+	void SolveBody(const FBodySkeleton& Skeleton, const FBodyTargets& Targets, FBodyPose& OutPose);
+
+	/**
+	* Solve a range of bodies of a batch, four bodies at a time with one body per SIMD lane. Ranges
+	* that don't overlap may be solved concurrently, ranges starting on a multiple of 4 use every lane.
+	* Empty ranges and batches without skeletons, valid masks or poses are left untouched.
+	* @param FBodyBatch - The bodies to solve
+	* @param int - First body of the range
+	* @param int - One past the last body of the range
+	*/
+	void SolveBodies(const FBodyBatch& Batch, int Begin, int End);
+}
@@ -0,0 +1,167 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+// Engine independent body role inference. This header must not include any Unreal headers
+// so the classifier can be built and exercised outside of the engine.
+
+#include "ViveTrackerCore/ViveTrackerIK.h"
+
+namespace ViveTrackerCore
+{
+	/** Most trackers a single classifier considers, a bit per tracker in FRoleFrame::ValidMask */
+	constexpr int MaxClassifiedTrackers = 16;
+
+	/** One frame of tracker positions plus the head, all in the same floor level space */
+	struct FRoleFrame
+	{
+		FPose Head;
+		FVec3 Trackers[MaxClassifiedTrackers];
+		uint32_t ValidMask = 0;
+	};
+
+	/** Tuning of the role classifier */
+	struct FRoleClassifierSettings
+	{
+		/** Axes of the frames' space, the floor is at height 0 */
+		FVec3 Up{ 0.f, 0.f, 1.f };
+		FVec3 Forward{ 1.f, 0.f, 0.f };
+
+		/** Trackers seen in fewer frames are left unclassified */
+		int MinFrames = 30;
+
+		/** Match cost, in squared standard deviations, above which a tracker is not given a role */
+		float MaxCost = 12.f;
+
+		/** Smallest correlation with head motion expected from torso trackers */
+		float MinTorsoCorrelation = 0.7f;
+
+		/** Horizontal head motion, relative to head height, needed before motion correlation is trusted */
+		float MinHeadMotion = 0.02f;
+	};
+
+	/** Result of a classification */
+	struct FRoleClassification
+	{
+		/** Inferred body tracker per tracker slot, EBodyTracker::Count for trackers that don't look body worn */
+		EBodyTracker Roles[MaxClassifiedTrackers];
+
+		/** Match cost per tracker slot, lower is more certain */
+		float Costs[MaxClassifiedTrackers];
+
+		FRoleClassification()
+		{
+			for (int i = 0; i < MaxClassifiedTrackers; i++)
+			{
+				Roles[i] = EBodyTracker::Count;
+				Costs[i] = 0.f;
+			}
+		}
+	};
+
+	/**
+	* Infers which body role each tracker is strapped to from its height and sideways offset relative to
+	* the head, the symmetry of left and right pairs and how well its motion follows the head. Frames are
+	* reduced to running sums as they arrive, so a classifier is a small value that can be copied to a
+	* worker thread and classified there while the next window is captured.
+	*/
+	class FRoleClassifier
+	{
+	public:
+		explicit FRoleClassifier(const FRoleClassifierSettings& Settings = FRoleClassifierSettings()) : m_settings(Settings) {}
+
+		/** Discard all frames, keeping the settings */
+		void Reset();
+
+		/**
+		* Add a frame of tracker positions, trackers keep their slot across frames
+		* @param FRoleFrame - Head pose and tracker positions
+		*/
+		void AddFrame(const FRoleFrame& Frame);
+
+		int GetNumFrames() const { return m_nFrames; }
+
+		/**
+		* Match the accumulated features against body role templates and assign each role at most once
+		* @param FRoleClassification - Receives the role of every tracker slot
+		*/
+		void Classify(FRoleClassification& OutClassification) const;
+
+	private:
+		/** Running sums of a tracker's features over the window */
+		struct FTrackerSums
+		{
+			int Count = 0;
+			double Height = 0.0;
+			double Lateral = 0.0;
+
+			/** Horizontal position sums for the correlation with the head, over the frames the tracker was seen */
+			double Position[2] = { 0.0, 0.0 };
+			double PositionSq = 0.0;
+			double HeadPosition[2] = { 0.0, 0.0 };
+			double HeadPositionSq = 0.0;
+			double Product = 0.0;
+		};
+
+		FRoleClassifierSettings m_settings;
+		FTrackerSums m_sums[MaxClassifiedTrackers];
+		double m_dHeadHeight = 0.0;
+		int m_nFrames = 0;
+	};
+
+	/**
+	* Accepts the roles of a classification only once two consecutive windows agree on them. A single window
+	* can be fooled by the user crouching or waving, which is then ignored rather than reassigning roles.
+	*/
+	class FRoleAgreement
+	{
+	public:
+		FRoleAgreement() { Reset(); }
+
+		/** Forget the pending and accepted roles, for a new set of trackers */
+		void Reset();
+
+		/**
+		* Add the classification of the next window
+		* @param FRoleClassification - Classification of the same tracker slots as the previous windows
+		* @return bool - Whether or not the accepted roles changed, always true for the first agreement after a reset
+		*/
+		bool AddClassification(const FRoleClassification& Classification);
+
+		/** Accepted role of a tracker slot, EBodyTracker::Count until two windows agreed on one */
+		EBodyTracker GetRole(int Slot) const { return m_acceptedRoles[Slot]; }
+
+	private:
+		EBodyTracker m_pendingRoles[MaxClassifiedTrackers];
+		EBodyTracker m_acceptedRoles[MaxClassifiedTrackers];
+		bool m_bHasPending = false;
+		bool m_bHasAccepted = false;
+	};
+}
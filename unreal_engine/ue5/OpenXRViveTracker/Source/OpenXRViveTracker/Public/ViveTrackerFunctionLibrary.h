@@ -31,6 +31,8 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "CoreMinimal.h"
 #include "OpenXRViveTracker.h"
+#include "ViveTrackerBodyIK.h"
+#include "ViveTrackerCalibration.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "ViveTrackerFunctionLibrary.generated.h"
 
@@ -53,4 +55,113 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
 	static FTransform GetTrackerTransform(ETrackerRole TrackerRole);
 
+	/**
+	* Solve a full body from the HMD, controllers and the Waist, Chest, Foot, Knee and Elbow tracker roles.
+	* All inputs are in tracking space, add the PlayerStart location to the results like GetTrackerTransform.
+	* @param FViveTrackerBodyIKSettings - Proportions and joint limits of the body
+	* @param FTransform - HMD transform
+	* @param FTransform - Left controller transform, ignored if bLeftHandTracked is false
+	* @param bool - Whether or not the left controller is tracked
+	* @param FTransform - Right controller transform, ignored if bRightHandTracked is false
+	* @param bool - Whether or not the right controller is tracked
+	* @return FViveTrackerBodyPose - The solved bone transforms
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
+	static FViveTrackerBodyPose SolveFullBodyIK(const FViveTrackerBodyIKSettings& Settings, const FTransform& HeadTransform, 
+		const FTransform& LeftHandTransform, bool bLeftHandTracked, const FTransform& RightHandTransform, bool bRightHandTracked);
+
+	/**
+	* Solve a full body like SolveFullBodyIK, with the proportions and tracker to bone offsets of a calibration
+	* @param FViveTrackerCalibration - Calibration from a UViveTrackerCalibrator
+	* @param FTransform - HMD transform
+	* @param FTransform - Left controller transform, ignored if bLeftHandTracked is false
+	* @param bool - Whether or not the left controller is tracked
+	* @param FTransform - Right controller transform, ignored if bRightHandTracked is false
+	* @param bool - Whether or not the right controller is tracked
+	* @return FViveTrackerBodyPose - The solved bone transforms
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
+	static FViveTrackerBodyPose SolveCalibratedFullBodyIK(const FViveTrackerCalibration& Calibration, const FTransform& HeadTransform,
+		const FTransform& LeftHandTransform, bool bLeftHandTracked, const FTransform& RightHandTransform, bool bRightHandTracked);
+
+	/**
+	* Start recording every tracker sample and connect event to a capture file, replacing the capture in progress
+	* @param FString - Path of the capture file, a timestamped file under Saved/ViveTracker if empty
+	* @param bool - Compress samples, positions are kept within 0.05mm and rotations within 0.00005 per quaternion component
+	* @return bool - Whether or not the capture file could be created
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
+	static bool StartTrackerCapture(const FString& Filename, bool bCompress = true);
+
+	/** Finish the tracker capture in progress, if any */
+	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
+	static void StopTrackerCapture();
+
+	/**
+	* Check whether or not tracker samples are being captured
+	* @return bool - Whether or not a capture is in progress
+	*/
+	UFUNCTION(BlueprintPure, Category = "Vive Tracker")
+	static bool IsCapturingTrackers();
+
+	/**
+	* Serve every tracker getter and connect event from a capture file instead of the runtime, replacing the replay in progress
+	* @param FString - Path of the capture file
+	* @param float - Replay speed relative to the engine clock
+	* @param float - Advance by exactly this many seconds every frame for deterministic tests, 0 follows the engine clock
+	* @param bool - Start over once the end of the capture is reached
+	* @return bool - Whether or not the capture could be opened
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
+	static bool StartTrackerReplay(const FString& Filename, float PlaybackRate = 1.f, float FixedStepSeconds = 0.f, bool bLoop = false);
+
+	/** Stop the tracker replay in progress, if any, and go back to the runtime's trackers */
+	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
+	static void StopTrackerReplay();
+
+	/**
+	* Check whether or not trackers are replayed from a capture
+	* @return bool - Whether or not a replay is in progress
+	*/
+	UFUNCTION(BlueprintPure, Category = "Vive Tracker")
+	static bool IsReplayingTrackers();
+
+	/**
+	* Pause or resume the tracker replay in progress, a paused replay holds its poses
+	* @param bool - Whether or not the replay should be paused
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
+	static void SetTrackerReplayPaused(bool bPaused);
+
+	/**
+	* Move the tracker replay in progress to a time of its capture, takes effect at the start of the next frame
+	* @param float - Seconds from the start of the capture
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
+	static void SeekTrackerReplay(float Seconds);
+
+	/**
+	* Change the speed of the tracker replay in progress
+	* @param float - Replay speed relative to the engine clock
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
+	static void SetTrackerReplayRate(float PlaybackRate);
+
+	/**
+	* Playhead and length of the tracker replay in progress
+	* @param float - Receives the length of the capture in seconds
+	* @return float - Seconds from the start of the capture, 0 without a replay
+	*/
+	UFUNCTION(BlueprintPure, Category = "Vive Tracker")
+	static float GetTrackerReplayPosition(float& Duration);
+
+	/**
+	* Draw every tracker's axes, velocity, trail and status (green tracked, yellow inferred, red lost) for debugging
+	* @param bool - Whether or not trackers should be drawn
+	* @param FVector - Added to every tracker location, like a tracker component's PlayerStartLocation
+	* @param int32 - Number of past positions in each tracker's trail, clamped to 0 to 10000, 0 hides trails
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Vive Tracker")
+	static void SetTrackerDebugDraw(bool bEnabled, FVector PlayerStartLocation, int32 TrailLength = 90);
+
 };
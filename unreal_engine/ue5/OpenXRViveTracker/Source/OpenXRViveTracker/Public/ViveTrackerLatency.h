@@ -0,0 +1,152 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "ViveTrackerSample.h"
+
+/** Stages a tracker pose goes through on its way to the screen, each measured from the moment the pose was sampled */
+enum class EViveTrackerLatencyStage : uint8
+{
+	/** The module stored the pose, from then on every getter returns it */
+	Publish,
+
+	/** A UViveTrackerComponent moved to the pose */
+	Component,
+
+	/** The render thread finished submitting the frame the pose was applied in */
+	RenderSubmit,
+
+	Num
+};
+
+/** Latency distribution in 10us buckets up to 100ms, fixed size so adding never allocates. Written by one thread at a time. */
+class OPENXRVIVETRACKER_API FViveTrackerLatencyHistogram
+{
+public:
+	static constexpr int32 NumBuckets = 10000;
+	static constexpr double BucketSeconds = 10.0e-6;
+
+	FViveTrackerLatencyHistogram() { Reset(); }
+
+	/**
+	* Add a latency, longer ones than the histogram covers land in its last bucket
+	* @param double - The latency in seconds
+	*/
+	void Add(double Seconds);
+
+	/** Discard every latency added so far */
+	void Reset();
+
+	/** Number of latencies added */
+	int64 Num() const { return m_nCount; }
+
+	/** Mean and longest latency in seconds, 0 if empty */
+	double GetMean() const { return m_nCount > 0 ? m_fSum / m_nCount : 0.0; }
+	double GetMax() const { return m_fMax; }
+
+	/**
+	* Latency below which a share of the latencies fall, to the bucket's resolution
+	* @param double - The share, between 0 and 1
+	* @return double - The latency in seconds, the upper end of its bucket, 0 if empty
+	*/
+	double GetPercentile(double Percentile) const;
+
+private:
+	TStaticArray<uint32, NumBuckets> m_arrBuckets;
+	int64 m_nCount = 0;
+	double m_fSum = 0.0;
+	double m_fMax = 0.0;
+};
+
+/**
+* Measures how long tracker poses take from being sampled by the module to being published, applied by
+* UViveTrackerComponents and submitted for rendering, as distributions per stage. Started and stopped through
+* FOpenXRViveTrackerModule::StartLatencyRecording, "vivetracker.MeasureLatency" runs a whole measurement.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerLatencyRecorder
+{
+public:
+	~FViveTrackerLatencyRecorder();
+
+	/** Discard previous results and start recording, game thread only */
+	void Start();
+
+	/** Stop recording, waits for the render thread to submit the frames recorded so far. Game thread only. */
+	void Stop();
+
+	/** Whether or not latencies are being recorded */
+	bool IsRecording() const { return m_hEndFrame.IsValid(); }
+
+	/**
+	* Record a pose the module just stored, game thread only
+	* @param FViveTrackerSample - The stored sample
+	*/
+	void RecordPublished(const FViveTrackerSample& Sample);
+
+	/**
+	* Record a pose a consumer such as UViveTrackerComponent just applied, game thread only
+	* @param FViveTrackerSample - The applied sample
+	*/
+	void RecordConsumed(const FViveTrackerSample& Sample);
+
+	/**
+	* Latencies of a stage
+	* @param EViveTrackerLatencyStage - The stage
+	* @return FViveTrackerLatencyHistogram - The stage's distribution
+	*/
+	const FViveTrackerLatencyHistogram& GetHistogram(EViveTrackerLatencyStage Stage) const { return m_arrHistograms[(int32)Stage]; }
+
+	/** Mean game frame time while recording, in seconds, 0 before the second frame */
+	double GetMeanFrameSeconds() const;
+
+	/** Log every stage's count, mean, percentiles and maximum, in milliseconds and frames */
+	void LogReport() const;
+
+private:
+	// Sample times applied by consumers during a game frame, frames rarely apply poses from more than one sync
+	struct FFrameSamples
+	{
+		static constexpr int32 Capacity = 4;
+		double SampledSeconds[Capacity];
+		int32 Num = 0;
+	};
+
+	void OnEndFrame();
+	void RecordRenderSubmit(const FFrameSamples& FrameSamples);
+
+	TStaticArray<FViveTrackerLatencyHistogram, (int32)EViveTrackerLatencyStage::Num> m_arrHistograms;
+	FFrameSamples m_frameSamples;
+	FDelegateHandle m_hEndFrame;
+	double m_fFirstFrameSeconds = 0.0;
+	double m_fLastFrameSeconds = 0.0;
+	int64 m_nFrames = 0;
+};
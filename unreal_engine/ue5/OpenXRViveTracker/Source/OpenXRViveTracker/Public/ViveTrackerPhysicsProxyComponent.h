@@ -0,0 +1,141 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "OpenXRViveTracker.h"
+#include "ViveTrackerPhysicsProxyComponent.generated.h"
+
+class UStaticMesh;
+class UStaticMeshComponent;
+class FViveTrackerSubstepTargetsCallback;
+
+/** A kinematic body driven by a tracker, owned by a UViveTrackerPhysicsProxyComponent */
+USTRUCT(BlueprintType)
+struct OPENXRVIVETRACKER_API FViveTrackerPhysicsProxy
+{
+	GENERATED_BODY()
+
+	/** The assigned tracker role in the openxr runtime, ignored if a persistent path is set */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker")
+	TEnumAsByte<ETrackerRole> TrackerRole = ETrackerRole::Unassigned;
+
+	/** Optional persistent path of the tracker (e.g. /devices/htc/vive_trackerLHR-XXXXXXXX), follows the tracker across role changes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker")
+	FString PersistentPath;
+
+	/** Mesh providing the body's collision */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker")
+	UStaticMesh* CollisionMesh = nullptr;
+
+	/** Offset of the body relative to the tracker */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker")
+	FTransform MeshOffset = FTransform::Identity;
+};
+
+/**
+* Owns one kinematic body per configured tracker and moves all of them to their tracker poses
+* with a single batched write to the physics scene per frame. When physics substeps, every
+* substep gets its own targets, fetched in one batch per frame and applied from the physics thread.
+*/
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class OPENXRVIVETRACKER_API UViveTrackerPhysicsProxyComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UViveTrackerPhysicsProxyComponent();
+
+	/** The trackers that get a kinematic body */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "ViveTracker")
+	TArray<FViveTrackerPhysicsProxy> Proxies;
+
+	/** The vr pawn/character's player start location */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker")
+	FVector PlayerStartLocation = FVector::ZeroVector;
+
+	/** Collision profile applied to every proxy body */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "ViveTracker")
+	FName CollisionProfileName = TEXT("BlockAllDynamic");
+
+	/** Enable continuous collision detection on bodies whose tracker moves faster than CCDSpeedThreshold */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker")
+	bool bEnableCCD = false;
+
+	/** Tracker speed in cm/s above which a proxy body is swept with CCD */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ViveTracker", meta = (EditCondition = "bEnableCCD", ClampMin = "0"))
+	float CCDSpeedThreshold = 300.f;
+
+	/**
+	* Retrieve the body created for a proxy
+	* @param int32 - Index of the proxy in Proxies
+	* @return UStaticMeshComponent - The proxy's body, null if the index is invalid or play hasn't begun
+	*/
+	UFUNCTION(BlueprintCallable, Category = "ViveTracker")
+	UStaticMeshComponent* GetProxyBody(int32 ProxyIndex) const;
+
+private:
+	FOpenXRViveTrackerModule* m_trackerModule = nullptr;
+
+	UPROPERTY(Transient)
+	TArray<UStaticMeshComponent*> m_arrBodies;
+
+	// Per-frame scratch, sized once in BeginPlay so the tick doesn't allocate
+	TArray<ETrackerRole> m_arrRoles;
+	TArray<FViveTrackerSample> m_arrSamples;
+	TArray<FTransform> m_arrTargets;
+	TArray<bool> m_arrCCDEnabled;
+
+	// Tracker transforms at every physics substep of the frame, substep-major, only grows with the substep count
+	TArray<FTransform> m_arrSubstepTransforms;
+
+	// Applies the substep targets at the start of each physics substep
+	FViveTrackerSubstepTargetsCallback* m_pSubstepCallback = nullptr;
+	uint32 m_nSubstepFrame = 0;
+
+	uint32 m_nTrackerPathsGeneration = MAX_uint32;
+
+	void ResolveRoles();
+	void PushKinematicTargets();
+	void PushSubstepTargets(float DeltaTime, int32 NumSubsteps);
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the game ends or the component is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+};
@@ -0,0 +1,130 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ViveTrackerCapture.h"
+
+/** How a replay advances */
+struct FViveTrackerReplaySettings
+{
+	/** Replay speed relative to the engine clock */
+	float PlaybackRate = 1.f;
+
+	/** Advance by exactly this many seconds every frame instead of following the engine clock, for deterministic tests. 0 follows the engine clock. */
+	float FixedStepSeconds = 0.f;
+
+	/** Start over once the end of the capture is reached, instead of holding the last poses */
+	bool bLoop = false;
+
+	/**
+	* Number of compressed chunks a worker thread decodes ahead of the playhead, along with the one before it for scrubbing back.
+	* 0 decodes every chunk on the thread advancing the replay. Only read when the capture is opened.
+	*/
+	int32 DecodeAheadChunks = 2;
+};
+
+class FViveTrackerReplayPrefetcher;
+
+/**
+* Plays a capture back in time order. Advance hands every sample and event between the previous playhead
+* and the new one to the caller, so replayed trackers go through exactly the samples the module saw while
+* recording. Compressed chunks are decoded one at a time as the playhead reaches them, seeks start from the
+* capture's last keyframe before the time. With DecodeAheadChunks set, a worker thread decodes the chunks around
+* the playhead before they are reached and pages uncompressed ones in, so playing and scrubbing rarely wait on either.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerReplay
+{
+public:
+	FViveTrackerReplay();
+	~FViveTrackerReplay();
+
+	/**
+	* Open a capture and put the playhead at its start
+	* @param FString - Path of the capture file
+	* @param FViveTrackerReplaySettings - How the owner should advance the replay
+	* @return bool - Whether or not the capture could be opened
+	*/
+	bool Open(const FString& Filename, const FViveTrackerReplaySettings& Settings = FViveTrackerReplaySettings());
+
+	/** Close the capture */
+	void Close();
+
+	/** Whether or not a capture is open */
+	bool IsOpen() const { return m_reader.IsOpen(); }
+
+	/** How the owner should advance the replay */
+	const FViveTrackerReplaySettings& GetSettings() const { return m_settings; }
+	void SetSettings(const FViveTrackerReplaySettings& Settings) { m_settings = Settings; }
+
+	/** The capture being replayed */
+	const FViveTrackerCaptureReader& GetReader() const { return m_reader; }
+
+	/** Runtime time of the playhead, every sample up to it has been handed out */
+	XrTime GetTime() const { return m_nTime; }
+
+	/** Whether or not every sample and event has been handed out */
+	bool IsFinished() const { return m_nChunk >= m_reader.GetNumSampleChunks() && m_nEvent >= m_reader.GetEvents().Num(); }
+
+	/**
+	* Move the playhead forward, handing out every sample and event up to the new time in time order.
+	* Events come before samples with the same time.
+	* @param XrTime - New runtime time of the playhead, ignored if before the current one
+	* @param TFunctionRef<void(const ViveTrackerCore::FCaptureSample&)> - Called for every sample
+	* @param TFunctionRef<void(const ViveTrackerCore::FCaptureEvent&)> - Called for every event
+	*/
+	void Advance(XrTime Time, TFunctionRef<void(const ViveTrackerCore::FCaptureSample&)> OnSample, TFunctionRef<void(const ViveTrackerCore::FCaptureEvent&)> OnEvent);
+
+	/**
+	* Jump the playhead back to the last keyframe before a time. The next Advance hands out the keyframe's samples,
+	* so every tracker's pose is known again right after a seek, followed by the samples from the keyframe on.
+	* Captures without keyframes start from the chunk holding the time instead.
+	* @param XrTime - Runtime time to move the playhead to
+	*/
+	void Seek(XrTime Time);
+
+private:
+	bool LoadChunk(int32 ChunkIndex);
+
+	FViveTrackerReplaySettings m_settings;
+	FViveTrackerCaptureReader m_reader;
+	FViveTrackerCaptureDecodeBuffer m_decodeBuffer;
+	TUniquePtr<FViveTrackerReplayPrefetcher> m_pPrefetcher;
+	TArrayView<const ViveTrackerCore::FCaptureSample> m_arrChunkSamples;
+	TArrayView<const ViveTrackerCore::FCaptureSample> m_arrKeyframeSamples;
+
+	XrTime m_nTime = 0;
+	int32 m_nChunk = 0;
+	int32 m_nSample = 0;
+	int32 m_nEvent = 0;
+	int32 m_nKeyframeSample = 0;
+	// Compressed chunk whose samples m_decodeBuffer holds, INDEX_NONE if none
+	int32 m_nDecodedChunk = INDEX_NONE;
+};
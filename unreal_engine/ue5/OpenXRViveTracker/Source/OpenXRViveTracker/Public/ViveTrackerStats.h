@@ -0,0 +1,104 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ViveTrackerSample.h"
+
+/**
+* Tracker plugin stats, shown with "stat ViveTracker". Like all stats they compile out where STATS is 0, e.g. in
+* shipping builds.
+*/
+DECLARE_STATS_GROUP(TEXT("ViveTracker"), STATGROUP_ViveTracker, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PostSyncActions"), STAT_ViveTracker_Sync, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Locate"), STAT_ViveTracker_Locate, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Publish"), STAT_ViveTracker_Publish, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tracker Paths"), STAT_ViveTracker_TrackerPaths, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Events"), STAT_ViveTracker_Events, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Replay"), STAT_ViveTracker_Replay, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tracker Components"), STAT_ViveTracker_Component, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics Proxies"), STAT_ViveTracker_PhysicsProxy, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Debug Draw"), STAT_ViveTracker_DebugDraw, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Located Trackers"), STAT_ViveTracker_LocatedTrackers, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Connect Events"), STAT_ViveTracker_ConnectEvents, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Connected Trackers"), STAT_ViveTracker_ConnectedTrackers, STATGROUP_ViveTracker, OPENXRVIVETRACKER_API);
+
+/** Time spent in each OpenXR function the plugin calls, shown with "stat ViveTrackerXr", see FViveTrackerXrProfiler */
+DECLARE_STATS_GROUP(TEXT("ViveTrackerXr"), STATGROUP_ViveTrackerXr, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrGetInstanceProcAddr"), STAT_ViveTrackerXr_GetInstanceProcAddr, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrCreateActionSet"), STAT_ViveTrackerXr_CreateActionSet, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrDestroyActionSet"), STAT_ViveTrackerXr_DestroyActionSet, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrCreateAction"), STAT_ViveTrackerXr_CreateAction, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrDestroyAction"), STAT_ViveTrackerXr_DestroyAction, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrCreateActionSpace"), STAT_ViveTrackerXr_CreateActionSpace, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrSuggestInteractionProfileBindings"), STAT_ViveTrackerXr_SuggestInteractionProfileBindings, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrLocateSpace"), STAT_ViveTrackerXr_LocateSpace, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrStringToPath"), STAT_ViveTrackerXr_StringToPath, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrPathToString"), STAT_ViveTrackerXr_PathToString, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("xrEnumerateViveTrackerPathsHTCX"), STAT_ViveTrackerXr_EnumerateViveTrackerPaths, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Convert Time"), STAT_ViveTrackerXr_ConvertTime, STATGROUP_ViveTrackerXr, OPENXRVIVETRACKER_API);
+
+/** Tracker events in Unreal Insights, recorded with -trace=default,vivetracker. Compiled out in shipping builds. */
+#define VIVETRACKER_TRACE_ENABLED (UE_TRACE_ENABLED && !UE_BUILD_SHIPPING)
+
+#if VIVETRACKER_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(ViveTrackerChannel, OPENXRVIVETRACKER_API);
+
+struct OPENXRVIVETRACKER_API FViveTrackerTrace
+{
+	/**
+	* Record a tracker's newly published pose, does nothing unless the channel is enabled
+	* @param uint8 - Role the pose was published for
+	* @param FViveTrackerSample - The published sample
+	*/
+	static void OutputPose(uint8 Role, const FViveTrackerSample& Sample);
+
+	/**
+	* Record a connect event, does nothing unless the channel is enabled
+	* @param uint8 - Runtime role of the connected tracker
+	*/
+	static void OutputConnected(uint8 Role);
+};
+
+#define VIVETRACKER_TRACE_POSE(Role, Sample) FViveTrackerTrace::OutputPose((uint8)(Role), Sample)
+#define VIVETRACKER_TRACE_CONNECTED(Role) FViveTrackerTrace::OutputConnected((uint8)(Role))
+
+#else
+
+#define VIVETRACKER_TRACE_POSE(Role, Sample)
+#define VIVETRACKER_TRACE_CONNECTED(Role)
+
+#endif
@@ -0,0 +1,189 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ViveTrackerStats.h"
+#include "ViveTrackerCore/ViveTrackerSession.h"
+
+/** OpenXR functions the plugin calls, as recorded by FViveTrackerXrProfiler */
+enum class EViveTrackerXrCall : uint8
+{
+	GetInstanceProcAddr,
+	CreateActionSet,
+	DestroyActionSet,
+	CreateAction,
+	DestroyAction,
+	CreateActionSpace,
+	SuggestInteractionProfileBindings,
+	LocateSpace,
+	StringToPath,
+	PathToString,
+	EnumerateViveTrackerPaths,
+	ConvertTime,
+
+	Num
+};
+
+/**
+* Call durations in log-linear buckets, 8 per power of two from 64ns to a minute, so percentiles are within 12.5% whether
+* a call takes a microsecond or a blocking millisecond. Fixed size so adding never allocates. Written by one thread at a time.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerXrCallHistogram
+{
+public:
+	static constexpr int32 SubBucketBits = 3;
+	static constexpr int32 MinExponent = 6;
+	static constexpr int32 MaxExponent = 36;
+	static constexpr int32 NumBuckets = 1 + ((MaxExponent - MinExponent + 1) << SubBucketBits);
+
+	FViveTrackerXrCallHistogram() { Reset(); }
+
+	/**
+	* Add a call duration, longer ones than the histogram covers land in its last bucket
+	* @param uint64 - The duration in nanoseconds
+	*/
+	void Add(uint64 Nanoseconds);
+
+	/** Discard every duration added so far */
+	void Reset();
+
+	/** Number of calls added */
+	int64 Num() const { return m_nCount; }
+
+	/** Total, mean and longest duration in seconds, 0 if empty */
+	double GetTotal() const { return m_nTotalNs * 1.0e-9; }
+	double GetMean() const { return m_nCount > 0 ? m_nTotalNs * 1.0e-9 / m_nCount : 0.0; }
+	double GetMax() const { return m_nMaxNs * 1.0e-9; }
+
+	/**
+	* Duration below which a share of the calls fall, to the bucket's resolution
+	* @param double - The share, between 0 and 1
+	* @return double - The duration in seconds, the upper end of its bucket, 0 if empty
+	*/
+	double GetPercentile(double Percentile) const;
+
+private:
+	static int32 GetBucket(uint64 Nanoseconds);
+	static uint64 GetBucketUpperBound(int32 Bucket);
+
+	uint32 m_arrBuckets[NumBuckets];
+	int64 m_nCount = 0;
+	uint64 m_nTotalNs = 0;
+	uint64 m_nMaxNs = 0;
+};
+
+/**
+* Optional instrumentation of every OpenXR call the plugin makes, so the cost of a runtime can be compared across
+* runtime versions. The module hands the tracker session entry points wrapped by Wrap, which forward every call and, while
+* profiling is enabled, add its duration to a histogram per function; xrEnumerateViveTrackerPathsHTCX is wrapped when
+* the session resolves it, and the clock times its conversions itself. Every call also counts towards
+* "stat ViveTrackerXr" when stats are compiled in.
+*
+* Disabled by default, where a call costs a branch more. Enabled with -ViveTrackerXrProfile or "vivetracker.XrProfile on",
+* reported with "vivetracker.XrProfileDump", which also writes the percentiles to a csv file. Calls are recorded from the
+* game thread, which makes all of them.
+*/
+class OPENXRVIVETRACKER_API FViveTrackerXrProfiler
+{
+public:
+	/**
+	* Entry points that time each call then forward it, replacing the ones previously wrapped
+	* @param FXrEntryPoints - The entry points to forward calls to
+	* @return FXrEntryPoints - The profiled entry points
+	*/
+	static ViveTrackerCore::FXrEntryPoints Wrap(const ViveTrackerCore::FXrEntryPoints& EntryPoints);
+
+	/** Start or stop adding calls to the histograms, which keep what they recorded until Reset */
+	static void SetEnabled(bool bEnabled);
+	static bool IsEnabled();
+
+	/** Discard every call recorded so far */
+	static void Reset();
+
+	/**
+	* Add a call that just returned, see FViveTrackerXrCallScope
+	* @param EViveTrackerXrCall - The function called
+	* @param uint64 - FPlatformTime::Cycles64 before the call
+	*/
+	static void Record(EViveTrackerXrCall Call, uint64 StartCycles);
+
+	/**
+	* Durations of a function's calls
+	* @param EViveTrackerXrCall - The function
+	* @return FViveTrackerXrCallHistogram - The function's distribution
+	*/
+	static const FViveTrackerXrCallHistogram& GetHistogram(EViveTrackerXrCall Call);
+
+	/**
+	* OpenXR name of a function
+	* @param EViveTrackerXrCall - The function
+	* @return TCHAR - e.g. "xrLocateSpace"
+	*/
+	static const TCHAR* GetCallName(EViveTrackerXrCall Call);
+
+	/** Log the count, total, mean, percentiles and maximum of every function called, in microseconds */
+	static void LogReport(FOutputDevice& Ar);
+
+	/**
+	* Write the same figures as LogReport as csv, one row per function called
+	* @param FString - File to write
+	* @return bool - Whether or not the file was written
+	*/
+	static bool WriteCsv(const FString& Filename);
+};
+
+/** Times a call for FViveTrackerXrProfiler, reading the clock only while profiling is enabled */
+class FViveTrackerXrCallScope
+{
+public:
+	explicit FViveTrackerXrCallScope(EViveTrackerXrCall InCall)
+		: m_call(InCall)
+		, m_nStartCycles(FViveTrackerXrProfiler::IsEnabled() ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FViveTrackerXrCallScope()
+	{
+		if (m_nStartCycles != 0)
+		{
+			FViveTrackerXrProfiler::Record(m_call, m_nStartCycles);
+		}
+	}
+
+private:
+	EViveTrackerXrCall m_call;
+	uint64 m_nStartCycles;
+};
+
+/** Profile the rest of the scope as a call to an OpenXR function, named after EViveTrackerXrCall */
+#define VIVETRACKER_XR_CALL_SCOPE(Call) \
+	SCOPE_CYCLE_COUNTER(STAT_ViveTrackerXr_##Call); \
+	FViveTrackerXrCallScope PREPROCESSOR_JOIN(xrCallScope, __LINE__)(EViveTrackerXrCall::Call)
@@ -0,0 +1,74 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/DeclarativeSyntaxSupport.h"
+#include "Widgets/SCompoundWidget.h"
+
+class SEditableTextBox;
+
+/**
+* Playback controls for tracker captures: open a capture, play, pause, scrub and change speed. The controls drive the
+* module's replay, so every UViveTrackerComponent follows the capture, in the level viewports as well as in PIE.
+*/
+class SViveTrackerPlayback : public SCompoundWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SViveTrackerPlayback) {}
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+
+private:
+	FReply OnBrowseClicked();
+	FReply OnOpenClicked();
+	FReply OnCloseClicked();
+	FReply OnPlayPauseClicked();
+
+	void OnScrubBegin();
+	void OnScrubEnd();
+	void OnScrubChanged(float Value);
+	void OnRateChanged(float Rate);
+	void OnLoopChanged(ECheckBoxState State);
+
+	bool IsReplaying() const;
+	FText GetPlayPauseText() const;
+	FText GetTimeText() const;
+	float GetScrubValue() const;
+	float GetRate() const;
+	ECheckBoxState GetLoopState() const;
+
+	TSharedPtr<SEditableTextBox> m_pFilenameBox;
+
+	// Playback is paused while the playhead is dragged, and resumes afterwards if it was playing
+	bool m_bScrubbing = false;
+	bool m_bPausedBeforeScrub = false;
+};
@@ -0,0 +1,937 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ViveTrackerExportCommandlet.h"
+#include "ViveTrackerCapture.h"
+#include "ViveTrackerSample.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+using namespace ViveTrackerCore;
+
+/** Samples further apart than this aren't interpolated, the tracker is considered lost in between */
+static constexpr XrTime MaxInterpolationGapNs = 100 * 1000 * 1000;
+
+/** Frames resampled at once, bounds memory when a capture has long stretches without samples */
+static constexpr int32 FramesPerPass = 16 * 1024;
+
+/** Frames converted and formatted per task */
+static constexpr int32 FramesPerTask = 256;
+
+/** Parent in the exported hierarchy of a role's joint, Unassigned for the root */
+static ETrackerRole GetParentRole(ETrackerRole Role)
+{
+	switch (Role)
+	{
+	case ETrackerRole::Foot_L: return ETrackerRole::Knee_L;
+	case ETrackerRole::Foot_R: return ETrackerRole::Knee_R;
+	case ETrackerRole::Knee_L: return ETrackerRole::Waist;
+	case ETrackerRole::Knee_R: return ETrackerRole::Waist;
+	case ETrackerRole::Elbow_L: return ETrackerRole::Shoulder_L;
+	case ETrackerRole::Elbow_R: return ETrackerRole::Shoulder_R;
+	case ETrackerRole::Shoulder_L: return ETrackerRole::Chest;
+	case ETrackerRole::Shoulder_R: return ETrackerRole::Chest;
+	case ETrackerRole::Chest: return ETrackerRole::Waist;
+	default: return ETrackerRole::Unassigned;
+	}
+}
+
+/** Engine space (X forward, Z up, left handed) to the Y up right handed space of BVH and glTF */
+static FVector ToYUp(const FVector& Vector)
+{
+	return FVector(Vector.X, Vector.Z, Vector.Y);
+}
+
+static FQuat ToYUp(const FQuat& Rotation)
+{
+	return FQuat(-Rotation.X, -Rotation.Z, -Rotation.Y, Rotation.W);
+}
+
+/** Euler angles in degrees of a right handed rotation, for BVH's Zrotation Xrotation Yrotation channel order */
+static FVector ToEulerZXY(const FQuat& Rotation)
+{
+	const double X = Rotation.X, Y = Rotation.Y, Z = Rotation.Z, W = Rotation.W;
+	const double M01 = 2.0 * (X * Y - Z * W);
+	const double M11 = 1.0 - 2.0 * (X * X + Z * Z);
+	const double M20 = 2.0 * (X * Z - Y * W);
+	const double M21 = 2.0 * (Y * Z + X * W);
+	const double M22 = 1.0 - 2.0 * (X * X + Y * Y);
+
+	double AngleZ, AngleY;
+	const double AngleX = FMath::Asin(FMath::Clamp(M21, -1.0, 1.0));
+	if (FMath::Abs(M21) < 0.999999)
+	{
+		AngleZ = FMath::Atan2(-M01, M11);
+		AngleY = FMath::Atan2(-M20, M22);
+	}
+	else
+	{
+		// Gimbal lock, Z and Y rotate about the same axis
+		const double M00 = 1.0 - 2.0 * (Y * Y + Z * Z);
+		const double M10 = 2.0 * (X * Y + Z * W);
+		AngleZ = FMath::Atan2(M10, M00);
+		AngleY = 0.0;
+	}
+
+	return FVector(FMath::RadiansToDegrees(AngleX), FMath::RadiansToDegrees(AngleY), FMath::RadiansToDegrees(AngleZ));
+}
+
+/** Joint names end up in BVH and JSON, keep letters, digits and underscores */
+static FString SanitizeJointName(const FString& Name)
+{
+	FString sName = Name;
+	for (int32 nChar = 0; nChar < sName.Len(); nChar++)
+	{
+		sName[nChar] = FChar::IsAlnum(sName[nChar]) ? sName[nChar] : TEXT('_');
+	}
+	return sName;
+}
+
+static void AppendNumber(TArray<ANSICHAR>& Out, double Value, int32 Precision)
+{
+	ANSICHAR Buffer[64];
+	const int32 nLength = FCStringAnsi::Snprintf(Buffer, UE_ARRAY_COUNT(Buffer), "%.*f", Precision, Value);
+	Out.Append(Buffer, FMath::Clamp(nLength, 0, (int32)UE_ARRAY_COUNT(Buffer) - 1));
+}
+
+static void AppendText(TArray<ANSICHAR>& Out, const FString& Text)
+{
+	FTCHARToUTF8 TextUTF8(*Text);
+	Out.Append(reinterpret_cast<const ANSICHAR*>(TextUTF8.Get()), TextUTF8.Length());
+}
+
+/** A joint of the exported hierarchy, the root at index 0 and every parent before its children */
+struct FExportJoint
+{
+	FString Name;
+
+	/** Tracker driving the joint, INDEX_NONE for the root */
+	int32 TrackerId = INDEX_NONE;
+
+	int32 Parent = INDEX_NONE;
+	TArray<int32> Children;
+
+	/** Pose of the tracker's first valid sample, gives the rest pose */
+	FTransform RestTransform = FTransform::Identity;
+};
+
+/** Resamples a capture and streams it out to every requested format */
+class FViveTrackerExporter
+{
+public:
+	FViveTrackerExporter(const FViveTrackerCaptureReader& Reader, double FrameRate)
+		: m_reader(Reader)
+		, m_fFrameRate(FrameRate)
+	{
+		m_nNumFrames = (int64)((m_reader.GetEndTime() - m_reader.GetStartTime()) * 1.0e-9 * m_fFrameRate) + 1;
+	}
+
+	bool BuildJoints(const FString& SkeletonFilename);
+	bool Open(const FString& OutputPath, bool bBvh, bool bCsv, bool bGltf);
+	void Export();
+	bool Close();
+
+	int64 GetNumFrames() const { return m_nNumFrames; }
+	int32 GetNumJoints() const { return m_arrJoints.Num(); }
+
+private:
+	XrTime GetFrameTime(int64 Frame) const { return m_reader.GetStartTime() + (XrTime)(Frame * 1.0e9 / m_fFrameRate); }
+	int64 GetFirstFrame(int32 SampleChunk) const;
+
+	void ExportBatch(int32 FirstChunk, int32 EndChunk);
+	void ExportFrames(int64 FirstFrame, int64 EndFrame);
+	void FormatBvh(int64 FirstFrame, int64 EndFrame, TArray<ANSICHAR>& Out) const;
+	void FormatCsv(int64 FirstFrame, int64 EndFrame, TArray<ANSICHAR>& Out) const;
+	void WriteGltf(int64 FirstFrame, int64 EndFrame);
+	void WriteText(FArchive* pArchive, const TArray<ANSICHAR>& Text);
+
+	const FViveTrackerCaptureReader& m_reader;
+	double m_fFrameRate;
+	int64 m_nNumFrames = 0;
+	TArray<FExportJoint> m_arrJoints;
+	TArray<int32> m_arrTrackerJoints;
+
+	FString m_sGltfPath;
+	FString m_sBinName;
+	TUniquePtr<FArchive> m_pBvh;
+	TUniquePtr<FArchive> m_pCsv;
+	TUniquePtr<FArchive> m_pBin;
+	bool m_bWriteFailed = false;
+
+	// Per batch: decoded chunks, valid samples of every joint in time order and where resampling got to
+	TArray<FViveTrackerCaptureDecodeBuffer> m_arrDecodeBuffers;
+	TArray<TArrayView<const FCaptureSample>> m_arrChunkSamples;
+	TArray<TArray<const FCaptureSample*>> m_arrJointSamples;
+	TArray<int32> m_arrBatchSamples;
+	TArray<int32> m_arrCursors;
+	TArray<const FCaptureSample*> m_arrPrevious;
+
+	// Carried across batches: every joint's last valid sample so far and last exported rotation
+	TArray<FCaptureSample> m_arrCarry;
+	TArray<bool> m_arrHasCarry;
+	TArray<FQuat> m_arrLastRotations;
+
+	// Rest pose of every joint relative to its parent, in Y up space
+	TArray<FTransform> m_arrRestLocal;
+
+	// Per pass, frame major: world poses in engine space, tracking state and poses relative to the parent in Y up space
+	int64 m_nPassFirstFrame = 0;
+	TArray<FTransform> m_arrWorld;
+	TArray<bool> m_arrTracked;
+	TArray<FTransform> m_arrLocal;
+	TArray<TArray<ANSICHAR>> m_arrBvhText;
+	TArray<TArray<ANSICHAR>> m_arrCsvText;
+	TArray<float> m_arrChannel;
+};
+
+bool FViveTrackerExporter::BuildJoints(const FString& SkeletonFilename)
+{
+	const TArray<FViveTrackerCaptureTracker>& arrTrackers = m_reader.GetTrackers();
+
+	// Rest pose from every tracker's first valid sample, trackers that never had one aren't exported
+	TArray<FTransform> arrRest;
+	TArray<bool> arrFound;
+	arrRest.SetNum(arrTrackers.Num());
+	arrFound.SetNumZeroed(arrTrackers.Num());
+	int32 nMissing = arrTrackers.Num();
+
+	FViveTrackerCaptureDecodeBuffer Buffer;
+	for (int32 nChunk = 0; nChunk < m_reader.GetNumSampleChunks() && nMissing > 0; nChunk++)
+	{
+		for (const FCaptureSample& CaptureSample : m_reader.GetSampleChunk(nChunk, Buffer))
+		{
+			const FViveTrackerSample Sample = FViveTrackerCaptureReader::ToTrackerSample(CaptureSample);
+			if (arrFound.IsValidIndex(CaptureSample.TrackerId) && !arrFound[CaptureSample.TrackerId] && Sample.HasValidPose())
+			{
+				arrRest[CaptureSample.TrackerId] = Sample.Transform;
+				arrFound[CaptureSample.TrackerId] = true;
+				nMissing--;
+			}
+		}
+	}
+
+	// Joints are named after their role, trackers without one or sharing it after their path
+	TArray<int32> arrRoleCounts;
+	arrRoleCounts.SetNumZeroed((int32)ETrackerRole::Unassigned + 1);
+	for (int32 nTracker = 0; nTracker < arrTrackers.Num(); nTracker++)
+	{
+		arrRoleCounts[(int32)arrTrackers[nTracker].Role] += arrFound[nTracker] ? 1 : 0;
+	}
+
+	TArray<FExportJoint> arrJoints;
+	arrJoints.AddDefaulted();
+	arrJoints[0].Name = TEXT("Root");
+
+	TArray<int32> arrRoleJoints;
+	arrRoleJoints.Init(INDEX_NONE, (int32)ETrackerRole::Unassigned + 1);
+	for (int32 nTracker = 0; nTracker < arrTrackers.Num(); nTracker++)
+	{
+		if (!arrFound[nTracker])
+			continue;
+
+		const FViveTrackerCaptureTracker& Tracker = arrTrackers[nTracker];
+		FExportJoint& Joint = arrJoints.AddDefaulted_GetRef();
+		Joint.TrackerId = nTracker;
+		Joint.RestTransform = arrRest[nTracker];
+
+		if (Tracker.Role != ETrackerRole::Unassigned && arrRoleCounts[(int32)Tracker.Role] == 1)
+		{
+			Joint.Name = StaticEnum<ETrackerRole>()->GetNameStringByValue((int64)Tracker.Role);
+			arrRoleJoints[(int32)Tracker.Role] = arrJoints.Num() - 1;
+		}
+		else
+		{
+			Joint.Name = Tracker.PersistentPath.IsEmpty() ? FString::Printf(TEXT("Tracker%d"), nTracker) : SanitizeJointName(FPaths::GetCleanFilename(Tracker.PersistentPath));
+		}
+	}
+
+	// Parents follow the role layout, skipping roles without a tracker
+	for (int32 nJoint = 1; nJoint < arrJoints.Num(); nJoint++)
+	{
+		arrJoints[nJoint].Parent = 0;
+		for (ETrackerRole Role = GetParentRole(arrTrackers[arrJoints[nJoint].TrackerId].Role); Role != ETrackerRole::Unassigned; Role = GetParentRole(Role))
+		{
+			if (arrRoleJoints[(int32)Role] != INDEX_NONE)
+			{
+				arrJoints[nJoint].Parent = arrRoleJoints[(int32)Role];
+				break;
+			}
+		}
+	}
+
+	if (!SkeletonFilename.IsEmpty())
+	{
+		TArray<FString> arrLines;
+		if (!FFileHelper::LoadFileToStringArray(arrLines, *SkeletonFilename))
+		{
+			UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to read skeleton file %s"), *SkeletonFilename);
+			return false;
+		}
+
+		auto FindJoint = [&arrJoints](const FString& Name)
+		{
+			return arrJoints.IndexOfByPredicate([&Name](const FExportJoint& Joint) { return Joint.Name.Equals(Name, ESearchCase::IgnoreCase); });
+		};
+
+		for (const FString& sLine : arrLines)
+		{
+			TArray<FString> arrTokens;
+			sLine.ParseIntoArrayWS(arrTokens);
+			if (arrTokens.Num() == 0 || arrTokens[0].StartsWith(TEXT("#")))
+				continue;
+
+			const int32 nJoint = FindJoint(arrTokens[0]);
+			const int32 nParent = arrTokens.Num() > 1 ? FindJoint(arrTokens[1]) : INDEX_NONE;
+			if (nJoint <= 0 || nParent == INDEX_NONE)
+			{
+				UE_LOG(LogOpenXRViveTracker, Warning, TEXT("Skeleton file %s: ignoring '%s', the capture has no such joint or parent"), *SkeletonFilename, *sLine);
+				continue;
+			}
+
+			arrJoints[nJoint].Parent = nParent;
+			if (arrTokens.Num() > 2)
+			{
+				arrJoints[nJoint].Name = SanitizeJointName(arrTokens[2]);
+			}
+		}
+
+		for (int32 nJoint = 1; nJoint < arrJoints.Num(); nJoint++)
+		{
+			int32 nAncestor = arrJoints[nJoint].Parent;
+			for (int32 nDepth = 0; nAncestor > 0 && nDepth < arrJoints.Num(); nDepth++)
+			{
+				nAncestor = arrJoints[nAncestor].Parent;
+			}
+
+			if (nAncestor != 0)
+			{
+				UE_LOG(LogOpenXRViveTracker, Error, TEXT("Skeleton file %s makes %s its own ancestor"), *SkeletonFilename, *arrJoints[nJoint].Name);
+				return false;
+			}
+		}
+	}
+
+	// Depth first, the order BVH lists joints and channels in
+	TArray<int32> arrOrder;
+	TArray<int32> arrStack = { 0 };
+	while (arrStack.Num() > 0)
+	{
+		const int32 nJoint = arrStack.Pop();
+		arrOrder.Add(nJoint);
+		for (int32 nChild = arrJoints.Num() - 1; nChild > 0; nChild--)
+		{
+			if (arrJoints[nChild].Parent == nJoint)
+			{
+				arrStack.Push(nChild);
+			}
+		}
+	}
+
+	TArray<int32> arrNewIndices;
+	arrNewIndices.SetNum(arrJoints.Num());
+	for (int32 nIndex = 0; nIndex < arrOrder.Num(); nIndex++)
+	{
+		arrNewIndices[arrOrder[nIndex]] = nIndex;
+	}
+
+	m_arrJoints.Reset();
+	m_arrTrackerJoints.Init(INDEX_NONE, arrTrackers.Num());
+	for (const int32 nJoint : arrOrder)
+	{
+		FExportJoint& Joint = m_arrJoints.Add_GetRef(arrJoints[nJoint]);
+		Joint.Parent = Joint.Parent != INDEX_NONE ? arrNewIndices[Joint.Parent] : INDEX_NONE;
+		if (Joint.Parent != INDEX_NONE)
+		{
+			m_arrJoints[Joint.Parent].Children.Add(m_arrJoints.Num() - 1);
+		}
+		if (Joint.TrackerId != INDEX_NONE)
+		{
+			m_arrTrackerJoints[Joint.TrackerId] = m_arrJoints.Num() - 1;
+		}
+	}
+
+	return m_arrJoints.Num() > 1;
+}
+
+bool FViveTrackerExporter::Open(const FString& OutputPath, bool bBvh, bool bCsv, bool bGltf)
+{
+	IFileManager& FileManager = IFileManager::Get();
+	const int32 nJoints = m_arrJoints.Num();
+
+	// Rest pose of every joint relative to its parent
+	TArray<FTransform>& arrRestLocal = m_arrRestLocal;
+	arrRestLocal.SetNum(nJoints);
+	for (int32 nJoint = 1; nJoint < nJoints; nJoint++)
+	{
+		const FExportJoint& Joint = m_arrJoints[nJoint];
+		const FTransform Local = Joint.RestTransform.GetRelativeTransform(m_arrJoints[Joint.Parent].RestTransform);
+		arrRestLocal[nJoint] = FTransform(ToYUp(Local.GetRotation()), ToYUp(Local.GetLocation()));
+	}
+
+	for (int32 nJoint = 0; nJoint < nJoints; nJoint++)
+	{
+		m_arrLastRotations.Add(arrRestLocal[nJoint].GetRotation());
+	}
+
+	if (bBvh)
+	{
+		m_pBvh.Reset(FileManager.CreateFileWriter(*(OutputPath + TEXT(".bvh"))));
+		if (!m_pBvh)
+			return false;
+
+		TArray<ANSICHAR> Header;
+		AppendText(Header, TEXT("HIERARCHY\n"));
+
+		// Every joint keys its translation as well, trackers don't keep fixed offsets
+		TFunction<void(int32, int32)> AppendJoint = [&](int32 nJoint, int32 nDepth)
+		{
+			const FString sIndent = FString::ChrN(nDepth, TEXT('\t'));
+			const FVector Offset = arrRestLocal[nJoint].GetLocation();
+			AppendText(Header, FString::Printf(TEXT("%s%s %s\n%s{\n"), *sIndent, nDepth == 0 ? TEXT("ROOT") : TEXT("JOINT"), *m_arrJoints[nJoint].Name, *sIndent));
+			AppendText(Header, FString::Printf(TEXT("%s\tOFFSET %.4f %.4f %.4f\n"), *sIndent, Offset.X, Offset.Y, Offset.Z));
+			AppendText(Header, FString::Printf(TEXT("%s\tCHANNELS 6 Xposition Yposition Zposition Zrotation Xrotation Yrotation\n"), *sIndent));
+			for (const int32 nChild : m_arrJoints[nJoint].Children)
+			{
+				AppendJoint(nChild, nDepth + 1);
+			}
+			if (m_arrJoints[nJoint].Children.Num() == 0)
+			{
+				AppendText(Header, FString::Printf(TEXT("%s\tEnd Site\n%s\t{\n%s\t\tOFFSET 0 0 0\n%s\t}\n"), *sIndent, *sIndent, *sIndent, *sIndent));
+			}
+			AppendText(Header, FString::Printf(TEXT("%s}\n"), *sIndent));
+		};
+		AppendJoint(0, 0);
+
+		AppendText(Header, FString::Printf(TEXT("MOTION\nFrames: %lld\nFrame Time: %.8f\n"), m_nNumFrames, 1.0 / m_fFrameRate));
+		WriteText(m_pBvh.Get(), Header);
+	}
+
+	if (bCsv)
+	{
+		m_pCsv.Reset(FileManager.CreateFileWriter(*(OutputPath + TEXT(".csv"))));
+		if (!m_pCsv)
+			return false;
+
+		TArray<ANSICHAR> Header;
+		AppendText(Header, TEXT("Frame,Time"));
+		for (int32 nJoint = 1; nJoint < nJoints; nJoint++)
+		{
+			const FString& sName = m_arrJoints[nJoint].Name;
+			AppendText(Header, FString::Printf(TEXT(",%s_X,%s_Y,%s_Z,%s_Roll,%s_Pitch,%s_Yaw,%s_QX,%s_QY,%s_QZ,%s_QW,%s_Tracked"),
+				*sName, *sName, *sName, *sName, *sName, *sName, *sName, *sName, *sName, *sName, *sName));
+		}
+		AppendText(Header, TEXT("\n"));
+		WriteText(m_pCsv.Get(), Header);
+	}
+
+	if (bGltf)
+	{
+		m_sGltfPath = OutputPath + TEXT(".gltf");
+		m_sBinName = FPaths::GetCleanFilename(OutputPath) + TEXT(".bin");
+		m_pBin.Reset(FileManager.CreateFileWriter(*(OutputPath + TEXT(".bin"))));
+		if (!m_pBin)
+			return false;
+	}
+
+	return true;
+}
+
+int64 FViveTrackerExporter::GetFirstFrame(int32 SampleChunk) const
+{
+	if (SampleChunk == 0)
+		return 0;
+	if (SampleChunk >= m_reader.GetNumSampleChunks())
+		return m_nNumFrames;
+
+	// First frame at or after the start of the chunk
+	const XrTime ChunkStart = m_reader.GetSampleChunkInfo(SampleChunk).FirstTime;
+	int64 nFrame = FMath::Clamp((int64)FMath::CeilToDouble((ChunkStart - m_reader.GetStartTime()) * 1.0e-9 * m_fFrameRate), (int64)0, m_nNumFrames);
+	while (nFrame > 0 && GetFrameTime(nFrame - 1) >= ChunkStart)
+	{
+		nFrame--;
+	}
+	while (nFrame < m_nNumFrames && GetFrameTime(nFrame) < ChunkStart)
+	{
+		nFrame++;
+	}
+	return nFrame;
+}
+
+void FViveTrackerExporter::Export()
+{
+	const int32 nJoints = m_arrJoints.Num();
+	m_arrJointSamples.SetNum(nJoints);
+	m_arrBatchSamples.SetNum(nJoints);
+	m_arrCursors.SetNum(nJoints);
+	m_arrPrevious.SetNum(nJoints);
+	m_arrCarry.SetNum(nJoints);
+	m_arrHasCarry.SetNumZeroed(nJoints);
+
+	// Enough chunks per batch to keep every worker busy decoding
+	const int32 nChunksPerBatch = FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads() * 2, 4);
+	m_arrDecodeBuffers.SetNum(nChunksPerBatch + 1);
+
+	for (int32 nChunk = 0; nChunk < m_reader.GetNumSampleChunks() && !m_bWriteFailed; nChunk += nChunksPerBatch)
+	{
+		ExportBatch(nChunk, FMath::Min(nChunk + nChunksPerBatch, m_reader.GetNumSampleChunks()));
+	}
+}
+
+void FViveTrackerExporter::ExportBatch(int32 FirstChunk, int32 EndChunk)
+{
+	// The chunk after the batch is decoded as well, frames at the end of the batch interpolate towards its samples
+	const int32 nDecodeChunks = FMath::Min(EndChunk + 1, m_reader.GetNumSampleChunks()) - FirstChunk;
+	m_arrChunkSamples.SetNum(nDecodeChunks);
+	ParallelFor(nDecodeChunks, [this, FirstChunk](int32 nChunk)
+		{
+			m_arrChunkSamples[nChunk] = m_reader.GetSampleChunk(FirstChunk + nChunk, m_arrDecodeBuffers[nChunk]);
+		});
+
+	for (int32 nJoint = 0; nJoint < m_arrJoints.Num(); nJoint++)
+	{
+		m_arrJointSamples[nJoint].Reset();
+		m_arrCursors[nJoint] = 0;
+		m_arrPrevious[nJoint] = m_arrHasCarry[nJoint] ? &m_arrCarry[nJoint] : nullptr;
+	}
+
+	constexpr uint8 PoseValidFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+	for (int32 nChunk = 0; nChunk < nDecodeChunks; nChunk++)
+	{
+		if (FirstChunk + nChunk == EndChunk)
+		{
+			for (int32 nJoint = 0; nJoint < m_arrJoints.Num(); nJoint++)
+			{
+				m_arrBatchSamples[nJoint] = m_arrJointSamples[nJoint].Num();
+			}
+		}
+
+		for (const FCaptureSample& Sample : m_arrChunkSamples[nChunk])
+		{
+			const int32 nJoint = m_arrTrackerJoints.IsValidIndex(Sample.TrackerId) ? m_arrTrackerJoints[Sample.TrackerId] : INDEX_NONE;
+			if (nJoint != INDEX_NONE && (Sample.LocationFlags & PoseValidFlags) == PoseValidFlags)
+			{
+				m_arrJointSamples[nJoint].Add(&Sample);
+			}
+		}
+	}
+
+	if (FirstChunk + nDecodeChunks == EndChunk)
+	{
+		for (int32 nJoint = 0; nJoint < m_arrJoints.Num(); nJoint++)
+		{
+			m_arrBatchSamples[nJoint] = m_arrJointSamples[nJoint].Num();
+		}
+	}
+
+	const int64 nEndFrame = GetFirstFrame(EndChunk);
+	for (int64 nFrame = GetFirstFrame(FirstChunk); nFrame < nEndFrame && !m_bWriteFailed; nFrame += FramesPerPass)
+	{
+		ExportFrames(nFrame, FMath::Min(nFrame + FramesPerPass, nEndFrame));
+	}
+
+	// The next batch starts from the last samples of this one, the decode buffers get reused
+	for (int32 nJoint = 1; nJoint < m_arrJoints.Num(); nJoint++)
+	{
+		if (m_arrBatchSamples[nJoint] > 0)
+		{
+			m_arrCarry[nJoint] = *m_arrJointSamples[nJoint][m_arrBatchSamples[nJoint] - 1];
+			m_arrHasCarry[nJoint] = true;
+		}
+	}
+}
+
+void FViveTrackerExporter::ExportFrames(int64 FirstFrame, int64 EndFrame)
+{
+	const int32 nJoints = m_arrJoints.Num();
+	const int32 nFrames = (int32)(EndFrame - FirstFrame);
+	const int32 nTasks = FMath::DivideAndRoundUp(nFrames, FramesPerTask);
+
+	m_nPassFirstFrame = FirstFrame;
+	m_arrWorld.SetNum(nFrames * nJoints);
+	m_arrTracked.SetNum(nFrames * nJoints);
+	m_arrLocal.SetNum(nFrames * nJoints);
+
+	// Resample every tracker, each walks its own samples
+	ParallelFor(nJoints - 1, [this, FirstFrame, nFrames, nJoints](int32 nTask)
+		{
+			const int32 nJoint = nTask + 1;
+			const TArray<const FCaptureSample*>& arrSamples = m_arrJointSamples[nJoint];
+			int32& nNext = m_arrCursors[nJoint];
+			const FCaptureSample*& pPrevious = m_arrPrevious[nJoint];
+
+			for (int32 nFrame = 0; nFrame < nFrames; nFrame++)
+			{
+				const XrTime Time = GetFrameTime(FirstFrame + nFrame);
+				while (nNext < arrSamples.Num() && arrSamples[nNext]->Time <= Time)
+				{
+					pPrevious = arrSamples[nNext++];
+				}
+				const FCaptureSample* pNext = nNext < arrSamples.Num() ? arrSamples[nNext] : nullptr;
+
+				FTransform& World = m_arrWorld[nFrame * nJoints + nJoint];
+				bool& bTracked = m_arrTracked[nFrame * nJoints + nJoint];
+				if (pPrevious && pNext && pNext->Time - pPrevious->Time <= MaxInterpolationGapNs)
+				{
+					World = FViveTrackerPoseHistory::Interpolate(FViveTrackerCaptureReader::ToTrackerSample(*pPrevious), FViveTrackerCaptureReader::ToTrackerSample(*pNext), Time);
+					bTracked = true;
+				}
+				else if (pPrevious && Time - pPrevious->Time <= FViveTrackerPoseHistory::MaxExtrapolationNs)
+				{
+					World = FViveTrackerPoseHistory::Extrapolate(FViveTrackerCaptureReader::ToTrackerSample(*pPrevious), (Time - pPrevious->Time) * 1.0e-9);
+					bTracked = true;
+				}
+				else
+				{
+					// Lost, hold the closest pose
+					const FCaptureSample* pHeld = pPrevious ? pPrevious : pNext;
+					World = pHeld ? FViveTrackerCaptureReader::ToTrackerSample(*pHeld).Transform : m_arrJoints[nJoint].RestTransform;
+					bTracked = false;
+				}
+			}
+		});
+
+	// Relative to the parent, in Y up space
+	ParallelFor(nTasks, [this, nFrames, nJoints](int32 nTask)
+		{
+			const int32 nEnd = FMath::Min((nTask + 1) * FramesPerTask, nFrames);
+			for (int32 nFrame = nTask * FramesPerTask; nFrame < nEnd; nFrame++)
+			{
+				const int32 nBase = nFrame * nJoints;
+				m_arrWorld[nBase] = FTransform::Identity;
+				m_arrLocal[nBase] = FTransform::Identity;
+				for (int32 nJoint = 1; nJoint < nJoints; nJoint++)
+				{
+					const FTransform Local = m_arrWorld[nBase + nJoint].GetRelativeTransform(m_arrWorld[nBase + m_arrJoints[nJoint].Parent]);
+					m_arrLocal[nBase + nJoint] = FTransform(ToYUp(Local.GetRotation()), ToYUp(Local.GetLocation()));
+				}
+			}
+		});
+
+	// Keep consecutive rotations in the same hemisphere so linear interpolation between keys takes the short way
+	for (int32 nJoint = 1; nJoint < nJoints; nJoint++)
+	{
+		FQuat LastRotation = m_arrLastRotations[nJoint];
+		for (int32 nFrame = 0; nFrame < nFrames; nFrame++)
+		{
+			FTransform& Local = m_arrLocal[nFrame * nJoints + nJoint];
+			FQuat Rotation = Local.GetRotation();
+			if ((Rotation | LastRotation) < 0.f)
+			{
+				Rotation = FQuat(-Rotation.X, -Rotation.Y, -Rotation.Z, -Rotation.W);
+				Local.SetRotation(Rotation);
+			}
+			LastRotation = Rotation;
+		}
+		m_arrLastRotations[nJoint] = LastRotation;
+	}
+
+	if (m_pBvh || m_pCsv)
+	{
+		m_arrBvhText.SetNum(nTasks);
+		m_arrCsvText.SetNum(nTasks);
+		ParallelFor(nTasks, [this, FirstFrame, nFrames](int32 nTask)
+			{
+				const int64 nTaskFirst = FirstFrame + nTask * FramesPerTask;
+				const int64 nTaskEnd = FirstFrame + FMath::Min((nTask + 1) * FramesPerTask, nFrames);
+				m_arrBvhText[nTask].Reset();
+				m_arrCsvText[nTask].Reset();
+				if (m_pBvh)
+				{
+					FormatBvh(nTaskFirst, nTaskEnd, m_arrBvhText[nTask]);
+				}
+				if (m_pCsv)
+				{
+					FormatCsv(nTaskFirst, nTaskEnd, m_arrCsvText[nTask]);
+				}
+			});
+
+		for (int32 nTask = 0; nTask < nTasks; nTask++)
+		{
+			WriteText(m_pBvh.Get(), m_arrBvhText[nTask]);
+			WriteText(m_pCsv.Get(), m_arrCsvText[nTask]);
+		}
+	}
+
+	if (m_pBin)
+	{
+		WriteGltf(FirstFrame, EndFrame);
+	}
+}
+
+void FViveTrackerExporter::FormatBvh(int64 FirstFrame, int64 EndFrame, TArray<ANSICHAR>& Out) const
+{
+	const int32 nJoints = m_arrJoints.Num();
+	for (int64 nFrame = FirstFrame; nFrame < EndFrame; nFrame++)
+	{
+		// The root doesn't move
+		AppendText(Out, TEXT("0 0 0 0 0 0"));
+
+		const int32 nBase = (int32)(nFrame - m_nPassFirstFrame) * nJoints;
+		for (int32 nJoint = 1; nJoint < nJoints; nJoint++)
+		{
+			const FTransform& Local = m_arrLocal[nBase + nJoint];
+			const FVector Location = Local.GetLocation();
+			const FVector Euler = ToEulerZXY(Local.GetRotation());
+
+			Out.Add(' ');
+			AppendNumber(Out, Location.X, 4);
+			Out.Add(' ');
+			AppendNumber(Out, Location.Y, 4);
+			Out.Add(' ');
+			AppendNumber(Out, Location.Z, 4);
+			Out.Add(' ');
+			AppendNumber(Out, Euler.Z, 4);
+			Out.Add(' ');
+			AppendNumber(Out, Euler.X, 4);
+			Out.Add(' ');
+			AppendNumber(Out, Euler.Y, 4);
+		}
+		Out.Add('\n');
+	}
+}
+
+void FViveTrackerExporter::FormatCsv(int64 FirstFrame, int64 EndFrame, TArray<ANSICHAR>& Out) const
+{
+	const int32 nJoints = m_arrJoints.Num();
+	for (int64 nFrame = FirstFrame; nFrame < EndFrame; nFrame++)
+	{
+		AppendText(Out, FString::Printf(TEXT("%lld,"), nFrame));
+		AppendNumber(Out, nFrame / m_fFrameRate, 6);
+
+		const int32 nBase = (int32)(nFrame - m_nPassFirstFrame) * nJoints;
+		for (int32 nJoint = 1; nJoint < nJoints; nJoint++)
+		{
+			const FTransform& World = m_arrWorld[nBase + nJoint];
+			const FVector Location = World.GetLocation();
+			const FQuat Rotation = World.GetRotation();
+			const FRotator Rotator = Rotation.Rotator();
+
+			const double Values[] = { Location.X, Location.Y, Location.Z, Rotator.Roll, Rotator.Pitch, Rotator.Yaw };
+			for (const double Value : Values)
+			{
+				Out.Add(',');
+				AppendNumber(Out, Value, 4);
+			}
+
+			const double Components[] = { Rotation.X, Rotation.Y, Rotation.Z, Rotation.W };
+			for (const double Value : Components)
+			{
+				Out.Add(',');
+				AppendNumber(Out, Value, 6);
+			}
+
+			Out.Add(',');
+			Out.Add(m_arrTracked[nBase + nJoint] ? '1' : '0');
+		}
+		Out.Add('\n');
+	}
+}
+
+void FViveTrackerExporter::WriteGltf(int64 FirstFrame, int64 EndFrame)
+{
+	// Tightly packed channels, as glTF requires for animation: times, then translations and rotations of every joint
+	const int32 nJoints = m_arrJoints.Num();
+	const int32 nFrames = (int32)(EndFrame - FirstFrame);
+	auto WriteChannel = [this, FirstFrame](int64 ChannelOffset, int32 Components)
+	{
+		m_pBin->Seek(ChannelOffset + FirstFrame * Components * (int64)sizeof(float));
+		m_pBin->Serialize(m_arrChannel.GetData(), m_arrChannel.Num() * sizeof(float));
+	};
+
+	m_arrChannel.Reset();
+	for (int64 nFrame = FirstFrame; nFrame < EndFrame; nFrame++)
+	{
+		m_arrChannel.Add((float)(nFrame / m_fFrameRate));
+	}
+	WriteChannel(0, 1);
+
+	const int64 nTimesSize = m_nNumFrames * sizeof(float);
+	for (int32 nJoint = 1; nJoint < nJoints; nJoint++)
+	{
+		const int64 nTranslationOffset = nTimesSize + (nJoint - 1) * m_nNumFrames * 7 * (int64)sizeof(float);
+
+		m_arrChannel.Reset();
+		for (int32 nFrame = 0; nFrame < nFrames; nFrame++)
+		{
+			const FVector Location = m_arrLocal[nFrame * nJoints + nJoint].GetLocation() * 0.01f;
+			m_arrChannel.Add((float)Location.X);
+			m_arrChannel.Add((float)Location.Y);
+			m_arrChannel.Add((float)Location.Z);
+		}
+		WriteChannel(nTranslationOffset, 3);
+
+		m_arrChannel.Reset();
+		for (int32 nFrame = 0; nFrame < nFrames; nFrame++)
+		{
+			const FQuat Rotation = m_arrLocal[nFrame * nJoints + nJoint].GetRotation();
+			m_arrChannel.Add((float)Rotation.X);
+			m_arrChannel.Add((float)Rotation.Y);
+			m_arrChannel.Add((float)Rotation.Z);
+			m_arrChannel.Add((float)Rotation.W);
+		}
+		WriteChannel(nTranslationOffset + m_nNumFrames * 3 * (int64)sizeof(float), 4);
+	}
+
+	m_bWriteFailed |= m_pBin->IsError();
+}
+
+void FViveTrackerExporter::WriteText(FArchive* pArchive, const TArray<ANSICHAR>& Text)
+{
+	if (pArchive == nullptr)
+		return;
+
+	pArchive->Serialize(const_cast<ANSICHAR*>(Text.GetData()), Text.Num());
+	m_bWriteFailed |= pArchive->IsError();
+}
+
+bool FViveTrackerExporter::Close()
+{
+	bool bSuccess = !m_bWriteFailed;
+	for (TUniquePtr<FArchive>* ppArchive : { &m_pBvh, &m_pCsv, &m_pBin })
+	{
+		if (*ppArchive)
+		{
+			bSuccess &= (*ppArchive)->Close();
+			ppArchive->Reset();
+		}
+	}
+
+	if (m_sGltfPath.IsEmpty() || !bSuccess)
+		return bSuccess;
+
+	// One node per joint and one translation and rotation sampler per tracker joint, sharing the times accessor
+	const int32 nJoints = m_arrJoints.Num();
+	const int64 nTimesSize = m_nNumFrames * sizeof(float);
+	const int64 nChannelSize = m_nNumFrames * 3 * (int64)sizeof(float);
+
+	FString sNodes, sBufferViews, sAccessors, sSamplers, sChannels;
+	sBufferViews = FString::Printf(TEXT("{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%lld}"), nTimesSize);
+	sAccessors = FString::Printf(TEXT("{\"bufferView\":0,\"componentType\":5126,\"count\":%lld,\"type\":\"SCALAR\",\"min\":[0],\"max\":[%.8f]}"),
+		m_nNumFrames, (m_nNumFrames - 1) / m_fFrameRate);
+
+	for (int32 nJoint = 0; nJoint < nJoints; nJoint++)
+	{
+		const FExportJoint& Joint = m_arrJoints[nJoint];
+		const FVector Location = m_arrRestLocal[nJoint].GetLocation() * 0.01f;
+		const FQuat Rotation = m_arrRestLocal[nJoint].GetRotation();
+
+		FString sChildren;
+		for (const int32 nChild : Joint.Children)
+		{
+			sChildren += FString::Printf(TEXT("%s%d"), sChildren.IsEmpty() ? TEXT("") : TEXT(","), nChild);
+		}
+
+		sNodes += FString::Printf(TEXT("%s{\"name\":\"%s\",\"translation\":[%.6f,%.6f,%.6f],\"rotation\":[%.8f,%.8f,%.8f,%.8f]%s}"),
+			nJoint > 0 ? TEXT(",") : TEXT(""), *Joint.Name, Location.X, Location.Y, Location.Z,
+			Rotation.X, Rotation.Y, Rotation.Z, Rotation.W, sChildren.IsEmpty() ? TEXT("") : *FString::Printf(TEXT(",\"children\":[%s]"), *sChildren));
+
+		if (nJoint == 0)
+			continue;
+
+		const int64 nTranslationOffset = nTimesSize + (nJoint - 1) * m_nNumFrames * 7 * (int64)sizeof(float);
+		const int32 nView = (nJoint - 1) * 2 + 1;
+		sBufferViews += FString::Printf(TEXT(",{\"buffer\":0,\"byteOffset\":%lld,\"byteLength\":%lld},{\"buffer\":0,\"byteOffset\":%lld,\"byteLength\":%lld}"),
+			nTranslationOffset, nChannelSize, nTranslationOffset + nChannelSize, nChannelSize / 3 * 4);
+		sAccessors += FString::Printf(TEXT(",{\"bufferView\":%d,\"componentType\":5126,\"count\":%lld,\"type\":\"VEC3\"},{\"bufferView\":%d,\"componentType\":5126,\"count\":%lld,\"type\":\"VEC4\"}"),
+			nView, m_nNumFrames, nView + 1, m_nNumFrames);
+		sSamplers += FString::Printf(TEXT("%s{\"input\":0,\"output\":%d,\"interpolation\":\"LINEAR\"},{\"input\":0,\"output\":%d,\"interpolation\":\"LINEAR\"}"),
+			nJoint > 1 ? TEXT(",") : TEXT(""), nView, nView + 1);
+		sChannels += FString::Printf(TEXT("%s{\"sampler\":%d,\"target\":{\"node\":%d,\"path\":\"translation\"}},{\"sampler\":%d,\"target\":{\"node\":%d,\"path\":\"rotation\"}}"),
+			nJoint > 1 ? TEXT(",") : TEXT(""), nView - 1, nJoint, nView, nJoint);
+	}
+
+	const int64 nBufferSize = nTimesSize + (nJoints - 1) * m_nNumFrames * 7 * (int64)sizeof(float);
+	const FString sGltf = FString::Printf(TEXT("{\"asset\":{\"version\":\"2.0\",\"generator\":\"OpenXRViveTracker capture export\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],")
+		TEXT("\"nodes\":[%s],\"buffers\":[{\"uri\":\"%s\",\"byteLength\":%lld}],\"bufferViews\":[%s],\"accessors\":[%s],")
+		TEXT("\"animations\":[{\"name\":\"Capture\",\"samplers\":[%s],\"channels\":[%s]}]}\n"),
+		*sNodes, *m_sBinName, nBufferSize, *sBufferViews, *sAccessors, *sSamplers, *sChannels);
+
+	return FFileHelper::SaveStringToFile(sGltf, *m_sGltfPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
+
+UViveTrackerExportCommandlet::UViveTrackerExportCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UViveTrackerExportCommandlet::Main(const FString& Params)
+{
+	FString sCapture;
+	if (!FParse::Value(*Params, TEXT("Capture="), sCapture))
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Usage: -run=ViveTrackerExport -Capture=<file> [-Output=<path without extension>] [-Formats=bvh,csv,gltf] [-FrameRate=90] [-Skeleton=<file>]"));
+		return 1;
+	}
+
+	FString sOutput = FPaths::Combine(FPaths::GetPath(sCapture), FPaths::GetBaseFilename(sCapture));
+	FString sFormats = TEXT("bvh,csv,gltf");
+	FString sSkeleton;
+	double FrameRate = 90.0;
+	FParse::Value(*Params, TEXT("Output="), sOutput);
+	FParse::Value(*Params, TEXT("Formats="), sFormats);
+	FParse::Value(*Params, TEXT("Skeleton="), sSkeleton);
+	FParse::Value(*Params, TEXT("FrameRate="), FrameRate);
+	FrameRate = FMath::Clamp(FrameRate, 1.0, 10000.0);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	FViveTrackerCaptureReader Reader;
+	if (!Reader.Open(sCapture))
+		return 1;
+
+	FViveTrackerExporter Exporter(Reader, FrameRate);
+	if (Reader.GetNumSamples() == 0 || !Exporter.BuildJoints(sSkeleton))
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Tracker capture %s has no tracked samples to export"), *sCapture);
+		return 1;
+	}
+
+	if (!Exporter.Open(sOutput, sFormats.Contains(TEXT("bvh")), sFormats.Contains(TEXT("csv")), sFormats.Contains(TEXT("gltf"))))
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to create export files %s.*"), *sOutput);
+		return 1;
+	}
+
+	Exporter.Export();
+	if (!Exporter.Close())
+	{
+		UE_LOG(LogOpenXRViveTracker, Error, TEXT("Unable to write export files %s.*"), *sOutput);
+		return 1;
+	}
+
+	UE_LOG(LogOpenXRViveTracker, Display, TEXT("Exported %lld frames of %d trackers at %.1f fps (%s) to %s in %.2fs"), Exporter.GetNumFrames(), Exporter.GetNumJoints() - 1,
+		FrameRate, *sFormats, *sOutput, FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles));
+	return 0;
+}
@@ -0,0 +1,62 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ViveTrackerExportCommandlet.generated.h"
+
+/**
+* Converts a tracker capture to BVH, CSV and glTF animation, without an XR runtime:
+*
+*	-run=ViveTrackerExport -Capture=<file> [-Output=<path without extension>] [-Formats=bvh,csv,gltf] [-FrameRate=90] [-Skeleton=<file>]
+*
+* Trackers are resampled at the frame rate, interpolating between samples and extrapolating from their velocities
+* across short gaps. The BVH and glTF hierarchy follows the role layout (feet under knees under the waist, elbows
+* under shoulders under the chest), every tracker a joint with translation and rotation keys relative to its parent,
+* in Y up right handed space (cm for BVH, m for glTF). The skeleton file can reparent and rename joints, one per line:
+*
+*	<joint> <parent joint or Root> [<exported name>]
+*
+* The CSV holds every tracker's engine space location, rotation and tracking state per frame, one column group per tracker.
+* Sample chunks are decoded, resampled and formatted in parallel a batch at a time, and each batch is written out
+* before the next, so memory stays flat however long the capture is.
+*/
+UCLASS()
+class UViveTrackerExportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UViveTrackerExportCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,363 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Sustained sample rate of the capture writer's pipeline on a plain machine. A producer thread queues samples of 30
+// trackers into a TSpscRing at 1kHz like PostSyncActions does, and a writer thread drains the ring the way
+// FViveTrackerCaptureWriter does: woken once a chunk's worth is queued, whole chunks, optionally compressed with the
+// capture codec, gathered into 1MB writes of 8 byte aligned chunks. Each mode runs paced at 1kHz, where nothing may be
+// dropped, then unpaced to find the rate where the writer falls behind.
+// Usage: ViveTrackerCaptureWriterBenchmark [seconds per case=5] [json file=ViveTrackerCaptureWriterBenchmark.json] [capture file]
+
+#include "ViveTrackerTestSupport.h"
+#include "ViveTrackerCore/ViveTrackerCaptureCodec.h"
+#include "ViveTrackerCore/ViveTrackerSpscRing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace ViveTrackerCore;
+
+// Same as FViveTrackerCaptureWriter
+static const uint32_t SamplesPerChunk = 1024;
+static const uint32_t CompressedSamplesPerChunk = 8192;
+static const uint32_t QueueCapacity = 64 * 1024;
+static const size_t WriteBufferSize = 1024 * 1024;
+static const double FlushInterval = 1.0;
+static const int WaitMs = 100;
+static const uint64_t CaptureAlignment = 8;
+
+static const int NumTrackers = 30;
+
+/** Writer thread side of the capture writer, minus trackers, events and keyframes which are rare next to samples */
+class FBenchmarkWriter
+{
+public:
+	FBenchmarkWriter(FILE* pFile, bool bCompressed, const FCaptureSample* pWarmupSamples)
+		: m_pFile(pFile)
+		, m_nSamplesPerChunk(bCompressed ? CompressedSamplesPerChunk : SamplesPerChunk)
+		, m_sampleQueue(std::max(QueueCapacity, m_nSamplesPerChunk))
+	{
+		m_arrStagedSamples.resize(m_nSamplesPerChunk);
+		size_t nMaxChunkSize = m_nSamplesPerChunk * sizeof(FCaptureSample);
+		if (bCompressed)
+		{
+			m_pEncoder.reset(new FCaptureEncoder());
+			m_arrEncodedSamples.resize(sizeof(FCaptureCompressedSamples) + FCaptureEncoder::GetMaxEncodedSize(m_nSamplesPerChunk));
+			nMaxChunkSize = m_arrEncodedSamples.size();
+
+			// The allocation counter is shared by both threads, the encoder's scratch memory grows to its steady size up front
+			m_pEncoder->Encode(pWarmupSamples, m_nSamplesPerChunk, m_arrEncodedSamples.data());
+		}
+		m_arrWriteBuffer.reserve(WriteBufferSize + nMaxChunkSize + CaptureAlignment + sizeof(FCaptureChunkHeader));
+
+		FCaptureHeader Header{};
+		std::memcpy(Header.Magic, CaptureMagic, sizeof(Header.Magic));
+		Header.Version = CaptureVersion;
+		Header.HeaderSize = sizeof(FCaptureHeader);
+		Append(&Header, sizeof(Header));
+		FlushWriteBuffer();
+
+		m_nLastFlushSeconds = ViveTrackerTest::GetSeconds();
+		m_thread = std::thread([this]() { Run(); });
+	}
+
+	/** Producer side of AddSample */
+	bool Push(const FCaptureSample& Sample)
+	{
+		return m_sampleQueue.Push(Sample);
+	}
+
+	/** Producer side of Update, once per game frame */
+	void Update()
+	{
+		if (m_sampleQueue.Num() >= m_nSamplesPerChunk)
+		{
+			{
+				std::lock_guard<std::mutex> Lock(m_wakeLock);
+				m_bWake = true;
+			}
+			m_wakeEvent.notify_one();
+		}
+	}
+
+	/** Stop the writer thread once everything queued is written */
+	void Close()
+	{
+		{
+			std::lock_guard<std::mutex> Lock(m_wakeLock);
+			m_bStopping = true;
+		}
+		m_wakeEvent.notify_one();
+		m_thread.join();
+	}
+
+	int64_t GetNumWrittenSamples() const { return m_nWrittenSamples; }
+	int64_t GetNumWrittenBytes() const { return m_nWrittenBytes; }
+	int64_t GetNumWakeups() const { return m_nWakeups; }
+	bool HasWriteFailed() const { return m_bWriteFailed; }
+
+private:
+	void Run()
+	{
+		for (;;)
+		{
+			bool bStopping;
+			{
+				std::unique_lock<std::mutex> Lock(m_wakeLock);
+				m_wakeEvent.wait_for(Lock, std::chrono::milliseconds(WaitMs), [this]() { return m_bWake || m_bStopping; });
+				m_bWake = false;
+				bStopping = m_bStopping;
+			}
+
+			m_nWakeups++;
+			Drain(bStopping);
+			if (bStopping)
+				return;
+		}
+	}
+
+	void Drain(bool bFinal)
+	{
+		// Whole chunks are written as soon as they are full, partial ones only when flushing
+		for (;;)
+		{
+			m_nStagedSamples += m_sampleQueue.Pop(m_arrStagedSamples.data() + m_nStagedSamples, m_nSamplesPerChunk - m_nStagedSamples);
+			if (m_nStagedSamples < m_nSamplesPerChunk)
+				break;
+
+			AppendSamples();
+		}
+
+		if (!bFinal && ViveTrackerTest::GetSeconds() - m_nLastFlushSeconds < FlushInterval)
+			return;
+
+		if (m_nStagedSamples > 0)
+		{
+			AppendSamples();
+		}
+		FlushWriteBuffer();
+		m_nLastFlushSeconds = ViveTrackerTest::GetSeconds();
+	}
+
+	void AppendSamples()
+	{
+		const int64_t nFirstTime = m_arrStagedSamples[0].Time;
+		const int64_t nLastTime = m_arrStagedSamples[m_nStagedSamples - 1].Time;
+
+		if (m_pEncoder)
+		{
+			FCaptureCompressedSamples Range{ nFirstTime, nLastTime };
+			std::memcpy(m_arrEncodedSamples.data(), &Range, sizeof(Range));
+			const size_t nEncodedSize = m_pEncoder->Encode(m_arrStagedSamples.data(), m_nStagedSamples, m_arrEncodedSamples.data() + sizeof(Range));
+			AppendChunk(CaptureChunk_CompressedSamples, m_nStagedSamples, m_arrEncodedSamples.data(), sizeof(Range) + nEncodedSize);
+		}
+		else
+		{
+			AppendChunk(CaptureChunk_Samples, m_nStagedSamples, m_arrStagedSamples.data(), m_nStagedSamples * sizeof(FCaptureSample));
+		}
+
+		m_nWrittenSamples += m_nStagedSamples;
+		m_nStagedSamples = 0;
+	}
+
+	void AppendChunk(uint32_t Type, uint32_t Count, const void* pData, uint64_t nSize)
+	{
+		static const uint8_t Padding[CaptureAlignment] = {};
+
+		FCaptureChunkHeader ChunkHeader{};
+		ChunkHeader.Type = Type;
+		ChunkHeader.Count = Count;
+		ChunkHeader.Size = (nSize + CaptureAlignment - 1) & ~(CaptureAlignment - 1);
+
+		Append(&ChunkHeader, sizeof(ChunkHeader));
+		Append(pData, nSize);
+		Append(Padding, ChunkHeader.Size - nSize);
+
+		if (m_arrWriteBuffer.size() >= WriteBufferSize)
+		{
+			FlushWriteBuffer();
+		}
+	}
+
+	void Append(const void* pData, size_t nSize)
+	{
+		const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+		m_arrWriteBuffer.insert(m_arrWriteBuffer.end(), pBytes, pBytes + nSize);
+	}
+
+	void FlushWriteBuffer()
+	{
+		if (m_arrWriteBuffer.empty())
+			return;
+
+		if (!m_bWriteFailed && std::fwrite(m_arrWriteBuffer.data(), 1, m_arrWriteBuffer.size(), m_pFile) == m_arrWriteBuffer.size())
+		{
+			m_nWrittenBytes += (int64_t)m_arrWriteBuffer.size();
+		}
+		else
+		{
+			m_bWriteFailed = true;
+		}
+		m_arrWriteBuffer.clear();
+	}
+
+	FILE* m_pFile;
+	const uint32_t m_nSamplesPerChunk;
+	TSpscRing<FCaptureSample> m_sampleQueue;
+
+	std::mutex m_wakeLock;
+	std::condition_variable m_wakeEvent;
+	bool m_bWake = false;
+	bool m_bStopping = false;
+	std::thread m_thread;
+
+	std::vector<FCaptureSample> m_arrStagedSamples;
+	uint32_t m_nStagedSamples = 0;
+	std::unique_ptr<FCaptureEncoder> m_pEncoder;
+	std::vector<uint8_t> m_arrEncodedSamples;
+	std::vector<uint8_t> m_arrWriteBuffer;
+	double m_nLastFlushSeconds = 0.0;
+
+	int64_t m_nWrittenSamples = 0;
+	int64_t m_nWrittenBytes = 0;
+	int64_t m_nWakeups = 0;
+	bool m_bWriteFailed = false;
+};
+
+/**
+* Queue the synthetic samples into a writer for a number of seconds, a frame of every tracker per millisecond when paced,
+* as fast as they can be queued otherwise, looping over the samples with their times moved on each pass
+*/
+static void RunCase(const std::vector<FCaptureSample>& Samples, const char* pCaptureFilename, bool bCompressed, bool bPaced, double Duration,
+	std::vector<ViveTrackerTest::FBenchmarkResult>& Results)
+{
+	// The game thread runs Update once per frame, about every 11 samples' worth of milliseconds at 90Hz
+	const int FramesPerUpdate = 11;
+	const int64_t NumFrames = (int64_t)(Samples.size() / NumTrackers);
+	const int64_t PassNs = NumFrames * 1000 * 1000;
+
+	FILE* pFile = std::fopen(pCaptureFilename, "wb");
+	if (!VIVETRACKER_CHECK(pFile != nullptr))
+		return;
+	std::setvbuf(pFile, nullptr, _IONBF, 0);
+
+	FBenchmarkWriter Writer(pFile, bCompressed, Samples.data());
+
+	int64_t nFrame = 0;
+	int64_t nQueued = 0;
+	int64_t nDropped = 0;
+	uint64_t nAllocations = 0;
+	const double StartSeconds = ViveTrackerTest::GetSeconds();
+	double Elapsed = 0.0;
+	while ((Elapsed = ViveTrackerTest::GetSeconds() - StartSeconds) < Duration)
+	{
+		const int64_t nDueFrame = bPaced ? (int64_t)(Elapsed * 1000.0) + 1 : nFrame + FramesPerUpdate;
+
+		const uint64_t nStartAllocations = ViveTrackerTest::GetNumAllocations();
+		for (; nFrame < nDueFrame; nFrame++)
+		{
+			const FCaptureSample* pFrame = &Samples[(size_t)(nFrame % NumFrames) * NumTrackers];
+			const int64_t nTimeOffset = nFrame / NumFrames * PassNs;
+			for (int nTracker = 0; nTracker < NumTrackers; nTracker++)
+			{
+				FCaptureSample Sample = pFrame[nTracker];
+				Sample.Time += nTimeOffset;
+				Sample.PlatformTimeNs += nTimeOffset;
+				nQueued++;
+				nDropped += Writer.Push(Sample) ? 0 : 1;
+			}
+
+			if (nFrame % FramesPerUpdate == 0)
+			{
+				Writer.Update();
+			}
+		}
+		nAllocations += ViveTrackerTest::GetNumAllocations() - nStartAllocations;
+
+		if (bPaced)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(500));
+		}
+	}
+
+	Writer.Close();
+	const double Seconds = ViveTrackerTest::GetSeconds() - StartSeconds;
+	std::fclose(pFile);
+	std::remove(pCaptureFilename);
+
+	// The producer never allocates or blocks, and everything not dropped reaches the file
+	VIVETRACKER_CHECK(nAllocations == 0);
+	VIVETRACKER_CHECK(!Writer.HasWriteFailed());
+	VIVETRACKER_CHECK(Writer.GetNumWrittenSamples() == nQueued - nDropped);
+	if (bPaced)
+	{
+		VIVETRACKER_CHECK(nDropped == 0);
+	}
+
+	const double SamplesPerSecond = Writer.GetNumWrittenSamples() / Seconds;
+	char sName[64];
+	char sLabel[128];
+	std::snprintf(sName, sizeof(sName), "%s/codec:%d/trackers:%d", bPaced ? "Paced1kHz" : "Unpaced", bCompressed ? 1 : 0, NumTrackers);
+	std::snprintf(sLabel, sizeof(sLabel), "per written sample, %.0f samples/s, %.2f MB/s, %lld of %lld dropped, %.1f wakeups/s",
+		SamplesPerSecond, Writer.GetNumWrittenBytes() / Seconds / 1.0e6, (long long)nDropped, (long long)nQueued, Writer.GetNumWakeups() / Seconds);
+	ViveTrackerTest::AddBenchmarkResult(Results, sName, Writer.GetNumWrittenSamples(), Seconds / std::max<int64_t>(Writer.GetNumWrittenSamples(), 1), sLabel);
+}
+
+int main(int ArgC, char** ArgV)
+{
+	const double Duration = ArgC > 1 ? std::max(0.1, std::min(std::atof(ArgV[1]), 600.0)) : 5.0;
+	const char* pFilename = ArgC > 2 ? ArgV[2] : "ViveTrackerCaptureWriterBenchmark.json";
+	const std::string sCaptureFilename = ArgC > 3 ? ArgV[3] : std::string(pFilename) + ".vtcap";
+
+	// Ten seconds of samples, looped over by longer and unpaced runs
+	std::vector<FCaptureSample> Samples;
+	ViveTrackerTest::MakeSyntheticCaptureSamples(10 * 1000, NumTrackers, Samples);
+
+	std::vector<ViveTrackerTest::FBenchmarkResult> Results;
+	for (int nCompressed = 0; nCompressed < 2; nCompressed++)
+	{
+		RunCase(Samples, sCaptureFilename.c_str(), nCompressed == 1, true, Duration, Results);
+		RunCase(Samples, sCaptureFilename.c_str(), nCompressed == 1, false, Duration, Results);
+	}
+
+	if (!ViveTrackerTest::SaveBenchmarkResults(pFilename, "ViveTrackerCaptureWriterBenchmark", Results))
+	{
+		std::printf("Unable to write %s\n", pFilename);
+		return 1;
+	}
+	std::printf("Results saved to %s\n", pFilename);
+	return VIVETRACKER_TEST_RESULT();
+}
@@ -0,0 +1,96 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Capture codec throughput and ratio on synthetic trajectories of 30 trackers at 1kHz.
+// Usage: ViveTrackerCodecBenchmark [seconds of samples=20] [json file=ViveTrackerCodecBenchmark.json]
+
+#include "ViveTrackerTestSupport.h"
+#include "ViveTrackerCore/ViveTrackerCaptureCodec.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace ViveTrackerCore;
+
+int main(int ArgC, char** ArgV)
+{
+	const int Seconds = ArgC > 1 ? std::max(1, std::min(std::atoi(ArgV[1]), 3600)) : 20;
+	const char* pFilename = ArgC > 2 ? ArgV[2] : "ViveTrackerCodecBenchmark.json";
+	const uint32_t SamplesPerChunk = 8192;
+	const int DecodePasses = 10;
+
+	std::vector<FCaptureSample> Samples;
+	ViveTrackerTest::MakeSyntheticCaptureSamples(Seconds * 1000, 30, Samples);
+
+	FCaptureEncoder Encoder;
+	FCaptureDecoder Decoder;
+	std::vector<uint8_t> Encoded(FCaptureEncoder::GetMaxEncodedSize(SamplesPerChunk) * (Samples.size() / SamplesPerChunk + 1));
+	std::vector<size_t> ChunkOffsets;
+
+	double StartSeconds = ViveTrackerTest::GetSeconds();
+	size_t nEncodedBytes = 0;
+	for (size_t nStart = 0; nStart < Samples.size(); nStart += SamplesPerChunk)
+	{
+		const uint32_t nCount = (uint32_t)std::min<size_t>(SamplesPerChunk, Samples.size() - nStart);
+		ChunkOffsets.push_back(nEncodedBytes);
+		nEncodedBytes += Encoder.Encode(Samples.data() + nStart, nCount, Encoded.data() + nEncodedBytes);
+	}
+	const double EncodeSeconds = ViveTrackerTest::GetSeconds() - StartSeconds;
+	ChunkOffsets.push_back(nEncodedBytes);
+
+	std::vector<FCaptureSample> Decoded(Samples.size());
+	bool bValid = true;
+	StartSeconds = ViveTrackerTest::GetSeconds();
+	for (int nPass = 0; nPass < DecodePasses; nPass++)
+	{
+		for (size_t nChunk = 0; nChunk + 1 < ChunkOffsets.size(); nChunk++)
+		{
+			bValid &= Decoder.Decode(Encoded.data() + ChunkOffsets[nChunk], ChunkOffsets[nChunk + 1] - ChunkOffsets[nChunk], Decoded.data() + nChunk * SamplesPerChunk);
+		}
+	}
+	const double DecodeSeconds = (ViveTrackerTest::GetSeconds() - StartSeconds) / DecodePasses;
+
+	const double RawBytes = (double)(Samples.size() * sizeof(FCaptureSample));
+	const int64_t nSamples = (int64_t)Samples.size();
+	std::vector<ViveTrackerTest::FBenchmarkResult> Results;
+	char sLabel[64];
+	std::snprintf(sLabel, sizeof(sLabel), "per sample, %.2f GB/s", RawBytes / EncodeSeconds / 1.0e9);
+	ViveTrackerTest::AddBenchmarkResult(Results, "Encode/trackers:30", nSamples, EncodeSeconds / nSamples, sLabel);
+	std::snprintf(sLabel, sizeof(sLabel), "per sample, %.2f GB/s", RawBytes / DecodeSeconds / 1.0e9);
+	ViveTrackerTest::AddBenchmarkResult(Results, "Decode/trackers:30", nSamples * DecodePasses, DecodeSeconds / nSamples, sLabel);
+	std::printf("%.2fx smaller, %.2f bytes per sample\n", RawBytes / std::max<size_t>(nEncodedBytes, 1), (double)nEncodedBytes / nSamples);
+
+	if (!ViveTrackerTest::SaveBenchmarkResults(pFilename, "ViveTrackerCodecBenchmark", Results))
+	{
+		std::printf("Unable to write %s\n", pFilename);
+		return 1;
+	}
+	std::printf("Results saved to %s\n", pFilename);
+	return bValid ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Round trips synthetic tracker streams through the capture codec, checking every sample against the error bounds,
+// the compression ratio the codec is meant to reach and that truncated blocks are rejected.
+
+#include "ViveTrackerTestSupport.h"
+#include "ViveTrackerCore/ViveTrackerCaptureCodec.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ViveTrackerCore;
+
+/** Samples of a capture chunk, see FViveTrackerCaptureWriter::CompressedSamplesPerChunk */
+static const uint32_t SamplesPerChunk = 8192;
+
+/**
+* Encode samples in capture sized chunks and decode them back
+* @return double - Compression ratio
+*/
+static double RoundTrip(const FCaptureCodecSettings& Settings, const std::vector<FCaptureSample>& Samples)
+{
+	FCaptureEncoder Encoder(Settings);
+	FCaptureDecoder Decoder;
+	std::vector<uint8_t> Chunk(FCaptureEncoder::GetMaxEncodedSize(SamplesPerChunk));
+	std::vector<FCaptureSample> Decoded(SamplesPerChunk);
+
+	// Float rounding of the reconstructed values comes on top of the bounds
+	auto IsWithin = [](float Value, float Decoded, float Bound) { return std::fabs(Value - Decoded) <= Bound * 1.01f + (std::fabs(Value) + 1.f) * 1.0e-6f; };
+
+	size_t nEncodedBytes = 0;
+	int nMismatches = 0;
+	for (size_t nStart = 0; nStart < Samples.size(); nStart += SamplesPerChunk)
+	{
+		const uint32_t nCount = (uint32_t)std::min<size_t>(SamplesPerChunk, Samples.size() - nStart);
+		const size_t nSize = Encoder.Encode(Samples.data() + nStart, nCount, Chunk.data());
+		nEncodedBytes += nSize;
+		VIVETRACKER_CHECK(nSize <= FCaptureEncoder::GetMaxEncodedSize(nCount));
+
+		if (!VIVETRACKER_CHECK(FCaptureDecoder::GetNumSamples(Chunk.data(), nSize) == nCount) ||
+			!VIVETRACKER_CHECK(Decoder.Decode(Chunk.data(), nSize, Decoded.data())))
+			continue;
+
+		for (uint32_t nSample = 0; nSample < nCount; nSample++)
+		{
+			const FCaptureSample& Sample = Samples[nStart + nSample];
+			const FCaptureSample& Out = Decoded[nSample];
+			bool bMatch = Sample.Time == Out.Time && Sample.PlatformTimeNs == Out.PlatformTimeNs && Sample.TrackerId == Out.TrackerId &&
+				Sample.Role == Out.Role && Sample.LocationFlags == Out.LocationFlags && Sample.VelocityFlags == Out.VelocityFlags;
+			for (int nAxis = 0; nAxis < 3; nAxis++)
+			{
+				bMatch &= IsWithin(Sample.Position[nAxis], Out.Position[nAxis], Settings.PositionError);
+				bMatch &= IsWithin(Sample.LinearVelocity[nAxis], Out.LinearVelocity[nAxis], Settings.LinearVelocityError);
+				bMatch &= IsWithin(Sample.AngularVelocity[nAxis], Out.AngularVelocity[nAxis], Settings.AngularVelocityError);
+			}
+			for (int nAxis = 0; nAxis < 4; nAxis++)
+			{
+				bMatch &= IsWithin(Sample.Rotation[nAxis], Out.Rotation[nAxis], Settings.RotationError);
+			}
+			nMismatches += bMatch ? 0 : 1;
+		}
+
+		// Truncated blocks are rejected instead of read past their end
+		VIVETRACKER_CHECK(!Decoder.Decode(Chunk.data(), nSize / 2, Decoded.data()));
+	}
+
+	VIVETRACKER_CHECK(nMismatches == 0);
+	const double Ratio = (double)(Samples.size() * sizeof(FCaptureSample)) / (double)std::max<size_t>(nEncodedBytes, 1);
+	std::printf("Codec: %zu samples, %.2fx smaller, position bound %g cm, %d samples out of bounds\n", Samples.size(), Ratio, Settings.PositionError, nMismatches);
+	return Ratio;
+}
+
+static void TestSmallBlocks()
+{
+	std::vector<FCaptureSample> Samples;
+	ViveTrackerTest::MakeSyntheticCaptureSamples(3, 5, Samples);
+
+	// Single samples and streams shorter than a packed block still round trip exactly where they aren't predicted
+	FCaptureEncoder Encoder;
+	FCaptureDecoder Decoder;
+	for (uint32_t nCount = 1; nCount <= (uint32_t)Samples.size(); nCount++)
+	{
+		std::vector<uint8_t> Block(FCaptureEncoder::GetMaxEncodedSize(nCount));
+		std::vector<FCaptureSample> Decoded(nCount);
+		const size_t nSize = Encoder.Encode(Samples.data(), nCount, Block.data());
+		VIVETRACKER_CHECK(FCaptureDecoder::GetNumSamples(Block.data(), nSize) == nCount);
+		VIVETRACKER_CHECK(Decoder.Decode(Block.data(), nSize, Decoded.data()));
+		VIVETRACKER_CHECK(Decoded[0].Time == Samples[0].Time && Decoded[0].Position[0] == Samples[0].Position[0]);
+	}
+
+	VIVETRACKER_CHECK(FCaptureDecoder::GetNumSamples(nullptr, 0) == 0);
+}
+
+int main()
+{
+	// 30 trackers at 1kHz for 20 seconds
+	std::vector<FCaptureSample> Samples;
+	ViveTrackerTest::MakeSyntheticCaptureSamples(20 * 1000, 30, Samples);
+
+	const double DefaultRatio = RoundTrip(FCaptureCodecSettings(), Samples);
+	VIVETRACKER_CHECK(DefaultRatio >= 8.0);
+
+	// Looser bounds trade precision for size
+	FCaptureCodecSettings Loose;
+	Loose.PositionError *= 10.f;
+	Loose.RotationError *= 10.f;
+	Loose.LinearVelocityError *= 10.f;
+	Loose.AngularVelocityError *= 10.f;
+	VIVETRACKER_CHECK(RoundTrip(Loose, Samples) > DefaultRatio);
+
+	TestSmallBlocks();
+	return VIVETRACKER_TEST_RESULT();
+}
@@ -0,0 +1,298 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Solves bodies with the full-body IK solver and checks that limbs keep their lengths and reach targets in range,
+// that batched solves match single body solves, that solves follow the skeleton's up axis, that an uncalibrated waist
+// tracker stands the legs under the hips and that bad batches are ignored.
+
+#include "ViveTrackerTestSupport.h"
+#include "ViveTrackerCore/ViveTrackerIK.h"
+#include "ViveTrackerCore/ViveTrackerMath.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace ViveTrackerCore;
+
+static bool IsNear(const FVec3& A, const FVec3& B, float Tolerance = 1.0e-2f)
+{
+	return Length(A - B) <= Tolerance;
+}
+
+static bool IsNear(const FQuat4& A, const FQuat4& B, float Tolerance = 1.0e-3f)
+{
+	// q and -q are the same rotation
+	return std::fabs(A.X * B.X + A.Y * B.Y + A.Z * B.Z + A.W * B.W) >= 1.f - Tolerance;
+}
+
+static bool IsNear(const FBodyPose& A, const FBodyPose& B)
+{
+	for (int nBone = 0; nBone < (int)EBodyBone::Count; nBone++)
+	{
+		if (!IsNear(A.Bones[nBone].Position, B.Bones[nBone].Position) || !IsNear(A.Bones[nBone].Rotation, B.Bones[nBone].Rotation))
+			return false;
+	}
+	return true;
+}
+
+/** Standing body in a Z up space, hands in front within reach, the left elbow tracker on the hand so the arm's bend falls back to up */
+static FBodyTargets MakeTargets(int Body)
+{
+	const float Offset = (float)Body * 3.f;
+
+	FBodyTargets Targets;
+	Targets.Head.Position = FVec3{ Offset, 0.f, 170.f };
+	Targets.Hands[0].Position = FVec3{ 20.f + Offset, -25.f, 110.f + Offset };
+	Targets.Hands[1].Position = FVec3{ 25.f + Offset, 20.f, 120.f };
+	Targets.Feet[0].Position = FVec3{ Offset, -12.f, 12.f };
+	Targets.Feet[1].Position = FVec3{ 10.f + Offset, 12.f, 15.f };
+	Targets.Elbows[0] = Targets.Hands[0].Position;
+	Targets.ValidMask = Target_Head | Target_Hand_L | Target_Hand_R | Target_Foot_L | Target_Foot_R | Target_Elbow_L;
+	return Targets;
+}
+
+static FVec3 RotateVec(const FQuat4& Q, const FVec3& V) { return Rotate(Q, V); }
+
+static FPose RotatePose(const FQuat4& Q, const FPose& Pose)
+{
+	return { Q * Pose.Rotation, Rotate(Q, Pose.Position) };
+}
+
+static void TestLimbs()
+{
+	const FBodySkeleton Skeleton;
+	const FBodyTargets Targets = MakeTargets(0);
+	FBodyPose Pose;
+	SolveBody(Skeleton, Targets, Pose);
+
+	// Hands and feet in range are reached, every bone keeps its length
+	VIVETRACKER_CHECK(IsNear(Pose.Bones[(int)EBodyBone::Hand_L].Position, Targets.Hands[0].Position));
+	VIVETRACKER_CHECK(IsNear(Pose.Bones[(int)EBodyBone::Hand_R].Position, Targets.Hands[1].Position));
+	VIVETRACKER_CHECK(IsNear(Pose.Bones[(int)EBodyBone::Foot_L].Position, Targets.Feet[0].Position));
+	VIVETRACKER_CHECK(IsNear(Pose.Bones[(int)EBodyBone::Foot_R].Position, Targets.Feet[1].Position));
+
+	auto BoneLength = [&Pose](EBodyBone Bone, EBodyBone Child) { return Length(Pose.Bones[(int)Child].Position - Pose.Bones[(int)Bone].Position); };
+	VIVETRACKER_CHECK(std::fabs(BoneLength(EBodyBone::UpperArm_L, EBodyBone::LowerArm_L) - Skeleton.UpperArmLength) < 1.0e-2f);
+	VIVETRACKER_CHECK(std::fabs(BoneLength(EBodyBone::LowerArm_R, EBodyBone::Hand_R) - Skeleton.LowerArmLength) < 1.0e-2f);
+	VIVETRACKER_CHECK(std::fabs(BoneLength(EBodyBone::Thigh_L, EBodyBone::Calf_L) - Skeleton.ThighLength) < 1.0e-2f);
+	VIVETRACKER_CHECK(std::fabs(BoneLength(EBodyBone::Calf_R, EBodyBone::Foot_R) - Skeleton.ShinLength) < 1.0e-2f);
+
+	// With the elbow tracker on the hand the left elbow bends up, perpendicular to the arm
+	const FVec3 Shoulder = Pose.Bones[(int)EBodyBone::UpperArm_L].Position;
+	const FVec3 Dir = SafeNormal(Targets.Hands[0].Position - Shoulder, FVec3{});
+	const FVec3 Elbow = Pose.Bones[(int)EBodyBone::LowerArm_L].Position - Shoulder;
+	const FVec3 ElbowPerp = Elbow - Dir * Dot(Elbow, Dir);
+	VIVETRACKER_CHECK(Dot(SafeNormal(ElbowPerp, FVec3{}), SafeNormal(Skeleton.Up - Dir * Dot(Skeleton.Up, Dir), FVec3{})) > 0.999f);
+}
+
+static void TestUpAxis()
+{
+	// The same body solved in a Y up space, rotating Z up onto Y up, must give the Z up solve rotated the same way
+	const FQuat4 ZToY{ -std::sqrt(0.5f), 0.f, 0.f, std::sqrt(0.5f) };
+
+	const FBodySkeleton Skeleton;
+	FBodySkeleton SkeletonY;
+	SkeletonY.Up = RotateVec(ZToY, Skeleton.Up);
+	SkeletonY.Forward = RotateVec(ZToY, Skeleton.Forward);
+	VIVETRACKER_CHECK(IsNear(SkeletonY.Up, FVec3{ 0.f, 1.f, 0.f }, 1.0e-5f));
+
+	const FBodyTargets Targets = MakeTargets(0);
+	FBodyTargets TargetsY = Targets;
+	TargetsY.Head = RotatePose(ZToY, Targets.Head);
+	for (int nSide = 0; nSide < 2; nSide++)
+	{
+		TargetsY.Hands[nSide] = RotatePose(ZToY, Targets.Hands[nSide]);
+		TargetsY.Feet[nSide] = RotatePose(ZToY, Targets.Feet[nSide]);
+		TargetsY.Elbows[nSide] = RotateVec(ZToY, Targets.Elbows[nSide]);
+		TargetsY.Knees[nSide] = RotateVec(ZToY, Targets.Knees[nSide]);
+	}
+
+	FBodyPose Pose, PoseY;
+	SolveBody(Skeleton, Targets, Pose);
+	SolveBody(SkeletonY, TargetsY, PoseY);
+
+	FBodyPose Rotated;
+	for (int nBone = 0; nBone < (int)EBodyBone::Count; nBone++)
+	{
+		Rotated.Bones[nBone] = RotatePose(ZToY, Pose.Bones[nBone]);
+	}
+	VIVETRACKER_CHECK(IsNear(Rotated, PoseY));
+}
+
+static void TestUprightPelvis()
+{
+	// A waist tracker worn without a calibration, identity rotation or turned and tilted, with no foot or knee trackers
+	const FBodySkeleton Skeleton;
+	const float HalfTurn = std::sqrt(0.5f);
+	const FQuat4 Rotations[] = { FQuat4{}, FQuat4{ 0.f, 0.f, HalfTurn, HalfTurn }, FQuat4{ 0.f, HalfTurn, 0.f, HalfTurn }, Normalize(FQuat4{ 0.3f, -0.2f, 0.6f, 0.7f }) };
+	for (const FQuat4& Rotation : Rotations)
+	{
+		FBodyTargets Targets;
+		Targets.Head.Position = FVec3{ 0.f, 0.f, 170.f };
+		Targets.Pelvis = MakeUprightPelvis(Skeleton, FPose{ Rotation, FVec3{ 0.f, 0.f, 95.f } });
+		Targets.ValidMask = Target_Head | Target_Pelvis;
+
+		// The pelvis stands up along the skeleton's up axis, its forward level with the ground
+		VIVETRACKER_CHECK(IsNear(Rotate(Targets.Pelvis.Rotation, FVec3{ 1.f, 0.f, 0.f }), Skeleton.Up, 1.0e-4f));
+		VIVETRACKER_CHECK(std::fabs(Dot(Rotate(Targets.Pelvis.Rotation, FVec3{ 0.f, 0.f, 1.f }), Skeleton.Up)) < 1.0e-4f);
+		VIVETRACKER_CHECK(IsNear(Targets.Pelvis.Position, FVec3{ 0.f, 0.f, 95.f }, 1.0e-4f));
+
+		FBodyPose Pose;
+		SolveBody(Skeleton, Targets, Pose);
+
+		// Legs hang straight down from the hips, knees don't bend
+		const float LegLength = Skeleton.ThighLength + Skeleton.ShinLength;
+		for (int nSide = 0; nSide < 2; nSide++)
+		{
+			const FVec3 Hip = Pose.Bones[(int)(nSide == 0 ? EBodyBone::Thigh_L : EBodyBone::Thigh_R)].Position;
+			const FVec3 Foot = Pose.Bones[(int)(nSide == 0 ? EBodyBone::Foot_L : EBodyBone::Foot_R)].Position;
+			VIVETRACKER_CHECK(std::fabs(Hip.Z - 95.f) < 1.0e-2f);
+			VIVETRACKER_CHECK(IsNear(Foot, Hip - Skeleton.Up * LegLength));
+		}
+	}
+}
+
+static void TestBatch()
+{
+	// Seven bodies, so the second group of four is short, alternating Z up and Y up skeletons
+	const int nBodies = 7;
+	const FQuat4 ZToY{ -std::sqrt(0.5f), 0.f, 0.f, std::sqrt(0.5f) };
+
+	std::vector<FBodySkeleton> Skeletons(nBodies);
+	std::vector<FBodyTargets> Targets(nBodies);
+	std::vector<FPose> Heads(nBodies), Hands[2], Feet[2];
+	std::vector<FVec3> Elbows[2], Knees[2];
+	std::vector<uint32_t> ValidMasks(nBodies);
+	for (int nSide = 0; nSide < 2; nSide++)
+	{
+		Hands[nSide].resize(nBodies);
+		Feet[nSide].resize(nBodies);
+		Elbows[nSide].resize(nBodies);
+		Knees[nSide].resize(nBodies);
+	}
+
+	for (int nBody = 0; nBody < nBodies; nBody++)
+	{
+		Targets[nBody] = MakeTargets(nBody);
+		Skeletons[nBody].ThighLength += (float)nBody;
+		if (nBody & 1)
+		{
+			Skeletons[nBody].Up = RotateVec(ZToY, Skeletons[nBody].Up);
+			Skeletons[nBody].Forward = RotateVec(ZToY, Skeletons[nBody].Forward);
+		}
+
+		Heads[nBody] = Targets[nBody].Head;
+		for (int nSide = 0; nSide < 2; nSide++)
+		{
+			Hands[nSide][nBody] = Targets[nBody].Hands[nSide];
+			Feet[nSide][nBody] = Targets[nBody].Feet[nSide];
+			Elbows[nSide][nBody] = Targets[nBody].Elbows[nSide];
+			Knees[nSide][nBody] = Targets[nBody].Knees[nSide];
+		}
+		ValidMasks[nBody] = Targets[nBody].ValidMask;
+	}
+
+	// One spare pose past the batch must stay untouched
+	std::vector<FBodyPose> Poses(nBodies + 1);
+	Poses[nBodies].Bones[0].Position = FVec3{ 1.f, 2.f, 3.f };
+
+	FBodyBatch Batch;
+	Batch.Count = nBodies;
+	Batch.Skeletons = Skeletons.data();
+	Batch.bPerBodySkeletons = true;
+	Batch.Heads = Heads.data();
+	for (int nSide = 0; nSide < 2; nSide++)
+	{
+		Batch.Hands[nSide] = Hands[nSide].data();
+		Batch.Feet[nSide] = Feet[nSide].data();
+		Batch.Elbows[nSide] = Elbows[nSide].data();
+		Batch.Knees[nSide] = Knees[nSide].data();
+	}
+	Batch.ValidMasks = ValidMasks.data();
+	Batch.Poses = Poses.data();
+
+	// Split in two ranges, the way worker threads solve a batch
+	SolveBodies(Batch, 0, 4);
+	SolveBodies(Batch, 4, 100);
+
+	for (int nBody = 0; nBody < nBodies; nBody++)
+	{
+		FBodyPose Expected;
+		SolveBody(Skeletons[nBody], Targets[nBody], Expected);
+		VIVETRACKER_CHECK(IsNear(Poses[nBody], Expected));
+	}
+	VIVETRACKER_CHECK(IsNear(Poses[nBodies].Bones[0].Position, FVec3{ 1.f, 2.f, 3.f }, 0.f));
+}
+
+static void TestInvalidBatch()
+{
+	FBodyPose Poses[2];
+	Poses[0].Bones[0].Position = FVec3{ 1.f, 2.f, 3.f };
+	const uint32_t ValidMasks[2] = {};
+	const FBodySkeleton Skeleton;
+
+	// Empty batches and ranges are no-ops
+	FBodyBatch Empty;
+	SolveBodies(Empty, 0, 4);
+
+	FBodyBatch Batch;
+	Batch.Count = 2;
+	Batch.Skeletons = &Skeleton;
+	Batch.ValidMasks = ValidMasks;
+	Batch.Poses = Poses;
+	SolveBodies(Batch, 2, 4);
+	SolveBodies(Batch, 1, 1);
+	VIVETRACKER_CHECK(IsNear(Poses[0].Bones[0].Position, FVec3{ 1.f, 2.f, 3.f }, 0.f));
+
+	// Missing skeletons, masks or poses leave the poses untouched instead of crashing
+	Batch.Skeletons = nullptr;
+	SolveBodies(Batch, 0, 2);
+	Batch.Skeletons = &Skeleton;
+	Batch.ValidMasks = nullptr;
+	SolveBodies(Batch, 0, 2);
+	VIVETRACKER_CHECK(IsNear(Poses[0].Bones[0].Position, FVec3{ 1.f, 2.f, 3.f }, 0.f));
+	Batch.ValidMasks = ValidMasks;
+	Batch.Poses = nullptr;
+	SolveBodies(Batch, 0, 2);
+
+	// A negative start solves from the first body
+	Batch.Poses = Poses;
+	SolveBodies(Batch, -4, 2);
+	VIVETRACKER_CHECK(!IsNear(Poses[0].Bones[0].Position, FVec3{ 1.f, 2.f, 3.f }, 0.f));
+}
+
+int main()
+{
+	TestLimbs();
+	TestUpAxis();
+	TestUprightPelvis();
+	TestBatch();
+	TestInvalidBatch();
+	return VIVETRACKER_TEST_RESULT();
+}
@@ -0,0 +1,143 @@
+/*
+Copyright 2021 Valve Corporation under https://opensource.org/licenses/BSD-3-Clause
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// The engine independent stages of the per-frame tracker pipeline, timed against the mock OpenXR runtime: locating
+// every role, the mock's own xrLocateSpace cost, connect events and the tracker enumeration they trigger.
+// Usage: ViveTrackerPipelineBenchmark [frames=5000] [json file=ViveTrackerPipelineBenchmark.json]
+// Publishing samples to the engine is timed in-engine by vivetracker.BenchmarkPipeline.
+
+#include "ViveTrackerMockXr.h"
+#include "ViveTrackerTestSupport.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+using namespace ViveTrackerCore;
+
+static const double FrameSeconds = 1.0 / 90.0;
+
+/**
+* Run every stage at one tracker count
+* @param bool - Whether to time the per-role stages too, which only ever see one tracker per role
+* @return bool - Whether or not the mock started
+*/
+static bool RunStages(int NumTrackers, int NumFrames, bool bPerRoleStages, std::vector<ViveTrackerTest::FBenchmarkResult>& Results)
+{
+	FMockXrRuntime Mock;
+	for (int nTracker = 0; nTracker < NumTrackers; nTracker++)
+	{
+		Mock.AddTracker(FMockXrRuntime::MakeOrbitingTracker(nTracker));
+	}
+
+	FTrackerSession Session;
+	if (!Mock.Start(Session))
+		return false;
+
+	// Connect everything before measuring
+	for (int nFrame = 0; nFrame < 90; nFrame++)
+	{
+		Mock.Tick(FrameSeconds);
+	}
+
+	const std::string Suffix = "/trackers:" + std::to_string(NumTrackers);
+	const XrSpace BaseSpace = FMockXrRuntime::GetBaseSpace();
+	XrTime Time = Mock.GetTime();
+	const XrTime FrameTime = (XrTime)(FrameSeconds * 1.0e9);
+
+	if (bPerRoleStages)
+	{
+		double StartSeconds = ViveTrackerTest::GetSeconds();
+		for (int nFrame = 0; nFrame < NumFrames; nFrame++)
+		{
+			Session.LocateRoles(BaseSpace, Time += FrameTime);
+		}
+		ViveTrackerTest::AddBenchmarkResult(Results, "Locate" + Suffix, NumFrames, (ViveTrackerTest::GetSeconds() - StartSeconds) / NumFrames, "per frame, all roles");
+
+		// The mock's share of the above, so it can be told apart from the session's
+		const PFN_xrLocateSpace LocateSpace = FMockXrRuntime::GetEntryPoints().LocateSpace;
+		StartSeconds = ViveTrackerTest::GetSeconds();
+		for (int nFrame = 0; nFrame < NumFrames; nFrame++)
+		{
+			Time += FrameTime;
+			for (int nRole = 0; nRole < NumTrackerRoles; nRole++)
+			{
+				XrSpaceVelocity xrSpaceVelocity{ XR_TYPE_SPACE_VELOCITY };
+				XrSpaceLocation xrSpaceLocation{ XR_TYPE_SPACE_LOCATION, &xrSpaceVelocity };
+				LocateSpace(Session.GetRoleAction(nRole).Space, BaseSpace, Time, &xrSpaceLocation);
+			}
+		}
+		ViveTrackerTest::AddBenchmarkResult(Results, "StubLocate" + Suffix, NumFrames, (ViveTrackerTest::GetSeconds() - StartSeconds) / NumFrames, "per frame, mock runtime only");
+	}
+
+	// A connect event only reads its own tracker's paths, the enumeration it triggers lists every tracker
+	const int NumEvents = std::max(10, std::min(NumFrames, 2000));
+	const double StartEventSeconds = Mock.GetEventSeconds();
+	double RefreshSeconds = 0.0;
+	for (int nEvent = 0; nEvent < NumEvents; nEvent++)
+	{
+		Mock.SendConnectEvent(nEvent % NumTrackers);
+
+		const double StartSeconds = ViveTrackerTest::GetSeconds();
+		Session.RefreshTrackers();
+		RefreshSeconds += ViveTrackerTest::GetSeconds() - StartSeconds;
+	}
+	ViveTrackerTest::AddBenchmarkResult(Results, "ConnectEvent" + Suffix, NumEvents, (Mock.GetEventSeconds() - StartEventSeconds) / NumEvents, "per event");
+	ViveTrackerTest::AddBenchmarkResult(Results, "RefreshTrackers" + Suffix, NumEvents, RefreshSeconds / NumEvents, "per enumeration");
+
+	Mock.Stop();
+	return true;
+}
+
+int main(int ArgC, char** ArgV)
+{
+	const int NumFrames = ArgC > 1 ? std::max(10, std::min(std::atoi(ArgV[1]), 1000000)) : 5000;
+	const char* pFilename = ArgC > 2 ? ArgV[2] : "ViveTrackerPipelineBenchmark.json";
+
+	// The runtime binds one tracker per role and locating goes through the role actions, so locating costs the same at
+	// any tracker count and is only timed at 12. Extra trackers are only seen by connect events and enumeration.
+	std::vector<ViveTrackerTest::FBenchmarkResult> Results;
+	const int TrackerCounts[] = { NumTrackerRoles, 64, 256 };
+	for (int NumTrackers : TrackerCounts)
+	{
+		if (!RunStages(NumTrackers, NumFrames, NumTrackers == NumTrackerRoles, Results))
+		{
+			std::printf("Unable to start the mock runtime\n");
+			return 1;
+		}
+	}
+
+	if (!ViveTrackerTest::SaveBenchmarkResults(pFilename, "ViveTrackerPipelineBenchmark", Results))
+	{
+		std::printf("Unable to write %s\n", pFilename);
+		return 1;
+	}
+	std::printf("Results saved to %s\n", pFilename);
+	return 0;
+}